@@ -149,6 +149,28 @@ public:
 
     /// \}
 
+public:
+    /// \name File Handle Management
+    /// \{
+
+    /// \brief Closes the underlying file handle (and its I/O buffers),
+    ///        remembering the current position.
+    ///
+    /// The file is reopened automatically, at the same position, the next
+    /// time the reader is used. This allows many readers to be kept without
+    /// exhausting the process's open file limit.
+    ///
+    /// Has no effect on streamed input (e.g. stdin), which cannot be reopened.
+    ///
+    void Park(void);
+
+    /// \returns true if the reader's file handle is currently closed (see
+    ///          Park())
+    ///
+    bool IsParked(void) const;
+
+    /// \}
+
 protected:
     /// \name BAM File I/O
     /// \{
@@ -68,6 +68,7 @@ namespace BAM {
 namespace internal {
 
 class BamRecordMemory;
+class ClipAndGapifyPlan;
 class Pulse2BaseCache;
 
 } // namespace internal
@@ -1225,6 +1226,9 @@ private:
 private:
     ///\internal
     /// raw tag data fetching
+    ///
+    /// A \p plan is only used if it still matches this record (see
+    /// ClipAndGapifyPlan::Matches), otherwise one is built for the call.
 
     // sequence tags
     std::string FetchBasesRaw(const BamRecordTag tag) const;
@@ -1232,7 +1236,8 @@ private:
                            const Orientation orientation = Orientation::NATIVE,
                            const bool aligned = false,
                            const bool exciseSoftClips = false,
-                           const PulseBehavior pulseBehavior = PulseBehavior::ALL) const;
+                           const PulseBehavior pulseBehavior = PulseBehavior::ALL,
+                           const internal::ClipAndGapifyPlan* plan = nullptr) const;
 
     // frame tags
     Frames FetchFramesRaw(const BamRecordTag tag) const;
@@ -1240,7 +1245,8 @@ private:
                        const Orientation orientation = Orientation::NATIVE,
                        const bool aligned = false,
                        const bool exciseSoftClips = false,
-                       const PulseBehavior pulseBehavior = PulseBehavior::ALL) const;
+                       const PulseBehavior pulseBehavior = PulseBehavior::ALL,
+                       const internal::ClipAndGapifyPlan* plan = nullptr) const;
 
     // pulse tags
     std::vector<float> FetchPhotonsRaw(const BamRecordTag tag) const;
@@ -1248,7 +1254,8 @@ private:
                                     const Orientation orientation = Orientation::NATIVE,
                                     const bool aligned = false,
                                     const bool exciseSoftClips = false,
-                                    const PulseBehavior pulseBehavior = PulseBehavior::ALL) const;
+                                    const PulseBehavior pulseBehavior = PulseBehavior::ALL,
+                                    const internal::ClipAndGapifyPlan* plan = nullptr) const;
 
     // QV tags
     QualityValues FetchQualitiesRaw(const BamRecordTag tag) const;
@@ -1256,7 +1263,8 @@ private:
                                  const Orientation orientation = Orientation::NATIVE,
                                  const bool aligned = false,
                                  const bool exciseSoftClips = false,
-                                 const PulseBehavior pulseBehavior = PulseBehavior::ALL) const;
+                                 const PulseBehavior pulseBehavior = PulseBehavior::ALL,
+                                 const internal::ClipAndGapifyPlan* plan = nullptr) const;
 
     // UInt tags (e.g. start frame)
     std::vector<uint32_t> FetchUIntsRaw(const BamRecordTag tag) const;
@@ -1264,7 +1272,8 @@ private:
                                      const Orientation orientation = Orientation::NATIVE,
                                      const bool aligned = false,
                                      const bool exciseSoftClips = false,
-                                     const PulseBehavior pulseBehavior = PulseBehavior::ALL) const;
+                                     const PulseBehavior pulseBehavior = PulseBehavior::ALL,
+                                     const internal::ClipAndGapifyPlan* plan = nullptr) const;
 
 private:
     ///\internal
@@ -1274,6 +1283,7 @@ private:
     void CalculatePulse2BaseCache(void) const;
 
     friend class internal::BamRecordMemory;
+    friend class BamRecordView;
 };
 
 } // namespace BAM
@@ -44,10 +44,13 @@
 
 #include "pbbam/BamRecordTag.h"
 #include "pbbam/Cigar.h"
+#include "pbbam/CigarView.h"
 #include "pbbam/Config.h"
 #include "pbbam/Position.h"
 #include "pbbam/QualityValues.h"
+#include "pbbam/FlatTagCollection.h"
 #include "pbbam/TagCollection.h"
+#include "pbbam/TagEditBatch.h"
 #include <htslib/sam.h>
 #include <map>
 #include <string>
@@ -285,7 +288,11 @@ public:
     ///
     BamRecordImpl& CigarData(const std::string& cigarString);
 
-    // TODO: CIGAR iterator - Cigar only or here as well ??
+    /// \returns a non-owning view of the record's CIGAR data
+    ///
+    /// \warning The view is invalidated by any change to this record.
+    ///
+    CigarView CigarDataView(void) const;
 
     /// \returns the record's query name
     std::string Name(void) const;
@@ -392,6 +399,21 @@ public:
     ///
     BamRecordImpl& Tags(const TagCollection& tags);
 
+    /// \brief Sets the record's full tag data via a FlatTagCollection object
+    ///
+    /// Tags are written in the collection's order.
+    ///
+    BamRecordImpl& Tags(const FlatTagCollection& tags);
+
+    /// \returns record's full tag data as a FlatTagCollection object, in
+    ///          record order
+    FlatTagCollection FlatTags(void) const;
+
+    /// \brief Decodes the record's full tag data into \p tags (in record
+    ///        order), re-using its memory.
+    ///
+    void FlatTags(FlatTagCollection* tags) const;
+
     /// \brief Adds a new tag to this record.
     ///
     /// \param[in] tagName  2-character tag name.
@@ -476,8 +498,13 @@ public:
     ///     record.EditTag("YY", v); // will overwrite tag YY with a uint32-array-type tag
     /// \endcode
     ///
+    /// The tag keeps its position in the record. If the new value's encoded
+    /// size matches the old one, it is overwritten in place.
+    ///
     /// \returns true if tag was successfully edited.
     ///
+    /// \sa ApplyTagEdits for changing several tags at once
+    ///
     bool EditTag(const std::string& tagName,
                  const Tag& newValue);
 
@@ -543,6 +570,28 @@ public:
     ///
     bool HasTag(const BamRecordTag tag) const;
 
+    /// \brief Applies a batch of tag adds, edits, & removals.
+    ///
+    /// The record's tag data is rebuilt at most once, however many edits the
+    /// batch contains (and not at all if every edit overwrites an existing
+    /// value of the same encoded size).
+    ///
+    /// \param[in] edits    TagEditBatch of pending changes
+    /// \returns number of edits actually applied (see TagEditBatch for skip
+    ///          rules)
+    ///
+    size_t ApplyTagEdits(const TagEditBatch& edits);
+
+    /// \brief Ensures capacity for \p numBytes more bytes of tag data.
+    ///
+    /// Subsequent tag additions up to that size will not reallocate the
+    /// record's memory.
+    ///
+    /// \param[in] numBytes number of additional bytes
+    /// \returns reference to this record
+    ///
+    BamRecordImpl& ReserveTagData(const size_t numBytes);
+
     /// \brief Removes an existing tag from this record.
     ///
     /// \param[in] tagName  2-character tag name.
@@ -600,6 +649,7 @@ private:
     // internal memory setup/expand methods
     void InitializeData(void);
     void MaybeReallocData(void);
+    uint8_t* ResizeTagData(const size_t numBytes); // returns tag start
     void UpdateTagMap(void) const; // allowed to be called from const methods
                                    // (lazy update on request)
 
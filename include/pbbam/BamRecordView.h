@@ -43,10 +43,13 @@
 #define BAMRECORDVIEW_H
 
 #include "pbbam/BamRecord.h"
+#include <memory>
 
 namespace PacBio {
 namespace BAM {
 
+namespace internal { class ClipAndGapifyPlan; }
+
 /// \brief Provides a re-usable "view" onto a BamRecord
 ///
 /// This class acts a convenience wrapper for working with per-base BamRecord
@@ -56,6 +59,11 @@ namespace BAM {
 /// client code, a BamRecordView can be used to state those parameters once, and
 /// then simply request the desired fields.
 ///
+/// When clipping and/or gapping is requested, the record's CIGAR is walked
+/// once, on construction, & that plan is shared by all fields fetched from
+/// the view. If the record is later modified (e.g. clipped, mapped, or reused
+/// by a reader), fields are computed from its current CIGAR instead.
+///
 /// \internal
 /// \todo Sync up method names with BamRecord
 /// \endinternal
@@ -158,11 +166,10 @@ private:
     bool aligned_;
     bool exciseSoftClips_;
     PulseBehavior pulseBehavior_;
+    std::shared_ptr<internal::ClipAndGapifyPlan> plan_;
 };
 
 } // namespace BAM
 } // namespace PacBio
 
-#include "pbbam/internal/BamRecordView.inl"
-
 #endif // BAMRECORDVIEW_H
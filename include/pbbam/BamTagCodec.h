@@ -43,8 +43,11 @@
 #define BAMTAGCODEC_H
 
 #include "pbbam/Config.h"
+#include "pbbam/FlatTagCollection.h"
 #include "pbbam/TagCollection.h"
 #include <vector>
+#include <cstddef>
+#include <cstdint>
 
 namespace PacBio {
 namespace BAM {
@@ -77,6 +80,68 @@ public:
 
     /// \}
 
+public:
+    /// \name Buffer-Based Tag Collection Methods
+    ///
+    /// These read from, or write to, caller-provided memory (e.g. a record's
+    /// own tag data), avoiding intermediate copies.
+    ///
+    /// \{
+
+    /// \brief Creates a TagCollection from raw BAM data.
+    ///
+    /// \param[in] data     pointer to BAM-formatted (binary) tag data
+    /// \param[in] numBytes number of bytes of tag data
+    /// \returns TagCollection containing tag data
+    ///
+    static TagCollection Decode(const uint8_t* data, const size_t numBytes);
+
+    /// \brief Decodes raw BAM data into a FlatTagCollection, keeping the
+    ///        order of the input.
+    ///
+    /// The collection is cleared first, so it may be re-used across records.
+    ///
+    /// \param[in]  data        pointer to BAM-formatted (binary) tag data
+    /// \param[in]  numBytes    number of bytes of tag data
+    /// \param[out] tags        destination collection
+    ///
+    static void Decode(const uint8_t* data,
+                       const size_t numBytes,
+                       PacBio::BAM::FlatTagCollection* tags);
+
+    /// \brief Creates binary BAM data from a FlatTagCollection (in its order).
+    ///
+    /// \param[in] tags     FlatTagCollection containing tag data
+    /// \returns vector of bytes (encoded BAM data)
+    ///
+    static std::vector<uint8_t> Encode(const PacBio::BAM::FlatTagCollection& tags);
+
+    /// \brief Encodes a TagCollection directly into \p dest.
+    ///
+    /// \param[in]  tags    TagCollection containing tag data
+    /// \param[out] dest    destination, with room for at least
+    ///                     EncodedSize(tags) bytes
+    /// \returns number of bytes written
+    ///
+    static size_t Encode(const PacBio::BAM::TagCollection& tags, uint8_t* dest);
+
+    /// \brief Encodes a FlatTagCollection directly into \p dest.
+    ///
+    /// \param[in]  tags    FlatTagCollection containing tag data
+    /// \param[out] dest    destination, with room for at least
+    ///                     EncodedSize(tags) bytes
+    /// \returns number of bytes written
+    ///
+    static size_t Encode(const PacBio::BAM::FlatTagCollection& tags, uint8_t* dest);
+
+    /// \returns number of bytes needed to encode \p tags
+    static size_t EncodedSize(const PacBio::BAM::TagCollection& tags);
+
+    /// \returns number of bytes needed to encode \p tags
+    static size_t EncodedSize(const PacBio::BAM::FlatTagCollection& tags);
+
+    /// \}
+
 public:
     /// \name Per-Tag Methods
     /// \{
@@ -115,7 +180,42 @@ public:
     ///
     static PacBio::BAM::Tag FromRawData(uint8_t* rawData);
 
+    /// \returns number of bytes ToRawData would produce for \p tag (0 if it
+    ///          cannot be encoded)
+    ///
+    static size_t EncodedSize(const PacBio::BAM::Tag& tag,
+                              const TagModifier& additionalModifier = TagModifier::NONE);
+
+    /// \brief Encodes a single Tag's contents directly into \p dest.
+    ///
+    /// Same output as ToRawData, without the intermediate vector.
+    ///
+    /// \param[in]  tag                  Tag object containing data to encode
+    /// \param[in]  additionalModifier   optional extra modifier
+    /// \param[out] dest                 destination, with room for at least
+    ///                                  EncodedSize(tag, additionalModifier)
+    ///                                  bytes
+    /// \returns number of bytes written
+    ///
+    static size_t ToRawData(const PacBio::BAM::Tag& tag,
+                            const TagModifier& additionalModifier,
+                            uint8_t* dest);
+
     /// \}
+
+private:
+    // decodes value at typeStart (type code, then data) into tag, returns
+    // number of bytes consumed
+    static size_t DecodeValue(const uint8_t* typeStart, PacBio::BAM::Tag* tag);
+
+    // encode "<name><type><value>" or value only, returning byte count
+    // (measures only if dest is null)
+    static size_t EncodeEntry(const std::string& name,
+                              const PacBio::BAM::Tag& tag,
+                              uint8_t* dest);
+    static size_t EncodeValue(const PacBio::BAM::Tag& tag,
+                              const TagModifier& additionalModifier,
+                              uint8_t* dest);
 };
 
 } // namespace BAM
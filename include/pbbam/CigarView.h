@@ -0,0 +1,208 @@
+// Copyright (c) 2016, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+// File Description
+/// \file CigarView.h
+/// \brief Defines the CigarView class.
+//
+// Author: Derek Barnett
+
+#ifndef CIGARVIEW_H
+#define CIGARVIEW_H
+
+#include "pbbam/Cigar.h"
+#include "pbbam/CigarOperation.h"
+#include "pbbam/Config.h"
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+
+namespace PacBio {
+namespace BAM {
+
+/// \brief The CigarView class provides read-only, non-owning access to
+///        BAM-encoded CIGAR data.
+///
+/// Each operation is stored as a packed uint32_t (length << 4 | type), exactly
+/// as it appears in a BAM record. No CigarOperation objects are created until
+/// an element is dereferenced, so scanning a record's alignment (clip
+/// detection, query/reference span, match counts) does not allocate.
+///
+/// \warning A CigarView does not own its data. It is invalidated by any
+///          change to the record it was obtained from.
+///
+/// \sa BamRecordImpl::CigarDataView
+///
+class PBBAM_EXPORT CigarView
+{
+public:
+    /// \brief Random-access iterator over a CigarView, yielding
+    ///        CigarOperation values.
+    ///
+    class const_iterator
+    {
+    public:
+        typedef std::random_access_iterator_tag iterator_category;
+        typedef CigarOperation                  value_type;
+        typedef std::ptrdiff_t                  difference_type;
+        typedef const CigarOperation*           pointer;
+        typedef CigarOperation                  reference;
+
+    public:
+        const_iterator(void);
+        explicit const_iterator(const uint32_t* op);
+
+    public:
+        /// \returns current operation's type (does not validate)
+        CigarOperationType Type(void) const;
+
+        /// \returns current operation's length
+        uint32_t Length(void) const;
+
+    public:
+        CigarOperation operator*(void) const;
+        CigarOperation operator[](const difference_type n) const;
+
+        const_iterator& operator++(void);
+        const_iterator operator++(int);
+        const_iterator& operator--(void);
+        const_iterator operator--(int);
+        const_iterator& operator+=(const difference_type n);
+        const_iterator& operator-=(const difference_type n);
+        const_iterator operator+(const difference_type n) const;
+        const_iterator operator-(const difference_type n) const;
+        difference_type operator-(const const_iterator& other) const;
+
+        bool operator==(const const_iterator& other) const;
+        bool operator!=(const const_iterator& other) const;
+        bool operator<(const const_iterator& other) const;
+
+    private:
+        const uint32_t* op_;
+    };
+
+    typedef const_iterator iterator;
+
+public:
+    /// \name Constructors & Related Methods
+    /// \{
+
+    /// \brief Creates an empty view.
+    CigarView(void);
+
+    /// \brief Creates a view over \p numOps BAM-encoded operations.
+    ///
+    /// \param[in] data     pointer to first packed operation
+    /// \param[in] numOps   number of operations
+    ///
+    CigarView(const uint32_t* data, const size_t numOps);
+
+    CigarView(const CigarView& other) = default;
+    CigarView& operator=(const CigarView& other) = default;
+    ~CigarView(void) = default;
+
+    /// \}
+
+public:
+    /// \name Element Access
+    /// \{
+
+    /// \returns operation at index \p i
+    ///
+    /// \throws std::runtime_error if the operation is 'M' (see
+    ///         CigarOperationType)
+    ///
+    CigarOperation operator[](const size_t i) const;
+
+    /// \returns type of the operation at index \p i (does not validate)
+    CigarOperationType Type(const size_t i) const;
+
+    /// \returns length of the operation at index \p i
+    uint32_t Length(const size_t i) const;
+
+    /// \returns pointer to packed BAM data
+    const uint32_t* Data(void) const;
+
+    /// \}
+
+public:
+    /// \name Iterators & Size
+    /// \{
+
+    const_iterator begin(void) const;
+    const_iterator end(void) const;
+    const_iterator cbegin(void) const;
+    const_iterator cend(void) const;
+
+    bool empty(void) const;
+    size_t size(void) const;
+
+    /// \}
+
+public:
+    /// \name Alignment Lengths
+    /// \{
+
+    /// \returns number of query bases covered (M/I/S/=/X)
+    size_t QueryLength(void) const;
+
+    /// \returns number of reference bases covered (M/D/N/=/X)
+    size_t ReferenceLength(void) const;
+
+    /// \}
+
+public:
+    /// \name Conversion
+    /// \{
+
+    /// \returns an owning copy of the viewed data
+    Cigar ToCigar(void) const;
+
+    /// \returns SAM-formatted CIGAR string
+    std::string ToStdString(void) const;
+
+    /// \}
+
+private:
+    const uint32_t* data_;
+    size_t size_;
+};
+
+} // namespace BAM
+} // namespace PacBio
+
+#include "pbbam/internal/CigarView.inl"
+
+#endif // CIGARVIEW_H
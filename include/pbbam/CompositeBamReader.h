@@ -48,12 +48,14 @@
 #include "pbbam/BamHeader.h"
 #include "pbbam/BamReader.h"
 #include "pbbam/BamRecord.h"
+#include "pbbam/Compare.h"
 #include "pbbam/Config.h"
 #include "pbbam/DataSet.h"
 #include "pbbam/GenomicInterval.h"
 #include "pbbam/PbiIndexedBamReader.h"
 #include <deque>
 #include <functional>
+#include <list>
 #include <memory>
 #include <string>
 #include <vector>
@@ -63,6 +65,8 @@ namespace BAM {
 
 namespace internal {
 
+class CompositeReadAheadPrivate;
+
 /// \internal
 /// \brief The CompositeMergeItem class provides a helper struct for composite
 ///        readers, containing a single-file reader and its "next" record.
@@ -93,15 +97,284 @@ struct CompositeMergeItemSorter : public std::function<bool(const CompositeMerge
                                                             const CompositeMergeItem&)>
 {
     bool operator()(const CompositeMergeItem& lhs,
-                    const CompositeMergeItem& rhs);
+                    const CompositeMergeItem& rhs) const;
+};
+
+/// \internal
+/// \brief The CompositeReadAhead class reads records from multiple BamReaders
+///        on a pool of background threads.
+///
+/// Each input has a small, bounded queue of decoded records. Whenever an
+/// input's queue runs low, a task is queued to refill it from its reader, so
+/// a pool of N threads serves any number of inputs. The consumer only pops
+/// records, blocking only when the requested input has none ready.
+///
+/// Readers must outlive this object, and must not otherwise be used while
+/// added.
+///
+class PBBAM_EXPORT CompositeReadAhead
+{
+public:
+    /// \brief Default number of records buffered per input.
+    static const size_t DefaultQueueSize;
+
+public:
+    explicit CompositeReadAhead(const size_t numThreads,
+                                const size_t queueSize = DefaultQueueSize);
+    ~CompositeReadAhead(void);
+
+public:
+    /// Starts reading from \p reader in the background.
+    ///
+    /// \returns input ID, for use with GetNext()
+    ///
+    size_t Add(BamReader* reader);
+
+    /// Fetches the next record read from input \p id, waiting if necessary.
+    ///
+    /// \returns false if the input has no more records
+    /// \throws any exception thrown while reading the input
+    ///
+    bool GetNext(const size_t id, BamRecord& record);
+
+private:
+    std::unique_ptr<CompositeReadAheadPrivate> d_;
+};
+
+/// \internal
+/// \brief The RecordMergeKey class provides the sort key for composite readers
+///        ordered by a BamRecord comparator.
+///
+/// A merge key type extracts a key from each record once, as it enters the
+/// merge, so that later comparisons need not re-read record data. It provides:
+///
+/// \code
+///     typedef ... key_type;
+///     key_type MakeKey(const BamRecord& record) const;
+///     bool Less(const key_type& lhs, const key_type& rhs) const;
+/// \endcode
+///
+/// This generic version just refers to the record itself, compared via
+/// CompareType. Comparators on BamRecord member functions (e.g. Compare::Zmw)
+/// & Compare::None are specialized to store their actual values.
+///
+template<typename CompareType>
+struct RecordMergeKey
+{
+    typedef const BamRecord* key_type;
+
+    key_type MakeKey(const BamRecord& record) const
+    { return &record; }
+
+    bool Less(const key_type& lhs, const key_type& rhs) const
+    { return CompareType()(*lhs, *rhs); }
+};
+
+template<>
+struct RecordMergeKey<Compare::None>
+{
+    struct key_type { };
+
+    key_type MakeKey(const BamRecord&) const
+    { return key_type{ }; }
+
+    bool Less(const key_type&, const key_type&) const
+    { return false; }
+};
+
+template<typename ValueType,
+         ValueType (BamRecord::*fn)(void) const,
+         typename CompareType>
+struct RecordMergeKey<Compare::MemberFunctionBase<ValueType, fn, CompareType> >
+{
+    typedef ValueType key_type;
+
+    key_type MakeKey(const BamRecord& record) const
+    { return (record.*fn)(); }
+
+    bool Less(const key_type& lhs, const key_type& rhs) const
+    { return CompareType()(lhs, rhs); }
+};
+
+/// \internal
+/// \brief Selects the RecordMergeKey for a comparator, mapping comparators
+///        derived from Compare::MemberFunctionBase (e.g. Compare::Zmw) onto
+///        that base.
+///
+template<typename CompareType>
+struct RecordMergeKeyFor
+{
+    template<typename ValueType,
+             ValueType (BamRecord::*fn)(void) const,
+             typename MemberCompareType>
+    static Compare::MemberFunctionBase<ValueType, fn, MemberCompareType>
+    Select(const Compare::MemberFunctionBase<ValueType, fn, MemberCompareType>*);
+
+    static CompareType Select(...);
+
+    typedef RecordMergeKey<decltype(Select(static_cast<const CompareType*>(nullptr)))> type;
+};
+
+/// \internal
+/// \brief Sort key for genomic position order (reference ID, then start),
+///        with unmapped records last. Same ordering as PositionSorter.
+///
+struct PositionMergeKey
+{
+    typedef uint64_t key_type;
+
+    key_type MakeKey(const BamRecord& record) const;
+
+    bool Less(const key_type& lhs, const key_type& rhs) const
+    { return lhs < rhs; }
+};
+
+/// \internal
+/// \brief The CompositeMergeHeap class provides a K-way merge over
+///        CompositeMergeItems, ordered by a merge key type (see
+///        RecordMergeKey).
+///
+/// Items are stored once & never moved. A binary min-heap of item indices
+/// selects the "next" item, so advancing the merge costs O(log K) key
+/// comparisons rather than re-sorting all K items. Each record's key is
+/// computed once, when it enters the merge. Ties are broken by insertion order,
+/// so equal records are returned in the order their readers were added.
+///
+/// Optionally, inputs may be read on background threads (see
+/// ReadAheadThreads()), leaving the merging thread to just compare & pop. The
+/// number of open input files may also be limited (see MaxOpenFiles()), by
+/// parking the least-recently used readers.
+///
+template<typename MergeKey>
+class CompositeMergeHeap
+{
+public:
+    typedef typename MergeKey::key_type key_type;
+
+public:
+    explicit CompositeMergeHeap(const MergeKey& mergeKey = MergeKey());
+    CompositeMergeHeap(CompositeMergeHeap&& other);
+    CompositeMergeHeap& operator=(CompositeMergeHeap&& other);
+
+public:
+    /// Adds an item, which must already hold its reader's first record.
+    void Push(CompositeMergeItem&& item);
+
+    /// Moves the least record into \p record, then advances the reader that
+    /// provided it.
+    ///
+    /// \returns false if no records remain
+    ///
+    bool GetNext(BamRecord& record);
+
+    /// \returns true if no records remain
+    bool IsEmpty(void) const;
+
+    /// \returns number of background threads used to read inputs (0 if
+    ///          inputs are read on the calling thread)
+    size_t ReadAheadThreads(void) const;
+
+    /// Sets the number of background threads used to read inputs.
+    ///
+    /// Enabling takes effect immediately, for all current & future items.
+    /// Otherwise, changes take effect after the next TakeItems().
+    ///
+    void ReadAheadThreads(const size_t numThreads);
+
+    /// \returns maximum number of readers kept open (0 for no limit)
+    size_t MaxOpenFiles(void) const;
+
+    /// Sets the maximum number of readers kept open (0 for no limit). Beyond
+    /// this, the least-recently used readers are parked (see
+    /// BamReader::Park), to be reopened when next needed.
+    ///
+    /// \note Not applied to inputs being read ahead (see ReadAheadThreads()).
+    ///
+    void MaxOpenFiles(const size_t numFiles);
+
+    /// \returns all items added, in insertion order. Readers that have been
+    ///          exhausted are null. The heap is left empty.
+    ///
+    /// \note Readers are left at an arbitrary position (records already read
+    ///       ahead are discarded), so should be reset before further use.
+    ///
+    std::vector<CompositeMergeItem> TakeItems(void);
+
+private:
+    bool Advance(const size_t index);
+    void EnforceMaxOpenFiles(void);
+    bool Less(const size_t lhs, const size_t rhs) const;
+    void StartReadAhead(const size_t index);
+    void TouchReader(const size_t index);
+    void SiftDown(size_t pos);
+    void SiftUp(size_t pos);
+
+private:
+    MergeKey mergeKey_;
+
+    // items_ is a deque so that keys may refer to items' records
+    std::deque<CompositeMergeItem> items_;
+    std::vector<key_type> keys_;          // parallel to items_
+    std::vector<size_t> readAheadIds_;    // parallel to items_
+    std::vector<size_t> heap_;            // indices into items_
+
+    // open readers, most-recently used first
+    size_t maxOpenFiles_;
+    std::list<size_t> openReaders_;
+    std::vector<std::list<size_t>::iterator> openReaderPositions_; // parallel to items_
+    std::vector<bool> isOpenReader_;                               // parallel to items_
+
+    // declared after items_, so that it is destroyed (stopping reads) first
+    size_t readAheadThreads_;
+    std::unique_ptr<CompositeReadAhead> readAhead_;
 };
 
 } // namespace internal
 
+/// \internal
+/// \brief Orders records by genomic position (reference ID, then start).
+///        Unmapped records are ordered last.
+///
+struct OrderByPosition
+{
+    static inline bool less_than(const BamRecord& lhs, const BamRecord& rhs)
+    {
+        const int32_t lhsId = lhs.ReferenceId();
+        const int32_t rhsId = rhs.ReferenceId();
+        if (lhsId == -1) return false;
+        if (rhsId == -1) return true;
+
+        if (lhsId == rhsId)
+            return lhs.ReferenceStart() < rhs.ReferenceStart();
+        else return lhsId < rhsId;
+    }
+
+    static inline bool equals(const BamRecord& lhs, const BamRecord& rhs)
+    {
+        return lhs.ReferenceId() == rhs.ReferenceId() &&
+               lhs.ReferenceStart() == rhs.ReferenceStart();
+    }
+};
+
+/// \internal
+/// \brief Orders CompositeMergeItems by their records' genomic position.
+///
+struct PositionSorter : std::binary_function<internal::CompositeMergeItem, internal::CompositeMergeItem, bool>
+{
+    bool operator()(const internal::CompositeMergeItem& lhs,
+                    const internal::CompositeMergeItem& rhs) const
+    {
+        const BamRecord& l = lhs.record;
+        const BamRecord& r = rhs.record;
+        return OrderByPosition::less_than(l, r);
+    }
+};
+
 /// \brief The GenomicIntervalCompositeBamReader class provides read access to
 ///        multipe %BAM files, limiting results to a genomic region.
 ///
-/// Requires a ".bai" file for each input %BAM file.
+/// Requires a ".bai" file for each input %BAM file. If one is missing, the
+/// file's ".pbi" is used instead (requires mapped & reference data).
 ///
 /// Results will be returned in order of genomic coordinate (first by reference
 /// ID, then by position).
@@ -144,12 +417,56 @@ public:
 
     /// \}
 
-private:
-    void UpdateSort(void);
+public:
+    /// \name Performance Tuning
+    /// \{
+
+    /// \returns number of background threads used to read input files (0 if
+    ///          inputs are read on the calling thread)
+    ///
+    size_t ReadAheadThreads(void) const;
+
+    /// Sets the number of background threads used to read input files.
+    ///
+    /// When enabled, each input's records are decoded ahead of time on a
+    /// shared pool of threads, into a small per-input queue. GetNext() then
+    /// only merges already-decoded records, so throughput scales with the
+    /// number of inputs (up to \p numThreads), and one slow input does not
+    /// stall reading of the others. Default is 0 (disabled).
+    ///
+    /// Enabling takes effect immediately. Disabling, or changing the number
+    /// of threads, takes effect after the next call to Interval().
+    ///
+    /// \returns reference to this reader
+    ///
+    GenomicIntervalCompositeBamReader& ReadAheadThreads(const size_t numThreads);
+
+    /// \returns maximum number of input files kept open at once (0 for no
+    ///          limit)
+    ///
+    size_t MaxOpenFiles(void) const;
+
+    /// Sets the maximum number of input files kept open at once. Default is 0
+    /// (no limit).
+    ///
+    /// When merging many files, the least-recently used inputs beyond this
+    /// limit have their file handles (and I/O buffers) closed, saving their
+    /// position, and are transparently reopened when next needed. This keeps
+    /// large datasets within the process's open file limit, at the cost of
+    /// reopening files whose records interleave.
+    ///
+    /// \note Not applied to inputs being read in the background (see
+    ///       ReadAheadThreads()).
+    ///
+    /// \returns reference to this reader
+    ///
+    GenomicIntervalCompositeBamReader& MaxOpenFiles(const size_t numFiles);
+
+    /// \}
 
 private:
     GenomicInterval interval_;
-    std::deque<internal::CompositeMergeItem> mergeItems_;
+    internal::CompositeMergeHeap<internal::PositionMergeKey> mergeItems_;
     std::vector<std::string> filenames_;
 };
 
@@ -180,11 +497,10 @@ template<typename OrderByType>
 class PBBAM_EXPORT PbiFilterCompositeBamReader
 {
 public:
-    typedef internal::CompositeMergeItem                      value_type;
-    typedef internal::CompositeMergeItemSorter<OrderByType>   merge_sorter_type;
-    typedef std::deque<value_type>                            container_type;
-    typedef typename container_type::iterator                 iterator;
-    typedef typename container_type::const_iterator           const_iterator;
+    typedef internal::CompositeMergeItem                                value_type;
+    typedef internal::CompositeMergeItemSorter<OrderByType>             merge_sorter_type;
+    typedef typename internal::RecordMergeKeyFor<OrderByType>::type     merge_key_type;
+    typedef internal::CompositeMergeHeap<merge_key_type>                container_type;
 
 public:
     /// \name Contstructors & Related Methods
@@ -217,8 +533,40 @@ public:
 
     /// \}
 
-private:
-    void UpdateSort(void);
+public:
+    /// \name Performance Tuning
+    /// \{
+
+    /// \returns number of background threads used to read input files (0 if
+    ///          inputs are read on the calling thread)
+    ///
+    size_t ReadAheadThreads(void) const;
+
+    /// Sets the number of background threads used to read input files.
+    ///
+    /// \sa GenomicIntervalCompositeBamReader::ReadAheadThreads
+    ///
+    /// Enabling takes effect immediately. Disabling, or changing the number
+    /// of threads, takes effect after the next call to Filter().
+    ///
+    /// \returns reference to this reader
+    ///
+    PbiFilterCompositeBamReader& ReadAheadThreads(const size_t numThreads);
+
+    /// \returns maximum number of input files kept open at once (0 for no
+    ///          limit)
+    ///
+    size_t MaxOpenFiles(void) const;
+
+    /// Sets the maximum number of input files kept open at once.
+    ///
+    /// \sa GenomicIntervalCompositeBamReader::MaxOpenFiles
+    ///
+    /// \returns reference to this reader
+    ///
+    PbiFilterCompositeBamReader& MaxOpenFiles(const size_t numFiles);
+
+    /// \}
 
 private:
     container_type mergeQueue_;
@@ -231,7 +579,8 @@ private:
 ///
 /// Input files will be accessed in the order provided to the constructor. Each
 /// file's contents will be exhausted before moving on to the next one (as
-/// opposed to a "round-robin" scheme).
+/// opposed to a "round-robin" scheme). Only the file currently being read is
+/// kept open.
 ///
 class PBBAM_EXPORT SequentialCompositeBamReader
 {
@@ -258,7 +607,8 @@ public:
     /// \}
 
 private:
-    std::deque<std::unique_ptr<BamReader> > readers_;
+    std::deque<BamFile> files_;
+    std::unique_ptr<BamReader> reader_;
 };
 
 } // namespace BAM
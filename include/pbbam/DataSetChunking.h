@@ -0,0 +1,114 @@
+// Copyright (c) 2016, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// File Description
+/// \file DataSetChunking.h
+/// \brief Defines the DataSetChunking enums and methods.
+//
+// Author: Derek Barnett
+
+#ifndef DATASETCHUNKING_H
+#define DATASETCHUNKING_H
+
+#include "pbbam/Config.h"
+#include "pbbam/DataSet.h"
+#include <vector>
+
+namespace PacBio {
+namespace BAM {
+
+/// \brief Splits a DataSet into chunks of roughly equal work, for distributed
+///        processing.
+///
+/// Chunk boundaries are planned from the input files' PBI data, honoring any
+/// filters already present on the dataset. Each chunk is a copy of the input
+/// dataset (with a new UniqueId) whose %Filters additionally restrict it to
+/// its share of the data, so it may be saved as DataSet XML & handed to a
+/// worker directly. Resource paths are copied as-is; if they are relative,
+/// save chunks alongside the input XML.
+///
+namespace DataSetChunking
+{
+    /// \brief This enum describes how chunks are balanced.
+    ///
+    enum Balance
+    {
+        BASES    ///< total query bases (qEnd - qStart) per chunk
+      , RECORDS  ///< number of records per chunk
+    };
+
+    /// \brief Splits a dataset on ZMW boundaries (e.g. for unaligned data).
+    ///
+    /// Chunks are contiguous ranges of hole numbers, expressed as "zm"
+    /// filter properties. A ZMW is never split across chunks.
+    ///
+    /// \param[in] dataset      input dataset
+    /// \param[in] numChunks    requested number of chunks
+    /// \param[in] balance      balancing criterion
+    /// \returns at least 1, and at most \p numChunks, chunks. Fewer chunks are
+    ///          returned if there are fewer distinct ZMWs.
+    ///
+    /// \throws std::runtime_error if \p numChunks is 0, or if any %BAM file
+    ///         is missing its PBI
+    ///
+    PBBAM_EXPORT std::vector<DataSet> ByZmw(const DataSet& dataset,
+                                            const size_t numChunks,
+                                            const Balance balance = BASES);
+
+    /// \brief Splits a dataset on reference/position boundaries (for aligned
+    ///        data).
+    ///
+    /// Chunks are contiguous ranges of (reference, tStart), expressed as
+    /// "rname" & "tstart" filter properties. Unmapped records are not part of
+    /// any chunk.
+    ///
+    /// \param[in] dataset      input dataset
+    /// \param[in] numChunks    requested number of chunks
+    /// \param[in] balance      balancing criterion
+    /// \returns at least 1, and at most \p numChunks, chunks. Fewer chunks are
+    ///          returned if there are fewer distinct positions.
+    ///
+    /// \throws std::runtime_error if \p numChunks is 0, or if any %BAM file
+    ///         is missing its PBI or its PBI has no mapped data
+    ///
+    PBBAM_EXPORT std::vector<DataSet> ByReference(const DataSet& dataset,
+                                                  const size_t numChunks,
+                                                  const Balance balance = BASES);
+
+} // namespace DataSetChunking
+} // namespace BAM
+} // namespace PacBio
+
+#endif // DATASETCHUNKING_H
@@ -0,0 +1,108 @@
+// Copyright (c) 2016, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+// File Description
+/// \file FlatTagCollection.h
+/// \brief Defines the FlatTagCollection class.
+//
+// Author: Derek Barnett
+
+#ifndef FLATTAGCOLLECTION_H
+#define FLATTAGCOLLECTION_H
+
+#include "pbbam/Config.h"
+#include "pbbam/Tag.h"
+#include "pbbam/TagCollection.h"
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace PacBio {
+namespace BAM {
+
+/// \brief The FlatTagCollection class represents an ordered list of
+///        (name, Tag) pairs.
+///
+/// Unlike TagCollection (a std::map), tags are stored contiguously and keep
+/// the order in which they were added (or the order they appear in a %BAM
+/// record, see BamRecordImpl::FlatTags). Lookups are linear, which is cheap
+/// for the handful of tags on a typical record, and a cleared collection keeps
+/// its memory. This makes it a better fit than TagCollection for bulk
+/// decode/modify/encode of whole tag sets.
+///
+class PBBAM_EXPORT FlatTagCollection : public std::vector<std::pair<std::string, Tag> >
+{
+public:
+    /// \name Constructors & Related Methods
+    /// \{
+
+    /// \brief Creates an empty collection.
+    FlatTagCollection(void) = default;
+
+    /// \brief Creates a collection from a TagCollection (in name order).
+    explicit FlatTagCollection(const TagCollection& tags);
+
+    /// \}
+
+public:
+    /// \returns true if the collection contains a tag with \p name
+    bool Contains(const std::string& name) const;
+
+    /// \returns pointer to the tag with \p name, or nullptr if not found
+    const Tag* Find(const std::string& name) const;
+
+    /// \returns pointer to the tag with \p name, or nullptr if not found
+    Tag* Find(const std::string& name);
+
+    /// \brief Removes the tag with \p name.
+    ///
+    /// \returns true if a tag was removed
+    ///
+    bool Remove(const std::string& name);
+
+    /// \brief Sets tag \p name to \p value, overwriting an existing tag in
+    ///        place, or appending a new one.
+    ///
+    /// \returns reference to this collection
+    ///
+    FlatTagCollection& Set(const std::string& name, const Tag& value);
+
+    /// \returns the tags as a TagCollection
+    TagCollection ToTagCollection(void) const;
+};
+
+} // namespace BAM
+} // namespace PacBio
+
+#endif // FLATTAGCOLLECTION_H
@@ -43,6 +43,8 @@
 #define FRAMES_H
 
 #include "pbbam/Config.h"
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 
 namespace PacBio {
@@ -73,6 +75,14 @@ public:
     ///
     static Frames Decode(const std::vector<uint8_t>& codedData);
 
+    /// \brief Decodes lossy, 8-bit frame codes into a caller-provided buffer.
+    ///
+    /// \param[in]  codedData   encoded data
+    /// \param[in]  length      number of codes
+    /// \param[out] frames      output buffer, with room for \p length values
+    ///
+    static void Decode(const uint8_t* codedData, const size_t length, uint16_t* frames);
+
     /// \brief Creates encoded, compressed frame data from raw input data.
     ///
     /// \param[in] frames   raw frame data
@@ -80,6 +90,14 @@ public:
     ///
     static std::vector<uint8_t> Encode(const std::vector<uint16_t>& frames);
 
+    /// \brief Encodes raw frame data into a caller-provided buffer.
+    ///
+    /// \param[in]  frames      raw frame data
+    /// \param[in]  length      number of frame values
+    /// \param[out] codedData   output buffer, with room for \p length codes
+    ///
+    static void Encode(const uint16_t* frames, const size_t length, uint8_t* codedData);
+
     /// \}
 
 public:
@@ -56,9 +56,10 @@ namespace BAM {
 /// Example:
 /// \include code/GenomicIntervalQuery.txt
 ///
-/// \note Currently, all %BAM files must have a corresponding ".bai" index file.
-///       Use BamFile::EnsureStandardIndexExists before creating the query if
-///       one may not be present.
+/// \note Each %BAM file must have a corresponding ".bai" index file or, failing
+///       that, a ".pbi" with mapped & reference data (i.e. from an aligned,
+///       coordinate-sorted %BAM). Use BamFile::EnsureStandardIndexExists
+///       before creating the query if neither may be present.
 ///
 class PBBAM_EXPORT GenomicIntervalQuery : public internal::IQuery
 {
@@ -70,8 +71,8 @@ public:
     /// \param[in] interval genomic interval of interest
     /// \param[in] dataset  input data source(s)
     ///
-    /// \throws std::runtime_error on failure to open/read underlying %BAM or
-    ///         BAI files.
+    /// \throws std::runtime_error on failure to open/read underlying %BAM,
+    ///         BAI, or PBI files.
     ///
     GenomicIntervalQuery(const GenomicInterval& interval,
                          const PacBio::BAM::DataSet& dataset);
@@ -0,0 +1,111 @@
+// Copyright (c) 2016, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// File Description
+/// \file MultiIntervalQuery.h
+/// \brief Defines the MultiIntervalQuery class.
+//
+// Author: Derek Barnett
+
+#ifndef MULTIINTERVALQUERY_H
+#define MULTIINTERVALQUERY_H
+
+#include "pbbam/GenomicInterval.h"
+#include "pbbam/internal/QueryBase.h"
+#include <memory>
+#include <vector>
+
+namespace PacBio {
+namespace BAM {
+
+/// \brief The MultiIntervalQuery class provides iterable access to a
+///        DataSet's %BAM records, limiting results to those overlapping any
+///        of a list of GenomicIntervals.
+///
+/// Intervals are sorted & merged up front, and the union of their BAI chunks
+/// is read in a single pass over each file. Each record is returned once, in
+/// genomic coordinate order, even if it overlaps several intervals. Use
+/// CurrentIntervals() to find which intervals it overlaps.
+///
+/// This is much cheaper than re-running GenomicIntervalQuery::Interval for
+/// each of many (especially neighboring) regions, which re-seeks & re-reads
+/// any blocks the regions share.
+///
+/// \note All %BAM files must have a corresponding ".bai" index file.
+///       Intervals on a reference not present in a file's header are ignored
+///       for that file.
+///
+class PBBAM_EXPORT MultiIntervalQuery : public internal::IQuery
+{
+public:
+    /// \brief Constructs a new MultiIntervalQuery, limiting record results to
+    ///        only those overlapping any of the intervals.
+    ///
+    /// \param[in] intervals    genomic intervals of interest, in any order
+    /// \param[in] dataset      input data source(s)
+    ///
+    /// \throws std::runtime_error on failure to open/read underlying %BAM or
+    ///         BAI files.
+    ///
+    MultiIntervalQuery(const std::vector<GenomicInterval>& intervals,
+                       const PacBio::BAM::DataSet& dataset);
+    ~MultiIntervalQuery(void);
+
+public:
+    /// \brief Main iteration point for record access.
+    ///
+    /// Most client code should not need to use this method directly. Use
+    /// iterators instead.
+    ///
+    bool GetNext(BamRecord& r);
+
+public:
+    /// \returns indices (into Intervals(), ascending) of all intervals
+    ///          overlapping the record most recently returned
+    ///
+    const std::vector<size_t>& CurrentIntervals(void) const;
+
+    /// \returns the intervals requested, in their original order
+    const std::vector<GenomicInterval>& Intervals(void) const;
+
+private:
+    struct MultiIntervalQueryPrivate;
+    std::unique_ptr<MultiIntervalQueryPrivate> d_;
+};
+
+} // namespace BAM
+} // namspace PacBio
+
+#endif // MULTIINTERVALQUERY_H
@@ -675,8 +675,28 @@ public:
     ///       whitelist, exactly.
     ///
     /// \param[in] whitelist    query names to compare on
+    /// \param[in] numThreads   number of threads used to parse large
+    ///                         whitelists. If 0, the number of available
+    ///                         cores is used.
     ///
-    PbiQueryNameFilter(const std::vector<std::string>& whitelist);
+    PbiQueryNameFilter(const std::vector<std::string>& whitelist,
+                       const size_t numThreads = 0);
+
+    /// \brief Creates a 'whitelisted' query name filter from a file, with one
+    ///        query name per line.
+    ///
+    /// The file is streamed in large blocks and parsed on multiple threads,
+    /// so this is the preferred way to load very large whitelists.
+    ///
+    /// \param[in] filename     query name file
+    /// \param[in] numThreads   number of parsing threads. If 0, the number of
+    ///                         available cores is used.
+    ///
+    /// \throws std::runtime_error if the file cannot be read, or if it
+    ///         contains an invalid PacBio BAM QNAME
+    ///
+    static PbiQueryNameFilter FromFile(const std::string& filename,
+                                       const size_t numThreads = 0);
 
     PbiQueryNameFilter(const PbiQueryNameFilter& other);
     ~PbiQueryNameFilter(void);
@@ -690,6 +710,7 @@ public:
 
 private:
     struct PbiQueryNameFilterPrivate;
+    PbiQueryNameFilter(std::unique_ptr<PbiQueryNameFilterPrivate>&& d);
     std::unique_ptr<PbiQueryNameFilterPrivate> d_;
 };
 
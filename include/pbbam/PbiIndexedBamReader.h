@@ -44,10 +44,13 @@
 
 #include "pbbam/BamFile.h"
 #include "pbbam/BamReader.h"
+#include "pbbam/GenomicInterval.h"
 #include "pbbam/PbiBasicTypes.h"
 #include "pbbam/PbiFilter.h"
 #include "pbbam/PbiIndex.h"
+#include "pbbam/PbiRawData.h"
 #include <string>
+#include <vector>
 
 namespace PacBio {
 namespace BAM {
@@ -61,6 +64,13 @@ namespace internal { struct PbiIndexedBamReaderPrivate; }
 ///
 class PBBAM_EXPORT PbiIndexedBamReader : public BamReader
 {
+public:
+    /// \brief Default value for ReadThroughThreshold (about one BGZF block).
+    static const size_t DefaultReadThroughThreshold = 65536;
+
+    /// \brief Default value for BlockCacheSize (16MB).
+    static const size_t DefaultBlockCacheSize = 16777216;
+
 public:
     /// \name Constructors & Related Methods
     /// \{
@@ -151,6 +161,14 @@ public:
 //    /// \returns the reader's underlying index data
 //    const PbiIndex& Index(void) const;
 
+    /// \returns the reader's raw PBI data
+    const PbiRawData& PbiRawIndex(void) const;
+
+    /// \returns the PBI rows selected by the current filter (or interval), as
+    ///          blocks of consecutive rows in file order. Unaffected by reading.
+    ///
+    const IndexResultBlocks& ResultBlocks(void) const;
+
 public:
     /// \brief Sets a new filter on the reader.
     ///
@@ -159,6 +177,132 @@ public:
     ///
     PbiIndexedBamReader& Filter(const PbiFilter& filter);
 
+    /// \brief Limits the reader to records overlapping a genomic interval.
+    ///
+    /// Uses the PBI's mapped & reference data (coordinate-sorted input), so
+    /// no BAI is required. Replaces any current filter; Filter() will then
+    /// return the equivalent reference ID/start/end filter.
+    ///
+    /// \param[in] interval    genomic interval, half-open [start, stop)
+    /// \returns reference to this reader
+    ///
+    /// \throws std::runtime_error if the PBI lacks mapped or reference data,
+    ///         or if the interval's reference is not in the %BAM header
+    ///
+    PbiIndexedBamReader& Interval(const GenomicInterval& interval);
+
+    /// \}
+
+public:
+    /// \name Read Planning
+    /// \{
+
+    /// \returns the maximum compressed distance (in bytes) between the end of
+    ///          one block of filtered records and the start of the next, for
+    ///          which the reader will read through (and discard) the
+    ///          intervening records rather than seek
+    ///
+    size_t ReadThroughThreshold(void) const;
+
+    /// \brief Sets the maximum compressed distance (in bytes) between
+    ///        consecutive blocks of filtered records that will be read through
+    ///        rather than seeked over.
+    ///
+    /// Seeking always discards the current BGZF block, so sparse filters can
+    /// end up inflating the same block many times. Reading through small gaps
+    /// avoids this. A value of 0 still reads through gaps within the same
+    /// BGZF block.
+    ///
+    /// \param[in] numBytes    threshold, in compressed bytes
+    /// \returns reference to this reader
+    ///
+    PbiIndexedBamReader& ReadThroughThreshold(const size_t numBytes);
+
+    /// \returns the number of chunks of filtered records fetched ahead of the
+    ///          consumer (0 if prefetching is disabled)
+    ///
+    size_t PrefetchDepth(void) const;
+
+    /// \brief Enables prefetching I/O, with up to 'numChunks' chunks of
+    ///        filtered records fetched ahead of the consumer.
+    ///
+    /// Since all filtered records' file offsets are known after Filter(), the
+    /// reader can group nearby records into chunks (~1MB compressed), fetch
+    /// each chunk with a single pread() and inflate it on a worker thread,
+    /// while earlier records are being consumed. Records are still returned
+    /// in filter (file) order. This helps most on high-latency storage (e.g.
+    /// network filesystems). Records less than ReadThroughThreshold apart are
+    /// fetched within the same chunk.
+    ///
+    /// Prefetch settings are applied when reading starts after the next call
+    /// to Filter() (or immediately, if no prefetching has started yet). While
+    /// prefetching, VirtualSeek() & VirtualTell() do not affect, or reflect,
+    /// the records returned.
+    ///
+    /// \param[in] numChunks   prefetch depth (0 disables prefetching, the
+    ///                        default)
+    /// \returns reference to this reader
+    ///
+    PbiIndexedBamReader& PrefetchDepth(const size_t numChunks);
+
+    /// \returns the number of worker threads used for prefetching (0 means
+    ///          the number of available hardware threads)
+    ///
+    size_t PrefetchThreads(void) const;
+
+    /// \brief Sets the number of worker threads used for prefetching.
+    ///
+    /// \param[in] numThreads  number of threads (0 = number of available
+    ///                        hardware threads, the default)
+    /// \returns reference to this reader
+    ///
+    PbiIndexedBamReader& PrefetchThreads(const size_t numThreads);
+
+    /// \}
+
+public:
+    /// \name Random Access
+    /// \{
+
+    /// \brief Reads a single record, by its row number in the PBI.
+    ///
+    /// Random access does not change the reader's current filter or position.
+    ///
+    /// \param[in] row     PBI row (i.e. the record's ordinal in the %BAM file)
+    /// \returns record
+    ///
+    /// \throws std::runtime_error if row is out of range, or if the record
+    ///         could not be read
+    ///
+    BamRecord ReadRecordAt(const size_t row);
+
+    /// \brief Reads multiple records, by their row numbers in the PBI.
+    ///
+    /// Requests are sorted & de-duplicated so that each record (and each BGZF
+    /// block) is read once, in file order. Records are returned in the order
+    /// requested.
+    ///
+    /// \param[in] rows    PBI rows
+    /// \returns records, one per requested row
+    ///
+    /// \throws std::runtime_error if any row is out of range, or if a record
+    ///         could not be read
+    ///
+    std::vector<BamRecord> ReadRecords(const std::vector<size_t>& rows);
+
+    /// \returns the maximum size (inflated bytes) of the BGZF block cache used
+    ///          for random access
+    ///
+    size_t BlockCacheSize(void) const;
+
+    /// \brief Sets the maximum size (inflated bytes) of the BGZF block cache
+    ///        used for random access.
+    ///
+    /// \param[in] numBytes    cache size
+    /// \returns reference to this reader
+    ///
+    PbiIndexedBamReader& BlockCacheSize(const size_t numBytes);
+
     /// \}
 
 protected:
@@ -55,6 +55,9 @@ namespace BAM {
 /// There is no random-access here. It is simply a sequential read-through,
 /// grouping contiguous results that share a BamRecord::FullName.
 ///
+/// For files with a PBI, names are compared via the index's (read group, ZMW,
+/// qStart, qEnd) entries, instead of building each record's name string.
+///
 /// \note The name is not ideal - but for legacy reasons, it will remain as-is
 ///       for now. It will likely become something more explicit, like
 ///       "SequentialQNameGroupQuery", so that the name "QNameQuery" will be
@@ -0,0 +1,111 @@
+// Copyright (c) 2016, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// File Description
+/// \file SharedBlockCache.h
+/// \brief Defines the SharedBlockCache class.
+//
+// Author: Derek Barnett
+
+#ifndef SHAREDBLOCKCACHE_H
+#define SHAREDBLOCKCACHE_H
+
+#include "pbbam/Config.h"
+#include <cstddef>
+
+namespace PacBio {
+namespace BAM {
+
+/// \brief The SharedBlockCache class controls a process-wide cache of
+///        inflated BGZF blocks.
+///
+/// When enabled, every reader in the process (BamReader and the readers built
+/// on it, e.g. PbiIndexedBamReader, the composite readers, and the
+/// query classes) consults the cache whenever it seeks to a new block. Blocks
+/// already inflated by another reader - or by an earlier pass of the same
+/// reader - are then re-used instead of being re-read & decompressed. This
+/// mostly benefits workloads that repeatedly query overlapping regions of the
+/// same files, or open several readers on one file.
+///
+/// Blocks are keyed on the underlying file's identity (device, inode, size,
+/// modification time), not its name, so different paths to the same file
+/// share entries and a rewritten file never matches stale ones.
+///
+/// The cache is disabled by default. All methods are thread-safe.
+///
+/// \note Sequential reading (the common case) never revisits a block and
+///       gains nothing from the cache. Records read via a multithreaded BGZF
+///       stream, or from non-regular files (e.g. stdin), bypass it. When
+///       pbbam is built against an external htslib, BamReader seeks also
+///       bypass the cache; only blocks that PbiIndexedBamReader decodes in
+///       memory still use it.
+///
+class PBBAM_EXPORT SharedBlockCache
+{
+public:
+    /// \brief Default cache size: 256 MB of inflated data.
+    static const size_t DefaultMaxBytes;
+
+public:
+    /// \brief Enables the shared cache, limited to \p maxBytes of inflated
+    ///        data.
+    ///
+    /// May be called again to resize an enabled cache. Least-recently used
+    /// blocks are evicted as needed.
+    ///
+    static void Enable(const size_t maxBytes = DefaultMaxBytes);
+
+    /// \brief Disables the shared cache & releases all cached blocks.
+    ///
+    static void Disable(void);
+
+    /// \returns true if the shared cache is enabled
+    static bool IsEnabled(void);
+
+    /// \brief Removes all cached blocks, without changing enabled state.
+    ///
+    static void Clear(void);
+
+    /// \returns maximum size (in bytes) of inflated data held
+    static size_t MaxBytes(void);
+
+    /// \returns current size (in bytes) of inflated data held
+    static size_t NumBytes(void);
+};
+
+} // namespace BAM
+} // namespace PacBio
+
+#endif // SHAREDBLOCKCACHE_H
@@ -50,6 +50,8 @@
 namespace PacBio {
 namespace BAM {
 
+class BamTagCodec;
+
 /// \brief This enum is used to describe the exact (C++) data type held by a
 ///        Tag.
 ///
@@ -444,6 +446,8 @@ private :
 
     var_t data_;
     TagModifier modifier_;
+
+    friend class BamTagCodec;
 };
 
 } // namespace BAM
@@ -0,0 +1,187 @@
+// Copyright (c) 2016, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+// File Description
+/// \file TagEditBatch.h
+/// \brief Defines the TagEditBatch class.
+//
+// Author: Derek Barnett
+
+#ifndef TAGEDITBATCH_H
+#define TAGEDITBATCH_H
+
+#include "pbbam/BamRecordTag.h"
+#include "pbbam/Config.h"
+#include "pbbam/Tag.h"
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace PacBio {
+namespace BAM {
+
+class BamRecordImpl;
+
+/// \brief The TagEditBatch class collects tag adds, edits, & removals to be
+///        applied to a record in a single pass.
+///
+/// Each call to BamRecordImpl::AddTag, EditTag, or RemoveTag may shift the
+/// record's entire tag block (and rescan it). A TagEditBatch instead encodes
+/// its values up front, and BamRecordImpl::ApplyTagEdits rebuilds the tag block
+/// once, no matter how many tags are touched.
+///
+/// Edits are applied in the order they were added, with the same rules as the
+/// corresponding BamRecordImpl methods: Add() is skipped if the tag is already
+/// present, Edit() & Remove() are skipped if it is not. Set() adds or edits.
+/// Tags already in the record keep their position; new tags are appended.
+///
+/// \code{.cpp}
+///
+///     TagEditBatch edits;
+///     edits.Set(BamRecordTag::QUERY_START, qStart)
+///          .Set(BamRecordTag::QUERY_END, qEnd)
+///          .Remove("XX");
+///     record.Impl().ApplyTagEdits(edits);
+///
+/// \endcode
+///
+/// A batch may be cleared & re-used across records, keeping its memory.
+///
+class PBBAM_EXPORT TagEditBatch
+{
+public:
+    /// \name Constructors & Related Methods
+    /// \{
+
+    TagEditBatch(void);
+    TagEditBatch(const TagEditBatch& other) = default;
+    TagEditBatch(TagEditBatch&& other) = default;
+    TagEditBatch& operator=(const TagEditBatch& other) = default;
+    TagEditBatch& operator=(TagEditBatch&& other) = default;
+    ~TagEditBatch(void) = default;
+
+    /// \}
+
+public:
+    /// \name Adding Edits
+    /// \{
+
+    /// \brief Adds \p value as a new tag, if not already present.
+    TagEditBatch& Add(const std::string& tagName,
+                      const Tag& value,
+                      const TagModifier additionalModifier = TagModifier::NONE);
+
+    /// \brief Adds \p value as a new tag, if not already present.
+    TagEditBatch& Add(const BamRecordTag tag,
+                      const Tag& value,
+                      const TagModifier additionalModifier = TagModifier::NONE);
+
+    /// \brief Overwrites an existing tag with \p value.
+    TagEditBatch& Edit(const std::string& tagName,
+                       const Tag& value,
+                       const TagModifier additionalModifier = TagModifier::NONE);
+
+    /// \brief Overwrites an existing tag with \p value.
+    TagEditBatch& Edit(const BamRecordTag tag,
+                       const Tag& value,
+                       const TagModifier additionalModifier = TagModifier::NONE);
+
+    /// \brief Overwrites an existing tag with \p value, or adds it if missing.
+    TagEditBatch& Set(const std::string& tagName,
+                      const Tag& value,
+                      const TagModifier additionalModifier = TagModifier::NONE);
+
+    /// \brief Overwrites an existing tag with \p value, or adds it if missing.
+    TagEditBatch& Set(const BamRecordTag tag,
+                      const Tag& value,
+                      const TagModifier additionalModifier = TagModifier::NONE);
+
+    /// \brief Removes an existing tag.
+    TagEditBatch& Remove(const std::string& tagName);
+
+    /// \brief Removes an existing tag.
+    TagEditBatch& Remove(const BamRecordTag tag);
+
+    /// \}
+
+public:
+    /// \name Batch Attributes
+    /// \{
+
+    /// \brief Removes all edits (keeps allocated memory).
+    void Clear(void);
+
+    /// \returns true if the batch contains no edits
+    bool IsEmpty(void) const;
+
+    /// \returns number of edits in the batch
+    size_t Size(void) const;
+
+    /// \}
+
+private:
+    enum class EditType
+    {
+        ADD
+      , EDIT
+      , SET
+      , REMOVE
+    };
+
+    struct Edit_
+    {
+        EditType type_;
+        uint16_t code_;     // tag name, as 2 packed chars
+        bool     valid_;    // false if name or value could not be encoded
+        size_t   offset_;   // into data_: type code, then value bytes
+        size_t   length_;
+    };
+
+    TagEditBatch& AddEdit(const EditType type,
+                          const std::string& tagName,
+                          const Tag* value,
+                          const TagModifier additionalModifier);
+
+private:
+    std::vector<Edit_> edits_;
+    std::vector<uint8_t> data_;
+
+    friend class BamRecordImpl;
+};
+
+} // namespace BAM
+} // namespace PacBio
+
+#endif // TAGEDITBATCH_H
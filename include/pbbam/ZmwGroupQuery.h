@@ -49,8 +49,15 @@ namespace PacBio {
 namespace BAM {
 
 /// \brief The ZmwGroupQuery class provides iterable access to a DataSet's
-///        %BAM records, limiting results to those matching a ZMW hole number
-///        whitelist, and grouping those results by hole number.
+///        %BAM records, grouped by ZMW hole number, optionally limited to
+///        those matching a hole number whitelist.
+///
+/// Groups are returned in ascending hole number order. Within a group,
+/// records are ordered by input file, then by position in that file.
+///
+/// Each file's PBI is scanned once up front, to plan which rows belong to
+/// each ZMW. Files already grouped by ZMW (the usual case) are then read in a
+/// single forward pass.
 ///
 /// Example:
 /// \include code/ZmwGroupQuery.txt
@@ -73,6 +80,17 @@ public:
     ///
     ZmwGroupQuery(const std::vector<int32_t>& zmwWhitelist,
                   const DataSet& dataset);
+
+    /// \brief Creates a new ZmwGroupQuery, grouping all records by ZMW hole
+    ///        number.
+    ///
+    /// \param[in] dataset          input data source(s)
+    ///
+    /// \throws std::runtime_error on failure to open/read underlying %BAM or
+    ///         PBI files.
+    ///
+    ZmwGroupQuery(const DataSet& dataset);
+
     ~ZmwGroupQuery(void);
 
 public:
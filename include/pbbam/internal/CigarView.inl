@@ -0,0 +1,206 @@
+// Copyright (c) 2016, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+// File Description
+/// \file CigarView.inl
+/// \brief Inline implementations for the CigarView class.
+//
+// Author: Derek Barnett
+
+#include "pbbam/CigarView.h"
+
+namespace PacBio {
+namespace BAM {
+namespace internal {
+
+// BAM packs each op as (length << 4 | type)
+inline CigarOperationType PackedCigarType(const uint32_t op)
+{ return static_cast<CigarOperationType>(op & 0xf); }
+
+inline uint32_t PackedCigarLength(const uint32_t op)
+{ return op >> 4; }
+
+// bit masks over CigarOperationType values (MIDNSHP=X), same as htslib's
+// bam_cigar_type(): bit 0 - consumes query, bit 1 - consumes reference
+inline int PackedCigarConsumes(const uint32_t op)
+{ return (0x3C1A7 >> ((op & 0xf) << 1)) & 3; }
+
+} // namespace internal
+
+// ----------------------
+// CigarView::const_iterator
+// ----------------------
+
+inline CigarView::const_iterator::const_iterator(void)
+    : op_(nullptr)
+{ }
+
+inline CigarView::const_iterator::const_iterator(const uint32_t* op)
+    : op_(op)
+{ }
+
+inline CigarOperationType CigarView::const_iterator::Type(void) const
+{ return internal::PackedCigarType(*op_); }
+
+inline uint32_t CigarView::const_iterator::Length(void) const
+{ return internal::PackedCigarLength(*op_); }
+
+inline CigarOperation CigarView::const_iterator::operator*(void) const
+{ return CigarOperation(Type(), Length()); }
+
+inline CigarOperation CigarView::const_iterator::operator[](const difference_type n) const
+{ return *(*this + n); }
+
+inline CigarView::const_iterator& CigarView::const_iterator::operator++(void)
+{ ++op_; return *this; }
+
+inline CigarView::const_iterator CigarView::const_iterator::operator++(int)
+{ const_iterator result(*this); ++op_; return result; }
+
+inline CigarView::const_iterator& CigarView::const_iterator::operator--(void)
+{ --op_; return *this; }
+
+inline CigarView::const_iterator CigarView::const_iterator::operator--(int)
+{ const_iterator result(*this); --op_; return result; }
+
+inline CigarView::const_iterator& CigarView::const_iterator::operator+=(const difference_type n)
+{ op_ += n; return *this; }
+
+inline CigarView::const_iterator& CigarView::const_iterator::operator-=(const difference_type n)
+{ op_ -= n; return *this; }
+
+inline CigarView::const_iterator CigarView::const_iterator::operator+(const difference_type n) const
+{ return const_iterator(op_ + n); }
+
+inline CigarView::const_iterator CigarView::const_iterator::operator-(const difference_type n) const
+{ return const_iterator(op_ - n); }
+
+inline CigarView::const_iterator::difference_type
+CigarView::const_iterator::operator-(const const_iterator& other) const
+{ return op_ - other.op_; }
+
+inline bool CigarView::const_iterator::operator==(const const_iterator& other) const
+{ return op_ == other.op_; }
+
+inline bool CigarView::const_iterator::operator!=(const const_iterator& other) const
+{ return op_ != other.op_; }
+
+inline bool CigarView::const_iterator::operator<(const const_iterator& other) const
+{ return op_ < other.op_; }
+
+// ----------------------
+// CigarView
+// ----------------------
+
+inline CigarView::CigarView(void)
+    : data_(nullptr)
+    , size_(0)
+{ }
+
+inline CigarView::CigarView(const uint32_t* data, const size_t numOps)
+    : data_(data)
+    , size_(numOps)
+{ }
+
+inline CigarOperation CigarView::operator[](const size_t i) const
+{ return CigarOperation(Type(i), Length(i)); }
+
+inline CigarOperationType CigarView::Type(const size_t i) const
+{ return internal::PackedCigarType(data_[i]); }
+
+inline uint32_t CigarView::Length(const size_t i) const
+{ return internal::PackedCigarLength(data_[i]); }
+
+inline const uint32_t* CigarView::Data(void) const
+{ return data_; }
+
+inline CigarView::const_iterator CigarView::begin(void) const
+{ return const_iterator(data_); }
+
+inline CigarView::const_iterator CigarView::end(void) const
+{ return const_iterator(data_ + size_); }
+
+inline CigarView::const_iterator CigarView::cbegin(void) const
+{ return begin(); }
+
+inline CigarView::const_iterator CigarView::cend(void) const
+{ return end(); }
+
+inline bool CigarView::empty(void) const
+{ return size_ == 0; }
+
+inline size_t CigarView::size(void) const
+{ return size_; }
+
+inline size_t CigarView::QueryLength(void) const
+{
+    size_t result = 0;
+    for (size_t i = 0; i < size_; ++i) {
+        if (internal::PackedCigarConsumes(data_[i]) & 1)
+            result += internal::PackedCigarLength(data_[i]);
+    }
+    return result;
+}
+
+inline size_t CigarView::ReferenceLength(void) const
+{
+    size_t result = 0;
+    for (size_t i = 0; i < size_; ++i) {
+        if (internal::PackedCigarConsumes(data_[i]) & 2)
+            result += internal::PackedCigarLength(data_[i]);
+    }
+    return result;
+}
+
+inline Cigar CigarView::ToCigar(void) const
+{
+    Cigar result;
+    result.reserve(size_);
+    for (size_t i = 0; i < size_; ++i)
+        result.push_back((*this)[i]);
+    return result;
+}
+
+inline std::string CigarView::ToStdString(void) const
+{
+    std::string result;
+    for (size_t i = 0; i < size_; ++i) {
+        result.append(std::to_string(Length(i)));
+        result.push_back(CigarOperation::TypeToChar(Type(i)));
+    }
+    return result;
+}
+
+} // namespace BAM
+} // namespace PacBio
@@ -42,6 +42,8 @@
 
 #include "pbbam/CompositeBamReader.h"
 #include <algorithm>
+#include <limits>
+#include <map>
 #include <set>
 #include <sstream>
 #include <stdexcept>
@@ -80,13 +82,274 @@ inline CompositeMergeItem::~CompositeMergeItem(void) { }
 
 template<typename CompareType>
 inline bool CompositeMergeItemSorter<CompareType>::operator()(const CompositeMergeItem& lhs,
-                                                              const CompositeMergeItem& rhs)
+                                                              const CompositeMergeItem& rhs) const
 {
     const BamRecord& l = lhs.record;
     const BamRecord& r = rhs.record;
     return CompareType()(l, r);
 }
 
+inline PositionMergeKey::key_type PositionMergeKey::MakeKey(const BamRecord& record) const
+{
+    // unmapped records sort last, all equal
+    const int32_t refId = record.ReferenceId();
+    if (refId == -1)
+        return std::numeric_limits<key_type>::max();
+
+    // flip sign bit, so that (signed) position orders as unsigned
+    const uint32_t position = static_cast<uint32_t>(record.ReferenceStart()) ^ 0x80000000u;
+    return (static_cast<key_type>(static_cast<uint32_t>(refId)) << 32) | position;
+}
+
+template<typename MergeKey>
+inline CompositeMergeHeap<MergeKey>::CompositeMergeHeap(const MergeKey& mergeKey)
+    : mergeKey_(mergeKey)
+    , maxOpenFiles_(0)
+    , readAheadThreads_(0)
+{ }
+
+template<typename MergeKey>
+inline CompositeMergeHeap<MergeKey>::CompositeMergeHeap(CompositeMergeHeap&& other)
+    : mergeKey_(std::move(other.mergeKey_))
+    , items_(std::move(other.items_))
+    , keys_(std::move(other.keys_))
+    , readAheadIds_(std::move(other.readAheadIds_))
+    , heap_(std::move(other.heap_))
+    , maxOpenFiles_(other.maxOpenFiles_)
+    , openReaders_(std::move(other.openReaders_))
+    , openReaderPositions_(std::move(other.openReaderPositions_))
+    , isOpenReader_(std::move(other.isOpenReader_))
+    , readAheadThreads_(other.readAheadThreads_)
+    , readAhead_(std::move(other.readAhead_))
+{ }
+
+template<typename MergeKey>
+inline CompositeMergeHeap<MergeKey>&
+CompositeMergeHeap<MergeKey>::operator=(CompositeMergeHeap&& other)
+{
+    // stop any reads on our current items, before releasing them
+    readAhead_ = std::move(other.readAhead_);
+    readAheadThreads_ = other.readAheadThreads_;
+
+    mergeKey_ = std::move(other.mergeKey_);
+    items_ = std::move(other.items_);
+    keys_ = std::move(other.keys_);
+    readAheadIds_ = std::move(other.readAheadIds_);
+    heap_ = std::move(other.heap_);
+    maxOpenFiles_ = other.maxOpenFiles_;
+    openReaders_ = std::move(other.openReaders_);
+    openReaderPositions_ = std::move(other.openReaderPositions_);
+    isOpenReader_ = std::move(other.isOpenReader_);
+    return *this;
+}
+
+template<typename MergeKey>
+inline bool CompositeMergeHeap<MergeKey>::Advance(const size_t index)
+{
+    CompositeMergeItem& item = items_[index];
+    const size_t id = readAheadIds_[index];
+    if (id == std::numeric_limits<size_t>::max()) {
+        TouchReader(index);
+        return item.reader->GetNext(item.record);
+    }
+    else
+        return readAhead_->GetNext(id, item.record);
+}
+
+template<typename MergeKey>
+inline void CompositeMergeHeap<MergeKey>::EnforceMaxOpenFiles(void)
+{
+    if (maxOpenFiles_ == 0)
+        return;
+    while (openReaders_.size() > maxOpenFiles_) {
+        const size_t index = openReaders_.back();
+        openReaders_.pop_back();
+        isOpenReader_[index] = false;
+        items_[index].reader->Park();
+    }
+}
+
+template<typename MergeKey>
+inline bool CompositeMergeHeap<MergeKey>::GetNext(BamRecord& record)
+{
+    // nothing left to read
+    if (heap_.empty())
+        return false;
+
+    // store first item's record in our output record
+    const size_t firstIndex = heap_.front();
+    CompositeMergeItem& first = items_[firstIndex];
+    std::swap(record, first.record);
+
+    // try fetch 'next' from first item's reader. if successful, restore heap
+    // order on its new key. otherwise, drop it (closing its reader)
+    if (Advance(firstIndex)) {
+        keys_[firstIndex] = mergeKey_.MakeKey(first.record);
+        SiftDown(0);
+    } else {
+        if (isOpenReader_[firstIndex]) {
+            openReaders_.erase(openReaderPositions_[firstIndex]);
+            isOpenReader_[firstIndex] = false;
+        }
+        first.reader.reset();
+        heap_.front() = heap_.back();
+        heap_.pop_back();
+        if (!heap_.empty())
+            SiftDown(0);
+    }
+
+    // return success
+    return true;
+}
+
+template<typename MergeKey>
+inline bool CompositeMergeHeap<MergeKey>::IsEmpty(void) const
+{ return heap_.empty(); }
+
+template<typename MergeKey>
+inline size_t CompositeMergeHeap<MergeKey>::ReadAheadThreads(void) const
+{ return readAheadThreads_; }
+
+template<typename MergeKey>
+inline void CompositeMergeHeap<MergeKey>::ReadAheadThreads(const size_t numThreads)
+{
+    readAheadThreads_ = numThreads;
+    if (readAheadThreads_ > 0) {
+        for (const size_t index : heap_) {
+            if (readAheadIds_[index] == std::numeric_limits<size_t>::max())
+                StartReadAhead(index);
+        }
+    }
+}
+
+template<typename MergeKey>
+inline size_t CompositeMergeHeap<MergeKey>::MaxOpenFiles(void) const
+{ return maxOpenFiles_; }
+
+template<typename MergeKey>
+inline void CompositeMergeHeap<MergeKey>::MaxOpenFiles(const size_t numFiles)
+{
+    maxOpenFiles_ = numFiles;
+    EnforceMaxOpenFiles();
+}
+
+template<typename MergeKey>
+inline bool CompositeMergeHeap<MergeKey>::Less(const size_t lhs, const size_t rhs) const
+{
+    const key_type& l = keys_[lhs];
+    const key_type& r = keys_[rhs];
+    if (mergeKey_.Less(l, r)) return true;
+    if (mergeKey_.Less(r, l)) return false;
+    return lhs < rhs;
+}
+
+template<typename MergeKey>
+inline void CompositeMergeHeap<MergeKey>::Push(CompositeMergeItem&& item)
+{
+    items_.push_back(std::move(item));
+    keys_.push_back(mergeKey_.MakeKey(items_.back().record));
+    readAheadIds_.push_back(std::numeric_limits<size_t>::max());
+    openReaderPositions_.push_back(openReaders_.end());
+    isOpenReader_.push_back(false);
+    heap_.push_back(items_.size() - 1);
+    SiftUp(heap_.size() - 1);
+
+    if (readAheadThreads_ > 0)
+        StartReadAhead(items_.size() - 1);
+    else
+        TouchReader(items_.size() - 1);
+}
+
+template<typename MergeKey>
+inline void CompositeMergeHeap<MergeKey>::SiftDown(size_t pos)
+{
+    const size_t size = heap_.size();
+    const size_t index = heap_[pos];
+    while (true) {
+        size_t child = 2*pos + 1;
+        if (child >= size)
+            break;
+        if (child + 1 < size && Less(heap_[child+1], heap_[child]))
+            ++child;
+        if (!Less(heap_[child], index))
+            break;
+        heap_[pos] = heap_[child];
+        pos = child;
+    }
+    heap_[pos] = index;
+}
+
+template<typename MergeKey>
+inline void CompositeMergeHeap<MergeKey>::SiftUp(size_t pos)
+{
+    const size_t index = heap_[pos];
+    while (pos > 0) {
+        const size_t parent = (pos - 1) / 2;
+        if (!Less(index, heap_[parent]))
+            break;
+        heap_[pos] = heap_[parent];
+        pos = parent;
+    }
+    heap_[pos] = index;
+}
+
+template<typename MergeKey>
+inline void CompositeMergeHeap<MergeKey>::StartReadAhead(const size_t index)
+{
+    // reader now belongs to background reads, no longer tracked as open
+    if (isOpenReader_[index]) {
+        openReaders_.erase(openReaderPositions_[index]);
+        isOpenReader_[index] = false;
+    }
+
+    if (!readAhead_)
+        readAhead_.reset(new CompositeReadAhead{ readAheadThreads_ });
+    readAheadIds_[index] = readAhead_->Add(items_[index].reader.get());
+}
+
+template<typename MergeKey>
+inline void CompositeMergeHeap<MergeKey>::TouchReader(const size_t index)
+{
+    // move to front of open list, parking others as needed
+    if (isOpenReader_[index])
+        openReaders_.splice(openReaders_.begin(), openReaders_, openReaderPositions_[index]);
+    else {
+        openReaders_.push_front(index);
+        openReaderPositions_[index] = openReaders_.begin();
+        isOpenReader_[index] = true;
+    }
+    EnforceMaxOpenFiles();
+}
+
+template<typename MergeKey>
+inline std::vector<CompositeMergeItem> CompositeMergeHeap<MergeKey>::TakeItems(void)
+{
+    // stop background reads first
+    readAhead_.reset();
+    readAheadIds_.clear();
+
+    // park readers, so that they can be reset without exceeding the open file
+    // limit
+    if (maxOpenFiles_ > 0) {
+        for (auto&& item : items_) {
+            if (item.reader)
+                item.reader->Park();
+        }
+    }
+    openReaders_.clear();
+    openReaderPositions_.clear();
+    isOpenReader_.clear();
+
+    std::vector<CompositeMergeItem> result;
+    result.reserve(items_.size());
+    for (auto&& item : items_)
+        result.push_back(std::move(item));
+    items_.clear();
+    keys_.clear();
+    heap_.clear();
+    return result;
+}
+
 } // namespace internal
 
 // -----------------------------------
@@ -117,127 +380,106 @@ inline GenomicIntervalCompositeBamReader::GenomicIntervalCompositeBamReader(cons
 { }
 
 inline bool GenomicIntervalCompositeBamReader::GetNext(BamRecord& record)
-{
-    // nothing left to read
-    if (mergeItems_.empty())
-        return false;
-
-    // non-destructive 'pop' of first item from queue
-    auto firstIter = mergeItems_.begin();
-    auto firstItem = internal::CompositeMergeItem{ std::move(firstIter->reader), std::move(firstIter->record) };
-    mergeItems_.pop_front();
+{ return mergeItems_.GetNext(record); }
 
-    // store its record in our output record
-    std::swap(record, firstItem.record);
+inline const GenomicInterval& GenomicIntervalCompositeBamReader::Interval(void) const
+{ return interval_; }
 
-    // try fetch 'next' from first item's reader
-    // if successful, re-insert it into container & re-sort on our new values
-    // otherwise, this item will go out of scope & reader destroyed
-    if (firstItem.reader->GetNext(firstItem.record)) {
-        mergeItems_.push_front(std::move(firstItem));
-        UpdateSort();
-    }
+inline size_t GenomicIntervalCompositeBamReader::ReadAheadThreads(void) const
+{ return mergeItems_.ReadAheadThreads(); }
 
-    // return success
-    return true;
+inline GenomicIntervalCompositeBamReader&
+GenomicIntervalCompositeBamReader::ReadAheadThreads(const size_t numThreads)
+{
+    mergeItems_.ReadAheadThreads(numThreads);
+    return *this;
 }
 
-inline const GenomicInterval& GenomicIntervalCompositeBamReader::Interval(void) const
-{ return interval_; }
+inline size_t GenomicIntervalCompositeBamReader::MaxOpenFiles(void) const
+{ return mergeItems_.MaxOpenFiles(); }
+
+inline GenomicIntervalCompositeBamReader&
+GenomicIntervalCompositeBamReader::MaxOpenFiles(const size_t numFiles)
+{
+    mergeItems_.MaxOpenFiles(numFiles);
+    return *this;
+}
 
 inline GenomicIntervalCompositeBamReader& GenomicIntervalCompositeBamReader::Interval(const GenomicInterval& interval)
 {
-    auto updatedMergeItems = std::deque<internal::CompositeMergeItem>{ };
-    auto filesToCreate = std::set<std::string>{ filenames_.cbegin(), filenames_.cend() };
-
-    // update existing readers
-    while (!mergeItems_.empty()) {
-
-        // non-destructive 'pop' of first item from queue
-        auto firstIter = mergeItems_.begin();
-        auto firstItem = internal::CompositeMergeItem{ std::move(firstIter->reader), std::move(firstIter->record) };
-        mergeItems_.pop_front();
-
-        // reset interval
-        BaiIndexedBamReader* baiReader = dynamic_cast<BaiIndexedBamReader*>(firstItem.reader.get());
-        assert(baiReader);
-        baiReader->Interval(interval);
-
-        // try fetch 'next' from first item's reader
-        // if successful, re-insert it into container & re-sort on our new values
-        // otherwise, this item will go out of scope & reader destroyed
-        if (firstItem.reader->GetNext(firstItem.record)) {
-            updatedMergeItems.push_front(std::move(firstItem));
-            filesToCreate.erase(firstItem.reader->Filename());
+    // collect existing (non-exhausted) readers, for re-use
+    auto activeReaders = std::map<std::string, std::unique_ptr<BamReader> >{ };
+    for (auto&& item : mergeItems_.TakeItems()) {
+        if (item.reader) {
+            const std::string fn = item.reader->Filename();
+            activeReaders[fn] = std::move(item.reader);
         }
     }
 
-    // create readers for files that were not 'active' for the previous
+    // add each file's reader, in input order, so that ties are resolved
+    // consistently
+    auto updatedMergeItems = internal::CompositeMergeHeap<internal::PositionMergeKey>{ };
+    updatedMergeItems.ReadAheadThreads(mergeItems_.ReadAheadThreads());
+    updatedMergeItems.MaxOpenFiles(mergeItems_.MaxOpenFiles());
+    auto filesSeen = std::set<std::string>{ };
     std::vector<std::string> missingBai;
-    for (auto&& fn : filesToCreate) {
-        auto bamFile = BamFile{ fn };
-        if (bamFile.StandardIndexExists()) {
-            auto item = internal::CompositeMergeItem{ std::unique_ptr<BamReader>{ new BaiIndexedBamReader{ interval, std::move(bamFile) } } };
-            if (item.reader->GetNext(item.record))
-                updatedMergeItems.push_back(std::move(item));
-            // else not an error, simply no data matching interval
+    for (const auto& fn : filenames_) {
+        if (!filesSeen.insert(fn).second)
+            continue;
+
+        auto item = internal::CompositeMergeItem{ std::unique_ptr<BamReader>{ } };
+
+        // update existing reader
+        auto found = activeReaders.find(fn);
+        if (found != activeReaders.end()) {
+            item.reader = std::move(found->second);
+            BaiIndexedBamReader* baiReader = dynamic_cast<BaiIndexedBamReader*>(item.reader.get());
+            if (baiReader)
+                baiReader->Interval(interval);
+            else {
+                PbiIndexedBamReader* pbiReader = dynamic_cast<PbiIndexedBamReader*>(item.reader.get());
+                assert(pbiReader);
+                pbiReader->Interval(interval);
+            }
         }
+
+        // or create reader for file that was not 'active' for the previous interval
         else {
-            // maybe handle PBI-backed interval searches if BAI missing, but for now treat as error
-            missingBai.push_back(bamFile.Filename());
+            auto bamFile = BamFile{ fn };
+            if (bamFile.StandardIndexExists())
+                item.reader.reset(new BaiIndexedBamReader{ interval, std::move(bamFile) });
+            else if (bamFile.PacBioIndexExists()) {
+                // no BAI, fall back to PBI mapped/reference data
+                auto pbiReader = std::unique_ptr<PbiIndexedBamReader>{ new PbiIndexedBamReader{ std::move(bamFile) } };
+                pbiReader->Interval(interval);
+                item.reader = std::move(pbiReader);
+            }
+            else {
+                missingBai.push_back(bamFile.Filename());
+                continue;
+            }
         }
+
+        if (item.reader->GetNext(item.record))
+            updatedMergeItems.Push(std::move(item));
+        // else not an error, simply no data matching interval
     }
 
-    // throw if any files missing BAI
+    // throw if any files missing both BAI & PBI
     if (!missingBai.empty()) {
         std::stringstream e;
-        e << "failed to open GenomicIntervalCompositeBamReader because the following files are missing a BAI file:" << std::endl;
+        e << "failed to open GenomicIntervalCompositeBamReader because the following files are missing a BAI (or PBI) file:" << std::endl;
         for (const auto& fn : missingBai)
             e << "  " << fn << std::endl;
         throw std::runtime_error(e.str());
     }
 
     // update our actual container and return
+    interval_ = interval;
     mergeItems_ = std::move(updatedMergeItems);
-    UpdateSort();
     return *this;
 }
 
-struct OrderByPosition
-{
-    static inline bool less_than(const BamRecord& lhs, const BamRecord& rhs)
-    {
-        const int32_t lhsId = lhs.ReferenceId();
-        const int32_t rhsId = rhs.ReferenceId();
-        if (lhsId == -1) return false;
-        if (rhsId == -1) return true;
-
-        if (lhsId == rhsId)
-            return lhs.ReferenceStart() < rhs.ReferenceStart();
-        else return lhsId < rhsId;
-    }
-
-    static inline bool equals(const BamRecord& lhs, const BamRecord& rhs)
-    {
-        return lhs.ReferenceId() == rhs.ReferenceId() &&
-               lhs.ReferenceStart() == rhs.ReferenceStart();
-    }
-};
-
-struct PositionSorter : std::binary_function<internal::CompositeMergeItem, internal::CompositeMergeItem, bool>
-{
-    bool operator()(const internal::CompositeMergeItem& lhs,
-                    const internal::CompositeMergeItem& rhs)
-    {
-        const BamRecord& l = lhs.record;
-        const BamRecord& r = rhs.record;
-        return OrderByPosition::less_than(l, r);
-    }
-};
-
-inline void GenomicIntervalCompositeBamReader::UpdateSort(void)
-{ std::sort(mergeItems_.begin(), mergeItems_.end(), PositionSorter{ }); }
-
 // ------------------------------
 // PbiRequestCompositeBamReader
 // ------------------------------
@@ -270,72 +512,57 @@ inline PbiFilterCompositeBamReader<OrderByType>::PbiFilterCompositeBamReader(con
 
 template<typename OrderByType>
 inline bool PbiFilterCompositeBamReader<OrderByType>::GetNext(BamRecord& record)
-{
-    // nothing left to read
-    if (mergeQueue_.empty())
-        return false;
-
-    // non-destructive 'pop' of first item from queue
-    auto firstIter = mergeQueue_.begin();
-    auto firstItem = value_type{ std::move(firstIter->reader), std::move(firstIter->record) };
-    mergeQueue_.pop_front();
-
-    // store its record in our output record
-    std::swap(record, firstItem.record);
-
-    // try fetch 'next' from first item's reader
-    // if successful, re-insert it into container & re-sort on our new values
-    // otherwise, this item will go out of scope & reader destroyed
-    if (firstItem.reader->GetNext(firstItem.record)) {
-        mergeQueue_.push_front(std::move(firstItem));
-        UpdateSort();
-    }
-
-    // return success
-    return true;
-}
+{ return mergeQueue_.GetNext(record); }
 
 template<typename OrderByType>
 inline PbiFilterCompositeBamReader<OrderByType>&
 PbiFilterCompositeBamReader<OrderByType>::Filter(const PbiFilter& filter)
 {
-    auto updatedMergeItems = container_type{ };
-    auto filesToCreate = std::set<std::string>{ filenames_.cbegin(), filenames_.cend() };
-
-    // update existing readers
-    while (!mergeQueue_.empty()) {
-
-        // non-destructive 'pop' of first item from queue
-        auto firstIter = mergeQueue_.begin();
-        auto firstItem = internal::CompositeMergeItem{ std::move(firstIter->reader), std::move(firstIter->record) };
-        mergeQueue_.pop_front();
-
-        // reset request
-        PbiIndexedBamReader* pbiReader = dynamic_cast<PbiIndexedBamReader*>(firstItem.reader.get());
-        assert(pbiReader);
-        pbiReader->Filter(filter);
-
-        // try fetch 'next' from first item's reader
-        // if successful, re-insert it into container & re-sort on our new values
-        // otherwise, this item will go out of scope & reader destroyed
-        if (firstItem.reader->GetNext(firstItem.record)) {
-            updatedMergeItems.push_front(std::move(firstItem));
-            filesToCreate.erase(firstItem.reader->Filename());
+    // collect existing (non-exhausted) readers, for re-use
+    auto activeReaders = std::map<std::string, std::unique_ptr<BamReader> >{ };
+    for (auto&& item : mergeQueue_.TakeItems()) {
+        if (item.reader) {
+            const std::string fn = item.reader->Filename();
+            activeReaders[fn] = std::move(item.reader);
         }
     }
 
-    // create readers for files that were not 'active' for the previous
+    // add each file's reader, in input order, so that ties are resolved
+    // consistently
+    auto updatedMergeItems = container_type{ };
+    updatedMergeItems.ReadAheadThreads(mergeQueue_.ReadAheadThreads());
+    updatedMergeItems.MaxOpenFiles(mergeQueue_.MaxOpenFiles());
+    auto filesSeen = std::set<std::string>{ };
     std::vector<std::string> missingPbi;
-    for (auto&& fn : filesToCreate) {
-        auto bamFile = BamFile{ fn };
-        if (bamFile.PacBioIndexExists()) {
-            auto item = internal::CompositeMergeItem{ std::unique_ptr<BamReader>{ new PbiIndexedBamReader{ filter, std::move(bamFile) } } };
-            if (item.reader->GetNext(item.record))
-                updatedMergeItems.push_back(std::move(item));
-            // else not an error, simply no data matching filter
+    for (const auto& fn : filenames_) {
+        if (!filesSeen.insert(fn).second)
+            continue;
+
+        auto item = value_type{ std::unique_ptr<BamReader>{ } };
+
+        // update existing reader
+        auto found = activeReaders.find(fn);
+        if (found != activeReaders.end()) {
+            item.reader = std::move(found->second);
+            PbiIndexedBamReader* pbiReader = dynamic_cast<PbiIndexedBamReader*>(item.reader.get());
+            assert(pbiReader);
+            pbiReader->Filter(filter);
         }
-        else
-            missingPbi.push_back(fn);
+
+        // or create reader for file that was not 'active' for the previous filter
+        else {
+            auto bamFile = BamFile{ fn };
+            if (bamFile.PacBioIndexExists())
+                item.reader.reset(new PbiIndexedBamReader{ filter, std::move(bamFile) });
+            else {
+                missingPbi.push_back(fn);
+                continue;
+            }
+        }
+
+        if (item.reader->GetNext(item.record))
+            updatedMergeItems.Push(std::move(item));
+        // else not an error, simply no data matching filter
     }
 
     // throw if any files missing PBI
@@ -349,28 +576,45 @@ PbiFilterCompositeBamReader<OrderByType>::Filter(const PbiFilter& filter)
 
     // update our actual container and return
     mergeQueue_ = std::move(updatedMergeItems);
-    UpdateSort();
     return *this;
 }
 
 template<typename OrderByType>
-inline void PbiFilterCompositeBamReader<OrderByType>::UpdateSort(void)
-{ std::stable_sort(mergeQueue_.begin(), mergeQueue_.end(), merge_sorter_type{}); }
+inline size_t PbiFilterCompositeBamReader<OrderByType>::ReadAheadThreads(void) const
+{ return mergeQueue_.ReadAheadThreads(); }
+
+template<typename OrderByType>
+inline PbiFilterCompositeBamReader<OrderByType>&
+PbiFilterCompositeBamReader<OrderByType>::ReadAheadThreads(const size_t numThreads)
+{
+    mergeQueue_.ReadAheadThreads(numThreads);
+    return *this;
+}
+
+template<typename OrderByType>
+inline size_t PbiFilterCompositeBamReader<OrderByType>::MaxOpenFiles(void) const
+{ return mergeQueue_.MaxOpenFiles(); }
+
+template<typename OrderByType>
+inline PbiFilterCompositeBamReader<OrderByType>&
+PbiFilterCompositeBamReader<OrderByType>::MaxOpenFiles(const size_t numFiles)
+{
+    mergeQueue_.MaxOpenFiles(numFiles);
+    return *this;
+}
 
 // ------------------------------
 // SequentialCompositeBamReader
 // ------------------------------
 
 inline SequentialCompositeBamReader::SequentialCompositeBamReader(const std::vector<BamFile>& bamFiles)
-{
-    for (auto&& bamFile : bamFiles)
-        readers_.emplace_back(new BamReader{ bamFile });
-}
+    : files_(bamFiles.cbegin(), bamFiles.cend())
+{ }
 
 inline SequentialCompositeBamReader::SequentialCompositeBamReader(std::vector<BamFile>&& bamFiles)
 {
     for (auto&& bamFile : bamFiles)
-        readers_.emplace_back(new BamReader{ std::move(bamFile) });
+        files_.push_back(std::move(bamFile));
 }
 
 inline SequentialCompositeBamReader::SequentialCompositeBamReader(const DataSet& dataset)
@@ -379,18 +623,20 @@ inline SequentialCompositeBamReader::SequentialCompositeBamReader(const DataSet&
 
 inline bool SequentialCompositeBamReader::GetNext(BamRecord& record)
 {
-    // try first reader, if successful return true
-    // else pop reader and try next, until all readers exhausted
-    while (!readers_.empty()) {
-        auto& reader = readers_.front();
-        if (reader->GetNext(record))
+    // try current reader, if successful return true
+    // else open next file and try again, until all files exhausted
+    while (true) {
+        if (!reader_) {
+            if (files_.empty())
+                return false; // no files remaining
+            reader_.reset(new BamReader{ std::move(files_.front()) });
+            files_.pop_front();
+        }
+
+        if (reader_->GetNext(record))
             return true;
-        else
-            readers_.pop_front();
+        reader_.reset();
     }
-
-    // no readers available
-    return false;
 }
 
 } // namespace BAM
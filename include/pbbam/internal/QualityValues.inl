@@ -49,14 +49,6 @@ inline QualityValues::QualityValues(void)
     : std::vector<QualityValue>()
 { }
 
-inline QualityValues::QualityValues(const std::string& fastqString)
-    : std::vector<QualityValue>()
-{
-    resize(fastqString.size());
-    std::transform(fastqString.cbegin(), fastqString.cend(),
-                   begin(), QualityValue::FromFastq);
-}
-
 inline QualityValues::QualityValues(const std::vector<QualityValue>& quals)
     : std::vector<QualityValue>(quals)
 { }
@@ -111,17 +103,6 @@ inline std::vector<QualityValue>::iterator QualityValues::end(void)
 inline QualityValues QualityValues::FromFastq(const std::string& fastq)
 { return QualityValues(fastq); }
 
-inline std::string QualityValues::Fastq(void) const
-{
-    std::string result;
-    result.reserve(size());
-    auto iter = cbegin();
-    const auto end = cend();
-    for (; iter != end; ++iter)
-        result.push_back((*iter).Fastq());
-    return result;
-}
-
 inline bool QualityValues::operator==(const std::string& fastq) const
 { return *this == QualityValues(fastq); }
 
@@ -0,0 +1,239 @@
+// Copyright (c) 2016, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// File Description
+/// \file LazyVirtualZmwBamRecord.h
+/// \brief Defines the LazyVirtualZmwBamRecord class.
+//
+// Author: Derek Barnett
+
+#ifndef LAZYVIRTUALZMWBAMRECORD_H
+#define LAZYVIRTUALZMWBAMRECORD_H
+
+#include "pbbam/BamHeader.h"
+#include "pbbam/BamRecord.h"
+#include "pbbam/Config.h"
+#include "pbbam/Frames.h"
+#include "pbbam/QualityValues.h"
+#include "pbbam/virtual/VirtualRegion.h"
+#include "pbbam/virtual/VirtualRegionType.h"
+#include "pbbam/virtual/VirtualZmwBamRecord.h"
+#include <boost/optional.hpp>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace PacBio {
+namespace BAM {
+
+/// \brief The LazyVirtualZmwBamRecord class represents a ZMW read stitched
+///        from subreads|hqregion + scraps, where each field is only stitched
+///        when first requested.
+///
+/// This is useful when only a few fields (e.g. sequence & region annotations)
+/// are needed. Stitched values are cached, and match those of the
+/// corresponding VirtualZmwBamRecord (which stitches all fields up front).
+/// Use ToBamRecord() to obtain the fully-stitched record, e.g. for writing.
+///
+/// \note Although the field accessors are const, the first call for a field
+///       stitches & stores its value (in a mutable cache). They must not be
+///       called concurrently on the same record, even for different fields.
+///       Give each thread its own copy, or use ToBamRecord() instead.
+///
+class PBBAM_EXPORT LazyVirtualZmwBamRecord
+{
+public:
+    /// \name Constructors & Related Methods
+    /// \{
+
+    /// \brief Creates a lazily-stitched ZMW record from its constituent
+    ///        segments.
+    ///
+    /// \param[in] unorderedSources source data (subreads, scraps, etc.)
+    /// \param[in] header           %BAM header to associate with the record
+    ///
+    /// \throws std::runtime_error if \p unorderedSources is empty
+    ///
+    LazyVirtualZmwBamRecord(std::vector<BamRecord>&& unorderedSources,
+                            const BamHeader& header);
+
+    LazyVirtualZmwBamRecord(void) = delete;
+    LazyVirtualZmwBamRecord(const LazyVirtualZmwBamRecord&) = default;
+    LazyVirtualZmwBamRecord(LazyVirtualZmwBamRecord&&) = default;
+    LazyVirtualZmwBamRecord& operator=(const LazyVirtualZmwBamRecord&) = default;
+    LazyVirtualZmwBamRecord& operator=(LazyVirtualZmwBamRecord&&) = default;
+    ~LazyVirtualZmwBamRecord(void) = default;
+
+    /// \}
+
+public:
+    /// \name General Data
+    /// \{
+
+    /// \returns the %BAM header associated with the stitched record
+    const BamHeader& Header(void) const;
+
+    /// \returns the source records, in stitching (query start) order
+    const std::vector<BamRecord>& Sources(void) const;
+
+    /// \returns stitched record name ("movie/zmw/qStart_qEnd")
+    std::string FullName(void) const;
+
+    /// \returns ZMW hole number
+    int32_t HoleNumber(void) const;
+
+    /// \returns query start of the stitched record
+    Position QueryStart(void) const;
+
+    /// \returns query end of the stitched record
+    Position QueryEnd(void) const;
+
+    /// \}
+
+public:
+    /// \name Region Annotations
+    /// \{
+
+    /// \returns true if requested VirtualRegionType has been annotated.
+    bool HasVirtualRegionType(const VirtualRegionType regionType) const;
+
+    /// \brief Provides all annotations of the polymerase read as a map (type => regions)
+    const std::map<VirtualRegionType, std::vector<VirtualRegion>>& VirtualRegionsMap(void) const;
+
+    /// \brief Provides annotations of the polymerase read for a given VirtualRegionType.
+    ///
+    /// \param[in] regionType  requested region type
+    /// \returns regions that match the requested type (empty vector if none found).
+    ///
+    std::vector<VirtualRegion> VirtualRegionsTable(const VirtualRegionType regionType) const;
+
+    /// \}
+
+public:
+    /// \name Stitched Fields
+    /// \{
+
+    /// \returns stitched sequence (BAM SEQ)
+    const std::string& Sequence(void) const;
+
+    /// \returns stitched qualities (BAM QUAL)
+    const QualityValues& Qualities(void) const;
+
+    bool HasAltLabelQV(void) const;
+    bool HasAltLabelTag(void) const;
+    bool HasDeletionQV(void) const;
+    bool HasDeletionTag(void) const;
+    bool HasInsertionQV(void) const;
+    bool HasIPD(void) const;
+    bool HasLabelQV(void) const;
+    bool HasMergeQV(void) const;
+    bool HasPkmean(void) const;
+    bool HasPkmid(void) const;
+    bool HasPrePulseFrames(void) const;
+    bool HasPulseCall(void) const;
+    bool HasPulseCallWidth(void) const;
+    bool HasPulseMergeQV(void) const;
+    bool HasPulseWidth(void) const;
+    bool HasStartFrame(void) const;
+    bool HasSubstitutionQV(void) const;
+    bool HasSubstitutionTag(void) const;
+
+    /// \returns stitched values (empty if no source has the field)
+    const QualityValues& AltLabelQV(void) const;
+    const std::string& AltLabelTag(void) const;
+    const QualityValues& DeletionQV(void) const;
+    const std::string& DeletionTag(void) const;
+    const QualityValues& InsertionQV(void) const;
+    const Frames& IPD(void) const;
+    const QualityValues& LabelQV(void) const;
+    const QualityValues& MergeQV(void) const;
+    const std::vector<float>& Pkmean(void) const;  ///< includes any pkmean2 data
+    const std::vector<float>& Pkmid(void) const;   ///< includes any pkmid2 data
+    const Frames& PrePulseFrames(void) const;
+    const std::string& PulseCall(void) const;
+    const Frames& PulseCallWidth(void) const;
+    const QualityValues& PulseMergeQV(void) const;
+    const Frames& PulseWidth(void) const;
+    const std::vector<uint32_t>& StartFrame(void) const;
+    const QualityValues& SubstitutionQV(void) const;
+    const std::string& SubstitutionTag(void) const;
+
+    /// \}
+
+public:
+    /// \name Conversion
+    /// \{
+
+    /// \returns fully-stitched record, with all fields populated
+    ///
+    /// \throws std::runtime_error on failure to stitch record
+    ///
+    VirtualZmwBamRecord ToBamRecord(void) const;
+
+    /// \}
+
+private:
+    std::vector<BamRecord> sources_;
+    BamHeader header_;
+
+    // stitched on first access (unsynchronized, see class note)
+    mutable boost::optional<std::map<VirtualRegionType, std::vector<VirtualRegion>>> virtualRegionsMap_;
+    mutable boost::optional<std::string> sequence_;
+    mutable boost::optional<QualityValues> qualities_;
+    mutable boost::optional<QualityValues> altLabelQV_;
+    mutable boost::optional<std::string> altLabelTag_;
+    mutable boost::optional<QualityValues> deletionQV_;
+    mutable boost::optional<std::string> deletionTag_;
+    mutable boost::optional<QualityValues> insertionQV_;
+    mutable boost::optional<Frames> ipd_;
+    mutable boost::optional<QualityValues> labelQV_;
+    mutable boost::optional<QualityValues> mergeQV_;
+    mutable boost::optional<std::vector<float>> pkmean_;
+    mutable boost::optional<std::vector<float>> pkmid_;
+    mutable boost::optional<Frames> prePulseFrames_;
+    mutable boost::optional<std::string> pulseCall_;
+    mutable boost::optional<Frames> pulseCallWidth_;
+    mutable boost::optional<QualityValues> pulseMergeQV_;
+    mutable boost::optional<Frames> pulseWidth_;
+    mutable boost::optional<std::vector<uint32_t>> startFrame_;
+    mutable boost::optional<QualityValues> substitutionQV_;
+    mutable boost::optional<std::string> substitutionTag_;
+};
+
+} // namespace BAM
+} // namespace PacBio
+
+#endif // LAZYVIRTUALZMWBAMRECORD_H
@@ -0,0 +1,183 @@
+// Copyright (c) 2016, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// File Description
+/// \file ParallelZmwReadStitcher.h
+/// \brief Defines the ParallelZmwReadStitcher class.
+//
+// Author: Derek Barnett
+
+#ifndef PARALLELZMWREADSTITCHER_H
+#define PARALLELZMWREADSTITCHER_H
+
+#include "pbbam/Config.h"
+#include "pbbam/virtual/VirtualZmwBamRecord.h"
+#include <memory>
+#include <string>
+
+namespace PacBio {
+namespace BAM {
+
+class BamWriter;
+class DataSet;
+class PbiFilter;
+
+/// \brief The ParallelZmwReadStitcher class re-stitches "virtual" polymerase
+///        reads (like ZmwReadStitcher), using multiple threads.
+///
+/// A dedicated I/O thread reads each ZMW's records from the primary & scraps
+/// %BAM files, and a pool of worker threads stitches them. Stitched records
+/// are returned in the same (ZMW) order that ZmwReadStitcher would provide.
+///
+/// At most WindowSize() ZMWs are in flight (read, being stitched, or stitched
+/// but not yet consumed) at any time, which bounds memory use.
+///
+/// \note This reader requires that any input %BAM files also have associated
+///       PBI files available for query. See BamFile::EnsurePacBioIndexExists .
+///
+class PBBAM_EXPORT ParallelZmwReadStitcher
+{
+public:
+    /// \brief Default maximum number of ZMWs in flight.
+    static const size_t DefaultWindowSize;
+
+public:
+    /// \name Constructors & Related Methods
+    /// \{
+
+    /// \brief Creates a stitcher for entire primary & scraps %BAM files.
+    ///
+    /// \param[in] primaryBamFilePath   hqregion.bam or subreads.bam file path
+    /// \param[in] scrapsBamFilePath    scraps.bam file path
+    /// \param[in] numThreads           number of stitching threads (0 uses
+    ///                                 all available hardware threads)
+    /// \param[in] windowSize           max number of ZMWs in flight
+    ///
+    /// \throws std::runtime_error if files cannot be opened
+    ///
+    ParallelZmwReadStitcher(const std::string& primaryBamFilePath,
+                            const std::string& scrapsBamFilePath,
+                            const size_t numThreads = 0,
+                            const size_t windowSize = DefaultWindowSize);
+
+    /// \brief Creates a stitcher for filtered primary & scraps %BAM files.
+    ///
+    /// \param[in] primaryBamFilePath   hqregion.bam or subreads.bam file path
+    /// \param[in] scrapsBamFilePath    scraps.bam file path
+    /// \param[in] filter               PBI filter criteria
+    /// \param[in] numThreads           number of stitching threads (0 uses
+    ///                                 all available hardware threads)
+    /// \param[in] windowSize           max number of ZMWs in flight
+    ///
+    /// \throws std::runtime_error if files cannot be opened
+    ///
+    ParallelZmwReadStitcher(const std::string& primaryBamFilePath,
+                            const std::string& scrapsBamFilePath,
+                            const PbiFilter& filter,
+                            const size_t numThreads = 0,
+                            const size_t windowSize = DefaultWindowSize);
+
+    /// \brief Creates a stitcher for a (maybe filtered) DataSet's primary &
+    ///        scraps %BAM files.
+    ///
+    /// \param[in] dataset      input data
+    /// \param[in] numThreads   number of stitching threads (0 uses all
+    ///                         available hardware threads)
+    /// \param[in] windowSize   max number of ZMWs in flight
+    ///
+    /// \throws std::runtime_error if files cannot be opened
+    ///
+    ParallelZmwReadStitcher(const DataSet& dataset,
+                            const size_t numThreads = 0,
+                            const size_t windowSize = DefaultWindowSize);
+
+    ParallelZmwReadStitcher(void) = delete;
+    ParallelZmwReadStitcher(const ParallelZmwReadStitcher&) = delete;
+    ParallelZmwReadStitcher(ParallelZmwReadStitcher&&) = delete;
+    ParallelZmwReadStitcher& operator=(const ParallelZmwReadStitcher&) = delete;
+    ParallelZmwReadStitcher& operator=(ParallelZmwReadStitcher&&) = delete;
+    ~ParallelZmwReadStitcher(void);
+
+    /// \}
+
+public:
+    /// \name Stitched Record Reading
+    /// \{
+
+    /// \returns true if more ZMWs are available for reading.
+    ///
+    /// \note May block until the next ZMW has been read.
+    ///
+    bool HasNext(void);
+
+    /// \returns the next stitched polymerase read
+    ///
+    /// \throws std::runtime_error if no more records are available, or on
+    ///         any failure to read or stitch input records
+    ///
+    VirtualZmwBamRecord Next(void);
+
+    /// \brief Writes all remaining stitched records to \p writer, in order.
+    ///
+    /// \returns number of records written
+    ///
+    /// \throws std::runtime_error on any failure to read, stitch, or write
+    ///         records
+    ///
+    size_t WriteTo(BamWriter& writer);
+
+    /// \}
+
+public:
+    /// \name Attributes
+    /// \{
+
+    /// \returns number of stitching threads
+    size_t NumThreads(void) const;
+
+    /// \returns max number of ZMWs in flight
+    size_t WindowSize(void) const;
+
+    /// \}
+
+private:
+    struct ParallelZmwReadStitcherPrivate;
+    std::unique_ptr<ParallelZmwReadStitcherPrivate> d_;
+};
+
+} // namespace BAM
+} // namespace PacBio
+
+#endif // PARALLELZMWREADSTITCHER_H
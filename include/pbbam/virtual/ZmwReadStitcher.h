@@ -44,6 +44,7 @@
 
 #include "pbbam/BamRecord.h"
 #include "pbbam/Config.h"
+#include "pbbam/virtual/LazyVirtualZmwBamRecord.h"
 #include "pbbam/virtual/VirtualZmwBamRecord.h"
 #include <memory>
 #include <vector>
@@ -110,6 +111,12 @@ public:
     /// \returns the next stitched polymerase read
     VirtualZmwBamRecord Next(void);
 
+    /// \returns the next polymerase read, with fields stitched on demand.
+    ///          Use this when only a few fields are needed; call
+    ///          LazyVirtualZmwBamRecord::ToBamRecord for a writable record.
+    ///
+    LazyVirtualZmwBamRecord NextLazy(void);
+
     /// \returns the next set of reads that belong to one ZMW.
     ///          This enables stitching records in a distinct thread.
     ///
@@ -41,6 +41,7 @@
 
 #include "pbbam/BamReader.h"
 #include "pbbam/Validator.h"
+#include "BgzfBlockCache.h"
 #include "MemoryUtils.h"
 #include <htslib/bgzf.h>
 #include <htslib/hfile.h>
@@ -58,6 +59,7 @@ public:
     BamReaderPrivate(const BamFile& bamFile)
         : htsFile_(nullptr)
         , bamFile_(bamFile)
+        , parkedOffset_(-1)
     {
         DoOpen();
     }
@@ -65,6 +67,7 @@ public:
     BamReaderPrivate(BamFile&& bamFile)
         : htsFile_(nullptr)
         , bamFile_(std::move(bamFile))
+        , parkedOffset_(-1)
     {
         DoOpen();
     }
@@ -75,11 +78,38 @@ public:
         htsFile_.reset(sam_open(bamFile_.Filename().c_str(), "rb"));
         if (!htsFile_)
             throw std::runtime_error("could not open BAM file for reading");
+
+        fileIdentity_ = FileIdentity::FromFilename(bamFile_.Filename());
+    }
+
+    void Park(void)
+    {
+        if (!htsFile_ || bamFile_.Filename() == "-")
+            return;
+        parkedOffset_ = bgzf_tell(htsFile_->fp.bgzf);
+        htsFile_.reset();
+    }
+
+    void Seek(const int64_t virtualOffset)
+    {
+        auto result = CachedBgzfSeek(htsFile_->fp.bgzf, fileIdentity_, virtualOffset);
+        if (result != 0)
+            throw std::runtime_error("Failed to seek in BAM file");
+    }
+
+    void Unpark(void)
+    {
+        if (htsFile_)
+            return;
+        DoOpen();
+        Seek(parkedOffset_);
     }
 
 public:
     std::unique_ptr<samFile, internal::HtslibFileDeleter> htsFile_;
     BamFile bamFile_;
+    FileIdentity fileIdentity_;
+    int64_t parkedOffset_; // position to restore, while htsFile_ is closed
 };
 
 } // namespace internal
@@ -107,6 +137,7 @@ BamReader::~BamReader(void) { }
 BGZF* BamReader::Bgzf(void) const
 {
     assert(d_);
+    d_->Unpark();
     assert(d_->htsFile_);
     assert(d_->htsFile_->fp.bgzf);
     return d_->htsFile_->fp.bgzf;
@@ -176,15 +207,35 @@ int BamReader::ReadRawData(BGZF* bgzf, bam1_t* b)
     return bam_read1(bgzf, b);
 }
 
+bool BamReader::IsParked(void) const
+{
+    assert(d_);
+    return !d_->htsFile_;
+}
+
+void BamReader::Park(void)
+{
+    assert(d_);
+    d_->Park();
+}
+
 void BamReader::VirtualSeek(int64_t virtualOffset)
 {
-    auto result = bgzf_seek(Bgzf(), virtualOffset, SEEK_SET);
-    if (result != 0)
-        throw std::runtime_error("Failed to seek in BAM file");
+    assert(d_);
+
+    // no need to reopen yet, just update position to restore
+    if (!d_->htsFile_) {
+        d_->parkedOffset_ = virtualOffset;
+        return;
+    }
+    d_->Seek(virtualOffset);
 }
 
 int64_t BamReader::VirtualTell(void) const
 {
+    assert(d_);
+    if (!d_->htsFile_)
+        return d_->parkedOffset_;
     return bgzf_tell(Bgzf());
 }
 
@@ -43,11 +43,14 @@
 #include "pbbam/virtual/VirtualRegionTypeMap.h"
 #include "pbbam/ZmwTypeMap.h"
 #include "BamRecordTags.h"
+#include "ClipAndGapifyPlan.h"
 #include "MemoryUtils.h"
 #include "Pulse2BaseCache.h"
+#include "SequenceKernels.h"
 #include "SequenceUtils.h"
 #include <boost/numeric/conversion/cast.hpp>
 #include <htslib/sam.h>
+#include <cstring>
 #include <iostream>
 #include <stdexcept>
 
@@ -122,14 +125,13 @@ std::pair<int32_t, int32_t> AlignedOffsets(const BamRecord& record,
     int32_t startOffset = 0;
     int32_t endOffset = seqLength;
 
-    PBBAM_SHARED_PTR<bam1_t> b = internal::BamRecordMemory::GetRawData(record);
-    uint32_t* cigarData = bam_get_cigar(b.get());
-    const size_t numCigarOps = b->core.n_cigar;
+    const CigarView cigar = record.Impl().CigarDataView();
+    const size_t numCigarOps = cigar.size();
     if (numCigarOps > 0) {
 
         // start offset
         for (size_t i = 0; i < numCigarOps; ++i) {
-            const CigarOperationType type = static_cast<CigarOperationType>(bam_cigar_op(cigarData[i]));
+            const CigarOperationType type = cigar.Type(i);
             if (type == CigarOperationType::HARD_CLIP) {
                 if (startOffset != 0 && startOffset != seqLength) {
                     startOffset = -1;
@@ -137,14 +139,14 @@ std::pair<int32_t, int32_t> AlignedOffsets(const BamRecord& record,
                 }
             }
             else if (type == CigarOperationType::SOFT_CLIP)
-                startOffset += bam_cigar_oplen(cigarData[i]);
+                startOffset += cigar.Length(i);
             else
                 break;
         }
 
         // end offset
         for (int i = numCigarOps-1; i >= 0; --i) {
-            const CigarOperationType type = static_cast<CigarOperationType>(bam_cigar_op(cigarData[i]));
+            const CigarOperationType type = cigar.Type(i);
             if (type == CigarOperationType::HARD_CLIP) {
                 if (endOffset != 0 && endOffset != seqLength) {
                     endOffset = -1;
@@ -152,7 +154,7 @@ std::pair<int32_t, int32_t> AlignedOffsets(const BamRecord& record,
                 }
             }
             else if (type == CigarOperationType::SOFT_CLIP)
-                endOffset -= bam_cigar_oplen(cigarData[i]);
+                endOffset -= cigar.Length(i);
             else
                 break;
 
@@ -204,160 +206,28 @@ T ClipPulse(const T& input,
               input.cbegin() + end + 1 };
 }
 
-template< class InputIt, class Size, class OutputIt>
-OutputIt Move_N(InputIt first, Size count, OutputIt result)
-{
-    return std::move(first, first+count, result);
-}
-
-template <typename F, typename N>
-static void ClipAndGapify(const BamRecordImpl& impl,
-                          const bool aligned,
-                          const bool exciseSoftClips,
-                          F* seq,
-                          N paddingNullValue,
-                          N deletionNullValue)
-{
-    assert(seq);
-
-    const bool clipOrGapRequested = aligned || exciseSoftClips;
-    if (impl.IsMapped() && clipOrGapRequested)
-    {
-        // determine final container length
-        auto incrementsOutputLength = [](const CigarOperationType type,
-                                         const bool aligned,
-                                         const bool exciseSoftClips)
-        {
-            if (type == CigarOperationType::HARD_CLIP ||
-                type == CigarOperationType::REFERENCE_SKIP)
-            {
-                return false;
-            }
-            else if (type == CigarOperationType::SOFT_CLIP && exciseSoftClips)
-            {
-                return false;
-            }
-            else if (!aligned && (type == CigarOperationType::DELETION ||
-                                  type == CigarOperationType::PADDING))
-            {
-                return false;
-            }
-            else
-                return true;
-        };
-
-        size_t outputLength = 0;
-        const auto cigar = impl.CigarData();
-        for (const CigarOperation& op : cigar) {
-            if (incrementsOutputLength(op.Type(), aligned, exciseSoftClips))
-                outputLength += op.Length();
-        }
-
-        // move original data to temp, prep output container size
-        F originalSeq = std::move(*seq);
-        seq->resize(outputLength);
-
-        // apply CIGAR ops
-        size_t srcIndex = 0;
-        size_t dstIndex = 0;
-        for (const CigarOperation& op : cigar) {
-            const auto opType = op.Type();
-            const auto opLength = op.Length();
-
-            // nothing to do for hard-clipped & ref-skipped positions
-            if (opType == CigarOperationType::HARD_CLIP ||
-                opType == CigarOperationType::REFERENCE_SKIP)
-            {
-                continue;
-            }
-
-            // maybe skip soft-clipped positions
-            else if (opType == CigarOperationType::SOFT_CLIP) {
-                if (exciseSoftClips)
-                    srcIndex += opLength;
-                else {
-                    Move_N(originalSeq.begin() + srcIndex,
-                           opLength,
-                           seq->begin() + dstIndex);
-                    srcIndex += opLength;
-                    dstIndex += opLength;
-                }
-            }
-
-            // maybe add deletion/padding values
-            else if (aligned && opType == CigarOperationType::DELETION) {
-                for (size_t i = 0; i < opLength; ++i)
-                    (*seq)[dstIndex++] = deletionNullValue;
-            }
-            else if (aligned && opType == CigarOperationType::PADDING) {
-                for (size_t i = 0; i < opLength; ++i)
-                    (*seq)[dstIndex++] = paddingNullValue;
-            }
-
-            // all other CIGAR ops
-            else {
-                Move_N(originalSeq.begin() + srcIndex,
-                       opLength,
-                       seq->begin() + dstIndex);
-                srcIndex += opLength;
-                dstIndex += opLength;
-            }
-        }
-    }
-}
-
 static inline
-void ClipAndGapifyBases(const BamRecordImpl& impl,
-                        const bool aligned,
-                        const bool exciseSoftClips,
-                        std::string* seq)
-{
-    ClipAndGapify<std::string, char>(impl, aligned, exciseSoftClips,
-                                     seq, char('*'), char('-'));
-}
+void ClipAndGapifyBases(const ClipAndGapifyPlan& plan, std::string* seq)
+{ plan.Apply(seq, char('*'), char('-')); }
 
 static inline
-void ClipAndGapifyFrames(const BamRecordImpl& impl,
-                         const bool aligned,
-                         const bool exciseSoftClips,
-                         Frames* frames)
+void ClipAndGapifyFrames(const ClipAndGapifyPlan& plan, Frames* frames)
 {
     assert(frames);
-    std::vector<uint16_t> data = std::move(frames->Data());
-    ClipAndGapify<std::vector<uint16_t>, uint16_t>(impl, aligned, exciseSoftClips,
-                                                   &data, 0, 0);
-    frames->Data(data);
+    plan.Apply(&frames->DataRaw(), uint16_t(0), uint16_t(0));
 }
 
 static inline
-void ClipAndGapifyPhotons(const BamRecordImpl& impl,
-                          const bool aligned,
-                          const bool exciseSoftClips,
-                          std::vector<float>* data)
-{
-    ClipAndGapify<std::vector<float>, float>(impl, aligned, exciseSoftClips,
-                                             data, 0.0, 0.0);
-}
+void ClipAndGapifyPhotons(const ClipAndGapifyPlan& plan, std::vector<float>* data)
+{ plan.Apply(data, 0.0f, 0.0f); }
 
 static inline
-void ClipAndGapifyQualities(const BamRecordImpl& impl,
-                            const bool aligned,
-                            const bool exciseSoftClips,
-                            QualityValues* quals)
-{
-    ClipAndGapify<QualityValues, QualityValue>(impl, aligned, exciseSoftClips,
-                                               quals, QualityValue(0), QualityValue(0));
-}
+void ClipAndGapifyQualities(const ClipAndGapifyPlan& plan, QualityValues* quals)
+{ plan.Apply(quals, QualityValue(0), QualityValue(0)); }
 
 static inline
-void ClipAndGapifyUInts(const BamRecordImpl& impl,
-                        const bool aligned,
-                        const bool exciseSoftClips,
-                        std::vector<uint32_t>* data)
-{
-    ClipAndGapify<std::vector<uint32_t>, uint32_t>(impl, aligned, exciseSoftClips,
-                                                   data, 0, 0);
-}
+void ClipAndGapifyUInts(const ClipAndGapifyPlan& plan, std::vector<uint32_t>* data)
+{ plan.Apply(data, uint32_t(0), uint32_t(0)); }
 
 static
 RecordType NameToType(const std::string& name)
@@ -375,6 +245,18 @@ RecordType NameToType(const std::string& name)
     return RecordType::UNKNOWN;
 }
 
+// \returns the tag's raw string data, or nullptr if missing or not a string
+static
+const char* RawStringTag(const BamRecordImpl& impl, const BamRecordTag tag)
+{
+    // NOTE: htslib returns pointer to the type code, just past the name
+    const bam1_t* b = BamRecordMemory::GetRawData(impl).get();
+    const uint8_t* value = bam_aux_get(b, BamRecordTags::LabelFor(tag).c_str());
+    if (value == nullptr || value[0] != 'Z')
+        return nullptr;
+    return reinterpret_cast<const char*>(value + 1);
+}
+
 static
 void OrientBasesAsRequested(std::string* bases,
                             Orientation current,
@@ -647,19 +529,20 @@ void BamRecord::CalculatePulse2BaseCache(void) const
 
 Cigar BamRecord::CigarData(bool exciseAllClips) const
 {
-    auto isClippingOp = [](const CigarOperation& op)
-    {
-        const auto type = op.Type();
-        return type == CigarOperationType::SOFT_CLIP ||
-               type == CigarOperationType::HARD_CLIP;
-    };
-
-    auto cigar = impl_.CigarData();
-    if (exciseAllClips) {
-        cigar.erase(std::remove_if(cigar.begin(),
-                                   cigar.end(),
-                                   isClippingOp),
-                    cigar.end());
+    const CigarView view = impl_.CigarDataView();
+    if (!exciseAllClips)
+        return view.ToCigar();
+
+    // copy only non-clipping ops, straight from the packed data
+    Cigar cigar;
+    cigar.reserve(view.size());
+    for (auto iter = view.cbegin(); iter != view.cend(); ++iter) {
+        const auto type = iter.Type();
+        if (type != CigarOperationType::SOFT_CLIP &&
+            type != CigarOperationType::HARD_CLIP)
+        {
+            cigar.push_back(*iter);
+        }
     }
     return cigar;
 }
@@ -693,23 +576,23 @@ void BamRecord::ClipFields(const size_t clipFrom,
     impl_.SetSequenceAndQualities(sequence, qualities.Fastq());
 
     // update BAM tags
-    TagCollection tags = impl_.Tags();
+    TagEditBatch tags;
     if (HasDeletionQV())
-        tags[internal::Label(BamRecordTag::DELETION_QV)]      = internal::Clip(DeletionQV(Orientation::NATIVE), clipFrom, clipLength).Fastq();
+        tags.Edit(BamRecordTag::DELETION_QV,      internal::Clip(DeletionQV(Orientation::NATIVE), clipFrom, clipLength).Fastq());
     if (HasInsertionQV())
-        tags[internal::Label(BamRecordTag::INSERTION_QV)]     = internal::Clip(InsertionQV(Orientation::NATIVE), clipFrom, clipLength).Fastq();
+        tags.Edit(BamRecordTag::INSERTION_QV,     internal::Clip(InsertionQV(Orientation::NATIVE), clipFrom, clipLength).Fastq());
     if (HasMergeQV())
-        tags[internal::Label(BamRecordTag::MERGE_QV)]         = internal::Clip(MergeQV(Orientation::NATIVE), clipFrom, clipLength).Fastq();
+        tags.Edit(BamRecordTag::MERGE_QV,         internal::Clip(MergeQV(Orientation::NATIVE), clipFrom, clipLength).Fastq());
     if (HasSubstitutionQV())
-        tags[internal::Label(BamRecordTag::SUBSTITUTION_QV)]  = internal::Clip(SubstitutionQV(Orientation::NATIVE), clipFrom, clipLength).Fastq();
+        tags.Edit(BamRecordTag::SUBSTITUTION_QV,  internal::Clip(SubstitutionQV(Orientation::NATIVE), clipFrom, clipLength).Fastq());
     if (HasIPD())
-        tags[internal::Label(BamRecordTag::IPD)]              = internal::Clip(IPD(Orientation::NATIVE).Data(), clipFrom, clipLength);
+        tags.Edit(BamRecordTag::IPD,              internal::Clip(IPD(Orientation::NATIVE).Data(), clipFrom, clipLength));
     if (HasPulseWidth())
-        tags[internal::Label(BamRecordTag::PULSE_WIDTH)]      = internal::Clip(PulseWidth(Orientation::NATIVE).Data(), clipFrom, clipLength);
+        tags.Edit(BamRecordTag::PULSE_WIDTH,      internal::Clip(PulseWidth(Orientation::NATIVE).Data(), clipFrom, clipLength));
     if (HasDeletionTag())
-        tags[internal::Label(BamRecordTag::DELETION_TAG)]     = internal::Clip(DeletionTag(Orientation::NATIVE), clipFrom, clipLength);
+        tags.Edit(BamRecordTag::DELETION_TAG,     internal::Clip(DeletionTag(Orientation::NATIVE), clipFrom, clipLength));
     if (HasSubstitutionTag())
-        tags[internal::Label(BamRecordTag::SUBSTITUTION_TAG)] = internal::Clip(SubstitutionTag(Orientation::NATIVE), clipFrom, clipLength);
+        tags.Edit(BamRecordTag::SUBSTITUTION_TAG, internal::Clip(SubstitutionTag(Orientation::NATIVE), clipFrom, clipLength));
 
     // internal BAM tags
     if (HasPulseCall()) {
@@ -719,33 +602,33 @@ void BamRecord::ClipFields(const size_t clipFrom,
         internal::Pulse2BaseCache* p2bCache = p2bCache_.get();
 
         if (HasAltLabelQV())
-            tags[internal::Label(BamRecordTag::ALT_LABEL_QV)]     = internal::ClipPulse(AltLabelQV(Orientation::NATIVE), p2bCache, clipFrom, clipLength).Fastq();
+            tags.Edit(BamRecordTag::ALT_LABEL_QV,     internal::ClipPulse(AltLabelQV(Orientation::NATIVE), p2bCache, clipFrom, clipLength).Fastq());
         if (HasLabelQV())
-            tags[internal::Label(BamRecordTag::LABEL_QV)]         = internal::ClipPulse(LabelQV(Orientation::NATIVE), p2bCache, clipFrom, clipLength).Fastq();
+            tags.Edit(BamRecordTag::LABEL_QV,         internal::ClipPulse(LabelQV(Orientation::NATIVE), p2bCache, clipFrom, clipLength).Fastq());
         if (HasPulseMergeQV())
-            tags[internal::Label(BamRecordTag::PULSE_MERGE_QV)]   = internal::ClipPulse(PulseMergeQV(Orientation::NATIVE), p2bCache, clipFrom, clipLength).Fastq();
+            tags.Edit(BamRecordTag::PULSE_MERGE_QV,   internal::ClipPulse(PulseMergeQV(Orientation::NATIVE), p2bCache, clipFrom, clipLength).Fastq());
         if (HasAltLabelTag())
-            tags[internal::Label(BamRecordTag::ALT_LABEL_TAG)]    = internal::ClipPulse(AltLabelTag(Orientation::NATIVE), p2bCache, clipFrom, clipLength);
+            tags.Edit(BamRecordTag::ALT_LABEL_TAG,    internal::ClipPulse(AltLabelTag(Orientation::NATIVE), p2bCache, clipFrom, clipLength));
         if (HasPulseCall())
-            tags[internal::Label(BamRecordTag::PULSE_CALL)]       = internal::ClipPulse(PulseCall(Orientation::NATIVE), p2bCache, clipFrom, clipLength);
+            tags.Edit(BamRecordTag::PULSE_CALL,       internal::ClipPulse(PulseCall(Orientation::NATIVE), p2bCache, clipFrom, clipLength));
         if (HasPkmean())
-            tags[internal::Label(BamRecordTag::PKMEAN)]           = EncodePhotons(internal::ClipPulse(Pkmean(Orientation::NATIVE), p2bCache, clipFrom, clipLength));
+            tags.Edit(BamRecordTag::PKMEAN,           EncodePhotons(internal::ClipPulse(Pkmean(Orientation::NATIVE), p2bCache, clipFrom, clipLength)));
         if (HasPkmid())
-            tags[internal::Label(BamRecordTag::PKMID)]            = EncodePhotons(internal::ClipPulse(Pkmid(Orientation::NATIVE), p2bCache, clipFrom, clipLength));
+            tags.Edit(BamRecordTag::PKMID,            EncodePhotons(internal::ClipPulse(Pkmid(Orientation::NATIVE), p2bCache, clipFrom, clipLength)));
         if (HasPkmean2())
-            tags[internal::Label(BamRecordTag::PKMEAN_2)]         = EncodePhotons(internal::ClipPulse(Pkmean2(Orientation::NATIVE), p2bCache, clipFrom, clipLength));
+            tags.Edit(BamRecordTag::PKMEAN_2,         EncodePhotons(internal::ClipPulse(Pkmean2(Orientation::NATIVE), p2bCache, clipFrom, clipLength)));
         if (HasPkmid2())
-            tags[internal::Label(BamRecordTag::PKMID_2)]          = EncodePhotons(internal::ClipPulse(Pkmid2(Orientation::NATIVE), p2bCache, clipFrom, clipLength));
+            tags.Edit(BamRecordTag::PKMID_2,          EncodePhotons(internal::ClipPulse(Pkmid2(Orientation::NATIVE), p2bCache, clipFrom, clipLength)));
         if (HasPrePulseFrames())
-            tags[internal::Label(BamRecordTag::PRE_PULSE_FRAMES)] = internal::ClipPulse(PrePulseFrames(Orientation::NATIVE).Data(), p2bCache, clipFrom, clipLength);
+            tags.Edit(BamRecordTag::PRE_PULSE_FRAMES, internal::ClipPulse(PrePulseFrames(Orientation::NATIVE).Data(), p2bCache, clipFrom, clipLength));
         if (HasPulseCallWidth())
-            tags[internal::Label(BamRecordTag::PULSE_CALL_WIDTH)] = internal::ClipPulse(PulseCallWidth(Orientation::NATIVE).Data(), p2bCache, clipFrom, clipLength);
+            tags.Edit(BamRecordTag::PULSE_CALL_WIDTH, internal::ClipPulse(PulseCallWidth(Orientation::NATIVE).Data(), p2bCache, clipFrom, clipLength));
         if (HasStartFrame())
-            tags[internal::Label(BamRecordTag::START_FRAME)]      = internal::ClipPulse(StartFrame(Orientation::NATIVE), p2bCache, clipFrom, clipLength);
+            tags.Edit(BamRecordTag::START_FRAME,      internal::ClipPulse(StartFrame(Orientation::NATIVE), p2bCache, clipFrom, clipLength));
 
     }
 
-    impl_.Tags(tags);
+    impl_.ApplyTagEdits(tags);
 }
 
 BamRecord& BamRecord::ClipToQuery(const Position start,
@@ -1166,6 +1049,11 @@ BamRecord::EncodePhotons(const std::vector<float>& data)
 
 std::string BamRecord::FetchBasesRaw(const BamRecordTag tag) const
 {
+    // read straight from the raw tag data, when it's a string
+    const char* raw = internal::RawStringTag(impl_, tag);
+    if (raw)
+        return std::string(raw);
+
     const Tag& seqTag = impl_.TagValue(tag);
     return seqTag.ToString();
 }
@@ -1174,7 +1062,8 @@ std::string BamRecord::FetchBases(const BamRecordTag tag,
                                   const Orientation orientation,
                                   const bool aligned,
                                   const bool exciseSoftClips,
-                                  const PulseBehavior pulseBehavior) const
+                                  const PulseBehavior pulseBehavior,
+                                  const internal::ClipAndGapifyPlan* plan) const
 {
     const bool isBamSeq = (tag == BamRecordTag::SEQ);
     const bool isPulse = internal::BamRecordTags::IsPulse(tag);
@@ -1212,10 +1101,10 @@ std::string BamRecord::FetchBases(const BamRecordTag tag,
         current = Orientation::GENOMIC;
 
         // clip & gapify as requested
-        internal::ClipAndGapifyBases(impl_,
-                                     aligned,
-                                     exciseSoftClips,
-                                     &bases);
+        if (plan && plan->Matches(impl_))
+            internal::ClipAndGapifyBases(*plan, &bases);
+        else
+            internal::ClipAndGapifyBases(internal::ClipAndGapifyPlan{ impl_, aligned, exciseSoftClips }, &bases);
     }
 
     // return in the orientation requested
@@ -1230,21 +1119,35 @@ std::string BamRecord::FetchBases(const BamRecordTag tag,
 Frames BamRecord::FetchFramesRaw(const BamRecordTag tag) const
 {
     Frames frames;
-    const Tag& frameTag = impl_.TagValue(tag);
-    if (frameTag.IsNull())
+
+    // NOTE: htslib returns pointer to the type code, just past the name
+    const bam1_t* b = internal::BamRecordMemory::GetRawData(impl_).get();
+    const std::string label = internal::BamRecordTags::LabelFor(tag);
+    const uint8_t* value = bam_aux_get(b, label.c_str());
+    if (value == nullptr)
         return frames;  // throw ?
 
+    if (value[0] != 'B')
+        throw std::runtime_error("frame data tag is not an array: " + label);
+    const char subType = static_cast<char>(value[1]);
+    uint32_t length;
+    memcpy(&length, value + 2, sizeof(length));
+    const uint8_t* data = value + 2 + sizeof(length);
+
+    // decode straight from the raw tag data, skipping the Tag round-trip
+    std::vector<uint16_t>& frameData = frames.DataRaw();
+    frameData.resize(length);
+
     // lossy frame codes
-    if (frameTag.IsUInt8Array()) {
-        const std::vector<uint8_t> codes = frameTag.ToUInt8Array();
-        frames = Frames::Decode(codes);
-    }
+    if (subType == 'C')
+        Frames::Decode(data, length, frameData.data());
 
     // lossless frame data
-    else {
-        assert(frameTag.IsUInt16Array());
-        frames.Data(frameTag.ToUInt16Array());
-    }
+    else if (subType == 'S')
+        memcpy(frameData.data(), data, length * sizeof(uint16_t));
+
+    else
+        throw std::runtime_error("frame data tag must contain uint8 or uint16 values: " + label);
 
     return frames;
 }
@@ -1253,7 +1156,8 @@ Frames BamRecord::FetchFrames(const BamRecordTag tag,
                               const Orientation orientation,
                               const bool aligned,
                               const bool exciseSoftClips,
-                              const PulseBehavior pulseBehavior) const
+                              const PulseBehavior pulseBehavior,
+                              const internal::ClipAndGapifyPlan* plan) const
 {
     const bool isPulse = internal::BamRecordTags::IsPulse(tag);
 
@@ -1282,10 +1186,10 @@ Frames BamRecord::FetchFrames(const BamRecordTag tag,
         current = Orientation::GENOMIC;
 
         // clip & gapify as requested
-        internal::ClipAndGapifyFrames(impl_,
-                                      aligned,
-                                      exciseSoftClips,
-                                      &frames);
+        if (plan && plan->Matches(impl_))
+            internal::ClipAndGapifyFrames(*plan, &frames);
+        else
+            internal::ClipAndGapifyFrames(internal::ClipAndGapifyPlan{ impl_, aligned, exciseSoftClips }, &frames);
     }
 
     // return in the orientation requested
@@ -1318,7 +1222,8 @@ std::vector<float> BamRecord::FetchPhotons(const BamRecordTag tag,
                                            const Orientation orientation,
                                            const bool aligned,
                                            const bool exciseSoftClips,
-                                           const PulseBehavior pulseBehavior) const
+                                           const PulseBehavior pulseBehavior,
+                                           const internal::ClipAndGapifyPlan* plan) const
 {
     const bool isPulse = internal::BamRecordTags::IsPulse(tag);
 
@@ -1346,10 +1251,10 @@ std::vector<float> BamRecord::FetchPhotons(const BamRecordTag tag,
         current = Orientation::GENOMIC;
 
         // clip & gapify as requested
-        internal::ClipAndGapifyPhotons(impl_,
-                                       aligned,
-                                       exciseSoftClips,
-                                       &data);
+        if (plan && plan->Matches(impl_))
+            internal::ClipAndGapifyPhotons(*plan, &data);
+        else
+            internal::ClipAndGapifyPhotons(internal::ClipAndGapifyPlan{ impl_, aligned, exciseSoftClips }, &data);
     }
 
     // return in the orientation requested
@@ -1362,6 +1267,17 @@ std::vector<float> BamRecord::FetchPhotons(const BamRecordTag tag,
 
 QualityValues BamRecord::FetchQualitiesRaw(const BamRecordTag tag) const
 {
+    // convert straight from the raw tag data, when it's a string
+    const char* raw = internal::RawStringTag(impl_, tag);
+    if (raw) {
+        static_assert(sizeof(QualityValue) == sizeof(uint8_t), "QualityValue must wrap a single byte");
+        QualityValues quals;
+        quals.resize(strlen(raw));
+        if (!quals.empty())
+            internal::FastqToQualities(raw, quals.size(), reinterpret_cast<uint8_t*>(&quals[0]));
+        return quals;
+    }
+
     const Tag& qvsTag = impl_.TagValue(tag);
     return QualityValues::FromFastq(qvsTag.ToString());
 }
@@ -1370,7 +1286,8 @@ QualityValues BamRecord::FetchQualities(const BamRecordTag tag,
                                         const Orientation orientation,
                                         const bool aligned,
                                         const bool exciseSoftClips,
-                                        const PulseBehavior pulseBehavior) const
+                                        const PulseBehavior pulseBehavior,
+                                        const internal::ClipAndGapifyPlan* plan) const
 {
     // requested data info
     const bool isBamQual = (tag == BamRecordTag::QUAL);
@@ -1408,10 +1325,10 @@ QualityValues BamRecord::FetchQualities(const BamRecordTag tag,
         current = Orientation::GENOMIC;
 
         // clip & gapify as requested
-        internal::ClipAndGapifyQualities(impl_,
-                                         aligned,
-                                         exciseSoftClips,
-                                         &quals);
+        if (plan && plan->Matches(impl_))
+            internal::ClipAndGapifyQualities(*plan, &quals);
+        else
+            internal::ClipAndGapifyQualities(internal::ClipAndGapifyPlan{ impl_, aligned, exciseSoftClips }, &quals);
     }
 
     // return in the orientation requested
@@ -1438,7 +1355,8 @@ std::vector<uint32_t> BamRecord::FetchUInts(const BamRecordTag tag,
                                             const Orientation orientation,
                                             const bool aligned,
                                             const bool exciseSoftClips,
-                                            const PulseBehavior pulseBehavior) const
+                                            const PulseBehavior pulseBehavior,
+                                            const internal::ClipAndGapifyPlan* plan) const
 {
     const bool isPulse = internal::BamRecordTags::IsPulse(tag);
 
@@ -1466,10 +1384,10 @@ std::vector<uint32_t> BamRecord::FetchUInts(const BamRecordTag tag,
         current = Orientation::GENOMIC;
 
         // clip & gapify as requested
-        internal::ClipAndGapifyUInts(impl_,
-                                     aligned,
-                                     exciseSoftClips,
-                                     &arr);
+        if (plan && plan->Matches(impl_))
+            internal::ClipAndGapifyUInts(*plan, &arr);
+        else
+            internal::ClipAndGapifyUInts(internal::ClipAndGapifyPlan{ impl_, aligned, exciseSoftClips }, &arr);
     }
 
     // return in the orientation requested
@@ -1808,14 +1726,13 @@ size_t BamRecord::NumMatches(void) const
 std::pair<size_t, size_t> BamRecord::NumMatchesAndMismatches(void) const
 {
     std::pair<size_t, size_t> result = std::make_pair(0,0);
-    PBBAM_SHARED_PTR<bam1_t> b = internal::BamRecordMemory::GetRawData(this);
-    uint32_t* cigarData = bam_get_cigar(b.get());
-    for (uint32_t i = 0; i < b->core.n_cigar; ++i) {
-        const CigarOperationType type = static_cast<CigarOperationType>(bam_cigar_op(cigarData[i]));
+    const CigarView cigar = impl_.CigarDataView();
+    for (auto iter = cigar.cbegin(); iter != cigar.cend(); ++iter) {
+        const CigarOperationType type = iter.Type();
         if (type == CigarOperationType::SEQUENCE_MATCH)
-            result.first += bam_cigar_oplen(cigarData[i]);
+            result.first += iter.Length();
         else if (type == CigarOperationType::SEQUENCE_MISMATCH)
-            result.second += bam_cigar_oplen(cigarData[i]);
+            result.second += iter.Length();
     }
     return result;
 }
@@ -134,14 +134,13 @@ bool BamRecordBuilder::BuildInPlace(BamRecord& record) const
     recordRawData->core = core_;
 
     // setup variable length data
-    const std::vector<uint8_t> encodedTags = BamTagCodec::Encode(tags_);
 
     const size_t nameLength  = name_.size() + 1;
     const size_t numCigarOps = cigar_.size();
     const size_t cigarLength = numCigarOps * sizeof(uint32_t);
     const size_t seqLength   = sequence_.size();
     const size_t qualLength  = seqLength;
-    const size_t tagLength   = encodedTags.size();
+    const size_t tagLength   = BamTagCodec::EncodedSize(tags_);
     const size_t dataLength  = nameLength + cigarLength + seqLength + qualLength + tagLength;
 
     // realloc if necessary
@@ -202,12 +201,8 @@ bool BamRecordBuilder::BuildInPlace(BamRecord& record) const
     }
 
     // tags
-    if (tagLength > 0) {
-        if (encodedTags.empty())
-            throw std::runtime_error("expected tags but none are encoded");
-        memcpy(&varLengthDataBlock[index], &encodedTags[0], tagLength);
-        index += tagLength;
-    }
+    if (tagLength > 0)
+        index += BamTagCodec::Encode(tags_, &varLengthDataBlock[index]);
 
     // sanity check
     if (index != dataLength) {
@@ -37,10 +37,13 @@
 
 #include "pbbam/BamRecordImpl.h"
 #include "pbbam/BamTagCodec.h"
+#include "pbbam/TagEditBatch.h"
 #include "BamRecordTags.h"
 #include "MemoryUtils.h"
+#include "SequenceKernels.h"
 #include <algorithm>
 #include <iostream>
+#include <type_traits>
 #include <utility>
 #include <cassert>
 #include <cstdlib>
@@ -48,6 +51,65 @@
 
 namespace PacBio {
 namespace BAM {
+namespace internal {
+
+// returns number of bytes in a tag's encoded value, starting at (and
+// including) its type code
+static
+size_t TagValueLength(const uint8_t* typeStart)
+{
+    const char tagType = static_cast<char>(typeStart[0]);
+    switch (tagType) {
+        case 'A' :
+        case 'a' :
+        case 'c' :
+        case 'C' :
+            return 1 + 1;
+
+        case 's' :
+        case 'S' :
+            return 1 + 2;
+
+        case 'i' :
+        case 'I' :
+        case 'f' :
+            return 1 + 4;
+
+        case 'Z' :
+        case 'H' :
+            // null-terminated string
+            return 1 + strlen(reinterpret_cast<const char*>(typeStart + 1)) + 1;
+
+        case 'B' :
+        {
+            const char subTagType = static_cast<char>(typeStart[1]);
+            size_t elementSize = 0;
+            switch (subTagType) {
+                case 'c' :
+                case 'C' : elementSize = 1; break;
+                case 's' :
+                case 'S' : elementSize = 2; break;
+                case 'i' :
+                case 'I' :
+                case 'f' : elementSize = 4; break;
+
+                // unknown subTagType
+                default:
+                    throw std::runtime_error("unsupported array-tag-type encountered: " + std::string(1, subTagType));
+            }
+
+            uint32_t numElements = 0;
+            memcpy(&numElements, typeStart + 2, sizeof(uint32_t));
+            return 2 + 4 + (elementSize * numElements);
+        }
+
+        // unknown tagType
+        default:
+            throw std::runtime_error("unsupported tag-type encountered: " + std::string(1, tagType));
+    }
+}
+
+} // namespace internal
 
 BamRecordImpl::BamRecordImpl(void)
     : d_(nullptr)
@@ -137,32 +199,142 @@ bool BamRecordImpl::AddTagImpl(const std::string& tagName,
                                const Tag& value,
                                const TagModifier additionalModifier)
 {
-    const std::vector<uint8_t> rawData = BamTagCodec::ToRawData(value, additionalModifier);
-    if (rawData.empty())
+    const size_t numBytes = BamTagCodec::EncodedSize(value, additionalModifier);
+    if (numBytes == 0)
         return false;
+    const uint8_t typeCode = BamTagCodec::TagTypeCode(value, additionalModifier);
 
-    bam_aux_append(d_.get(),
-                   tagName.c_str(),
-                   BamTagCodec::TagTypeCode(value, additionalModifier),
-                   rawData.size(),
-                   const_cast<uint8_t*>(rawData.data()));
+    // append "<name><type><value>", encoding straight into record
+    const int oldLengthData = d_->l_data;
+    d_->l_data += static_cast<int>(3 + numBytes);
+    MaybeReallocData();
+
+    uint8_t* tagStart = d_->data + oldLengthData;
+    tagStart[0] = static_cast<uint8_t>(tagName[0]);
+    tagStart[1] = static_cast<uint8_t>(tagName[1]);
+    tagStart[2] = typeCode;
+    BamTagCodec::ToRawData(value, additionalModifier, tagStart + 3);
     return true;
 }
 
-Cigar BamRecordImpl::CigarData(void) const
+size_t BamRecordImpl::ApplyTagEdits(const TagEditBatch& batch)
 {
-    Cigar result;
-    result.reserve(d_->core.n_cigar);
-    uint32_t* cigarData = bam_get_cigar(d_);
-    for (uint32_t i = 0; i < d_->core.n_cigar; ++i) {
-        const uint32_t length = bam_cigar_oplen(cigarData[i]);
-        const CigarOperationType type = static_cast<CigarOperationType>(bam_cigar_op(cigarData[i]));
-        result.push_back(CigarOperation(type, length));
+    if (batch.IsEmpty())
+        return 0;
+
+    // index current tags, each pointing at its value bytes in the record
+    struct Entry
+    {
+        uint16_t code_;
+        uint8_t* origValue_;
+        size_t origLength_;
+        const uint8_t* value_;
+        size_t length_;
+        bool removed_;
+    };
+    std::vector<Entry> entries;
+
+    uint8_t* tagStart = bam_get_aux(d_);
+    const size_t oldNumBytes = d_->l_data - (tagStart - d_->data);
+    size_t i = 0;
+    while (i < oldNumBytes) {
+        const uint16_t code = (tagStart[i] << 8) | tagStart[i+1];
+        uint8_t* value = tagStart + i + 2;
+        const size_t length = internal::TagValueLength(value);
+        entries.push_back(Entry{ code, value, length, value, length, false });
+        i += 2 + length;
     }
+    const size_t numOriginalEntries = entries.size();
+
+    // resolve edits, in order, against the index (no record data moves yet)
+    size_t numApplied = 0;
+    for (const TagEditBatch::Edit_& edit : batch.edits_) {
+        if (!edit.valid_)
+            continue;
+
+        auto found = std::find_if(entries.begin(), entries.end(),
+                                  [&edit](const Entry& e)
+                                  { return !e.removed_ && e.code_ == edit.code_; });
+        const bool isPresent = (found != entries.end());
+        const uint8_t* value = batch.data_.data() + edit.offset_;
+
+        switch (edit.type_) {
+            case TagEditBatch::EditType::ADD :
+                if (isPresent)
+                    continue;
+                entries.push_back(Entry{ edit.code_, nullptr, 0, value, edit.length_, false });
+                break;
 
-    return result;
+            case TagEditBatch::EditType::EDIT :
+            case TagEditBatch::EditType::SET :
+                if (isPresent) {
+                    found->value_  = value;
+                    found->length_ = edit.length_;
+                }
+                else if (edit.type_ == TagEditBatch::EditType::SET)
+                    entries.push_back(Entry{ edit.code_, nullptr, 0, value, edit.length_, false });
+                else
+                    continue;
+                break;
+
+            case TagEditBatch::EditType::REMOVE :
+                if (!isPresent)
+                    continue;
+                found->removed_ = true;
+                break;
+
+            default:
+                assert(false);
+                continue;
+        }
+        ++numApplied;
+    }
+    if (numApplied == 0)
+        return 0;
+
+    // if only same-sized overwrites of existing values, write them in place
+    bool inPlace = (entries.size() == numOriginalEntries);
+    size_t newNumBytes = 0;
+    for (const Entry& e : entries) {
+        if (e.removed_ || e.length_ != e.origLength_)
+            inPlace = false;
+        if (!e.removed_)
+            newNumBytes += 2 + e.length_;
+    }
+
+    if (inPlace) {
+        for (const Entry& e : entries) {
+            if (e.value_ != e.origValue_)
+                memcpy(e.origValue_, e.value_, e.length_);
+        }
+        return numApplied;  // tag offsets unchanged
+    }
+
+    // otherwise, rebuild the tag block once
+    std::vector<uint8_t> newTagData;
+    newTagData.reserve(newNumBytes);
+    for (const Entry& e : entries) {
+        if (e.removed_)
+            continue;
+        newTagData.push_back(static_cast<uint8_t>(e.code_ >> 8));
+        newTagData.push_back(static_cast<uint8_t>(e.code_ & 0xff));
+        newTagData.insert(newTagData.end(), e.value_, e.value_ + e.length_);
+    }
+
+    d_->l_data += static_cast<int>(newNumBytes) - static_cast<int>(oldNumBytes);
+    MaybeReallocData();
+    memcpy(bam_get_aux(d_), newTagData.data(), newNumBytes);
+
+    UpdateTagMap();
+    return numApplied;
 }
 
+Cigar BamRecordImpl::CigarData(void) const
+{ return CigarDataView().ToCigar(); }
+
+CigarView BamRecordImpl::CigarDataView(void) const
+{ return CigarView(bam_get_cigar(d_), d_->core.n_cigar); }
+
 BamRecordImpl& BamRecordImpl::CigarData(const Cigar& cigar)
 {
     // determine change in memory needed
@@ -214,16 +386,41 @@ bool BamRecordImpl::EditTag(const std::string& tagName,
                             const Tag& newValue,
                             const TagModifier additionalModifier)
 {
-    // try remove old value (with delayed tag map update)
-    const bool removed = RemoveTagImpl(tagName);
-    if (!removed)
+    if (tagName.size() != 2)
+        return false;
+    const int offset = TagOffset(tagName);
+    if (offset == -1)
         return false;
 
-    // if old value removed, add new value
-    const bool added = AddTagImpl(tagName, newValue, additionalModifier);
-    if (added)
-        UpdateTagMap();
-    return added;
+    const size_t numBytes = BamTagCodec::EncodedSize(newValue, additionalModifier);
+    if (numBytes == 0)
+        return false;
+    const uint8_t typeCode = BamTagCodec::TagTypeCode(newValue, additionalModifier);
+
+    // same encoded size: overwrite in place, no data moves & offsets unchanged
+    uint8_t* value = bam_get_aux(d_) + offset;
+    const size_t oldLength = internal::TagValueLength(value);
+    const size_t newLength = 1 + numBytes;
+    if (newLength == oldLength) {
+        value[0] = typeCode;
+        BamTagCodec::ToRawData(newValue, additionalModifier, value + 1);
+        return true;
+    }
+
+    // otherwise, shift trailing tags & splice new value where the old one was
+    const int oldLengthData = d_->l_data;
+    const size_t valueEnd = (value - d_->data) + oldLength;
+    const size_t trailingDataLength = oldLengthData - valueEnd;
+    d_->l_data += static_cast<int>(newLength) - static_cast<int>(oldLength);
+    MaybeReallocData();
+
+    value = bam_get_aux(d_) + offset;
+    memmove(value + newLength, value + oldLength, trailingDataLength);
+    value[0] = typeCode;
+    BamTagCodec::ToRawData(newValue, additionalModifier, value + 1);
+
+    UpdateTagMap();
+    return true;
 }
 
 bool BamRecordImpl::EditTag(const BamRecordTag tag,
@@ -323,11 +520,14 @@ QualityValues BamRecordImpl::Qualities(void) const
     if (qualData[0] == 0xff)
         return QualityValues();
 
-    const size_t numQuals = d_->core.l_qseq;
+    // %BAM stores raw QVs (no FASTQ offset), so decoding is a straight copy
+    // into the result's own storage
+    static_assert(sizeof(QualityValue) == sizeof(uint8_t) &&
+                  std::is_trivially_copyable<QualityValue>::value,
+                  "QualityValue must be a plain uint8_t wrapper");
     QualityValues result;
-    result.reserve(numQuals);
-    for (size_t i = 0; i < numQuals; ++i)
-        result.push_back(QualityValue(qualData[i]));
+    result.resize(d_->core.l_qseq);
+    memcpy(result.data(), qualData, result.size());
     return result;
 }
 
@@ -355,14 +555,31 @@ bool BamRecordImpl::RemoveTagImpl(const std::string &tagName)
     return ok;
 }
 
+BamRecordImpl& BamRecordImpl::ReserveTagData(const size_t numBytes)
+{
+    const int required = d_->l_data + static_cast<int>(numBytes);
+    if (d_->m_data < required) {
+        d_->m_data = required;
+        kroundup32(d_->m_data);
+        d_->data = static_cast<uint8_t*>(realloc(d_->data, d_->m_data));
+    }
+    return *this;
+}
+
+uint8_t* BamRecordImpl::ResizeTagData(const size_t numBytes)
+{
+    const uint8_t* tagStart = bam_get_aux(d_);
+    const size_t oldNumBytes = d_->l_data - (tagStart - d_->data);
+    d_->l_data += static_cast<int>(numBytes) - static_cast<int>(oldNumBytes);
+    MaybeReallocData();
+    return bam_get_aux(d_);
+}
+
 std::string BamRecordImpl::Sequence(void) const
 {
-    std::string result;
-    result.reserve(d_->core.l_qseq);
-    static const std::string DnaLookup = std::string("=ACMGRSVTWYHKDBN");
-    const uint8_t* seqData = bam_get_seq(d_);
-    for (int i = 0; i < d_->core.l_qseq; ++i)
-        result.append(1, DnaLookup[bam_seqi(seqData, i)]);
+    std::string result(d_->core.l_qseq, '\0');
+    if (!result.empty())
+        internal::DecodeBamSequence(bam_get_seq(d_), result.size(), &result[0]);
     return result;
 }
 
@@ -428,19 +645,15 @@ BamRecordImpl& BamRecordImpl::SetSequenceAndQualitiesInternal(const char* sequen
     if (isPreencoded) {
         memcpy(pEncodedSequence, sequence, encodedSequenceLength);
     } else {
-        memset(pEncodedSequence, 0, encodedSequenceLength);
-        for (size_t i = 0; i < sequenceLength; ++i)
-            pEncodedSequence[i>>1] |= seq_nt16_table[(int)sequence[i]] << ((~i&1)<<2);
+        internal::EncodeBamSequence(sequence, sequenceLength, pEncodedSequence);
     }
 
     // fill in quality values
     uint8_t* encodedQualities = bam_get_qual(d_);
     if ( (qualities == 0 ) || (strlen(qualities) == 0) )
         memset(encodedQualities, 0xff, sequenceLength);
-    else {
-        for (size_t i = 0; i < sequenceLength; ++i)
-            encodedQualities[i] = qualities[i] - 33;  // FASTQ ASCII -> int conversion
-    }
+    else
+        internal::FastqToQualities(qualities, sequenceLength, encodedQualities);
     return *this;
 }
 
@@ -459,21 +672,20 @@ int BamRecordImpl::TagOffset(const std::string& tagName) const
 
 BamRecordImpl& BamRecordImpl::Tags(const TagCollection& tags)
 {
-    // convert tags to binary
-    const std::vector<uint8_t>& tagData = BamTagCodec::Encode(tags);
-    const size_t numBytes = tagData.size();
-    const uint8_t* data = tagData.data();
+    // size tag data & encode directly into record
+    const size_t numBytes = BamTagCodec::EncodedSize(tags);
+    BamTagCodec::Encode(tags, ResizeTagData(numBytes));
 
-    // determine change in memory needed
-    uint8_t* tagStart = bam_get_aux(d_);
-    const size_t oldNumBytes = d_->l_data - (tagStart - d_->data);
-    const int diffNumBytes = numBytes - oldNumBytes;
-    d_->l_data += diffNumBytes;
-    MaybeReallocData();
-    tagStart = bam_get_aux(d_);
+    // update tag info
+    UpdateTagMap();
+    return *this;
+}
 
-    // fill in new tag data
-    memcpy((void*)tagStart, data, numBytes);
+BamRecordImpl& BamRecordImpl::Tags(const FlatTagCollection& tags)
+{
+    // size tag data & encode directly into record
+    const size_t numBytes = BamTagCodec::EncodedSize(tags);
+    BamTagCodec::Encode(tags, ResizeTagData(numBytes));
 
     // update tag info
     UpdateTagMap();
@@ -484,7 +696,21 @@ TagCollection BamRecordImpl::Tags(void) const
 {
     const uint8_t* tagDataStart = bam_get_aux(d_);
     const size_t numBytes = d_->l_data - (tagDataStart - d_->data);
-    return BamTagCodec::Decode(std::vector<uint8_t>(tagDataStart, tagDataStart+numBytes));
+    return BamTagCodec::Decode(tagDataStart, numBytes);
+}
+
+FlatTagCollection BamRecordImpl::FlatTags(void) const
+{
+    FlatTagCollection result;
+    FlatTags(&result);
+    return result;
+}
+
+void BamRecordImpl::FlatTags(FlatTagCollection* tags) const
+{
+    const uint8_t* tagDataStart = bam_get_aux(d_);
+    const size_t numBytes = d_->l_data - (tagDataStart - d_->data);
+    BamTagCodec::Decode(tagDataStart, numBytes, tags);
 }
 
 Tag BamRecordImpl::TagValue(const std::string& tagName) const
@@ -538,66 +764,7 @@ void BamRecordImpl::UpdateTagMap(void) const
         tagOffsets_[tagNameCode] = i;
 
         // skip tag contents
-        const char tagType = static_cast<char>(tagStart[i++]);
-        switch (tagType) {
-            case 'A' :
-            case 'a' :
-            case 'c' :
-            case 'C' :
-            {
-                i += 1;
-                break;
-            }
-            case 's' :
-            case 'S' :
-            {
-                i += 2;
-                break;
-            }
-            case 'i' :
-            case 'I' :
-            case 'f' :
-            {
-                i += 4;
-                break;
-            }
-
-            case 'Z' :
-            case 'H' :
-            {
-                // null-terminated string
-                i += strlen((const char*)&tagStart[i]) + 1;
-                break;
-            }
-
-            case 'B' :
-            {
-                const char subTagType = tagStart[i++];
-                size_t elementSize = 0;
-                switch (subTagType) {
-                    case 'c' :
-                    case 'C' : elementSize = 1; break;
-                    case 's' :
-                    case 'S' : elementSize = 2; break;
-                    case 'i' :
-                    case 'I' :
-                    case 'f' : elementSize = 4; break;
-
-                    // unknown subTagType
-                    default:
-                        throw std::runtime_error("unsupported array-tag-type encountered: " + std::string(1, subTagType));
-                }
-
-                uint32_t numElements = 0;
-                memcpy(&numElements, &tagStart[i], sizeof(uint32_t));
-                i += (4 + (elementSize * numElements));
-                break;
-            }
-
-            // unknown tagType
-            default:
-                throw std::runtime_error("unsupported tag-type encountered: " + std::string(1, tagType));
-        }
+        i += internal::TagValueLength(&tagStart[i]);
     }
 }
 
@@ -0,0 +1,154 @@
+// Copyright (c) 2016, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// File Description
+/// \file BamRecordView.cpp
+/// \brief Implements the BamRecordView class.
+//
+// Author: Derek Barnett
+
+#include "pbbam/BamRecordView.h"
+#include "ClipAndGapifyPlan.h"
+
+namespace PacBio {
+namespace BAM {
+
+BamRecordView::BamRecordView(const BamRecord& record,
+                             const Orientation orientation,
+                             const bool aligned,
+                             const bool exciseSoftClips,
+                             const PulseBehavior pulseBehavior)
+    : record_(record)
+    , orientation_(orientation)
+    , aligned_(aligned)
+    , exciseSoftClips_(exciseSoftClips)
+    , pulseBehavior_(pulseBehavior)
+    , plan_(std::make_shared<internal::ClipAndGapifyPlan>(record.Impl(), aligned, exciseSoftClips))
+{ }
+
+QualityValues BamRecordView::AltLabelQVs(void) const
+{ return record_.FetchQualities(BamRecordTag::ALT_LABEL_QV, orientation_, aligned_, exciseSoftClips_,
+                                pulseBehavior_, plan_.get()); }
+
+std::string BamRecordView::AltLabelTags(void) const
+{ return record_.FetchBases(BamRecordTag::ALT_LABEL_TAG, orientation_, aligned_, exciseSoftClips_,
+                            pulseBehavior_, plan_.get()); }
+
+QualityValues BamRecordView::DeletionQVs(void) const
+{ return record_.FetchQualities(BamRecordTag::DELETION_QV, orientation_, aligned_, exciseSoftClips_,
+                                PulseBehavior::ALL, plan_.get()); }
+
+std::string BamRecordView::DeletionTags(void) const
+{ return record_.FetchBases(BamRecordTag::DELETION_TAG, orientation_, aligned_, exciseSoftClips_,
+                            PulseBehavior::ALL, plan_.get()); }
+
+QualityValues BamRecordView::InsertionQVs(void) const
+{ return record_.FetchQualities(BamRecordTag::INSERTION_QV, orientation_, aligned_, exciseSoftClips_,
+                                PulseBehavior::ALL, plan_.get()); }
+
+Frames BamRecordView::IPD(void) const
+{ return record_.FetchFrames(BamRecordTag::IPD, orientation_, aligned_, exciseSoftClips_,
+                             PulseBehavior::ALL, plan_.get()); }
+
+Frames BamRecordView::PrebaseFrames(void) const
+{ return record_.FetchFrames(BamRecordTag::IPD, orientation_, aligned_, exciseSoftClips_,
+                             PulseBehavior::ALL, plan_.get()); }
+
+QualityValues BamRecordView::LabelQVs(void) const
+{ return record_.FetchQualities(BamRecordTag::LABEL_QV, orientation_, aligned_, exciseSoftClips_,
+                                pulseBehavior_, plan_.get()); }
+
+QualityValues BamRecordView::MergeQVs(void) const
+{ return record_.FetchQualities(BamRecordTag::MERGE_QV, orientation_, aligned_, exciseSoftClips_,
+                                PulseBehavior::ALL, plan_.get()); }
+
+QualityValues BamRecordView::PulseMergeQVs(void) const
+{ return record_.FetchQualities(BamRecordTag::PULSE_MERGE_QV, orientation_, aligned_, exciseSoftClips_,
+                                pulseBehavior_, plan_.get()); }
+
+std::vector<float> BamRecordView::Pkmean(void) const
+{ return record_.FetchPhotons(BamRecordTag::PKMEAN, orientation_, aligned_, exciseSoftClips_,
+                              pulseBehavior_, plan_.get()); }
+
+std::vector<float> BamRecordView::Pkmid(void) const
+{ return record_.FetchPhotons(BamRecordTag::PKMID, orientation_, aligned_, exciseSoftClips_,
+                              pulseBehavior_, plan_.get()); }
+
+std::vector<float> BamRecordView::Pkmean2(void) const
+{ return record_.FetchPhotons(BamRecordTag::PKMEAN_2, orientation_, aligned_, exciseSoftClips_,
+                              pulseBehavior_, plan_.get()); }
+
+std::vector<float> BamRecordView::Pkmid2(void) const
+{ return record_.FetchPhotons(BamRecordTag::PKMID_2, orientation_, aligned_, exciseSoftClips_,
+                              pulseBehavior_, plan_.get()); }
+
+Frames BamRecordView::PrePulseFrames(void) const
+{ return record_.FetchFrames(BamRecordTag::PRE_PULSE_FRAMES, orientation_, aligned_, exciseSoftClips_,
+                             pulseBehavior_, plan_.get()); }
+
+std::string BamRecordView::PulseCalls(void) const
+{ return record_.FetchBases(BamRecordTag::PULSE_CALL, orientation_, aligned_, exciseSoftClips_,
+                            pulseBehavior_, plan_.get()); }
+
+Frames BamRecordView::PulseCallWidth(void) const
+{ return record_.FetchFrames(BamRecordTag::PULSE_CALL_WIDTH, orientation_, aligned_, exciseSoftClips_,
+                             pulseBehavior_, plan_.get()); }
+
+Frames BamRecordView::PulseWidths(void) const
+{ return record_.FetchFrames(BamRecordTag::PULSE_WIDTH, orientation_, aligned_, exciseSoftClips_,
+                             PulseBehavior::ALL, plan_.get()); }
+
+QualityValues BamRecordView::Qualities(void) const
+{ return record_.FetchQualities(BamRecordTag::QUAL, orientation_, aligned_, exciseSoftClips_,
+                                PulseBehavior::ALL, plan_.get()); }
+
+std::string BamRecordView::Sequence(void) const
+{ return record_.FetchBases(BamRecordTag::SEQ, orientation_, aligned_, exciseSoftClips_,
+                            PulseBehavior::ALL, plan_.get()); }
+
+std::vector<uint32_t> BamRecordView::StartFrames(void) const
+{ return record_.FetchUInts(BamRecordTag::START_FRAME, orientation_, aligned_, exciseSoftClips_,
+                            pulseBehavior_, plan_.get()); }
+
+QualityValues BamRecordView::SubstitutionQVs(void) const
+{ return record_.FetchQualities(BamRecordTag::SUBSTITUTION_QV, orientation_, aligned_, exciseSoftClips_,
+                                PulseBehavior::ALL, plan_.get()); }
+
+std::string BamRecordView::SubstitutionTags(void) const
+{ return record_.FetchBases(BamRecordTag::SUBSTITUTION_TAG, orientation_, aligned_, exciseSoftClips_,
+                            PulseBehavior::ALL, plan_.get()); }
+
+} // namespace BAM
+} // namespace PacBio
@@ -40,26 +40,70 @@
 // Author: Derek Barnett
 
 #include "pbbam/BamTagCodec.h"
-#include <htslib/kstring.h>
+#include <string>
+#include <cassert>
 #include <cstring>
 
 namespace PacBio {
 namespace BAM {
 namespace internal {
 
-template<typename T>
-inline void appendBamValue(const T& value, kstring_t* str)
+template<typename T> struct ArrayTypeCode;
+template<> struct ArrayTypeCode<int8_t>   { static const char value = 'c'; };
+template<> struct ArrayTypeCode<uint8_t>  { static const char value = 'C'; };
+template<> struct ArrayTypeCode<int16_t>  { static const char value = 's'; };
+template<> struct ArrayTypeCode<uint16_t> { static const char value = 'S'; };
+template<> struct ArrayTypeCode<int32_t>  { static const char value = 'i'; };
+template<> struct ArrayTypeCode<uint32_t> { static const char value = 'I'; };
+template<> struct ArrayTypeCode<float>    { static const char value = 'f'; };
+
+// Writes a tag value's BAM bytes (no name or type code, but including the
+// element type for arrays) to dest. With a null dest, only measures them.
+class RawValueEncoder : public boost::static_visitor<size_t>
 {
-    kputsn_((char*)&value, sizeof(value), str);
-}
+public:
+    explicit RawValueEncoder(uint8_t* dest)
+        : dest_(dest)
+    { }
+
+    size_t operator()(const boost::blank&) const
+    {
+        throw std::runtime_error("unsupported tag-type encountered: " +
+                                 std::to_string(static_cast<uint16_t>(TagDataType::INVALID)));
+    }
 
-template<typename T>
-inline void appendBamMultiValue(const std::vector<T>& container, kstring_t* str)
-{
-    const uint32_t n = container.size();
-    kputsn_(&n, sizeof(n), str);
-    kputsn_((char*)&container[0], n*sizeof(T), str);
-}
+    size_t operator()(const std::string& value) const
+    {
+        const size_t numBytes = value.size() + 1; // includes null-term
+        if (dest_)
+            memcpy(dest_, value.c_str(), numBytes);
+        return numBytes;
+    }
+
+    template<typename T>
+    size_t operator()(const std::vector<T>& value) const
+    {
+        const uint32_t numElements = value.size();
+        if (dest_) {
+            dest_[0] = ArrayTypeCode<T>::value;
+            memcpy(dest_ + 1, &numElements, sizeof(uint32_t));
+            if (numElements > 0)
+                memcpy(dest_ + 5, value.data(), numElements * sizeof(T));
+        }
+        return 1 + sizeof(uint32_t) + (numElements * sizeof(T));
+    }
+
+    template<typename T>
+    size_t operator()(const T& value) const
+    {
+        if (dest_)
+            memcpy(dest_, &value, sizeof(T));
+        return sizeof(T);
+    }
+
+private:
+    uint8_t* dest_;
+};
 
 template<typename T>
 inline T readBamValue(const uint8_t* src, size_t& offset)
@@ -77,298 +121,130 @@ std::vector<T> readBamMultiValue(const uint8_t* src, size_t& offset)
     memcpy(&numElements, &src[offset], sizeof(uint32_t));
     offset += 4;
 
-    std::vector<T> result;
-    result.reserve(numElements);
-    for (size_t i = 0; i < numElements; ++i) {
-        const T& value = readBamValue<T>(src, offset);
-        result.push_back(value);
-    }
+    std::vector<T> result(numElements);
+    if (numElements > 0)
+        memcpy(&result[0], &src[offset], numElements * sizeof(T));
+    offset += numElements * sizeof(T);
     return result;
 }
 
+// type code for whole-collection encoding, where ASCII chars are handled
+// separately (& a null char falls back to its integer type)
+static
+char EntryTypeCode(const Tag& tag)
+{
+    switch (tag.Type()) {
+        case TagDataType::INT8   : return 'c';
+        case TagDataType::UINT8  : return 'C';
+        case TagDataType::INT16  : return 's';
+        case TagDataType::UINT16 : return 'S';
+        case TagDataType::INT32  : return 'i';
+        case TagDataType::UINT32 : return 'I';
+        case TagDataType::FLOAT  : return 'f';
+        case TagDataType::STRING :
+            return tag.HasModifier(TagModifier::HEX_STRING) ? 'H' : 'Z';
+
+        case TagDataType::INT8_ARRAY   : // fall through
+        case TagDataType::UINT8_ARRAY  : // .
+        case TagDataType::INT16_ARRAY  : // .
+        case TagDataType::UINT16_ARRAY : // .
+        case TagDataType::INT32_ARRAY  : // .
+        case TagDataType::UINT32_ARRAY : // .
+        case TagDataType::FLOAT_ARRAY  : return 'B';
+
+        default:
+            throw std::runtime_error("unsupported tag-type encountered: " +
+                                     std::to_string(static_cast<uint16_t>(tag.Type())));
+    }
+}
+
 } // namespace internal
 
 TagCollection BamTagCodec::Decode(const std::vector<uint8_t>& data)
+{
+    return Decode(data.data(), data.size());
+}
+
+TagCollection BamTagCodec::Decode(const uint8_t* data, const size_t numBytes)
 {
     TagCollection tags;
 
     // NOTE: not completely safe - no real bounds-checking yet on input data
 
-    const uint8_t* pData  = data.data();
-    const size_t numBytes = data.size();
     size_t i = 0;
     while (i < numBytes) {
-
-        std::string tagName;
-        tagName.reserve(2);
-        tagName.append(1, pData[i++]);
-        tagName.append(1, pData[i++]);
-
-        using internal::readBamMultiValue;
-        using internal::readBamValue;
-
-        const char tagType = static_cast<char>(pData[i++]);
-        switch (tagType) {
-            case 'A' :
-            case 'a' :
-            {
-                tags[tagName] = readBamValue<uint8_t>(pData, i);
-                tags[tagName].Modifier(TagModifier::ASCII_CHAR);
-                break;
-            }
-
-            case 'c' : tags[tagName] = readBamValue<int8_t>(pData, i);   break;
-            case 'C' : tags[tagName] = readBamValue<uint8_t>(pData, i);  break;
-            case 's' : tags[tagName] = readBamValue<int16_t>(pData, i);  break;
-            case 'S' : tags[tagName] = readBamValue<uint16_t>(pData, i); break;
-            case 'i' : tags[tagName] = readBamValue<int32_t>(pData, i);  break;
-            case 'I' : tags[tagName] = readBamValue<uint32_t>(pData, i); break;
-            case 'f' : tags[tagName] = readBamValue<float>(pData, i);    break;
-
-            case 'Z' :
-            case 'H' :
-            {
-                const size_t dataLength = strlen((const char*)&pData[i]);
-                std::string value;
-                value.resize(dataLength);
-                memcpy((char*)value.data(), &pData[i], dataLength);
-                tags[tagName] = value;
-                if (tagType == 'H')
-                    tags[tagName].Modifier(TagModifier::HEX_STRING);
-                i += dataLength + 1;
-                break;
-            }
-
-            case 'B' :
-            {
-                const char subTagType = pData[i++];
-                switch (subTagType) {
-                    case 'c' : tags[tagName] = readBamMultiValue<int8_t>(pData, i);   break;
-                    case 'C' : tags[tagName] = readBamMultiValue<uint8_t>(pData, i);  break;
-                    case 's' : tags[tagName] = readBamMultiValue<int16_t>(pData, i);  break;
-                    case 'S' : tags[tagName] = readBamMultiValue<uint16_t>(pData, i); break;
-                    case 'i' : tags[tagName] = readBamMultiValue<int32_t>(pData, i);  break;
-                    case 'I' : tags[tagName] = readBamMultiValue<uint32_t>(pData, i); break;
-                    case 'f' : tags[tagName] = readBamMultiValue<float>(pData, i);    break;
-
-                    // unknown subTagType
-                    default:
-                        throw std::runtime_error("unsupported array-tag-type encountered: " + std::string(1, subTagType));
-                }
-                break;
-            }
-
-            // unknown tagType
-            default:
-                throw std::runtime_error("unsupported tag-type encountered: " + std::string(1, tagType));
-        }
+        const std::string tagName(reinterpret_cast<const char*>(&data[i]), 2);
+        i += 2;
+        i += DecodeValue(&data[i], &tags[tagName]);
     }
-
     return tags;
 }
 
-std::vector<uint8_t> BamTagCodec::Encode(const TagCollection& tags)
+void BamTagCodec::Decode(const uint8_t* data,
+                         const size_t numBytes,
+                         FlatTagCollection* tags)
 {
-    kstring_t str = { 0, 0, NULL };
-
-    const auto tagEnd  = tags.cend();
-    for (auto tagIter = tags.cbegin(); tagIter != tagEnd; ++tagIter) {
-
-        const std::string& name = (*tagIter).first;
-        if (name.size() != 2)
-            throw std::runtime_error("malformatted tag name: " + name);
-        const Tag& tag = (*tagIter).second;
-        if (tag.IsNull())
-            continue;
-
-        // "<TAG>:"
-        kputsn_(name.c_str(), 2, &str);
-
-        // "<TYPE>:<DATA>" for printable, ASCII char
-        if (tag.HasModifier(TagModifier::ASCII_CHAR)) {
-            char c = tag.ToAscii();
-            if (c != '\0') {
-                kputc_('A', &str);
-                kputc_(c, &str);
-                continue;
-            }
-        }
-
-        using internal::appendBamMultiValue;
-        using internal::appendBamValue;
-
-        // "<TYPE>:<DATA>" for all other data
-        switch ( tag.Type() ) {
-            case TagDataType::INT8   :
-            {
-                kputc_('c', &str);
-                appendBamValue(tag.ToInt8(), &str);
-                break;
-            }
-            case TagDataType::UINT8  :
-            {
-                kputc_('C', &str);
-                appendBamValue(tag.ToUInt8(), &str);
-                break;
-            }
-            case TagDataType::INT16  :
-            {
-                kputc_('s', &str);
-                appendBamValue(tag.ToInt16(), &str);
-                break;
-            }
-            case TagDataType::UINT16 :
-            {
-                kputc_('S', &str);
-                appendBamValue(tag.ToUInt16(), &str);
-                break;
-            }
-            case TagDataType::INT32  :
-            {
-                kputc_('i', &str);
-                appendBamValue(tag.ToInt32(), &str);
-                break;
-            }
-            case TagDataType::UINT32 :
-            {
-                kputc_('I', &str);
-                appendBamValue(tag.ToUInt32(), &str);
-                break;
-            }
-            case TagDataType::FLOAT :
-            {
-                kputc_('f', &str);
-                appendBamValue(tag.ToFloat(), &str);
-                break;
-            }
+    assert(tags);
+    tags->clear();
 
-            case TagDataType::STRING :
-            {
-                if (tag.HasModifier(TagModifier::HEX_STRING))
-                    kputc_('H', &str);
-                else
-                    kputc_('Z', &str);
-                const std::string& s = tag.ToString();
-                kputsn_(s.c_str(), s.size()+1, &str); // this adds the null-term
-                break;
-            }
-
-            case TagDataType::INT8_ARRAY   :
-            {
-                kputc_('B', &str);
-                kputc_('c', &str);
-                appendBamMultiValue(tag.ToInt8Array(), &str);
-                break;
-            }
-            case TagDataType::UINT8_ARRAY  :
-            {
-                kputc_('B', &str);
-                kputc_('C', &str);
-                appendBamMultiValue(tag.ToUInt8Array(), &str);
-                break;
-            }
-            case TagDataType::INT16_ARRAY  :
-            {
-                kputc_('B', &str);
-                kputc_('s', &str);
-                appendBamMultiValue(tag.ToInt16Array(), &str);
-                break;
-            }
-            case TagDataType::UINT16_ARRAY :
-            {
-                kputc_('B', &str);
-                kputc_('S', &str);
-                appendBamMultiValue(tag.ToUInt16Array(), &str);
-                break;
-            }
-            case TagDataType::INT32_ARRAY  :
-            {
-                kputc_('B', &str);
-                kputc_('i', &str);
-                appendBamMultiValue(tag.ToInt32Array(), &str);
-                break;
-            }
-            case TagDataType::UINT32_ARRAY :
-            {
-                kputc_('B', &str);
-                kputc_('I', &str);
-                appendBamMultiValue(tag.ToUInt32Array(), &str);
-                break;
-            }
-            case TagDataType::FLOAT_ARRAY :
-            {
-                kputc_('B', &str);
-                kputc_('f', &str);
-                appendBamMultiValue(tag.ToFloatArray(), &str);
-                break;
-            }
-
-            // unsupported tag type
-            default :
-            {
-                free(str.s);
-                throw std::runtime_error("unsupported tag-type encountered: " +
-                                         std::to_string(static_cast<uint16_t>(tag.Type())));
-            }
-        }
+    size_t i = 0;
+    while (i < numBytes) {
+        tags->emplace_back(std::string(reinterpret_cast<const char*>(&data[i]), 2), Tag());
+        i += 2;
+        i += DecodeValue(&data[i], &tags->back().second);
     }
-
-    std::vector<uint8_t> result;
-    result.resize(str.l);
-    memcpy((char*)&result[0], str.s, str.l);
-    free(str.s);
-    return result;
 }
 
-Tag BamTagCodec::FromRawData(uint8_t* rawData)
+size_t BamTagCodec::DecodeValue(const uint8_t* typeStart, Tag* tag)
 {
     using internal::readBamMultiValue;
     using internal::readBamValue;
 
+    assert(tag);
+    tag->modifier_ = TagModifier::NONE;
+
+    const uint8_t* rawData = typeStart + 1;
     size_t offset = 0;
-    const char tagType = static_cast<char>(*rawData++);
+    const char tagType = static_cast<char>(typeStart[0]);
     switch (tagType) {
         case 'A' :
         case 'a' :
         {
-            Tag t = Tag(readBamValue<uint8_t>(rawData, offset));
-            t.Modifier(TagModifier::ASCII_CHAR);
-            return t;
+            tag->data_ = readBamValue<uint8_t>(rawData, offset);
+            tag->modifier_ = TagModifier::ASCII_CHAR;
+            break;
         }
 
-        case 'c' : return Tag(readBamValue<int8_t>(rawData, offset));
-        case 'C' : return Tag(readBamValue<uint8_t>(rawData, offset));
-        case 's' : return Tag(readBamValue<int16_t>(rawData, offset));
-        case 'S' : return Tag(readBamValue<uint16_t>(rawData, offset));
-        case 'i' : return Tag(readBamValue<int32_t>(rawData, offset));
-        case 'I' : return Tag(readBamValue<uint32_t>(rawData, offset));
-        case 'f' : return Tag(readBamValue<float>(rawData, offset));
+        case 'c' : tag->data_ = readBamValue<int8_t>(rawData, offset);   break;
+        case 'C' : tag->data_ = readBamValue<uint8_t>(rawData, offset);  break;
+        case 's' : tag->data_ = readBamValue<int16_t>(rawData, offset);  break;
+        case 'S' : tag->data_ = readBamValue<uint16_t>(rawData, offset); break;
+        case 'i' : tag->data_ = readBamValue<int32_t>(rawData, offset);  break;
+        case 'I' : tag->data_ = readBamValue<uint32_t>(rawData, offset); break;
+        case 'f' : tag->data_ = readBamValue<float>(rawData, offset);    break;
 
         case 'Z' :
         case 'H' :
         {
-            const size_t dataLength = strlen((const char*)&rawData[0]);
-            std::string value;
-            value.resize(dataLength);
-            memcpy((char*)value.data(), &rawData[0], dataLength);
-            Tag t(value);
+            const size_t dataLength = strlen(reinterpret_cast<const char*>(rawData));
+            tag->data_ = std::string(reinterpret_cast<const char*>(rawData), dataLength);
             if (tagType == 'H')
-                t.Modifier(TagModifier::HEX_STRING);
-            return t;
+                tag->modifier_ = TagModifier::HEX_STRING;
+            offset += dataLength + 1;
+            break;
         }
 
         case 'B' :
         {
-            const char subTagType = *rawData++;
+            const char subTagType = static_cast<char>(rawData[offset++]);
             switch (subTagType) {
-
-                case 'c' : return Tag(readBamMultiValue<int8_t>(rawData, offset));
-                case 'C' : return Tag(readBamMultiValue<uint8_t>(rawData, offset));
-                case 's' : return Tag(readBamMultiValue<int16_t>(rawData, offset));
-                case 'S' : return Tag(readBamMultiValue<uint16_t>(rawData, offset));
-                case 'i' : return Tag(readBamMultiValue<int32_t>(rawData, offset));
-                case 'I' : return Tag(readBamMultiValue<uint32_t>(rawData, offset));
-                case 'f' : return Tag(readBamMultiValue<float>(rawData, offset));
+                case 'c' : tag->data_ = readBamMultiValue<int8_t>(rawData, offset);   break;
+                case 'C' : tag->data_ = readBamMultiValue<uint8_t>(rawData, offset);  break;
+                case 's' : tag->data_ = readBamMultiValue<int16_t>(rawData, offset);  break;
+                case 'S' : tag->data_ = readBamMultiValue<uint16_t>(rawData, offset); break;
+                case 'i' : tag->data_ = readBamMultiValue<int32_t>(rawData, offset);  break;
+                case 'I' : tag->data_ = readBamMultiValue<uint32_t>(rawData, offset); break;
+                case 'f' : tag->data_ = readBamMultiValue<float>(rawData, offset);    break;
 
                 // unknown subTagType
                 default:
@@ -381,109 +257,139 @@ Tag BamTagCodec::FromRawData(uint8_t* rawData)
         default:
             throw std::runtime_error("unsupported tag-type encountered: " + std::string(1, tagType));
     }
-    return Tag(); // to avoid compiler warning
+
+    return 1 + offset;
 }
 
-std::vector<uint8_t> BamTagCodec::ToRawData(const Tag& tag,
-                                            const TagModifier& additionalModifier)
+std::vector<uint8_t> BamTagCodec::Encode(const TagCollection& tags)
 {
-    // temp raw data destination (for use with htslib methods)
-    kstring_t str = { 0, 0, NULL };
+    std::vector<uint8_t> result(EncodedSize(tags));
+    if (!result.empty())
+        Encode(tags, &result[0]);
+    return result;
+}
 
-    // "<TYPE>:<DATA>" for printable, ASCII char
-    if (tag.HasModifier(TagModifier::ASCII_CHAR) || additionalModifier == TagModifier::ASCII_CHAR) {
-        const char c = tag.ToAscii();
-        if (c != '\0')
-            kputc_(c, &str);
-    }
+std::vector<uint8_t> BamTagCodec::Encode(const FlatTagCollection& tags)
+{
+    std::vector<uint8_t> result(EncodedSize(tags));
+    if (!result.empty())
+        Encode(tags, &result[0]);
+    return result;
+}
 
-    // for all others
-    else {
+size_t BamTagCodec::Encode(const TagCollection& tags, uint8_t* dest)
+{
+    size_t numBytes = 0;
+    for (const auto& entry : tags)
+        numBytes += EncodeEntry(entry.first, entry.second, dest + numBytes);
+    return numBytes;
+}
 
-        using internal::appendBamMultiValue;
-        using internal::appendBamValue;
+size_t BamTagCodec::Encode(const FlatTagCollection& tags, uint8_t* dest)
+{
+    size_t numBytes = 0;
+    for (const auto& entry : tags)
+        numBytes += EncodeEntry(entry.first, entry.second, dest + numBytes);
+    return numBytes;
+}
 
-        switch (tag.Type()) {
+size_t BamTagCodec::EncodedSize(const TagCollection& tags)
+{
+    size_t numBytes = 0;
+    for (const auto& entry : tags)
+        numBytes += EncodeEntry(entry.first, entry.second, nullptr);
+    return numBytes;
+}
 
-            // single, numeric values
-            case TagDataType::INT8   : appendBamValue(tag.ToInt8(),   &str); break;
-            case TagDataType::UINT8  : appendBamValue(tag.ToUInt8(),  &str); break;
-            case TagDataType::INT16  : appendBamValue(tag.ToInt16(),  &str); break;
-            case TagDataType::UINT16 : appendBamValue(tag.ToUInt16(), &str); break;
-            case TagDataType::INT32  : appendBamValue(tag.ToInt32(),  &str); break;
-            case TagDataType::UINT32 : appendBamValue(tag.ToUInt32(), &str); break;
-            case TagDataType::FLOAT  : appendBamValue(tag.ToFloat(),  &str); break;
-
-            // string & hex-string values
-            case TagDataType::STRING :
-            {
-                const std::string& s = tag.ToString();
-                kputsn_(s.c_str(), s.size()+1, &str); // this adds the null-term
-                break;
-            }
+size_t BamTagCodec::EncodedSize(const FlatTagCollection& tags)
+{
+    size_t numBytes = 0;
+    for (const auto& entry : tags)
+        numBytes += EncodeEntry(entry.first, entry.second, nullptr);
+    return numBytes;
+}
 
-            // array-type values
-            case TagDataType::INT8_ARRAY   :
-            {
-                kputc_('c', &str);
-                appendBamMultiValue(tag.ToInt8Array(), &str);
-                break;
-            }
-            case TagDataType::UINT8_ARRAY  :
-            {
-                kputc_('C', &str);
-                appendBamMultiValue(tag.ToUInt8Array(), &str);
-                break;
-            }
-            case TagDataType::INT16_ARRAY  :
-            {
-                kputc_('s', &str);
-                appendBamMultiValue(tag.ToInt16Array(), &str);
-                break;
-            }
-            case TagDataType::UINT16_ARRAY :
-            {
-                kputc_('S', &str);
-                appendBamMultiValue(tag.ToUInt16Array(), &str);
-                break;
-            }
-            case TagDataType::INT32_ARRAY  :
-            {
-                kputc_('i', &str);
-                appendBamMultiValue(tag.ToInt32Array(), &str);
-                break;
-            }
-            case TagDataType::UINT32_ARRAY :
-            {
-                kputc_('I', &str);
-                appendBamMultiValue(tag.ToUInt32Array(), &str);
-                break;
-            }
-            case TagDataType::FLOAT_ARRAY :
-            {
-                kputc_('f', &str);
-                appendBamMultiValue(tag.ToFloatArray(), &str);
-                break;
-            }
+size_t BamTagCodec::EncodedSize(const Tag& tag,
+                                const TagModifier& additionalModifier)
+{
+    return EncodeValue(tag, additionalModifier, nullptr);
+}
 
-            // unsupported tag type
-            default :
-            {
-                free(str.s);
-                throw std::runtime_error("unsupported tag-type encountered: " +
-                                         std::to_string(static_cast<uint16_t>(tag.Type())));
+size_t BamTagCodec::EncodeEntry(const std::string& name,
+                                const Tag& tag,
+                                uint8_t* dest)
+{
+    if (name.size() != 2)
+        throw std::runtime_error("malformatted tag name: " + name);
+    if (tag.IsNull())
+        return 0;
+
+    // "<TAG>:"
+    if (dest) {
+        dest[0] = static_cast<uint8_t>(name[0]);
+        dest[1] = static_cast<uint8_t>(name[1]);
+    }
+
+    // "<TYPE>:<DATA>" for printable, ASCII char
+    if (tag.HasModifier(TagModifier::ASCII_CHAR)) {
+        const char c = tag.ToAscii();
+        if (c != '\0') {
+            if (dest) {
+                dest[2] = 'A';
+                dest[3] = static_cast<uint8_t>(c);
             }
+            return 4;
         }
     }
 
-    // store temp contents in actual destination
-    std::vector<uint8_t> result;
-    result.resize(str.l);
-    memcpy((char*)&result[0], str.s, str.l);
-    free(str.s);
+    // "<TYPE>:<DATA>" for all other data
+    const char typeCode = internal::EntryTypeCode(tag);
+    if (dest)
+        dest[2] = static_cast<uint8_t>(typeCode);
+    return 3 + boost::apply_visitor(internal::RawValueEncoder(dest ? dest + 3 : nullptr), tag.data_);
+}
+
+size_t BamTagCodec::EncodeValue(const Tag& tag,
+                                const TagModifier& additionalModifier,
+                                uint8_t* dest)
+{
+    // printable, ASCII char
+    if (tag.HasModifier(TagModifier::ASCII_CHAR) || additionalModifier == TagModifier::ASCII_CHAR) {
+        const char c = tag.ToAscii();
+        if (c == '\0')
+            return 0;
+        if (dest)
+            dest[0] = static_cast<uint8_t>(c);
+        return 1;
+    }
+
+    // for all others
+    return boost::apply_visitor(internal::RawValueEncoder(dest), tag.data_);
+}
+
+Tag BamTagCodec::FromRawData(uint8_t* rawData)
+{
+    Tag result;
+    DecodeValue(rawData, &result);
     return result;
 }
 
+std::vector<uint8_t> BamTagCodec::ToRawData(const Tag& tag,
+                                            const TagModifier& additionalModifier)
+{
+    std::vector<uint8_t> result(EncodedSize(tag, additionalModifier));
+    if (!result.empty())
+        EncodeValue(tag, additionalModifier, &result[0]);
+    return result;
+}
+
+size_t BamTagCodec::ToRawData(const Tag& tag,
+                              const TagModifier& additionalModifier,
+                              uint8_t* dest)
+{
+    return EncodeValue(tag, additionalModifier, dest);
+}
+
 uint8_t BamTagCodec::TagTypeCode(const Tag& tag,
                                  const TagModifier& additionalModifier)
 {
@@ -0,0 +1,238 @@
+// Copyright (c) 2016, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// Author: Derek Barnett
+
+#include "BgzfBlockCache.h"
+#include <htslib/hfile.h>
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <cstring>
+#include <sys/stat.h>
+
+namespace PacBio {
+namespace BAM {
+namespace internal {
+
+BgzfBlockPtr ReadBgzfBlock(const RandomAccessFile& file, const int64_t offset)
+{
+    const size_t maxLength =
+        static_cast<size_t>(std::min(static_cast<int64_t>(BgzfUtils::MaxBlockSize),
+                                     file.Size() - offset));
+    std::vector<uint8_t> compressed(maxLength);
+    const size_t numRead = file.ReadAt(offset, compressed.data(), maxLength);
+    if (numRead == 0)
+        throw std::runtime_error("unexpected end of BAM file: " + std::to_string(offset));
+
+    auto block = std::make_shared<BgzfBlock>();
+    block->compressedSize = BgzfUtils::InflateBlock(compressed.data(), numRead, &block->data);
+    return block;
+}
+
+FileIdentity FileIdentity::FromFilename(const std::string& filename)
+{
+    FileIdentity result = { false, 0, 0, 0, 0 };
+    struct stat s;
+    if (::stat(filename.c_str(), &s) == 0 && S_ISREG(s.st_mode)) {
+        result.valid    = true;
+        result.device   = static_cast<uint64_t>(s.st_dev);
+        result.inode    = static_cast<uint64_t>(s.st_ino);
+        result.size     = static_cast<int64_t>(s.st_size);
+        result.modified = static_cast<int64_t>(s.st_mtime);
+    }
+    return result;
+}
+
+BgzfBlockCache::BgzfBlockCache(const size_t maxBytes)
+    : maxBytes_(maxBytes)
+    , numBytes_(0)
+{ }
+
+void BgzfBlockCache::Clear(void)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    lookup_.clear();
+    numBytes_ = 0;
+}
+
+void BgzfBlockCache::EvictAsNeeded(void)
+{
+    while (numBytes_ > maxBytes_ && !entries_.empty()) {
+        const Entry& last = entries_.back();
+        numBytes_ -= last.second->data.size();
+        lookup_.erase(last.first);
+        entries_.pop_back();
+    }
+}
+
+BgzfBlockPtr BgzfBlockCache::Find(const BgzfBlockKey& key)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto found = lookup_.find(key);
+    if (found == lookup_.end())
+        return BgzfBlockPtr{ };
+
+    // mark as most recently used
+    entries_.splice(entries_.begin(), entries_, found->second);
+    return found->second->second;
+}
+
+void BgzfBlockCache::Insert(const BgzfBlockKey& key, BgzfBlockPtr block)
+{
+    if (!block)
+        return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (block->data.size() > maxBytes_)
+        return;
+
+    const auto found = lookup_.find(key);
+    if (found != lookup_.end()) {
+        numBytes_ -= found->second->second->data.size();
+        entries_.erase(found->second);
+        lookup_.erase(found);
+    }
+
+    numBytes_ += block->data.size();
+    entries_.emplace_front(key, std::move(block));
+    lookup_[key] = entries_.begin();
+    EvictAsNeeded();
+}
+
+size_t BgzfBlockCache::MaxBytes(void) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return maxBytes_;
+}
+
+void BgzfBlockCache::MaxBytes(const size_t maxBytes)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    maxBytes_ = maxBytes;
+    EvictAsNeeded();
+}
+
+size_t BgzfBlockCache::NumBytes(void) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return numBytes_;
+}
+
+// process-wide cache, disabled (and empty) by default
+static std::atomic<bool> sharedCacheEnabled(false);
+
+BgzfBlockCache& SharedBgzfBlockCache(void)
+{
+    static BgzfBlockCache cache(0);
+    return cache;
+}
+
+bool SharedBgzfBlockCacheEnabled(void)
+{ return sharedCacheEnabled.load(); }
+
+void SharedBgzfBlockCacheEnabled(const bool enabled)
+{ sharedCacheEnabled.store(enabled); }
+
+// Installing a cached block means writing BGZF fields that htslib considers
+// its own. We only do so against the bundled htslib (1.1), where this mirrors
+// bgzf.c's load_block_from_cache() exactly:
+//
+//   - uncompressed_block : holds the inflated block (BGZF_MAX_BLOCK_SIZE bytes)
+//   - block_length       : inflated size; 0 means "not loaded", forcing a read
+//   - block_address      : compressed offset of the current block
+//   - block_offset       : read position within the inflated block
+//   - fp (hFILE)         : positioned at the start of the following block
+//
+// Later htslib releases add reader threads, block_clength & seek bookkeeping
+// (and define HTS_VERSION in hts.h), so any other htslib only gets plain
+// bgzf_seek().
+//
+#if defined(PBBAM_BUNDLED_HTSLIB) && !defined(HTS_VERSION)
+#define PBBAM_BGZF_BLOCK_INSTALL 1
+#endif
+
+int CachedBgzfSeek(BGZF* fp, const FileIdentity& file, const int64_t virtualOffset)
+{
+#ifndef PBBAM_BGZF_BLOCK_INSTALL
+    (void)file;
+    return bgzf_seek(fp, virtualOffset, SEEK_SET);
+#else
+    // only plain, single-threaded BGZF reading can use cached blocks
+    if (!SharedBgzfBlockCacheEnabled() || !file.valid ||
+        fp->is_write || !fp->is_compressed || fp->is_gzip || fp->mt)
+    {
+        return bgzf_seek(fp, virtualOffset, SEEK_SET);
+    }
+
+    const int64_t blockAddress = BgzfUtils::CompressedOffset(virtualOffset);
+    const int blockOffset = static_cast<int>(BgzfUtils::UncompressedOffset(virtualOffset));
+    const BgzfBlockKey key = { file, blockAddress };
+    BgzfBlockCache& cache = SharedBgzfBlockCache();
+
+    // cache hit: install inflated data & position the file at the next block
+    const BgzfBlockPtr block = cache.Find(key);
+    if (block && static_cast<size_t>(blockOffset) <= block->data.size()) {
+        if (hseek(fp->fp, blockAddress + block->compressedSize, SEEK_SET) < 0) {
+            fp->errcode |= BGZF_ERR_IO;
+            return -1;
+        }
+        memcpy(fp->uncompressed_block, block->data.data(), block->data.size());
+        fp->block_length  = static_cast<int>(block->data.size());
+        fp->block_address = blockAddress;
+        fp->block_offset  = blockOffset;
+        return 0;
+    }
+
+    // cache miss: seek & load block as usual, then store a copy
+    if (bgzf_seek(fp, virtualOffset, SEEK_SET) != 0)
+        return -1;
+    if (bgzf_read_block(fp) != 0)
+        return -1;
+    if (fp->block_length > 0 && fp->block_address == blockAddress) {
+        auto newBlock = std::make_shared<BgzfBlock>();
+        const uint8_t* data = static_cast<const uint8_t*>(fp->uncompressed_block);
+        newBlock->data.assign(data, data + fp->block_length);
+        newBlock->compressedSize = static_cast<size_t>(htell(fp->fp) - blockAddress);
+        cache.Insert(key, std::move(newBlock));
+    }
+    return 0;
+#endif // PBBAM_BGZF_BLOCK_INSTALL
+}
+
+} // namespace internal
+} // namespace BAM
+} // namespace PacBio
@@ -0,0 +1,205 @@
+// Copyright (c) 2016, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// Author: Derek Barnett
+
+#ifndef BGZFBLOCKCACHE_H
+#define BGZFBLOCKCACHE_H
+
+#include "BgzfUtils.h"
+#include <htslib/bgzf.h>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace PacBio {
+namespace BAM {
+namespace internal {
+
+/// \internal
+///
+/// One inflated BGZF block.
+///
+struct BgzfBlock
+{
+    std::vector<uint8_t> data;  // inflated contents
+    size_t compressedSize;      // size on disk, so next block starts at offset + compressedSize
+};
+
+typedef std::shared_ptr<const BgzfBlock> BgzfBlockPtr;
+
+/// \internal
+///
+/// Identifies a file on disk, independent of the name used to open it.
+/// Size & modification time are included so that a replaced file does not
+/// match stale cache entries.
+///
+struct FileIdentity
+{
+    bool     valid;
+    uint64_t device;
+    uint64_t inode;
+    int64_t  size;
+    int64_t  modified;
+
+    /// \returns identity of file, or an invalid identity if the file cannot be
+    ///          stat'd (e.g. a stream or remote URL)
+    static FileIdentity FromFilename(const std::string& filename);
+
+    bool operator==(const FileIdentity& other) const
+    {
+        return valid    == other.valid  &&
+               device   == other.device &&
+               inode    == other.inode  &&
+               size     == other.size   &&
+               modified == other.modified;
+    }
+};
+
+/// \internal
+///
+/// Cache key for an inflated BGZF block: (file, compressed offset)
+///
+struct BgzfBlockKey
+{
+    FileIdentity file;
+    int64_t offset;
+
+    bool operator==(const BgzfBlockKey& other) const
+    { return offset == other.offset && file == other.file; }
+};
+
+struct BgzfBlockKeyHash
+{
+    size_t operator()(const BgzfBlockKey& key) const
+    {
+        size_t seed = std::hash<int64_t>()(key.offset);
+        const auto combine = [&seed](const size_t h)
+        { seed ^= h + 0x9e3779b9 + (seed << 6) + (seed >> 2); };
+        combine(std::hash<uint64_t>()(key.file.inode));
+        combine(std::hash<uint64_t>()(key.file.device));
+        combine(std::hash<int64_t>()(key.file.modified));
+        return seed;
+    }
+};
+
+/// \internal
+///
+/// Reads & inflates the BGZF block starting at compressed 'offset'.
+///
+/// \throws std::runtime_error on read failure or invalid BGZF data
+///
+BgzfBlockPtr ReadBgzfBlock(const RandomAccessFile& file, const int64_t offset);
+
+/// \internal
+///
+/// Thread-safe LRU cache of inflated BGZF blocks, keyed on (file, compressed
+/// offset), limited by total inflated size.
+///
+class BgzfBlockCache
+{
+public:
+    explicit BgzfBlockCache(const size_t maxBytes);
+
+public:
+    /// \returns cached block for 'key', or null if not present
+    BgzfBlockPtr Find(const BgzfBlockKey& key);
+
+    /// Adds 'block' to cache, evicting least-recently used blocks as needed.
+    void Insert(const BgzfBlockKey& key, BgzfBlockPtr block);
+
+    void Clear(void);
+
+    size_t MaxBytes(void) const;
+    void MaxBytes(const size_t maxBytes);
+
+    /// \returns total inflated size of cached blocks
+    size_t NumBytes(void) const;
+
+private:
+    void EvictAsNeeded(void);
+
+private:
+    typedef std::pair<BgzfBlockKey, BgzfBlockPtr> Entry;
+    typedef std::list<Entry> EntryList;
+
+    mutable std::mutex mutex_;
+    size_t maxBytes_;
+    size_t numBytes_;
+    EntryList entries_;  // most recently used at front
+    std::unordered_map<BgzfBlockKey, EntryList::iterator, BgzfBlockKeyHash> lookup_;
+};
+
+/// \internal
+///
+/// \returns the process-wide block cache (see SharedBlockCache)
+///
+BgzfBlockCache& SharedBgzfBlockCache(void);
+
+/// \internal
+///
+/// \returns true if the process-wide block cache is enabled
+///
+bool SharedBgzfBlockCacheEnabled(void);
+
+/// \internal
+///
+/// Enables/disables the process-wide block cache.
+///
+void SharedBgzfBlockCacheEnabled(const bool enabled);
+
+/// \internal
+///
+/// Seeks a BGZF stream to 'virtualOffset', as bgzf_seek().
+///
+/// If the shared block cache is enabled & contains the target block, its
+/// inflated data is installed directly into the stream instead of being
+/// re-read & re-inflated. Otherwise, the block is loaded normally and added
+/// to the cache.
+///
+/// \returns 0 on success, -1 on failure
+///
+int CachedBgzfSeek(BGZF* fp, const FileIdentity& file, const int64_t virtualOffset);
+
+} // namespace internal
+} // namespace BAM
+} // namespace PacBio
+
+#endif // BGZFBLOCKCACHE_H
@@ -0,0 +1,183 @@
+// Copyright (c) 2016, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// Author: Derek Barnett
+
+#include "BgzfPrefetcher.h"
+#include <algorithm>
+#include <stdexcept>
+#include <cassert>
+
+namespace PacBio {
+namespace BAM {
+namespace internal {
+
+const int64_t BgzfPrefetcher::TargetChunkSize;
+
+BgzfPrefetcher::BgzfPrefetcher(const std::string& filename,
+                               const PbiRawData& index,
+                               const IndexResultBlocks& blocks,
+                               const size_t depth,
+                               const size_t numThreads,
+                               const size_t maxGap)
+    : file_(filename)
+    , nextChunk_(0)
+    , currentRecord_(0)
+    , pool_(numThreads)
+{
+    plan_ = MakePlan(index, blocks, file_.Size(), maxGap);
+    const size_t initialDepth = std::max(depth, size_t{1});
+    for (size_t i = 0; i < initialDepth; ++i)
+        SubmitNext();
+}
+
+std::vector<BgzfPrefetcher::ChunkPlan>
+BgzfPrefetcher::MakePlan(const PbiRawData& index,
+                         const IndexResultBlocks& blocks,
+                         const int64_t fileSize,
+                         const size_t maxGap)
+{
+    const std::vector<int64_t>& fileOffsets = index.BasicData().fileOffset_;
+    const int64_t eofVirtualOffset = fileSize << 16;
+
+    std::vector<ChunkPlan> plan;
+    for (const IndexResultBlock& block : blocks) {
+        for (size_t row = block.firstIndex_; row < block.firstIndex_ + block.numReads_; ++row) {
+            const int64_t start = fileOffsets.at(row);
+            const int64_t end = (row + 1 < fileOffsets.size() ? fileOffsets.at(row + 1)
+                                                              : eofVirtualOffset);
+
+            // extend current chunk if record is close enough & chunk not too large
+            if (!plan.empty()) {
+                ChunkPlan& chunk = plan.back();
+                const int64_t gap  = BgzfUtils::CompressedOffset(start) -
+                                     BgzfUtils::CompressedOffset(chunk.endVirtualOffset);
+                const int64_t span = BgzfUtils::CompressedOffset(end) - chunk.beginOffset;
+                if (gap <= static_cast<int64_t>(maxGap) && span <= TargetChunkSize) {
+                    chunk.records.push_back(start);
+                    chunk.endVirtualOffset = end;
+                    continue;
+                }
+            }
+
+            // otherwise start new chunk
+            ChunkPlan chunk;
+            chunk.beginOffset = BgzfUtils::CompressedOffset(start);
+            chunk.endVirtualOffset = end;
+            chunk.records.push_back(start);
+            plan.push_back(std::move(chunk));
+        }
+    }
+    return plan;
+}
+
+BgzfPrefetcher::Chunk BgzfPrefetcher::FetchChunk(const RandomAccessFile& file,
+                                                 const ChunkPlan& plan)
+{
+    // The last record ends in the block at endVirtualOffset's compressed
+    // offset (unless it ends exactly on that block's boundary). That block's
+    // size is not known up front, but can be no larger than MaxBlockSize.
+    const int64_t endBlock = BgzfUtils::CompressedOffset(plan.endVirtualOffset);
+    const bool includeEndBlock = BgzfUtils::UncompressedOffset(plan.endVirtualOffset) > 0;
+    int64_t readEnd = (includeEndBlock ? endBlock + static_cast<int64_t>(BgzfUtils::MaxBlockSize)
+                                       : endBlock);
+    readEnd = std::min(readEnd, file.Size());
+
+    std::vector<uint8_t> compressed(static_cast<size_t>(readEnd - plan.beginOffset));
+    const size_t numRead = file.ReadAt(plan.beginOffset, compressed.data(), compressed.size());
+
+    // inflate blocks, noting where each starts in the output
+    Chunk chunk;
+    chunk.data.reserve(compressed.size() * 4);
+    std::vector<std::pair<int64_t, size_t> > blockStarts;
+    int64_t blockOffset = plan.beginOffset;
+    while (blockOffset < endBlock || (includeEndBlock && blockOffset == endBlock)) {
+        const size_t position = static_cast<size_t>(blockOffset - plan.beginOffset);
+        if (position >= numRead)
+            throw std::runtime_error("unexpected end of BAM file: " + std::to_string(blockOffset));
+        blockStarts.emplace_back(blockOffset, chunk.data.size());
+        blockOffset += BgzfUtils::InflateBlock(compressed.data() + position,
+                                               numRead - position,
+                                               &chunk.data);
+    }
+
+    // locate requested records (in file order) within inflated data
+    chunk.records.reserve(plan.records.size());
+    size_t blockIndex = 0;
+    for (const int64_t virtualOffset : plan.records) {
+        const int64_t recordBlock = BgzfUtils::CompressedOffset(virtualOffset);
+        while (blockIndex < blockStarts.size() && blockStarts.at(blockIndex).first < recordBlock)
+            ++blockIndex;
+        if (blockIndex == blockStarts.size() || blockStarts.at(blockIndex).first != recordBlock)
+            throw std::runtime_error("PBI file offset does not match BAM block boundaries");
+        chunk.records.push_back(blockStarts.at(blockIndex).second +
+                                BgzfUtils::UncompressedOffset(virtualOffset));
+    }
+    return chunk;
+}
+
+int BgzfPrefetcher::ReadNext(bam1_t* b)
+{
+    // move to next chunk, if needed, keeping the pipeline full
+    while (currentRecord_ >= current_.records.size()) {
+        if (pending_.empty())
+            return -1; // "EOF"
+        current_ = pending_.front().get();
+        pending_.pop_front();
+        currentRecord_ = 0;
+        SubmitNext();
+    }
+
+    const size_t position = current_.records.at(currentRecord_++);
+    if (position >= current_.data.size())
+        return -2; // truncated
+    return BgzfUtils::ReadRecord(current_.data.data() + position,
+                                 current_.data.size() - position,
+                                 b);
+}
+
+void BgzfPrefetcher::SubmitNext(void)
+{
+    if (nextChunk_ >= plan_.size())
+        return;
+
+    const ChunkPlan* plan = &plan_.at(nextChunk_++);
+    const RandomAccessFile* file = &file_;
+    pending_.push_back(pool_.Submit([file, plan]() { return FetchChunk(*file, *plan); }));
+}
+
+} // namespace internal
+} // namespace BAM
+} // namespace PacBio
@@ -0,0 +1,134 @@
+// Copyright (c) 2016, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// Author: Derek Barnett
+
+#ifndef BGZFPREFETCHER_H
+#define BGZFPREFETCHER_H
+
+#include "pbbam/PbiBasicTypes.h"
+#include "pbbam/PbiRawData.h"
+#include "BgzfUtils.h"
+#include "ThreadPool.h"
+#include <htslib/sam.h>
+#include <deque>
+#include <future>
+#include <string>
+#include <vector>
+
+namespace PacBio {
+namespace BAM {
+namespace internal {
+
+/// \internal
+///
+/// Reads the records selected by a PBI lookup, fetching & inflating their
+/// compressed data ahead of the consumer.
+///
+/// The requested records are planned up front into chunks of nearby
+/// records. Each chunk's compressed span is fetched with a single pread() and
+/// inflated on a worker thread, with up to 'depth' chunks in flight. Records
+/// are returned in the original (file) order.
+///
+class BgzfPrefetcher
+{
+public:
+    /// target compressed size of a single prefetch chunk
+    static const int64_t TargetChunkSize = 1 << 20;
+
+public:
+    /// \param[in] filename     BAM filename
+    /// \param[in] index        PBI data for BAM file
+    /// \param[in] blocks       blocks of records to read
+    /// \param[in] depth        max number of chunks in flight
+    /// \param[in] numThreads   number of worker threads (0 = hardware threads)
+    /// \param[in] maxGap       largest compressed gap (bytes) between records
+    ///                         that will be fetched within the same chunk
+    ///
+    BgzfPrefetcher(const std::string& filename,
+                   const PbiRawData& index,
+                   const IndexResultBlocks& blocks,
+                   const size_t depth,
+                   const size_t numThreads,
+                   const size_t maxGap);
+
+public:
+    /// Reads the next requested record into 'b'.
+    ///
+    /// \returns same as bam_read1(): bytes read, -1 at end of requested data,
+    ///          or other negative value on error
+    ///
+    int ReadNext(bam1_t* b);
+
+private:
+    struct ChunkPlan
+    {
+        int64_t beginOffset;            // compressed offset of first block
+        int64_t endVirtualOffset;       // virtual offset just past last record
+        std::vector<int64_t> records;   // virtual offsets of requested records
+    };
+
+    struct Chunk
+    {
+        std::vector<uint8_t> data;      // inflated data for chunk's blocks
+        std::vector<size_t> records;    // position of each record in data
+    };
+
+private:
+    static std::vector<ChunkPlan> MakePlan(const PbiRawData& index,
+                                           const IndexResultBlocks& blocks,
+                                           const int64_t fileSize,
+                                           const size_t maxGap);
+    static Chunk FetchChunk(const RandomAccessFile& file,
+                            const ChunkPlan& plan);
+    void SubmitNext(void);
+
+private:
+    RandomAccessFile file_;
+    std::vector<ChunkPlan> plan_;
+    size_t nextChunk_;
+    std::deque<std::future<Chunk> > pending_;
+    Chunk current_;
+    size_t currentRecord_;
+
+    // keep last, workers must be joined before the data above is destroyed
+    ThreadPool pool_;
+};
+
+} // namespace internal
+} // namespace BAM
+} // namespace PacBio
+
+#endif // BGZFPREFETCHER_H
@@ -0,0 +1,206 @@
+// Copyright (c) 2016, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// Author: Derek Barnett
+
+#include "BgzfUtils.h"
+#include <htslib/hts.h>
+#include <zlib.h>
+#include <stdexcept>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace PacBio {
+namespace BAM {
+namespace internal {
+
+static const size_t BgzfHeaderLength = 18;
+static const size_t BgzfFooterLength = 8;
+
+static inline uint16_t readUInt16(const uint8_t* data)
+{ return static_cast<uint16_t>(data[0] | (data[1] << 8)); }
+
+static inline uint32_t readUInt32(const uint8_t* data)
+{
+    return static_cast<uint32_t>(data[0])         |
+           (static_cast<uint32_t>(data[1]) << 8)  |
+           (static_cast<uint32_t>(data[2]) << 16) |
+           (static_cast<uint32_t>(data[3]) << 24);
+}
+
+const size_t BgzfUtils::MaxBlockSize;
+
+bool BgzfUtils::CanDecodeInMemory(void)
+{ return ed_is_big() == 0; }
+
+size_t BgzfUtils::InflateBlock(const uint8_t* compressed,
+                               const size_t available,
+                               std::vector<uint8_t>* out)
+{
+    // check header: gzip magic, deflate, FEXTRA, and the 'BC' subfield
+    if (available < BgzfHeaderLength + BgzfFooterLength ||
+        compressed[0] != 31 || compressed[1] != 139 ||
+        compressed[2] != 8  || (compressed[3] & 4) == 0 ||
+        readUInt16(compressed + 10) != 6 ||
+        compressed[12] != 'B' || compressed[13] != 'C' ||
+        readUInt16(compressed + 14) != 2)
+    {
+        throw std::runtime_error("invalid BGZF block header");
+    }
+
+    const size_t blockSize = static_cast<size_t>(readUInt16(compressed + 16)) + 1;
+    if (blockSize < BgzfHeaderLength + BgzfFooterLength || blockSize > available)
+        throw std::runtime_error("truncated BGZF block");
+
+    const uint32_t inflatedSize = readUInt32(compressed + blockSize - 4);
+    if (inflatedSize > MaxBlockSize)
+        throw std::runtime_error("invalid BGZF block size");
+    if (inflatedSize == 0)
+        return blockSize;
+
+    const size_t outStart = out->size();
+    out->resize(outStart + inflatedSize);
+
+    z_stream zs;
+    zs.zalloc   = nullptr;
+    zs.zfree    = nullptr;
+    zs.opaque   = nullptr;
+    zs.next_in  = const_cast<Bytef*>(compressed + BgzfHeaderLength);
+    zs.avail_in = static_cast<uInt>(blockSize - BgzfHeaderLength - BgzfFooterLength);
+    zs.next_out  = out->data() + outStart;
+    zs.avail_out = inflatedSize;
+
+    if (inflateInit2(&zs, -15) != Z_OK) // -15: raw deflate, no zlib header
+        throw std::runtime_error("could not initialize BGZF block decompression");
+    const int status = inflate(&zs, Z_FINISH);
+    inflateEnd(&zs);
+    if (status != Z_STREAM_END || zs.total_out != inflatedSize)
+        throw std::runtime_error("could not decompress BGZF block");
+
+    return blockSize;
+}
+
+int BgzfUtils::ReadRecord(const uint8_t* data,
+                          const size_t available,
+                          bam1_t* b)
+{
+    if (available == 0)
+        return -1; // normal "EOF"
+    if (available < 4)
+        return -2; // truncated
+
+    const int32_t blockLength = static_cast<int32_t>(readUInt32(data));
+    if (available < 4 + 32)
+        return -3;
+
+    uint32_t x[8];
+    for (size_t i = 0; i < 8; ++i)
+        x[i] = readUInt32(data + 4 + (i*4));
+
+    bam1_core_t* c = &b->core;
+    c->tid = x[0]; c->pos = x[1];
+    c->bin = x[2]>>16; c->qual = x[2]>>8&0xff; c->l_qname = x[2]&0xff;
+    c->flag = x[3]>>16; c->n_cigar = x[3]&0xffff;
+    c->l_qseq = x[4];
+    c->mtid = x[5]; c->mpos = x[6]; c->isize = x[7];
+    b->l_data = blockLength - 32;
+    if (b->l_data < 0 || c->l_qseq < 0)
+        return -4;
+    if ((char *)bam_get_aux(b) - (char *)b->data > b->l_data)
+        return -4;
+    if (available < static_cast<size_t>(4 + blockLength))
+        return -4;
+
+    if (b->m_data < b->l_data) {
+        b->m_data = b->l_data;
+        kroundup32(b->m_data);
+        uint8_t* newData = static_cast<uint8_t*>(realloc(b->data, b->m_data));
+        if (!newData)
+            return -4;
+        b->data = newData;
+    }
+    memcpy(b->data, data + 4 + 32, b->l_data);
+    return 4 + blockLength;
+}
+
+RandomAccessFile::RandomAccessFile(const std::string& filename)
+    : filename_(filename)
+    , fd_(-1)
+    , size_(0)
+{
+    fd_ = ::open(filename.c_str(), O_RDONLY);
+    if (fd_ < 0)
+        throw std::runtime_error("could not open file for reading: " + filename);
+
+    struct stat s;
+    if (::fstat(fd_, &s) != 0) {
+        ::close(fd_);
+        throw std::runtime_error("could not determine file size: " + filename);
+    }
+    size_ = static_cast<int64_t>(s.st_size);
+}
+
+RandomAccessFile::~RandomAccessFile(void)
+{
+    if (fd_ >= 0)
+        ::close(fd_);
+}
+
+int64_t RandomAccessFile::Size(void) const
+{ return size_; }
+
+size_t RandomAccessFile::ReadAt(const int64_t offset, uint8_t* buffer, const size_t length) const
+{
+    size_t total = 0;
+    while (total < length) {
+        const ssize_t result = ::pread(fd_, buffer + total, length - total, offset + total);
+        if (result < 0) {
+            if (errno == EINTR)
+                continue;
+            throw std::runtime_error("could not read from file: " + filename_);
+        }
+        if (result == 0)
+            break; // EOF
+        total += static_cast<size_t>(result);
+    }
+    return total;
+}
+
+} // namespace internal
+} // namespace BAM
+} // namespace PacBio
@@ -0,0 +1,129 @@
+// Copyright (c) 2016, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// Author: Derek Barnett
+
+#ifndef BGZFUTILS_H
+#define BGZFUTILS_H
+
+#include <htslib/sam.h>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace PacBio {
+namespace BAM {
+namespace internal {
+
+/// \internal
+///
+/// Low-level helpers for working with BGZF blocks & BAM records outside of
+/// htslib's BGZF stream (e.g. for data fetched with pread()).
+///
+struct BgzfUtils
+{
+public:
+    /// maximum size of a single BGZF block, compressed or not
+    static const size_t MaxBlockSize = 65536;
+
+    /// \returns compressed offset of a BGZF virtual offset
+    static int64_t CompressedOffset(const int64_t virtualOffset)
+    { return virtualOffset >> 16; }
+
+    /// \returns uncompressed (within-block) offset of a BGZF virtual offset
+    static size_t UncompressedOffset(const int64_t virtualOffset)
+    { return static_cast<size_t>(virtualOffset & 0xFFFF); }
+
+    /// \returns true if records can be decoded with ReadRecord on this host
+    ///          (BAM data is little-endian)
+    static bool CanDecodeInMemory(void);
+
+    /// Inflates the BGZF block at the start of 'compressed', appending its
+    /// contents to 'out'.
+    ///
+    /// \returns the block's total compressed size (header + data + footer)
+    /// \throws std::runtime_error if the data is not a valid BGZF block
+    ///
+    static size_t InflateBlock(const uint8_t* compressed,
+                               const size_t available,
+                               std::vector<uint8_t>* out);
+
+    /// Decodes one BAM record from 'data', as bam_read1() would from a BGZF
+    /// stream.
+    ///
+    /// \returns number of bytes consumed, -1 if no data available, or a
+    ///          negative error code matching bam_read1()'s
+    ///
+    static int ReadRecord(const uint8_t* data,
+                          const size_t available,
+                          bam1_t* b);
+};
+
+/// \internal
+///
+/// Read-only file supporting concurrent, positioned reads (pread).
+///
+class RandomAccessFile
+{
+public:
+    explicit RandomAccessFile(const std::string& filename);
+    RandomAccessFile(const RandomAccessFile&) = delete;
+    RandomAccessFile& operator=(const RandomAccessFile&) = delete;
+    ~RandomAccessFile(void);
+
+public:
+    /// \returns file size in bytes
+    int64_t Size(void) const;
+
+    /// Reads up to 'length' bytes at 'offset' into 'buffer'. Safe to call
+    /// from multiple threads.
+    ///
+    /// \returns number of bytes read (less than 'length' only at EOF)
+    /// \throws std::runtime_error on read failure
+    ///
+    size_t ReadAt(const int64_t offset, uint8_t* buffer, const size_t length) const;
+
+private:
+    std::string filename_;
+    int fd_;
+    int64_t size_;
+};
+
+} // namespace internal
+} // namespace BAM
+} // namespace PacBio
+
+#endif // BGZFUTILS_H
@@ -0,0 +1,128 @@
+// Copyright (c) 2016, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// File Description
+/// \file ClipAndGapifyPlan.cpp
+/// \brief Implements the ClipAndGapifyPlan class.
+//
+// Author: Derek Barnett
+
+#include "ClipAndGapifyPlan.h"
+#include <stdexcept>
+
+namespace PacBio {
+namespace BAM {
+namespace internal {
+
+ClipAndGapifyPlan::ClipAndGapifyPlan(const BamRecordImpl& impl,
+                                     const bool aligned,
+                                     const bool exciseSoftClips)
+    : aligned_(aligned)
+    , exciseSoftClips_(exciseSoftClips)
+    , isIdentity_(!impl.IsMapped() || !(aligned || exciseSoftClips))
+    , inputLength_(0)
+    , outputLength_(0)
+    , isMapped_(impl.IsMapped())
+    , sequenceLength_(impl.SequenceLength())
+{
+    const CigarView cigar = impl.CigarDataView();
+    cigar_.assign(cigar.Data(), cigar.Data() + cigar.size());
+
+    if (isIdentity_)
+        return;
+
+    // walk the packed CIGAR, no CigarOperation objects needed
+    for (auto iter = cigar.cbegin(); iter != cigar.cend(); ++iter) {
+        const size_t opLength = iter.Length();
+        switch (iter.Type()) {
+
+            // forbidden in PacBio BAM (see CigarOperationType)
+            case CigarOperationType::ALIGNMENT_MATCH :
+                throw std::runtime_error("CIGAR operation 'M' is not allowed in PacBio BAM files. Use 'X/=' instead.");
+
+            // nothing to do for hard-clipped & ref-skipped positions
+            case CigarOperationType::HARD_CLIP      :
+            case CigarOperationType::REFERENCE_SKIP :
+                break;
+
+            // maybe skip soft-clipped positions
+            case CigarOperationType::SOFT_CLIP :
+                AddStep(exciseSoftClips ? StepType::SKIP : StepType::COPY, opLength);
+                break;
+
+            // maybe add deletion/padding values
+            case CigarOperationType::DELETION :
+                if (aligned)
+                    AddStep(StepType::DELETION, opLength);
+                break;
+            case CigarOperationType::PADDING :
+                if (aligned)
+                    AddStep(StepType::PADDING, opLength);
+                break;
+
+            // all other CIGAR ops
+            default :
+                AddStep(StepType::COPY, opLength);
+                break;
+        }
+    }
+}
+
+void ClipAndGapifyPlan::AddStep(const StepType type, const size_t length)
+{
+    if (type == StepType::COPY || type == StepType::SKIP)
+        inputLength_ += length;
+    if (type != StepType::SKIP)
+        outputLength_ += length;
+
+    // merge with previous step of the same type (e.g. M & I runs are one copy)
+    if (!steps_.empty() && steps_.back().type_ == type)
+        steps_.back().length_ += length;
+    else
+        steps_.push_back(Step{ type, length });
+}
+
+bool ClipAndGapifyPlan::Matches(const BamRecordImpl& impl) const
+{
+    if (impl.IsMapped() != isMapped_ || impl.SequenceLength() != sequenceLength_)
+        return false;
+    const CigarView cigar = impl.CigarDataView();
+    return cigar.size() == cigar_.size() &&
+           std::equal(cigar_.cbegin(), cigar_.cend(), cigar.Data());
+}
+
+} // namespace internal
+} // namespace BAM
+} // namespace PacBio
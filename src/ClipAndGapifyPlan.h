@@ -0,0 +1,178 @@
+// Copyright (c) 2016, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// File Description
+/// \file ClipAndGapifyPlan.h
+/// \brief Defines the ClipAndGapifyPlan class.
+//
+// Author: Derek Barnett
+
+#ifndef CLIPANDGAPIFYPLAN_H
+#define CLIPANDGAPIFYPLAN_H
+
+#include "pbbam/BamRecordImpl.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace PacBio {
+namespace BAM {
+namespace internal {
+
+/// \brief The ClipAndGapifyPlan class records how a record's CIGAR clips
+///        and/or gaps its per-base data.
+///
+/// The CIGAR is walked once, on construction. The plan can then be applied to
+/// any number of per-base fields (sequence, QVs, frames, etc.) of the same
+/// record. Data passed to Apply() must be in genomic orientation.
+///
+/// A plan keeps a fingerprint of the record it was built from (mapped flag,
+/// sequence length & CIGAR), so holders of a long-lived plan can detect that
+/// the record has since been modified (see Matches()).
+///
+class ClipAndGapifyPlan
+{
+public:
+    ClipAndGapifyPlan(const BamRecordImpl& impl,
+                      const bool aligned,
+                      const bool exciseSoftClips);
+
+public:
+    bool Aligned(void) const
+    { return aligned_; }
+
+    bool ExciseSoftClips(void) const
+    { return exciseSoftClips_; }
+
+    /// \returns true if data is left unchanged (unmapped record, or neither
+    ///          clipping nor gapping requested)
+    bool IsIdentity(void) const
+    { return isIdentity_; }
+
+    /// \returns length of per-base data expected by Apply()
+    size_t InputLength(void) const
+    { return inputLength_; }
+
+    /// \returns length of clipped/gapped output
+    size_t OutputLength(void) const
+    { return outputLength_; }
+
+    /// \returns true if \p impl still has the mapped flag, sequence length &
+    ///          CIGAR this plan was built from
+    bool Matches(const BamRecordImpl& impl) const;
+
+public:
+    /// \brief Clips and/or gaps \p data in place.
+    ///
+    /// \param[in,out] data                 per-base values
+    /// \param[in]     paddingNullValue     value inserted at padding ops
+    /// \param[in]     deletionNullValue    value inserted at deletion ops
+    ///
+    /// \throws std::runtime_error if \p data length does not match the
+    ///         record's CIGAR (i.e. InputLength())
+    ///
+    template<typename F, typename N>
+    void Apply(F* data,
+               const N paddingNullValue,
+               const N deletionNullValue) const
+    {
+        if (isIdentity_)
+            return;
+
+        if (data->size() != inputLength_)
+            throw std::runtime_error("ClipAndGapifyPlan: data length does not match CIGAR query length");
+
+        F result;
+        result.resize(outputLength_);
+        auto src = data->begin();
+        auto dst = result.begin();
+        for (const Step& step : steps_) {
+            switch (step.type_) {
+                case StepType::COPY :
+                    dst = std::move(src, src + step.length_, dst);
+                    src += step.length_;
+                    break;
+                case StepType::SKIP :
+                    src += step.length_;
+                    break;
+                case StepType::DELETION :
+                    dst = std::fill_n(dst, step.length_, deletionNullValue);
+                    break;
+                case StepType::PADDING :
+                    dst = std::fill_n(dst, step.length_, paddingNullValue);
+                    break;
+            }
+        }
+        *data = std::move(result);
+    }
+
+private:
+    enum class StepType
+    {
+        COPY
+      , SKIP
+      , DELETION
+      , PADDING
+    };
+
+    struct Step
+    {
+        StepType type_;
+        size_t length_;
+    };
+
+    void AddStep(const StepType type, const size_t length);
+
+private:
+    bool aligned_;
+    bool exciseSoftClips_;
+    bool isIdentity_;
+    size_t inputLength_;
+    size_t outputLength_;
+    std::vector<Step> steps_;
+
+    // source record fingerprint
+    bool isMapped_;
+    size_t sequenceLength_;
+    std::vector<uint32_t> cigar_;
+};
+
+} // namespace internal
+} // namespace BAM
+} // namespace PacBio
+
+#endif // CLIPANDGAPIFYPLAN_H
@@ -0,0 +1,218 @@
+// Copyright (c) 2016, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// File Description
+/// \file CompositeBamReader.cpp
+/// \brief Implements the non-template helpers for the composite BAM readers.
+//
+// Author: Derek Barnett
+
+#include "pbbam/CompositeBamReader.h"
+#include "ThreadPool.h"
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <cassert>
+
+namespace PacBio {
+namespace BAM {
+namespace internal {
+
+// max records read per lock acquisition
+static const size_t ReadAheadBatchSize = 16;
+
+class CompositeReadAheadPrivate
+{
+public:
+    struct Input
+    {
+        Input(BamReader* rdr)
+            : reader(rdr)
+            , scheduled(false)
+            , finished(false)
+        { }
+
+        BamReader* reader;
+        std::deque<BamRecord> records;
+        bool scheduled;   // fill task queued or running
+        bool finished;    // reader exhausted, or failed
+        std::exception_ptr error;
+    };
+
+public:
+    CompositeReadAheadPrivate(const size_t numThreads, const size_t queueSize)
+        : queueSize_(std::max(queueSize, size_t(1)))
+        , stop_(false)
+        , pool_(new ThreadPool{ numThreads })
+    { }
+
+    ~CompositeReadAheadPrivate(void)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+
+        // discards queued fills & waits for running ones
+        pool_.reset();
+    }
+
+    size_t Add(BamReader* reader)
+    {
+        assert(reader);
+        std::lock_guard<std::mutex> lock(mutex_);
+        inputs_.emplace_back(new Input{ reader });
+        const size_t id = inputs_.size() - 1;
+        ScheduleFill(id, *inputs_.back());
+        return id;
+    }
+
+    bool GetNext(const size_t id, BamRecord& record)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        Input& input = *inputs_.at(id);
+        while (input.records.empty()) {
+            if (input.error)
+                std::rethrow_exception(input.error);
+            if (input.finished)
+                return false;
+            ScheduleFill(id, input);
+            ready_.wait(lock);
+        }
+
+        record = std::move(input.records.front());
+        input.records.pop_front();
+
+        // top up queue, once drained halfway
+        if (input.records.size() <= queueSize_/2)
+            ScheduleFill(id, input);
+        return true;
+    }
+
+private:
+    // must hold mutex_
+    void ScheduleFill(const size_t id, Input& input)
+    {
+        if (input.scheduled || input.finished || stop_)
+            return;
+        input.scheduled = true;
+        pool_->Submit([this, id]() { Fill(id); });
+    }
+
+    // reads input until its queue is full (or input ends)
+    void Fill(const size_t id)
+    {
+        Input* input = nullptr;
+        size_t room = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            input = inputs_.at(id).get();
+            room = queueSize_ - std::min(queueSize_, input->records.size());
+        }
+
+        std::vector<BamRecord> batch;
+        batch.reserve(ReadAheadBatchSize);
+        while (true) {
+
+            // read next batch, without holding the lock
+            bool finished = false;
+            std::exception_ptr error;
+            const size_t batchSize = std::min(room, ReadAheadBatchSize);
+            try {
+                for (size_t i = 0; i < batchSize; ++i) {
+                    BamRecord record;
+                    if (!input->reader->GetNext(record)) {
+                        finished = true;
+                        break;
+                    }
+                    batch.push_back(std::move(record));
+                }
+            } catch (...) {
+                error = std::current_exception();
+                finished = true;
+            }
+
+            // publish batch
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (auto&& record : batch)
+                input->records.push_back(std::move(record));
+            batch.clear();
+            input->finished = finished;
+            input->error = error;
+            room = queueSize_ - std::min(queueSize_, input->records.size());
+            ready_.notify_all();
+
+            if (finished || room == 0 || stop_) {
+                input->scheduled = false;
+                return;
+            }
+        }
+    }
+
+private:
+    const size_t queueSize_;
+    bool stop_;
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::vector<std::unique_ptr<Input> > inputs_;
+
+    // declared last, so destroyed (joining workers) before inputs
+    std::unique_ptr<ThreadPool> pool_;
+};
+
+const size_t CompositeReadAhead::DefaultQueueSize = 128;
+
+CompositeReadAhead::CompositeReadAhead(const size_t numThreads,
+                                       const size_t queueSize)
+    : d_(new CompositeReadAheadPrivate{ numThreads, queueSize })
+{ }
+
+CompositeReadAhead::~CompositeReadAhead(void) { }
+
+size_t CompositeReadAhead::Add(BamReader* reader)
+{
+    assert(d_);
+    return d_->Add(reader);
+}
+
+bool CompositeReadAhead::GetNext(const size_t id, BamRecord& record)
+{
+    assert(d_);
+    return d_->GetNext(id, record);
+}
+
+} // namespace internal
+} // namespace BAM
+} // namespace PacBio
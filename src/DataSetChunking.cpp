@@ -0,0 +1,304 @@
+// Copyright (c) 2016, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// File Description
+/// \file DataSetChunking.cpp
+/// \brief Implements the DataSetChunking methods.
+//
+// Author: Derek Barnett
+
+#include "pbbam/DataSetChunking.h"
+#include "pbbam/Compare.h"
+#include "pbbam/PbiFilter.h"
+#include "pbbam/PbiRawData.h"
+#include "DataSetUtils.h"
+#include <algorithm>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace PacBio {
+namespace BAM {
+namespace internal {
+
+// (major, minor) sort key: (ZMW, 0) or (reference index, tStart)
+typedef std::pair<int64_t, int64_t> ChunkKey;
+typedef std::pair<ChunkKey, uint64_t> WeightedKey;
+
+struct ChunkBounds
+{
+    bool hasLower_;
+    ChunkKey lower_;    // inclusive
+    bool hasUpper_;
+    ChunkKey upper_;    // exclusive
+};
+
+static
+uint64_t RecordWeight(const PbiRawBasicData& basicData,
+                      const size_t row,
+                      const DataSetChunking::Balance balance)
+{
+    if (balance == DataSetChunking::RECORDS)
+        return 1;
+    const int32_t qStart = basicData.qStart_.at(row);
+    const int32_t qEnd = basicData.qEnd_.at(row);
+    return (qEnd > qStart) ? static_cast<uint64_t>(qEnd - qStart) : 0;
+}
+
+// Collects (key, weight) for each record passing the dataset's filters, then
+// sorts & sums weights per distinct key. For reference keys, 'refNames' is
+// filled with reference names, indexed by key major.
+//
+static
+std::vector<WeightedKey> CollectWeights(const DataSet& dataset,
+                                        const DataSetChunking::Balance balance,
+                                        std::vector<std::string>* refNames)
+{
+    std::unordered_map<std::string, int64_t> refIndices;
+
+    std::vector<WeightedKey> weights;
+    auto filesSeen = std::set<std::string>{ };
+    for (const BamFile& bamFile : dataset.BamFiles()) {
+        if (!filesSeen.insert(bamFile.Filename()).second)
+            continue;
+        if (!bamFile.PacBioIndexExists())
+            throw std::runtime_error("DataSetChunking: missing PBI file for " + bamFile.Filename());
+
+        // fresh filter per file, as some filters (e.g. rname) resolve against
+        // the first file they see
+        const PbiFilter filter = PbiFilter::FromDataSet(dataset);
+        const PbiRawData index(bamFile.PacBioIndexFilename());
+        const PbiRawBasicData& basicData = index.BasicData();
+
+        // map this file's reference IDs to dataset-wide indices (in order of
+        // first appearance across files)
+        std::vector<int64_t> fileRefIndices;
+        if (refNames) {
+            if (!index.HasMappedData()) {
+                throw std::runtime_error("DataSetChunking: PBI file has no mapped data, "
+                                         "cannot chunk by reference: " + bamFile.PacBioIndexFilename());
+            }
+            for (const std::string& name : bamFile.Header().SequenceNames()) {
+                auto found = refIndices.find(name);
+                if (found == refIndices.end()) {
+                    found = refIndices.emplace(name, static_cast<int64_t>(refNames->size())).first;
+                    refNames->push_back(name);
+                }
+                fileRefIndices.push_back(found->second);
+            }
+        }
+
+        const size_t numReads = index.NumReads();
+        for (size_t row = 0; row < numReads; ++row) {
+            if (!filter.Accepts(index, row))
+                continue;
+
+            ChunkKey key;
+            if (refNames) {
+                const int32_t tId = index.MappedData().tId_.at(row);
+                if (tId < 0 || static_cast<size_t>(tId) >= fileRefIndices.size())
+                    continue; // unmapped
+                key = ChunkKey{ fileRefIndices.at(tId), index.MappedData().tStart_.at(row) };
+            } else
+                key = ChunkKey{ basicData.holeNumber_.at(row), 0 };
+
+            weights.emplace_back(key, RecordWeight(basicData, row, balance));
+        }
+    }
+
+    // sum weights per distinct key
+    std::sort(weights.begin(), weights.end());
+    std::vector<WeightedKey> result;
+    for (const WeightedKey& w : weights) {
+        if (!result.empty() && result.back().first == w.first)
+            result.back().second += w.second;
+        else
+            result.push_back(w);
+    }
+    return result;
+}
+
+// Splits sorted, distinct keys into at most 'numChunks' contiguous ranges of
+// roughly equal total weight. The first & last chunks are left open-ended, so
+// that together the chunks cover the entire key space.
+//
+static
+std::vector<ChunkBounds> PlanChunks(const std::vector<WeightedKey>& weights,
+                                    const size_t numChunks)
+{
+    uint64_t total = 0;
+    for (const WeightedKey& w : weights)
+        total += w.second;
+
+    std::vector<size_t> starts = { 0 };
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i + 1 < weights.size() && starts.size() < numChunks; ++i) {
+        cumulative += weights.at(i).second;
+        if (cumulative * numChunks >= total * starts.size())
+            starts.push_back(i + 1);
+    }
+
+    std::vector<ChunkBounds> result;
+    for (size_t i = 0; i < starts.size(); ++i) {
+        ChunkBounds bounds;
+        bounds.hasLower_ = (i > 0);
+        bounds.lower_ = bounds.hasLower_ ? weights.at(starts.at(i)).first : ChunkKey{ };
+        bounds.hasUpper_ = (i + 1 < starts.size());
+        bounds.upper_ = bounds.hasUpper_ ? weights.at(starts.at(i + 1)).first : ChunkKey{ };
+        result.push_back(bounds);
+    }
+    return result;
+}
+
+static
+Property MakeProperty(const std::string& name,
+                      const int64_t value,
+                      const Compare::Type cmp)
+{
+    return Property{ name, std::to_string(value), Compare::TypeToOperator(cmp) };
+}
+
+// Restricts a copy of the dataset to the union of 'chunkFilters' (if any),
+// applied on top of its existing filters.
+//
+static
+DataSet MakeChunk(const DataSet& dataset,
+                  const std::vector<Filter>& chunkFilters)
+{
+    DataSet chunk = dataset;
+    chunk.UniqueId(GenerateUuid());
+    if (chunkFilters.empty())
+        return chunk;
+
+    const Filters& existing = dataset.Filters();
+    Filters combined;
+    if (existing.Size() == 0) {
+        for (const Filter& chunkFilter : chunkFilters)
+            combined.Add(chunkFilter);
+    } else {
+        // (A or B) and (C or D) == (A and C) or (A and D) or ...
+        for (const Filter& filter : existing) {
+            for (const Filter& chunkFilter : chunkFilters) {
+                Filter merged = filter;
+                for (const Property& property : chunkFilter.Properties())
+                    merged.Properties().Add(property);
+                combined.Add(merged);
+            }
+        }
+    }
+    chunk.Filters(combined);
+    return chunk;
+}
+
+static
+std::vector<Filter> ZmwChunkFilters(const ChunkBounds& bounds)
+{
+    if (!bounds.hasLower_ && !bounds.hasUpper_)
+        return std::vector<Filter>{ };
+
+    Filter filter;
+    if (bounds.hasLower_)
+        filter.Properties().Add(MakeProperty("zm", bounds.lower_.first, Compare::GREATER_THAN_EQUAL));
+    if (bounds.hasUpper_)
+        filter.Properties().Add(MakeProperty("zm", bounds.upper_.first, Compare::LESS_THAN));
+    return std::vector<Filter>{ filter };
+}
+
+static
+std::vector<Filter> ReferenceChunkFilters(const ChunkBounds& bounds,
+                                          const std::vector<std::string>& refNames)
+{
+    const int64_t firstRef = bounds.hasLower_ ? bounds.lower_.first : 0;
+    const int64_t lastRef = bounds.hasUpper_ ? bounds.upper_.first
+                                             : static_cast<int64_t>(refNames.size()) - 1;
+
+    std::vector<Filter> filters;
+    for (int64_t ref = firstRef; ref <= lastRef; ++ref) {
+        const bool isFirst = (bounds.hasLower_ && ref == bounds.lower_.first);
+        const bool isLast = (bounds.hasUpper_ && ref == bounds.upper_.first);
+        if (isLast && bounds.upper_.second == 0)
+            continue; // nothing before position 0
+
+        Filter filter;
+        filter.Properties().Add(Property{ "rname", refNames.at(ref), "=" });
+        if (isFirst && bounds.lower_.second > 0)
+            filter.Properties().Add(MakeProperty("tstart", bounds.lower_.second, Compare::GREATER_THAN_EQUAL));
+        if (isLast)
+            filter.Properties().Add(MakeProperty("tstart", bounds.upper_.second, Compare::LESS_THAN));
+        filters.push_back(filter);
+    }
+    return filters;
+}
+
+static
+void CheckNumChunks(const size_t numChunks)
+{
+    if (numChunks == 0)
+        throw std::runtime_error("DataSetChunking: number of chunks must be greater than 0");
+}
+
+} // namespace internal
+
+std::vector<DataSet> DataSetChunking::ByZmw(const DataSet& dataset,
+                                            const size_t numChunks,
+                                            const Balance balance)
+{
+    internal::CheckNumChunks(numChunks);
+    const auto weights = internal::CollectWeights(dataset, balance, nullptr);
+
+    std::vector<DataSet> chunks;
+    for (const internal::ChunkBounds& bounds : internal::PlanChunks(weights, numChunks))
+        chunks.push_back(internal::MakeChunk(dataset, internal::ZmwChunkFilters(bounds)));
+    return chunks;
+}
+
+std::vector<DataSet> DataSetChunking::ByReference(const DataSet& dataset,
+                                                  const size_t numChunks,
+                                                  const Balance balance)
+{
+    internal::CheckNumChunks(numChunks);
+    std::vector<std::string> refNames;
+    const auto weights = internal::CollectWeights(dataset, balance, &refNames);
+
+    std::vector<DataSet> chunks;
+    for (const internal::ChunkBounds& bounds : internal::PlanChunks(weights, numChunks))
+        chunks.push_back(internal::MakeChunk(dataset, internal::ReferenceChunkFilters(bounds, refNames)));
+    return chunks;
+}
+
+} // namespace BAM
+} // namespace PacBio
@@ -0,0 +1,102 @@
+// Copyright (c) 2016, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+// File Description
+/// \file FlatTagCollection.cpp
+/// \brief Implements the FlatTagCollection class.
+//
+// Author: Derek Barnett
+
+#include "pbbam/FlatTagCollection.h"
+#include <algorithm>
+
+namespace PacBio {
+namespace BAM {
+
+FlatTagCollection::FlatTagCollection(const TagCollection& tags)
+    : std::vector<std::pair<std::string, Tag> >(tags.cbegin(), tags.cend())
+{ }
+
+bool FlatTagCollection::Contains(const std::string& name) const
+{ return Find(name) != nullptr; }
+
+const Tag* FlatTagCollection::Find(const std::string& name) const
+{
+    for (const auto& entry : *this) {
+        if (entry.first == name)
+            return &entry.second;
+    }
+    return nullptr;
+}
+
+Tag* FlatTagCollection::Find(const std::string& name)
+{
+    for (auto& entry : *this) {
+        if (entry.first == name)
+            return &entry.second;
+    }
+    return nullptr;
+}
+
+bool FlatTagCollection::Remove(const std::string& name)
+{
+    const auto found = std::find_if(begin(), end(),
+                                    [&name](const value_type& entry)
+                                    { return entry.first == name; });
+    if (found == end())
+        return false;
+    erase(found);
+    return true;
+}
+
+FlatTagCollection& FlatTagCollection::Set(const std::string& name, const Tag& value)
+{
+    Tag* existing = Find(name);
+    if (existing)
+        *existing = value;
+    else
+        emplace_back(name, value);
+    return *this;
+}
+
+TagCollection FlatTagCollection::ToTagCollection(void) const
+{
+    TagCollection result;
+    for (const auto& entry : *this)
+        result[entry.first] = entry.second;
+    return result;
+}
+
+} // namespace BAM
+} // namespace PacBio
@@ -40,104 +40,130 @@
 // Author: Derek Barnett
 
 #include "pbbam/Frames.h"
-#include <algorithm>
-#include <cassert>
-#include <cmath>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 namespace PacBio {
 namespace BAM {
 namespace internal {
 
-static std::vector<uint16_t> framepoints;
-static std::vector<uint8_t> frameToCode;
-static uint16_t maxFramepoint;
-
-static
-void InitIpdDownsampling(void)
-{
-    if (!framepoints.empty())
-        return;
-
-    // liftover from Dave's python code:
-    // .../bioinformatics/tools/kineticsTools/kineticsTools/_downsampling.py
-
-    const int B = 2;
-    const int t = 6;
-    const double T = pow(B, t);
-
-    int next = 0;
-    double grain;
-    const int end = 256/T;
-    for (int i = 0; i < end; ++i) {
-        grain = pow(B, i);
-        std::vector<uint16_t> nextOnes;
-        for (double j = 0; j < T; ++j)
-            nextOnes.push_back(j*grain + next);
-        next = nextOnes.back() + grain;
-        framepoints.insert(framepoints.end(), nextOnes.cbegin(), nextOnes.cend());
-    }
-    assert(framepoints.size()-1 <= UINT8_MAX);
-
-    const uint16_t maxElement = (*max_element(framepoints.cbegin(), framepoints.cend()));
-    frameToCode.assign(maxElement+1, 0);
-
-    const int fpEnd = framepoints.size() - 1;
-    uint8_t i = 0;
-    uint16_t fl = 0;
-    uint16_t fu = 0;
-    for (; i < fpEnd; ++i) {
-        fl = framepoints[i];
-        fu = framepoints[i+1];
-        if (fu > fl+1) {
-            const int middle = (fl+fu)/2;
-            for (int f = fl; f < middle; ++f)
-                frameToCode[f] = i;
-            for (int f = middle; f < fu; ++f)
-                frameToCode[f] = i+1;
-        } else
-            frameToCode[fl] = i;
-    }
+// The lossy, 8-bit frame code is a 2-bit exponent & 6-bit mantissa, ported
+// from Dave's python code:
+// .../bioinformatics/tools/kineticsTools/kineticsTools/_downsampling.py
+//
+// Code c decodes to ((64 + (c & 63)) << (c >> 6)) - 64, giving framepoints
+// 0..63 (step 1), 64..190 (step 2), 192..444 (step 4), & 448..952 (step 8).
+// Encoding rounds to the nearest framepoint (ties go up) & clamps at 952.
+//
+// These closed forms replace the lookup tables previously built on first use,
+// so there is no shared state to initialize.
 
-    // this next line differs from the python implementation (there, it's "i+1")
-    // our C++ for loop has incremented our index counter one more time than the indexes from python enumerate(...)
-    frameToCode[fu] = i;
-    maxFramepoint = fu;
-}
+static constexpr uint16_t MaxFramepoint = 952;
 
-static inline
+static constexpr
 uint16_t CodeToFrames(const uint8_t code)
+{ return static_cast<uint16_t>(((64 + (code & 63)) << (code >> 6)) - 64); }
+
+static constexpr
+int FrameExponent(const uint16_t frame)
+{ return (frame >= 448) ? 3 : (frame >= 192) ? 2 : (frame >= 64) ? 1 : 0; }
+
+static constexpr
+uint8_t FramesToCode(const uint16_t frame, const int exponent)
 {
-    return framepoints[code];
+    return static_cast<uint8_t>((exponent << 6) +
+                                ((frame - CodeToFrames(exponent << 6) + ((1 << exponent) >> 1)) >> exponent));
 }
 
-static
-std::vector<uint16_t> CodeToFrames(const std::vector<uint8_t>& codedData)
+static constexpr
+uint8_t FramesToCode(const uint16_t frame)
 {
-    InitIpdDownsampling();
+    return (frame >= MaxFramepoint) ? FramesToCode(MaxFramepoint, 3)
+                                    : FramesToCode(frame, FrameExponent(frame));
+}
+
+static_assert(CodeToFrames(63)  == 63  && CodeToFrames(64)  == 64,  "frame codec mismatch");
+static_assert(CodeToFrames(128) == 192 && CodeToFrames(192) == 448, "frame codec mismatch");
+static_assert(CodeToFrames(255) == MaxFramepoint, "frame codec mismatch");
+static_assert(FramesToCode(65)  == 65  && FramesToCode(947) == 254, "frame codec mismatch");
+static_assert(FramesToCode(948) == 255 && FramesToCode(UINT16_MAX) == 255, "frame codec mismatch");
+
+#if defined(__SSE2__)
+
+static inline
+__m128i Select(const __m128i mask, const __m128i a, const __m128i b)
+{ return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b)); }
 
-    const size_t length = codedData.size();
-    std::vector<uint16_t> frames(length, 0);
-    for (size_t i = 0; i < length; ++i)
-        frames[i] = CodeToFrames(codedData[i]);
-    return frames;
+// decodes 8 codes, held in 16-bit lanes
+static inline
+__m128i CodeToFrames(const __m128i codes)
+{
+    // (1 << exponent), built from compares since SSE2 has no per-lane shifts
+    const __m128i exponent = _mm_srli_epi16(codes, 6);
+    __m128i scale = _mm_set1_epi16(1);
+    scale = _mm_add_epi16(scale, _mm_and_si128(_mm_cmpgt_epi16(exponent, _mm_set1_epi16(0)), _mm_set1_epi16(1)));
+    scale = _mm_add_epi16(scale, _mm_and_si128(_mm_cmpgt_epi16(exponent, _mm_set1_epi16(1)), _mm_set1_epi16(2)));
+    scale = _mm_add_epi16(scale, _mm_and_si128(_mm_cmpgt_epi16(exponent, _mm_set1_epi16(2)), _mm_set1_epi16(4)));
+
+    const __m128i mantissa = _mm_add_epi16(_mm_and_si128(codes, _mm_set1_epi16(63)), _mm_set1_epi16(64));
+    return _mm_sub_epi16(_mm_mullo_epi16(mantissa, scale), _mm_set1_epi16(64));
 }
 
+// encodes 8 frame values, results in 16-bit lanes
 static inline
-uint8_t FramesToCode(const uint16_t frame)
+__m128i FramesToCode(__m128i frames)
 {
-    return frameToCode[std::min(maxFramepoint, frame)];
+    // unsigned min(frames, MaxFramepoint)
+    frames = _mm_subs_epu16(frames, _mm_subs_epu16(frames, _mm_set1_epi16(MaxFramepoint)));
+
+    // candidate code for each exponent, then keep the one matching each lane
+    const __m128i code1 = _mm_add_epi16(_mm_srli_epi16(_mm_sub_epi16(frames, _mm_set1_epi16( 64-1)), 1), _mm_set1_epi16( 64));
+    const __m128i code2 = _mm_add_epi16(_mm_srli_epi16(_mm_sub_epi16(frames, _mm_set1_epi16(192-2)), 2), _mm_set1_epi16(128));
+    const __m128i code3 = _mm_add_epi16(_mm_srli_epi16(_mm_sub_epi16(frames, _mm_set1_epi16(448-4)), 3), _mm_set1_epi16(192));
+
+    __m128i codes = frames;
+    codes = Select(_mm_cmpgt_epi16(frames, _mm_set1_epi16( 63)), code1, codes);
+    codes = Select(_mm_cmpgt_epi16(frames, _mm_set1_epi16(191)), code2, codes);
+    codes = Select(_mm_cmpgt_epi16(frames, _mm_set1_epi16(447)), code3, codes);
+    return codes;
 }
 
+#endif // __SSE2__
+
 static
-std::vector<uint8_t> FramesToCode(const std::vector<uint16_t>& frames)
+void CodeToFrames(const uint8_t* codes, const size_t length, uint16_t* frames)
 {
-    InitIpdDownsampling();
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= length; i += 16) {
+        const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(codes + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(frames + i),
+                         CodeToFrames(_mm_unpacklo_epi8(c, zero)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(frames + i + 8),
+                         CodeToFrames(_mm_unpackhi_epi8(c, zero)));
+    }
+#endif
+    for (; i < length; ++i)
+        frames[i] = CodeToFrames(codes[i]);
+}
 
-    const size_t length = frames.size();
-    std::vector<uint8_t> result(length, 0);
-    for (size_t i = 0; i < length; ++i)
-        result[i] = FramesToCode(frames[i]);
-    return result;
+static
+void FramesToCode(const uint16_t* frames, const size_t length, uint8_t* codes)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    for (; i + 16 <= length; i += 16) {
+        const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(frames + i));
+        const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(frames + i + 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(codes + i),
+                         _mm_packus_epi16(FramesToCode(lo), FramesToCode(hi)));
+    }
+#endif
+    for (; i < length; ++i)
+        codes[i] = FramesToCode(frames[i]);
 }
 
 } // namespace internal
@@ -154,10 +180,24 @@ Frames::Frames(std::vector<uint16_t>&& frames)
 { }
 
 Frames Frames::Decode(const std::vector<uint8_t>& codedData)
-{ return Frames(internal::CodeToFrames(codedData)); }
+{
+    std::vector<uint16_t> frames(codedData.size());
+    Decode(codedData.data(), codedData.size(), frames.data());
+    return Frames(std::move(frames));
+}
+
+void Frames::Decode(const uint8_t* codedData, const size_t length, uint16_t* frames)
+{ internal::CodeToFrames(codedData, length, frames); }
 
 std::vector<uint8_t> Frames::Encode(const std::vector<uint16_t>& frames)
-{ return internal::FramesToCode(frames); }
+{
+    std::vector<uint8_t> result(frames.size());
+    Encode(frames.data(), frames.size(), result.data());
+    return result;
+}
+
+void Frames::Encode(const uint16_t* frames, const size_t length, uint8_t* codedData)
+{ internal::FramesToCode(frames, length, codedData); }
 
 } // namespace BAM
 } // namespace PacBio
@@ -160,18 +160,19 @@ IndexedFastaReader::ReferenceSubsequence(const BamRecord& bamRecord,
     if (bamRecord.Impl().IsMapped() && gapped)
     {
         size_t seqIndex = 0;
-        const Cigar& cigar = bamRecord.Impl().CigarData();
-        Cigar::const_iterator cigarIter = cigar.cbegin();
-        Cigar::const_iterator cigarEnd = cigar.cend();
+        const CigarView cigar = bamRecord.Impl().CigarDataView();
+        CigarView::const_iterator cigarIter = cigar.cbegin();
+        CigarView::const_iterator cigarEnd = cigar.cend();
         for (; cigarIter != cigarEnd; ++cigarIter)
         {
-            const CigarOperation& op = (*cigarIter);
-            const CigarOperationType& type = op.Type();
+            const CigarOperationType type = cigarIter.Type();
+            if (type == CigarOperationType::ALIGNMENT_MATCH)
+                throw std::runtime_error("CIGAR operation 'M' is not allowed in PacBio BAM files. Use 'X/=' instead.");
 
             // do nothing for hard clips
             if (type != CigarOperationType::HARD_CLIP)
             {
-                const size_t opLength = op.Length();
+                const size_t opLength = cigarIter.Length();
 
                 // maybe remove soft clips
                 if (type == CigarOperationType::SOFT_CLIP)
@@ -0,0 +1,361 @@
+// Copyright (c) 2016, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// File Description
+/// \file LazyVirtualZmwBamRecord.cpp
+/// \brief Implements the LazyVirtualZmwBamRecord class.
+//
+// Author: Derek Barnett
+
+#include "pbbam/virtual/LazyVirtualZmwBamRecord.h"
+#include "VirtualZmwStitching.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace PacBio {
+namespace BAM {
+namespace internal {
+
+inline void AppendTo(const std::string& src, std::string* dst)
+{ dst->append(src); }
+
+inline void AppendTo(const QualityValues& src, QualityValues* dst)
+{ dst->insert(dst->end(), src.cbegin(), src.cend()); }
+
+inline void AppendTo(const Frames& src, Frames* dst)
+{ dst->DataRaw().insert(dst->DataRaw().end(), src.Data().cbegin(), src.Data().cend()); }
+
+template<typename T>
+inline void AppendTo(const std::vector<T>& src, std::vector<T>* dst)
+{ dst->insert(dst->end(), src.cbegin(), src.cend()); }
+
+template<typename HasFn>
+inline bool AnySource(const std::vector<BamRecord>& sources, HasFn has)
+{ return std::any_of(sources.cbegin(), sources.cend(), has); }
+
+// Concatenates a field across all sources that have it, caching the result.
+template<typename T, typename HasFn, typename FetchFn>
+inline const T& StitchField(const std::vector<BamRecord>& sources,
+                            boost::optional<T>* cache,
+                            HasFn has,
+                            FetchFn fetch)
+{
+    if (!cache->is_initialized()) {
+        T result;
+        for (const BamRecord& b : sources) {
+            if (has(b))
+                AppendTo(fetch(b), &result);
+        }
+        *cache = std::move(result);
+    }
+    return cache->get();
+}
+
+} // namespace internal
+
+LazyVirtualZmwBamRecord::LazyVirtualZmwBamRecord(std::vector<BamRecord>&& unorderedSources,
+                                                 const BamHeader& header)
+    : sources_(std::move(unorderedSources))
+    , header_(header)
+{
+    if (sources_.empty())
+        throw std::runtime_error("cannot stitch ZMW record without source records");
+    internal::SortVirtualZmwSources(&sources_);
+}
+
+const BamHeader& LazyVirtualZmwBamRecord::Header(void) const
+{ return header_; }
+
+const std::vector<BamRecord>& LazyVirtualZmwBamRecord::Sources(void) const
+{ return sources_; }
+
+std::string LazyVirtualZmwBamRecord::FullName(void) const
+{
+    return sources_.front().MovieName() + "/" +
+           std::to_string(HoleNumber()) + "/" +
+           std::to_string(QueryStart()) + "_" +
+           std::to_string(QueryEnd());
+}
+
+int32_t LazyVirtualZmwBamRecord::HoleNumber(void) const
+{ return sources_.front().HoleNumber(); }
+
+Position LazyVirtualZmwBamRecord::QueryStart(void) const
+{ return sources_.front().QueryStart(); }
+
+Position LazyVirtualZmwBamRecord::QueryEnd(void) const
+{ return sources_.back().QueryEnd(); }
+
+bool LazyVirtualZmwBamRecord::HasVirtualRegionType(const VirtualRegionType regionType) const
+{
+    const auto& regions = VirtualRegionsMap();
+    return regions.find(regionType) != regions.cend();
+}
+
+const std::map<VirtualRegionType, std::vector<VirtualRegion>>&
+LazyVirtualZmwBamRecord::VirtualRegionsMap(void) const
+{
+    if (!virtualRegionsMap_.is_initialized()) {
+
+        // only sequence lengths needed here, not the sequences themselves
+        size_t sequenceLength = 0;
+        for (const BamRecord& b : sources_)
+            sequenceLength += b.Impl().SequenceLength();
+        virtualRegionsMap_ = internal::StitchVirtualRegions(sources_, sequenceLength);
+    }
+    return virtualRegionsMap_.get();
+}
+
+std::vector<VirtualRegion>
+LazyVirtualZmwBamRecord::VirtualRegionsTable(const VirtualRegionType regionType) const
+{
+    const auto& regions = VirtualRegionsMap();
+    const auto iter = regions.find(regionType);
+    if (iter != regions.cend())
+        return iter->second;
+    return std::vector<VirtualRegion>();
+}
+
+const std::string& LazyVirtualZmwBamRecord::Sequence(void) const
+{
+    return internal::StitchField(sources_, &sequence_,
+                                 [](const BamRecord&) { return true; },
+                                 [](const BamRecord& b) { return b.Sequence(); });
+}
+
+const QualityValues& LazyVirtualZmwBamRecord::Qualities(void) const
+{
+    return internal::StitchField(sources_, &qualities_,
+                                 [](const BamRecord&) { return true; },
+                                 [](const BamRecord& b) { return b.Qualities(); });
+}
+
+bool LazyVirtualZmwBamRecord::HasAltLabelQV(void) const
+{ return internal::AnySource(sources_, [](const BamRecord& b) { return b.HasAltLabelQV(); }); }
+
+bool LazyVirtualZmwBamRecord::HasAltLabelTag(void) const
+{ return internal::AnySource(sources_, [](const BamRecord& b) { return b.HasAltLabelTag(); }); }
+
+bool LazyVirtualZmwBamRecord::HasDeletionQV(void) const
+{ return internal::AnySource(sources_, [](const BamRecord& b) { return b.HasDeletionQV(); }); }
+
+bool LazyVirtualZmwBamRecord::HasDeletionTag(void) const
+{ return internal::AnySource(sources_, [](const BamRecord& b) { return b.HasDeletionTag(); }); }
+
+bool LazyVirtualZmwBamRecord::HasInsertionQV(void) const
+{ return internal::AnySource(sources_, [](const BamRecord& b) { return b.HasInsertionQV(); }); }
+
+bool LazyVirtualZmwBamRecord::HasIPD(void) const
+{ return internal::AnySource(sources_, [](const BamRecord& b) { return b.HasIPD(); }); }
+
+bool LazyVirtualZmwBamRecord::HasLabelQV(void) const
+{ return internal::AnySource(sources_, [](const BamRecord& b) { return b.HasLabelQV(); }); }
+
+bool LazyVirtualZmwBamRecord::HasMergeQV(void) const
+{ return internal::AnySource(sources_, [](const BamRecord& b) { return b.HasMergeQV(); }); }
+
+bool LazyVirtualZmwBamRecord::HasPkmean(void) const
+{ return internal::AnySource(sources_, [](const BamRecord& b) { return b.HasPkmean() || b.HasPkmean2(); }); }
+
+bool LazyVirtualZmwBamRecord::HasPkmid(void) const
+{ return internal::AnySource(sources_, [](const BamRecord& b) { return b.HasPkmid() || b.HasPkmid2(); }); }
+
+bool LazyVirtualZmwBamRecord::HasPrePulseFrames(void) const
+{ return internal::AnySource(sources_, [](const BamRecord& b) { return b.HasPrePulseFrames(); }); }
+
+bool LazyVirtualZmwBamRecord::HasPulseCall(void) const
+{ return internal::AnySource(sources_, [](const BamRecord& b) { return b.HasPulseCall(); }); }
+
+bool LazyVirtualZmwBamRecord::HasPulseCallWidth(void) const
+{ return internal::AnySource(sources_, [](const BamRecord& b) { return b.HasPulseCallWidth(); }); }
+
+bool LazyVirtualZmwBamRecord::HasPulseMergeQV(void) const
+{ return internal::AnySource(sources_, [](const BamRecord& b) { return b.HasPulseMergeQV(); }); }
+
+bool LazyVirtualZmwBamRecord::HasPulseWidth(void) const
+{ return internal::AnySource(sources_, [](const BamRecord& b) { return b.HasPulseWidth(); }); }
+
+bool LazyVirtualZmwBamRecord::HasStartFrame(void) const
+{ return internal::AnySource(sources_, [](const BamRecord& b) { return b.HasStartFrame(); }); }
+
+bool LazyVirtualZmwBamRecord::HasSubstitutionQV(void) const
+{ return internal::AnySource(sources_, [](const BamRecord& b) { return b.HasSubstitutionQV(); }); }
+
+bool LazyVirtualZmwBamRecord::HasSubstitutionTag(void) const
+{ return internal::AnySource(sources_, [](const BamRecord& b) { return b.HasSubstitutionTag(); }); }
+
+const QualityValues& LazyVirtualZmwBamRecord::AltLabelQV(void) const
+{
+    return internal::StitchField(sources_, &altLabelQV_,
+                                 [](const BamRecord& b) { return b.HasAltLabelQV(); },
+                                 [](const BamRecord& b) { return b.AltLabelQV(); });
+}
+
+const std::string& LazyVirtualZmwBamRecord::AltLabelTag(void) const
+{
+    return internal::StitchField(sources_, &altLabelTag_,
+                                 [](const BamRecord& b) { return b.HasAltLabelTag(); },
+                                 [](const BamRecord& b) { return b.AltLabelTag(); });
+}
+
+const QualityValues& LazyVirtualZmwBamRecord::DeletionQV(void) const
+{
+    return internal::StitchField(sources_, &deletionQV_,
+                                 [](const BamRecord& b) { return b.HasDeletionQV(); },
+                                 [](const BamRecord& b) { return b.DeletionQV(); });
+}
+
+const std::string& LazyVirtualZmwBamRecord::DeletionTag(void) const
+{
+    return internal::StitchField(sources_, &deletionTag_,
+                                 [](const BamRecord& b) { return b.HasDeletionTag(); },
+                                 [](const BamRecord& b) { return b.DeletionTag(); });
+}
+
+const QualityValues& LazyVirtualZmwBamRecord::InsertionQV(void) const
+{
+    return internal::StitchField(sources_, &insertionQV_,
+                                 [](const BamRecord& b) { return b.HasInsertionQV(); },
+                                 [](const BamRecord& b) { return b.InsertionQV(); });
+}
+
+const Frames& LazyVirtualZmwBamRecord::IPD(void) const
+{
+    return internal::StitchField(sources_, &ipd_,
+                                 [](const BamRecord& b) { return b.HasIPD(); },
+                                 [](const BamRecord& b) { return b.IPD(); });
+}
+
+const QualityValues& LazyVirtualZmwBamRecord::LabelQV(void) const
+{
+    return internal::StitchField(sources_, &labelQV_,
+                                 [](const BamRecord& b) { return b.HasLabelQV(); },
+                                 [](const BamRecord& b) { return b.LabelQV(); });
+}
+
+const QualityValues& LazyVirtualZmwBamRecord::MergeQV(void) const
+{
+    return internal::StitchField(sources_, &mergeQV_,
+                                 [](const BamRecord& b) { return b.HasMergeQV(); },
+                                 [](const BamRecord& b) { return b.MergeQV(); });
+}
+
+const std::vector<float>& LazyVirtualZmwBamRecord::Pkmean(void) const
+{
+    // NOTE: pkmean2 is appended to pkmean, as in VirtualZmwBamRecord
+    return internal::StitchField(sources_, &pkmean_,
+                                 [](const BamRecord& b) { return b.HasPkmean() || b.HasPkmean2(); },
+                                 [](const BamRecord& b) {
+                                     std::vector<float> pkmean = b.Pkmean();
+                                     if (b.HasPkmean2())
+                                         internal::AppendTo(b.Pkmean2(), &pkmean);
+                                     return pkmean;
+                                 });
+}
+
+const std::vector<float>& LazyVirtualZmwBamRecord::Pkmid(void) const
+{
+    // NOTE: pkmid2 is appended to pkmid, as in VirtualZmwBamRecord
+    return internal::StitchField(sources_, &pkmid_,
+                                 [](const BamRecord& b) { return b.HasPkmid() || b.HasPkmid2(); },
+                                 [](const BamRecord& b) {
+                                     std::vector<float> pkmid = b.Pkmid();
+                                     if (b.HasPkmid2())
+                                         internal::AppendTo(b.Pkmid2(), &pkmid);
+                                     return pkmid;
+                                 });
+}
+
+const Frames& LazyVirtualZmwBamRecord::PrePulseFrames(void) const
+{
+    return internal::StitchField(sources_, &prePulseFrames_,
+                                 [](const BamRecord& b) { return b.HasPrePulseFrames(); },
+                                 [](const BamRecord& b) { return b.PrePulseFrames(); });
+}
+
+const std::string& LazyVirtualZmwBamRecord::PulseCall(void) const
+{
+    return internal::StitchField(sources_, &pulseCall_,
+                                 [](const BamRecord& b) { return b.HasPulseCall(); },
+                                 [](const BamRecord& b) { return b.PulseCall(); });
+}
+
+const Frames& LazyVirtualZmwBamRecord::PulseCallWidth(void) const
+{
+    return internal::StitchField(sources_, &pulseCallWidth_,
+                                 [](const BamRecord& b) { return b.HasPulseCallWidth(); },
+                                 [](const BamRecord& b) { return b.PulseCallWidth(); });
+}
+
+const QualityValues& LazyVirtualZmwBamRecord::PulseMergeQV(void) const
+{
+    return internal::StitchField(sources_, &pulseMergeQV_,
+                                 [](const BamRecord& b) { return b.HasPulseMergeQV(); },
+                                 [](const BamRecord& b) { return b.PulseMergeQV(); });
+}
+
+const Frames& LazyVirtualZmwBamRecord::PulseWidth(void) const
+{
+    return internal::StitchField(sources_, &pulseWidth_,
+                                 [](const BamRecord& b) { return b.HasPulseWidth(); },
+                                 [](const BamRecord& b) { return b.PulseWidth(); });
+}
+
+const std::vector<uint32_t>& LazyVirtualZmwBamRecord::StartFrame(void) const
+{
+    return internal::StitchField(sources_, &startFrame_,
+                                 [](const BamRecord& b) { return b.HasStartFrame(); },
+                                 [](const BamRecord& b) { return b.StartFrame(); });
+}
+
+const QualityValues& LazyVirtualZmwBamRecord::SubstitutionQV(void) const
+{
+    return internal::StitchField(sources_, &substitutionQV_,
+                                 [](const BamRecord& b) { return b.HasSubstitutionQV(); },
+                                 [](const BamRecord& b) { return b.SubstitutionQV(); });
+}
+
+const std::string& LazyVirtualZmwBamRecord::SubstitutionTag(void) const
+{
+    return internal::StitchField(sources_, &substitutionTag_,
+                                 [](const BamRecord& b) { return b.HasSubstitutionTag(); },
+                                 [](const BamRecord& b) { return b.SubstitutionTag(); });
+}
+
+VirtualZmwBamRecord LazyVirtualZmwBamRecord::ToBamRecord(void) const
+{ return VirtualZmwBamRecord{ std::vector<BamRecord>(sources_), header_ }; }
+
+} // namespace BAM
+} // namespace PacBio
@@ -0,0 +1,339 @@
+// Copyright (c) 2016, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// File Description
+/// \file MultiIntervalQuery.cpp
+/// \brief Implements the MultiIntervalQuery class.
+//
+// Author: Derek Barnett
+
+#include "pbbam/MultiIntervalQuery.h"
+#include "pbbam/CompositeBamReader.h"
+#include "MemoryUtils.h"
+#include <htslib/sam.h>
+#include <algorithm>
+#include <map>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <tuple>
+#include <unordered_map>
+
+namespace PacBio {
+namespace BAM {
+namespace internal {
+
+struct RegionBounds
+{
+    int32_t tId_;
+    int32_t start_;
+    int32_t stop_;
+};
+
+// Reads one BAM file's records overlapping a set of regions, visiting the
+// union of the regions' BAI chunks in file order.
+//
+class MultiIntervalBamReader : public BamReader
+{
+public:
+    MultiIntervalBamReader(BamFile&& bamFile,
+                           const std::vector<GenomicInterval>& intervals)
+        : BamReader(std::move(bamFile))
+        , chunkIndex_(0)
+        , inChunk_(false)
+        , regionIndex_(0)
+    {
+        const BamHeader& header = File().Header();
+        for (const GenomicInterval& interval : intervals) {
+            if (interval.Start() >= interval.Stop() || !header.HasSequence(interval.Name()))
+                continue;
+            const int32_t tId = header.SequenceId(interval.Name());
+            regions_.push_back(RegionBounds{ tId, std::max(interval.Start(), Position(0)), interval.Stop() });
+        }
+
+        // sort & merge overlapping (or abutting) regions
+        std::sort(regions_.begin(), regions_.end(),
+                  [](const RegionBounds& lhs, const RegionBounds& rhs)
+                  { return std::tie(lhs.tId_, lhs.start_) < std::tie(rhs.tId_, rhs.start_); });
+        auto merged = std::vector<RegionBounds>{ };
+        for (const RegionBounds& region : regions_) {
+            if (!merged.empty() &&
+                merged.back().tId_ == region.tId_ &&
+                merged.back().stop_ >= region.start_)
+            {
+                merged.back().stop_ = std::max(merged.back().stop_, region.stop_);
+            }
+            else
+                merged.push_back(region);
+        }
+        regions_ = std::move(merged);
+
+        LoadChunks();
+    }
+
+protected:
+    int ReadRawData(BGZF* bgzf, bam1_t* b) override
+    {
+        while (chunkIndex_ < chunks_.size() && regionIndex_ < regions_.size()) {
+            const hts_pair64_t& chunk = chunks_.at(chunkIndex_);
+
+            // on new chunk, move to its start. records between chunks within
+            // the current BGZF block are read through, rather than re-loading
+            // the block (they cannot overlap any region, so are dropped below)
+            if (!inChunk_) {
+                const uint64_t currentOffset = static_cast<uint64_t>(bgzf_tell(bgzf));
+                if (currentOffset > chunk.u || (currentOffset >> 16) != (chunk.u >> 16))
+                    VirtualSeek(static_cast<int64_t>(chunk.u));
+                inChunk_ = true;
+            }
+
+            if (static_cast<uint64_t>(bgzf_tell(bgzf)) >= chunk.v) {
+                ++chunkIndex_;
+                inChunk_ = false;
+                continue;
+            }
+
+            const int result = bam_read1(bgzf, b);
+            if (result < 0)
+                return result;
+            if (Overlaps(b))
+                return result;
+        }
+        return -1; // "EOF"
+    }
+
+private:
+    void LoadChunks(void)
+    {
+        if (regions_.empty())
+            return;
+
+        std::unique_ptr<hts_idx_t, HtslibIndexDeleter> htsIndex{ bam_index_load(File().Filename().c_str()) };
+        if (!htsIndex)
+            throw std::runtime_error("could not load BAI index data");
+
+        for (const RegionBounds& region : regions_) {
+            std::unique_ptr<hts_itr_t, HtslibIteratorDeleter> htsIterator{
+                bam_itr_queryi(htsIndex.get(), region.tId_, region.start_, region.stop_)
+            };
+            if (!htsIterator)
+                throw std::runtime_error("could not create iterator for requested region");
+            for (int i = 0; i < htsIterator->n_off; ++i)
+                chunks_.push_back(htsIterator->off[i]);
+        }
+
+        // sort & merge chunks, so that each record is read once
+        std::sort(chunks_.begin(), chunks_.end(),
+                  [](const hts_pair64_t& lhs, const hts_pair64_t& rhs)
+                  { return lhs.u < rhs.u; });
+        auto merged = std::vector<hts_pair64_t>{ };
+        for (const hts_pair64_t& chunk : chunks_) {
+            if (!merged.empty() && merged.back().v >= chunk.u)
+                merged.back().v = std::max(merged.back().v, chunk.v);
+            else
+                merged.push_back(chunk);
+        }
+        chunks_ = std::move(merged);
+    }
+
+    // Records arrive in coordinate order, so regions ending at or before the
+    // current record's start can be discarded for good.
+    bool Overlaps(const bam1_t* b)
+    {
+        const int32_t tId = b->core.tid;
+        const int32_t start = b->core.pos;
+        while (regionIndex_ < regions_.size()) {
+            const RegionBounds& region = regions_.at(regionIndex_);
+            if (region.tId_ < tId || (region.tId_ == tId && region.stop_ <= start))
+                ++regionIndex_;
+            else
+                break;
+        }
+        if (regionIndex_ == regions_.size())
+            return false;
+
+        const RegionBounds& region = regions_.at(regionIndex_);
+        return region.tId_ == tId && region.start_ < bam_endpos(b);
+    }
+
+private:
+    std::vector<RegionBounds> regions_;
+    std::vector<hts_pair64_t> chunks_;
+    size_t chunkIndex_;
+    bool inChunk_;
+    size_t regionIndex_;
+};
+
+// Intervals on a single reference, for looking up those overlapping a record.
+// 'maxStop_' is a running max of interval stops (in start order), so overlap
+// candidates are bounded by binary search on both ends.
+//
+struct ReferenceIntervals
+{
+    std::vector<size_t> indices_;
+    std::vector<Position> starts_;
+    std::vector<Position> stops_;
+    std::vector<Position> maxStop_;
+};
+
+} // namespace internal
+
+struct MultiIntervalQuery::MultiIntervalQueryPrivate
+{
+    MultiIntervalQueryPrivate(const std::vector<GenomicInterval>& intervals,
+                              const DataSet& dataset)
+        : intervals_(intervals)
+        , hasCachedReference_(false)
+        , cachedReference_(nullptr)
+    {
+        IndexIntervals();
+        OpenFiles(dataset.BamFiles());
+    }
+
+    void IndexIntervals(void)
+    {
+        for (size_t i = 0; i < intervals_.size(); ++i) {
+            const GenomicInterval& interval = intervals_.at(i);
+            if (interval.Start() < interval.Stop())
+                references_[interval.Name()].indices_.push_back(i);
+        }
+
+        for (auto& entry : references_) {
+            internal::ReferenceIntervals& ref = entry.second;
+            std::stable_sort(ref.indices_.begin(), ref.indices_.end(),
+                             [this](const size_t lhs, const size_t rhs)
+                             { return intervals_.at(lhs).Start() < intervals_.at(rhs).Start(); });
+            Position maxStop = 0;
+            for (const size_t i : ref.indices_) {
+                const GenomicInterval& interval = intervals_.at(i);
+                maxStop = std::max(maxStop, interval.Stop());
+                ref.starts_.push_back(interval.Start());
+                ref.stops_.push_back(interval.Stop());
+                ref.maxStop_.push_back(maxStop);
+            }
+        }
+    }
+
+    void OpenFiles(const std::vector<BamFile>& bamFiles)
+    {
+        auto filesSeen = std::set<std::string>{ };
+        std::vector<std::string> missingBai;
+        for (const BamFile& bamFile : bamFiles) {
+            if (!filesSeen.insert(bamFile.Filename()).second)
+                continue;
+            if (!bamFile.StandardIndexExists()) {
+                missingBai.push_back(bamFile.Filename());
+                continue;
+            }
+
+            auto item = internal::CompositeMergeItem{
+                std::unique_ptr<BamReader>{ new internal::MultiIntervalBamReader{ BamFile{ bamFile }, intervals_ } }
+            };
+            if (item.reader->GetNext(item.record))
+                mergeItems_.Push(std::move(item));
+            // else not an error, simply no data matching intervals
+        }
+
+        if (!missingBai.empty()) {
+            std::stringstream e;
+            e << "failed to open MultiIntervalQuery because the following files are missing a BAI file:" << std::endl;
+            for (const auto& fn : missingBai)
+                e << "  " << fn << std::endl;
+            throw std::runtime_error(e.str());
+        }
+    }
+
+    bool GetNext(BamRecord& record)
+    {
+        currentIntervals_.clear();
+        if (!mergeItems_.GetNext(record))
+            return false;
+
+        // cache on name, not ID: input files may list references in different orders
+        std::string refName = record.ReferenceName();
+        if (!hasCachedReference_ || refName != cachedReferenceName_) {
+            const auto found = references_.find(refName);
+            hasCachedReference_ = true;
+            cachedReferenceName_ = std::move(refName);
+            cachedReference_ = (found == references_.cend()) ? nullptr : &found->second;
+        }
+
+        if (cachedReference_) {
+            const internal::ReferenceIntervals& ref = *cachedReference_;
+            const Position start = record.ReferenceStart();
+            const Position end = std::max(record.ReferenceEnd(), start + 1);
+
+            const size_t last = std::lower_bound(ref.starts_.cbegin(), ref.starts_.cend(), end)
+                                - ref.starts_.cbegin();
+            const size_t first = std::upper_bound(ref.maxStop_.cbegin(), ref.maxStop_.cbegin() + last, start)
+                                 - ref.maxStop_.cbegin();
+            for (size_t i = first; i < last; ++i) {
+                if (ref.stops_.at(i) > start)
+                    currentIntervals_.push_back(ref.indices_.at(i));
+            }
+            std::sort(currentIntervals_.begin(), currentIntervals_.end());
+        }
+        return true;
+    }
+
+    std::vector<GenomicInterval> intervals_;
+    std::unordered_map<std::string, internal::ReferenceIntervals> references_;
+    internal::CompositeMergeHeap<internal::PositionMergeKey> mergeItems_;
+    std::vector<size_t> currentIntervals_;
+
+    bool hasCachedReference_;
+    std::string cachedReferenceName_;
+    const internal::ReferenceIntervals* cachedReference_;
+};
+
+MultiIntervalQuery::MultiIntervalQuery(const std::vector<GenomicInterval>& intervals,
+                                       const DataSet& dataset)
+    : internal::IQuery()
+    , d_(new MultiIntervalQueryPrivate(intervals, dataset))
+{ }
+
+MultiIntervalQuery::~MultiIntervalQuery(void) { }
+
+bool MultiIntervalQuery::GetNext(BamRecord& r)
+{ return d_->GetNext(r); }
+
+const std::vector<size_t>& MultiIntervalQuery::CurrentIntervals(void) const
+{ return d_->currentIntervals_; }
+
+const std::vector<GenomicInterval>& MultiIntervalQuery::Intervals(void) const
+{ return d_->intervals_; }
+
+} // namespace BAM
+} // namespace PacBio
@@ -0,0 +1,321 @@
+// Copyright (c) 2016, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// File Description
+/// \file ParallelZmwReadStitcher.cpp
+/// \brief Implements the ParallelZmwReadStitcher class.
+//
+// Author: Derek Barnett
+
+#include "pbbam/virtual/ParallelZmwReadStitcher.h"
+#include "pbbam/BamWriter.h"
+#include "pbbam/DataSet.h"
+#include "pbbam/PbiFilter.h"
+#include "ThreadPool.h"
+#include "VirtualZmwReader.h"
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <cassert>
+
+namespace PacBio {
+namespace BAM {
+
+const size_t ParallelZmwReadStitcher::DefaultWindowSize = 256;
+
+struct ParallelZmwReadStitcher::ParallelZmwReadStitcherPrivate
+{
+public:
+    typedef std::pair<std::string, std::string> Source;
+
+    // one in-flight ZMW, stitched by a worker
+    struct Slot
+    {
+        Slot(void) : ready_(false) { }
+
+        bool ready_;
+        std::unique_ptr<VirtualZmwBamRecord> record_;
+        std::exception_ptr error_;
+    };
+
+public:
+    ParallelZmwReadStitcherPrivate(std::deque<Source>&& sources,
+                                   const PbiFilter& filter,
+                                   const size_t numThreads,
+                                   const size_t windowSize)
+        : sources_(std::move(sources))
+        , filter_(filter)
+        , windowSize_(std::max(windowSize, size_t(1)))
+        , readerDone_(false)
+        , stop_(false)
+        , pool_(new internal::ThreadPool{ numThreads })
+    {
+        // open first source here, so that failures are reported immediately
+        OpenNextReader();
+        reader_ = std::thread(&ParallelZmwReadStitcherPrivate::ReadZmws, this);
+    }
+
+    ~ParallelZmwReadStitcherPrivate(void)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        hasRoom_.notify_all();
+        if (reader_.joinable())
+            reader_.join();
+
+        // discards queued stitches & waits for running ones
+        pool_.reset();
+    }
+
+public:
+    bool HasNext(void)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        hasResult_.wait(lock, [this]() { return !window_.empty() || readerDone_; });
+        return !window_.empty() || readerError_;
+    }
+
+    VirtualZmwBamRecord Next(void)
+    {
+        std::unique_ptr<VirtualZmwBamRecord> record;
+        std::exception_ptr error;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            hasResult_.wait(lock, [this]() {
+                return (!window_.empty() && window_.front()->ready_) ||
+                       (window_.empty() && readerDone_);
+            });
+
+            if (window_.empty()) {
+                // reader error is reported once, after which there are no more records
+                if (readerError_) {
+                    std::exception_ptr readerError;
+                    std::swap(readerError, readerError_);
+                    std::rethrow_exception(readerError);
+                }
+                throw std::runtime_error("no more stitched records available, make sure "
+                                         "you use ParallelZmwReadStitcher::HasNext before "
+                                         "requesting next record");
+            }
+
+            std::shared_ptr<Slot> slot = window_.front();
+            window_.pop_front();
+            record = std::move(slot->record_);
+            error = slot->error_;
+        }
+        hasRoom_.notify_one();
+
+        if (error)
+            std::rethrow_exception(error);
+
+        assert(record);
+        return std::move(*record);
+    }
+
+    size_t NumThreads(void) const
+    { return pool_->NumThreads(); }
+
+    size_t WindowSize(void) const
+    { return windowSize_; }
+
+private:
+    void OpenNextReader(void)
+    {
+        zmwReader_.reset();
+        while (!sources_.empty()) {
+            const Source source = sources_.front();
+            sources_.pop_front();
+            std::unique_ptr<internal::VirtualZmwReader> next(
+                new internal::VirtualZmwReader(source.first, source.second, filter_));
+            if (next->HasNext()) {
+                header_ = next->StitchedHeader();
+                zmwReader_ = std::move(next);
+                return;
+            }
+        }
+    }
+
+    // I/O thread: reads each ZMW's records & hands them off for stitching
+    void ReadZmws(void)
+    {
+        try {
+            while (zmwReader_) {
+                while (zmwReader_->HasNext()) {
+                    auto records = std::make_shared<std::vector<BamRecord> >(zmwReader_->NextRaw());
+                    auto slot = std::make_shared<Slot>();
+                    {
+                        std::unique_lock<std::mutex> lock(mutex_);
+                        hasRoom_.wait(lock, [this]() { return stop_ || window_.size() < windowSize_; });
+                        if (stop_)
+                            return;
+                        window_.push_back(slot);
+                    }
+                    hasResult_.notify_all();
+
+                    const BamHeader header = header_;
+                    pool_->Submit([this, slot, records, header]() {
+                        Stitch(slot, records, header);
+                    });
+                }
+                OpenNextReader();
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            readerError_ = std::current_exception();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            readerDone_ = true;
+        }
+        hasResult_.notify_all();
+    }
+
+    // worker thread: stitches one ZMW
+    void Stitch(const std::shared_ptr<Slot>& slot,
+                const std::shared_ptr<std::vector<BamRecord> >& records,
+                const BamHeader& header)
+    {
+        std::unique_ptr<VirtualZmwBamRecord> record;
+        std::exception_ptr error;
+        try {
+            record.reset(new VirtualZmwBamRecord{ std::move(*records), header });
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            slot->record_ = std::move(record);
+            slot->error_ = error;
+            slot->ready_ = true;
+        }
+        hasResult_.notify_all();
+    }
+
+private:
+    // owned by I/O thread, after construction
+    std::deque<Source> sources_;
+    PbiFilter filter_;
+    std::unique_ptr<internal::VirtualZmwReader> zmwReader_;
+    BamHeader header_;
+
+    // shared state
+    const size_t windowSize_;
+    std::deque<std::shared_ptr<Slot> > window_;
+    bool readerDone_;
+    std::exception_ptr readerError_;
+    bool stop_;
+    std::mutex mutex_;
+    std::condition_variable hasResult_;
+    std::condition_variable hasRoom_;
+
+    std::thread reader_;
+
+    // declared last, so destroyed (joining workers) before shared state
+    std::unique_ptr<internal::ThreadPool> pool_;
+};
+
+// ----------------------------------------
+// ParallelZmwReadStitcher implementation
+// ----------------------------------------
+
+ParallelZmwReadStitcher::ParallelZmwReadStitcher(const std::string& primaryBamFilePath,
+                                                 const std::string& scrapsBamFilePath,
+                                                 const size_t numThreads,
+                                                 const size_t windowSize)
+    : ParallelZmwReadStitcher(primaryBamFilePath,
+                              scrapsBamFilePath,
+                              PbiFilter{},
+                              numThreads,
+                              windowSize)
+{ }
+
+ParallelZmwReadStitcher::ParallelZmwReadStitcher(const std::string& primaryBamFilePath,
+                                                 const std::string& scrapsBamFilePath,
+                                                 const PbiFilter& filter,
+                                                 const size_t numThreads,
+                                                 const size_t windowSize)
+{
+    std::deque<ParallelZmwReadStitcherPrivate::Source> sources;
+    sources.push_back(std::make_pair(primaryBamFilePath, scrapsBamFilePath));
+    d_.reset(new ParallelZmwReadStitcherPrivate(std::move(sources),
+                                                filter,
+                                                numThreads,
+                                                windowSize));
+}
+
+ParallelZmwReadStitcher::ParallelZmwReadStitcher(const DataSet& dataset,
+                                                 const size_t numThreads,
+                                                 const size_t windowSize)
+    : d_(new ParallelZmwReadStitcherPrivate(internal::ZmwStitchingSources(dataset),
+                                            PbiFilter::FromDataSet(dataset),
+                                            numThreads,
+                                            windowSize))
+{ }
+
+ParallelZmwReadStitcher::~ParallelZmwReadStitcher(void) { }
+
+bool ParallelZmwReadStitcher::HasNext(void)
+{ return d_->HasNext(); }
+
+VirtualZmwBamRecord ParallelZmwReadStitcher::Next(void)
+{ return d_->Next(); }
+
+size_t ParallelZmwReadStitcher::NumThreads(void) const
+{ return d_->NumThreads(); }
+
+size_t ParallelZmwReadStitcher::WindowSize(void) const
+{ return d_->WindowSize(); }
+
+size_t ParallelZmwReadStitcher::WriteTo(BamWriter& writer)
+{
+    size_t count = 0;
+    while (HasNext()) {
+        writer.Write(Next());
+        ++count;
+    }
+    return count;
+}
+
+} // namespace BAM
+} // namespace PacBio
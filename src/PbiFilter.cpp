@@ -46,7 +46,6 @@
 #include <boost/algorithm/string/trim.hpp>
 #include <boost/numeric/conversion/cast.hpp>
 #include <algorithm>
-#include <fstream>
 #include <iostream>
 #include <sstream>
 #include <string>
@@ -253,12 +252,7 @@ PbiFilter CreateQueryNamesFilterFromFile(const std::string& value,
 {
     // resolve file from dataset, value
     const std::string resolvedFilename = dataset.ResolvePath(value);
-    std::vector<std::string> whitelist;
-    std::string fn;
-    std::ifstream in(resolvedFilename);
-    while (std::getline(in, fn))
-        whitelist.push_back(fn);
-    return PbiQueryNameFilter{ whitelist };
+    return PbiQueryNameFilter::FromFile(resolvedFilename);
 }
 
 static
@@ -41,9 +41,18 @@
 
 #include "pbbam/PbiFilterTypes.h"
 #include "StringUtils.h"
+#include "ThreadPool.h"
 #include <boost/algorithm/string.hpp>
+#include <algorithm>
+#include <exception>
+#include <fstream>
+#include <future>
+#include <limits>
+#include <memory>
 #include <sstream>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <cassert>
 
 namespace PacBio {
@@ -209,136 +218,425 @@ bool PbiQueryLengthFilter::Accepts(const PbiRawData& idx, const size_t row) cons
 
 // PbiQueryNameFilter
 
+namespace internal {
+
+// Compact lookup key for one whitelisted query name.
+//
+// 'group' encodes the movie (interned) and whether the name was CCS, so that
+// each key is a fixed-width tuple that can be sorted & compared as integers.
+//
+struct QueryNameKey
+{
+    uint32_t group;
+    int32_t  zmw;
+    int32_t  qStart;
+    int32_t  qEnd;
+
+    bool operator<(const QueryNameKey& other) const
+    {
+        if (group  != other.group)  return group  < other.group;
+        if (zmw    != other.zmw)    return zmw    < other.zmw;
+        if (qStart != other.qStart) return qStart < other.qStart;
+        return qEnd < other.qEnd;
+    }
+
+    bool operator==(const QueryNameKey& other) const
+    {
+        return group  == other.group  &&
+               zmw    == other.zmw    &&
+               qStart == other.qStart &&
+               qEnd   == other.qEnd;
+    }
+};
+
+// only bother with worker threads when there's enough work to share
+static const size_t MinQueryNamesPerThread = 100000;
+
+// same limit for query name files, in bytes (~100K typical PacBio QNAMEs)
+static const size_t MinQueryNameBytesPerThread = 4 * 1024 * 1024;
+
+// query name files are parsed in blocks of this size
+static const size_t QueryNameFileBlockSize = 64 * 1024 * 1024;
+
+// Parsed names from one thread's share of the whitelist. Movie indices are
+// local to this result until merged.
+//
+struct QueryNameParseResult
+{
+    std::vector<std::string> movies;
+    std::unordered_map<std::string, uint32_t> movieLookup;
+    std::vector<QueryNameKey> keys;
+};
+
+static
+void throwInvalidQueryName(const char* begin, const char* end)
+{
+    auto msg = std::string{ "PbiQueryNameFilter error: requested QNAME (" } + std::string{ begin, end };
+    msg += std::string{ ") is not a valid PacBio BAM QNAME. See spec for details"};
+    throw std::runtime_error(msg);
+}
+
+static inline
+bool parseInt32(const char* begin, const char* end, int32_t* result)
+{
+    if (begin == end)
+        return false;
+
+    bool isNegative = false;
+    if (*begin == '-') {
+        isNegative = true;
+        ++begin;
+        if (begin == end)
+            return false;
+    }
+
+    int64_t value = 0;
+    for (const char* c = begin; c != end; ++c) {
+        if (*c < '0' || *c > '9')
+            return false;
+        value = (value * 10) + (*c - '0');
+        if (value > std::numeric_limits<int32_t>::max())
+            return false;
+    }
+    *result = static_cast<int32_t>(isNegative ? -value : value);
+    return true;
+}
+
+// Parses a single "movie/zmw/qStart_qEnd" or "movie/zmw/ccs" name, appending
+// its key to 'result'. The movie name is interned, so each distinct movie is
+// stored (and later hashed into read group IDs) only once.
+//
+static
+void parseQueryName(const char* begin, const char* end, QueryNameParseResult* result)
+{
+    // split name into main parts
+    const char* firstSlash = std::find(begin, end, '/');
+    if (firstSlash == end)
+        throwInvalidQueryName(begin, end);
+    const char* secondSlash = std::find(firstSlash+1, end, '/');
+    if (secondSlash == end || std::find(secondSlash+1, end, '/') != end)
+        throwInvalidQueryName(begin, end);
+
+    QueryNameKey key;
+
+    // fetch ZMW
+    if (!parseInt32(firstSlash+1, secondSlash, &key.zmw))
+        throwInvalidQueryName(begin, end);
+
+    // fetch QueryStart/QEnd from query name, or (-1,-1) if CCS
+    const char* lastPart = secondSlash+1;
+    const size_t lastPartLength = end - lastPart;
+    const bool isCCS = (lastPartLength == 3 &&
+                        (std::equal(lastPart, end, "ccs") ||
+                         std::equal(lastPart, end, "CCS")));
+    if (isCCS) {
+        key.qStart = -1;
+        key.qEnd   = -1;
+    } else {
+        const char* underscore = std::find(lastPart, end, '_');
+        if (underscore == end ||
+            !parseInt32(lastPart, underscore, &key.qStart) ||
+            !parseInt32(underscore+1, end, &key.qEnd))
+        {
+            throwInvalidQueryName(begin, end);
+        }
+    }
+
+    // intern movie name
+    uint32_t movieIndex = 0;
+    std::string movieName{ begin, firstSlash };
+    const auto movieFound = result->movieLookup.find(movieName);
+    if (movieFound == result->movieLookup.end()) {
+        movieIndex = static_cast<uint32_t>(result->movies.size());
+        result->movies.push_back(movieName);
+        result->movieLookup.emplace(std::move(movieName), movieIndex);
+    } else
+        movieIndex = movieFound->second;
+
+    key.group = (movieIndex << 1) | (isCCS ? 1 : 0);
+    result->keys.push_back(key);
+}
+
+// Parses all newline-delimited names in [begin, end). Blank lines (including
+// any trailing carriage return) are skipped.
+//
+static
+void parseQueryNameLines(const char* begin, const char* end, QueryNameParseResult* result)
+{
+    while (begin < end) {
+        const char* lineEnd = std::find(begin, end, '\n');
+        const char* nameEnd = lineEnd;
+        if (nameEnd != begin && *(nameEnd-1) == '\r')
+            --nameEnd;
+        if (nameEnd != begin)
+            parseQueryName(begin, nameEnd, result);
+        begin = (lineEnd == end ? end : lineEnd + 1);
+    }
+}
+
+// Runs 'parseChunk(i)' for i in [0, numChunks). Chunk 0 runs on the calling
+// thread, the rest on 'pool' (which must be non-null if numChunks > 1). Any
+// exception thrown from a worker is re-thrown here.
+//
+template<typename ParseChunk>
+void parseInParallel(const size_t numChunks,
+                     ParseChunk parseChunk,
+                     ThreadPool* pool)
+{
+    if (numChunks == 1) {
+        parseChunk(0);
+        return;
+    }
+
+    assert(pool);
+    std::vector<std::future<void> > workers;
+    workers.reserve(numChunks - 1);
+    for (size_t i = 1; i < numChunks; ++i)
+        workers.push_back(pool->Submit([&parseChunk, i]() { parseChunk(i); }));
+
+    // wait for all workers before re-throwing, they reference our stack
+    std::exception_ptr error;
+    try { parseChunk(0); }
+    catch (...) { error = std::current_exception(); }
+    for (auto& worker : workers) {
+        try { worker.get(); }
+        catch (...) {
+            if (!error)
+                error = std::current_exception();
+        }
+    }
+    if (error)
+        std::rethrow_exception(error);
+}
+
+} // namespace internal
+
 struct PbiQueryNameFilter::PbiQueryNameFilterPrivate
 {
 public:
-    typedef std::pair<int32_t, int32_t>                 QueryInterval;
-    typedef std::set<QueryInterval>                     QueryIntervals;
-    typedef std::unordered_map<int32_t, QueryIntervals> ZmwLookup;
-    typedef std::shared_ptr<ZmwLookup>                  ZmwLookupPtr;
-    typedef std::unordered_map<int32_t, ZmwLookupPtr>   RgIdLookup;
+    typedef std::vector<internal::QueryNameKey> KeyTable;
 
 public:
-    PbiQueryNameFilterPrivate(const std::vector<std::string>& whitelist)
+    PbiQueryNameFilterPrivate(const std::vector<std::string>& whitelist,
+                              const size_t numThreads)
     {
-        for (const auto& queryName : whitelist) {
-
-            // split name into main parts
-            auto nameParts = internal::Split(queryName, '/');
-            if (nameParts.size() != 3) {
-                auto msg = std::string{ "PbiQueryNameFilter error: requested QNAME (" } + queryName;
-                msg += std::string{ ") is not a valid PacBio BAM QNAME. See spec for details"};
-                throw std::runtime_error(msg);
+        const size_t maxThreads = internal::ThreadPool::ActualNumThreads(numThreads);
+        const size_t numChunks =
+            std::max(size_t{1}, std::min(maxThreads, whitelist.size() / internal::MinQueryNamesPerThread));
+        const size_t chunkSize = (whitelist.size() + numChunks - 1) / numChunks;
+        std::unique_ptr<internal::ThreadPool> pool;
+        if (numChunks > 1)
+            pool.reset(new internal::ThreadPool(numChunks - 1));
+
+        std::vector<internal::QueryNameParseResult> results(numChunks);
+        internal::parseInParallel(numChunks, [&](const size_t i)
+        {
+            const size_t first = i * chunkSize;
+            const size_t last  = std::min(first + chunkSize, whitelist.size());
+            auto& result = results.at(i);
+            result.keys.reserve(last - first);
+            for (size_t j = first; j < last; ++j) {
+                const std::string& name = whitelist.at(j);
+                internal::parseQueryName(name.data(), name.data() + name.size(), &result);
             }
+        }, pool.get());
+        BuildLookup(std::move(results));
+    }
 
-            //
-            // generate candidate read group IDs from movie name
-            //
-            // then, ensure read group IDs in lookup table, creating or fetching
-            // shared ZmwLookup table if new movie
-            //
-            const std::string& movieName = nameParts.at(0);
-            const bool isCCS = (nameParts.at(2) == "ccs" || nameParts.at(2) == "CCS");
-            std::vector<int32_t> rgIds;
-            if (isCCS) {
-                rgIds.push_back( ReadGroupInfo::IdToInt(MakeReadGroupId(movieName, "CCS")) );
-            } else {
-                rgIds.reserve(6);
-                rgIds.push_back( ReadGroupInfo::IdToInt(MakeReadGroupId(movieName, "POLYMERASE")));
-                rgIds.push_back( ReadGroupInfo::IdToInt(MakeReadGroupId(movieName, "HQREGION")));
-                rgIds.push_back( ReadGroupInfo::IdToInt(MakeReadGroupId(movieName, "SUBREAD")));
-                rgIds.push_back( ReadGroupInfo::IdToInt(MakeReadGroupId(movieName, "SCRAP")));
-                rgIds.push_back( ReadGroupInfo::IdToInt(MakeReadGroupId(movieName, "UNKNOWN")));
-                rgIds.push_back( ReadGroupInfo::IdToInt(MakeReadGroupId(movieName, "ZMW")));
-            }
-            assert(!rgIds.empty());
-            auto rgFound = lookup_.find(rgIds.front());
-            ZmwLookupPtr zmwPtr = nullptr;
-            if (rgFound == lookup_.end()) {
-                zmwPtr = ZmwLookupPtr(new ZmwLookup);
-                for (const auto& rg : rgIds) {
-                    assert(lookup_.find(rg) == lookup_.end());
-                    lookup_.emplace(rg, zmwPtr);
+    PbiQueryNameFilterPrivate(const std::string& filename,
+                              const size_t numThreads)
+    {
+        std::ifstream in(filename, std::ios::binary);
+        if (!in)
+            throw std::runtime_error("PbiQueryNameFilter error: could not open query name file: " + filename);
+
+        // stream file in fixed-size blocks (works for pipes/FIFOs too), each
+        // split across worker threads at line boundaries, if large enough to
+        // be worth it. Each worker keeps its own results across blocks, and
+        // the pool is only started once a block needs it.
+        const size_t maxThreads = internal::ThreadPool::ActualNumThreads(numThreads);
+        std::unique_ptr<internal::ThreadPool> pool;
+        std::vector<internal::QueryNameParseResult> results(maxThreads);
+        std::string block;
+        std::string leftover;
+        std::unique_ptr<char[]> buffer(new char[internal::QueryNameFileBlockSize]);
+        while (in) {
+            in.read(buffer.get(), internal::QueryNameFileBlockSize);
+            const size_t numRead = static_cast<size_t>(in.gcount());
+            if (numRead == 0)
+                break;
+
+            // carry partial last line over to next block (unless at EOF)
+            block.assign(leftover);
+            block.append(buffer.get(), numRead);
+            leftover.clear();
+            if (in) {
+                const size_t lastNewline = block.rfind('\n');
+                if (lastNewline == std::string::npos) {
+                    leftover.swap(block);
+                    continue;
                 }
-            }
-            else {
-#ifndef NDEBUG
-                for (const auto& rg : rgIds)
-                    assert(lookup_.find(rg) != lookup_.end());
-#endif
-                zmwPtr = rgFound->second;
+                leftover.assign(block, lastNewline + 1, std::string::npos);
+                block.resize(lastNewline + 1);
             }
 
-            // fetch ZMW & QueryStart/QEnd from query name
-            const int32_t zmw = stoi(nameParts.at(1));
-            int32_t queryStart = -1;
-            int32_t queryEnd   = -1;
-            if (!isCCS) {
-                const auto queryIntervalParts = internal::Split(nameParts.at(2), '_');
-                if (queryIntervalParts.size() != 2) {
-                    auto msg = std::string{ "PbiQueryNameFilter error: requested QNAME (" } + queryName;
-                    msg += std::string{ ") is not a valid PacBio BAM QNAME. See spec for details"};
-                    throw std::runtime_error(msg);
-                }
-                queryStart = stoi(queryIntervalParts.at(0));
-                queryEnd   = stoi(queryIntervalParts.at(1));
+            const size_t numChunks =
+                std::max(size_t{1}, std::min(maxThreads, block.size() / internal::MinQueryNameBytesPerThread));
+            if (numChunks > 1 && !pool)
+                pool.reset(new internal::ThreadPool(maxThreads - 1));
+
+            // determine chunk boundaries, snapped forward to line starts
+            const char* blockBegin = block.data();
+            const char* blockEnd   = blockBegin + block.size();
+            std::vector<const char*> bounds(numChunks + 1, blockEnd);
+            bounds[0] = blockBegin;
+            for (size_t i = 1; i < numChunks; ++i) {
+                const char* candidate = blockBegin + (block.size() * i) / numChunks;
+                candidate = std::max(candidate, bounds[i-1]);
+                candidate = std::find(candidate, blockEnd, '\n');
+                bounds[i] = (candidate == blockEnd ? blockEnd : candidate + 1);
             }
 
-            // creating new ZMW entry if not yet seen & store QS/QE pair
-            //
-            const auto zmwFound = zmwPtr->find(zmw);
-            if (zmwFound == zmwPtr->end())
-                zmwPtr->emplace(zmw, QueryIntervals{});
-            QueryIntervals& queryIntervals = zmwPtr->at(zmw);
-            queryIntervals.emplace(std::make_pair(queryStart, queryEnd));
+            internal::parseInParallel(numChunks, [&](const size_t i)
+            {
+                internal::parseQueryNameLines(bounds[i], bounds[i+1], &results.at(i));
+            }, pool.get());
         }
+        if (in.bad())
+            throw std::runtime_error("PbiQueryNameFilter error: could not read query name file: " + filename);
+        if (!leftover.empty())
+            internal::parseQueryNameLines(leftover.data(), leftover.data() + leftover.size(), &results.at(0));
+
+        BuildLookup(std::move(results));
     }
 
     PbiQueryNameFilterPrivate(const std::unique_ptr<PbiQueryNameFilterPrivate>& other)
     {
-        if (other)
-            lookup_ = other->lookup_;
+        // lookup data is immutable, so it can be shared between copies
+        assert(other);
+        groupLookup_ = other->groupLookup_;
+        keys_ = other->keys_;
     }
 
     bool Accepts(const PbiRawData& idx, const size_t row) const
     {
-        const auto& basicData = idx.BasicData();
-
-        // see if row's RGID known
-        const auto& rgId = basicData.rgId_.at(row);
-        const auto rgFound = lookup_.find(rgId);
-        if (rgFound == lookup_.end())
+        if (keys_->empty())
             return false;
 
-        // see if row's ZMW known
-        const auto& zmwPtr = rgFound->second;
-        const auto zmw = basicData.holeNumber_.at(row);
-        const auto zmwFound = zmwPtr->find(zmw);
-        if (zmwFound == zmwPtr->end())
+        const auto& basicData = idx.BasicData();
+
+        // a row's RGID is either from a whitelisted movie or not at all
+        const auto rgFound = groupLookup_->find(basicData.rgId_.at(row));
+        if (rgFound == groupLookup_->end())
             return false;
 
-        // see if row's QueryStart/QueryEnd known
         // CCS names already covered in lookup construction phase
-        const auto& queryIntervals = zmwFound->second;
-        const auto qStart = basicData.qStart_.at(row);
-        const auto qEnd   = basicData.qEnd_.at(row);
-        const auto queryInterval = std::make_pair(qStart, qEnd);
-        return queryIntervals.find(queryInterval) != queryIntervals.end();
+        const internal::QueryNameKey key =
+        {
+            rgFound->second,
+            basicData.holeNumber_.at(row),
+            basicData.qStart_.at(row),
+            basicData.qEnd_.at(row)
+        };
+        return Find(key);
     }
 
 private:
-    RgIdLookup lookup_;
+    void BuildLookup(std::vector<internal::QueryNameParseResult>&& results)
+    {
+        // merge per-thread movie indices into global ones
+        std::unordered_map<std::string, uint32_t> movieLookup;
+        std::vector<std::string> movies;
+        size_t numKeys = 0;
+        std::vector<std::vector<uint32_t> > localToGlobal(results.size());
+        for (size_t i = 0; i < results.size(); ++i) {
+            const auto& result = results.at(i);
+            numKeys += result.keys.size();
+            for (const auto& movieName : result.movies) {
+                const auto found = movieLookup.find(movieName);
+                if (found == movieLookup.end()) {
+                    const uint32_t movieIndex = static_cast<uint32_t>(movies.size());
+                    movies.push_back(movieName);
+                    movieLookup.emplace(movieName, movieIndex);
+                    localToGlobal.at(i).push_back(movieIndex);
+                } else
+                    localToGlobal.at(i).push_back(found->second);
+            }
+        }
+
+        // build & sort flat key table
+        auto keys = std::make_shared<KeyTable>();
+        keys->reserve(numKeys);
+        for (size_t i = 0; i < results.size(); ++i) {
+            const auto& movieIndices = localToGlobal.at(i);
+            for (auto key : results.at(i).keys) {
+                const uint32_t ccsBit = key.group & 1;
+                key.group = (movieIndices.at(key.group >> 1) << 1) | ccsBit;
+                keys->push_back(key);
+            }
+            results.at(i).keys = KeyTable{ };
+        }
+        std::sort(keys->begin(), keys->end());
+        keys->erase(std::unique(keys->begin(), keys->end()), keys->end());
+        keys_ = keys;
+
+        // generate candidate read group IDs, once per movie
+        static const std::vector<std::string> nonCcsTypes =
+        {
+            "POLYMERASE", "HQREGION", "SUBREAD", "SCRAP", "UNKNOWN", "ZMW"
+        };
+        auto groupLookup = std::make_shared<GroupLookup>();
+        for (size_t i = 0; i < movies.size(); ++i) {
+            const auto& movieName = movies.at(i);
+            const uint32_t group = static_cast<uint32_t>(i << 1);
+            for (const auto& readType : nonCcsTypes)
+                groupLookup->emplace(ReadGroupInfo::IdToInt(MakeReadGroupId(movieName, readType)), group);
+            groupLookup->emplace(ReadGroupInfo::IdToInt(MakeReadGroupId(movieName, "CCS")), group | 1);
+        }
+        groupLookup_ = groupLookup;
+    }
+
+    // Lookups are stateless (plain binary search over the sorted key table),
+    // so a single filter may be shared by concurrent readers.
+    //
+    bool Find(const internal::QueryNameKey& key) const
+    {
+        const KeyTable& keys = *keys_;
+        const auto found = std::lower_bound(keys.cbegin(), keys.cend(), key);
+        return found != keys.cend() && *found == key;
+    }
+
+private:
+    typedef std::unordered_map<int32_t, uint32_t> GroupLookup;
+
+    std::shared_ptr<const GroupLookup> groupLookup_;
+    std::shared_ptr<const KeyTable> keys_;
 };
 
 PbiQueryNameFilter::PbiQueryNameFilter(const std::string& qname)
-    : d_(new PbiQueryNameFilter::PbiQueryNameFilterPrivate(std::vector<std::string>{1, qname}))
+    : d_(new PbiQueryNameFilter::PbiQueryNameFilterPrivate(std::vector<std::string>{1, qname}, 1))
 { }
 //    : compositeFilter_(internal::filterFromQueryName(qname))
 //{ }
 
-PbiQueryNameFilter::PbiQueryNameFilter(const std::vector<std::string>& whitelist)
-    : d_(new PbiQueryNameFilter::PbiQueryNameFilterPrivate(whitelist))
+PbiQueryNameFilter::PbiQueryNameFilter(const std::vector<std::string>& whitelist,
+                                       const size_t numThreads)
+    : d_(new PbiQueryNameFilter::PbiQueryNameFilterPrivate(whitelist, numThreads))
+{ }
+
+PbiQueryNameFilter::PbiQueryNameFilter(std::unique_ptr<PbiQueryNameFilterPrivate>&& d)
+    : d_(std::move(d))
 { }
+
+PbiQueryNameFilter PbiQueryNameFilter::FromFile(const std::string& filename,
+                                                const size_t numThreads)
+{
+    return PbiQueryNameFilter{
+        std::unique_ptr<PbiQueryNameFilterPrivate>{
+            new PbiQueryNameFilter::PbiQueryNameFilterPrivate(filename, numThreads)
+        }
+    };
+}
 //    : compositeFilter_(PbiFilter::UNION)
 //{
 //    try {
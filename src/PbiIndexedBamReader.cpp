@@ -40,7 +40,12 @@
 // Author: Derek Barnett
 
 #include "pbbam/PbiIndexedBamReader.h"
+#include "BgzfBlockCache.h"
+#include "BgzfPrefetcher.h"
+#include "MemoryUtils.h"
+#include "PbiIntervalIndex.h"
 #include <htslib/bgzf.h>
+#include <algorithm>
 #include <iostream>
 
 namespace PacBio {
@@ -50,9 +55,17 @@ namespace internal {
 struct PbiIndexedBamReaderPrivate
 {
 public:
-    PbiIndexedBamReaderPrivate(const std::string& pbiFilename)
-        : index_(pbiFilename)
+    PbiIndexedBamReaderPrivate(const std::string& bamFilename,
+                               const std::string& pbiFilename)
+        : bamFilename_(bamFilename)
+        , fileIdentity_(FileIdentity::FromFilename(bamFilename))
+        , index_(pbiFilename)
         , currentBlockReadCount_(0)
+        , nextRow_(0)
+        , readThroughThreshold_(PbiIndexedBamReader::DefaultReadThroughThreshold)
+        , prefetchDepth_(0)
+        , prefetchThreads_(0)
+        , blockCache_(PbiIndexedBamReader::DefaultBlockCacheSize)
     { }
 
     void ApplyOffsets(void)
@@ -60,14 +73,24 @@ public:
         const std::vector<int64_t>& fileOffsets = index_.BasicData().fileOffset_;
         for (IndexResultBlock& block : blocks_)
             block.virtualOffset_ = fileOffsets.at(block.firstIndex_);
+
+        // blocks_ is consumed while reading, keep the full result
+        resultBlocks_ = blocks_;
     }
 
-    void Filter(const PbiFilter& filter)
+    void Reset(const PbiFilter& filter)
     {
-        // store request & reset counters
         filter_ = filter;
         currentBlockReadCount_ = 0;
         blocks_.clear();
+        resultBlocks_.clear();
+        prefetcher_.reset();
+    }
+
+    void Filter(const PbiFilter& filter)
+    {
+        // store request & reset counters
+        Reset(filter);
 
         // find blocks of reads passing filter criteria
         const uint32_t numReads = index_.NumReads();
@@ -89,17 +112,96 @@ public:
         ApplyOffsets();
     }
 
+    void Interval(const BamHeader& header, const GenomicInterval& interval)
+    {
+        if (!header.HasSequence(interval.Name())) {
+            throw std::runtime_error("PbiIndexedBamReader: reference " + interval.Name() +
+                                     " not found in header of " + bamFilename_);
+        }
+        const int32_t tId = header.SequenceId(interval.Name());
+        const uint32_t start = static_cast<uint32_t>(std::max(interval.Start(), Position(0)));
+        const uint32_t stop  = static_cast<uint32_t>(std::max(interval.Stop(),  Position(0)));
+
+        if (!intervalIndex_)
+            intervalIndex_.reset(new PbiIntervalIndex(index_));
+
+        // store the equivalent filter, so that Filter() reflects the request
+        Reset(PbiFilter::Intersection({
+            PbiReferenceIdFilter{ tId },
+            PbiReferenceStartFilter{ stop, Compare::LESS_THAN },
+            PbiReferenceEndFilter{ start, Compare::GREATER_THAN }
+        }));
+
+        blocks_ = mergedIndexBlocks(intervalIndex_->Overlapping(tId, start, stop));
+        ApplyOffsets();
+    }
+
+    // Returns true if the reader is positioned before 'block', at a known row,
+    // and the compressed distance to the block's first record is small enough
+    // that reading through the intervening records beats a seek (which would
+    // discard & re-inflate the current BGZF block).
+    //
+    bool CanReadThrough(BGZF* bgzf, const IndexResultBlock& block) const
+    {
+        if (nextRow_ > block.firstIndex_)
+            return false;
+
+        // make sure our row bookkeeping matches the actual file position
+        // (e.g. client may have called VirtualSeek() directly)
+        const int64_t currentOffset = bgzf_tell(bgzf);
+        if (currentOffset != index_.BasicData().fileOffset_.at(nextRow_))
+            return false;
+
+        const int64_t compressedGap = (block.virtualOffset_ >> 16) - (currentOffset >> 16);
+        return compressedGap <= static_cast<int64_t>(readThroughThreshold_);
+    }
+
+    // Hands remaining blocks over to a prefetcher. Any records already read
+    // from the current block are dropped from it first.
+    void StartPrefetching(void)
+    {
+        if (!blocks_.empty() && currentBlockReadCount_ > 0) {
+            blocks_.front().firstIndex_ += currentBlockReadCount_;
+            blocks_.front().numReads_   -= currentBlockReadCount_;
+            currentBlockReadCount_ = 0;
+        }
+
+        prefetcher_.reset(new BgzfPrefetcher(bamFilename_,
+                                             index_,
+                                             blocks_,
+                                             prefetchDepth_,
+                                             prefetchThreads_,
+                                             readThroughThreshold_));
+        blocks_.clear();
+    }
+
     int ReadRawData(BGZF* bgzf, bam1_t* b)
     {
+        // use prefetching I/O, if requested
+        if (!prefetcher_ && prefetchDepth_ > 0 && BgzfUtils::CanDecodeInMemory())
+            StartPrefetching();
+        if (prefetcher_)
+            return prefetcher_->ReadNext(b);
+
         // no data to fetch, return false
         if (blocks_.empty())
             return -1; // "EOF"
 
-        // if on new block, seek to its first record
+        // if on new block, move to its first record: either by skipping over
+        // the (few) unwanted records between blocks, or by seeking
         if (currentBlockReadCount_ == 0) {
-            auto seekResult = bgzf_seek(bgzf, blocks_.at(0).virtualOffset_, SEEK_SET);
-            if (seekResult == -1)
-                throw std::runtime_error("could not seek in BAM file");
+            const IndexResultBlock& block = blocks_.front();
+            if (CanReadThrough(bgzf, block)) {
+                for ( ; nextRow_ < block.firstIndex_; ++nextRow_) {
+                    auto skipResult = bam_read1(bgzf, b);
+                    if (skipResult < 0)
+                        return skipResult;
+                }
+            } else {
+                auto seekResult = CachedBgzfSeek(bgzf, fileIdentity_, block.virtualOffset_);
+                if (seekResult == -1)
+                    throw std::runtime_error("could not seek in BAM file");
+            }
         }
 
         // read next record
@@ -108,6 +210,7 @@ public:
         // update counters. if block finished, pop & reset
         ++currentBlockReadCount_;
         if (currentBlockReadCount_ == blocks_.at(0).numReads_) {
+            nextRow_ = blocks_.at(0).firstIndex_ + blocks_.at(0).numReads_;
             blocks_.pop_front();
             currentBlockReadCount_ = 0;
         }
@@ -115,15 +218,110 @@ public:
         return result;
     }
 
+    const RandomAccessFile& RandomAccess(void)
+    {
+        if (!randomAccessFile_)
+            randomAccessFile_.reset(new RandomAccessFile(bamFilename_));
+        return *randomAccessFile_;
+    }
+
+    BgzfBlockPtr FetchBlock(const int64_t offset)
+    {
+        // prefer the process-wide cache, if enabled, so that blocks loaded by
+        // other readers of the same file can be re-used
+        BgzfBlockCache& cache = (SharedBgzfBlockCacheEnabled() && fileIdentity_.valid)
+                ? SharedBgzfBlockCache()
+                : blockCache_;
+        const BgzfBlockKey key = { fileIdentity_, offset };
+        auto block = cache.Find(key);
+        if (!block) {
+            block = ReadBgzfBlock(RandomAccess(), offset);
+            cache.Insert(key, block);
+        }
+        return block;
+    }
+
+    // Appends 'length' bytes of inflated data to 'out', starting 'position'
+    // bytes into the block at 'blockOffset' & continuing into following blocks
+    // as needed.
+    void CopyData(int64_t blockOffset,
+                  size_t position,
+                  size_t length,
+                  std::vector<uint8_t>* out)
+    {
+        while (length > 0) {
+            const auto block = FetchBlock(blockOffset);
+            const size_t blockLength = block->data.size();
+            if (position < blockLength) {
+                const size_t numCopied = std::min(length, blockLength - position);
+                const auto begin = block->data.cbegin() + position;
+                out->insert(out->end(), begin, begin + numCopied);
+                length -= numCopied;
+                position = 0;
+            } else
+                position -= blockLength;
+            blockOffset += block->compressedSize;
+        }
+    }
+
+    void ReadRecordAt(const size_t row, bam1_t* b)
+    {
+        if (!BgzfUtils::CanDecodeInMemory())
+            throw std::runtime_error("PbiIndexedBamReader: random access not supported on big-endian hosts");
+        if (row >= index_.NumReads()) {
+            throw std::runtime_error("PbiIndexedBamReader: requested row (" + std::to_string(row) +
+                                     ") is out of range for " + bamFilename_);
+        }
+
+        const int64_t virtualOffset = index_.BasicData().fileOffset_.at(row);
+        const int64_t blockOffset = BgzfUtils::CompressedOffset(virtualOffset);
+        const size_t position = BgzfUtils::UncompressedOffset(virtualOffset);
+
+        // record length, then record contents
+        recordBuffer_.clear();
+        CopyData(blockOffset, position, 4, &recordBuffer_);
+        const uint32_t blockLength = static_cast<uint32_t>(recordBuffer_[0])         |
+                                     (static_cast<uint32_t>(recordBuffer_[1]) << 8)  |
+                                     (static_cast<uint32_t>(recordBuffer_[2]) << 16) |
+                                     (static_cast<uint32_t>(recordBuffer_[3]) << 24);
+        CopyData(blockOffset, position + 4, blockLength, &recordBuffer_);
+
+        const int result = BgzfUtils::ReadRecord(recordBuffer_.data(), recordBuffer_.size(), b);
+        if (result < 0) {
+            throw std::runtime_error("corrupted BAM file: could not read record at row " +
+                                     std::to_string(row) + " (" + bamFilename_ + ")");
+        }
+    }
+
 public:
+    std::string bamFilename_;
+    FileIdentity fileIdentity_;
     PbiFilter filter_;
     PbiRawData index_;
+    std::unique_ptr<PbiIntervalIndex> intervalIndex_; // built on first Interval()
     IndexResultBlocks blocks_;
+    IndexResultBlocks resultBlocks_;
     size_t currentBlockReadCount_;
+
+    // row following the last record read (a hint, verified before use)
+    size_t nextRow_;
+    size_t readThroughThreshold_;
+
+    size_t prefetchDepth_;
+    size_t prefetchThreads_;
+    std::unique_ptr<BgzfPrefetcher> prefetcher_;
+
+    // random access
+    std::unique_ptr<RandomAccessFile> randomAccessFile_;
+    BgzfBlockCache blockCache_;
+    std::vector<uint8_t> recordBuffer_;
 };
 
 } // namespace internal
 
+const size_t PbiIndexedBamReader::DefaultReadThroughThreshold;
+const size_t PbiIndexedBamReader::DefaultBlockCacheSize;
+
 PbiIndexedBamReader::PbiIndexedBamReader(const PbiFilter& filter,
                                          const std::string& filename)
     : PbiIndexedBamReader(filter, BamFile(filename))
@@ -149,12 +347,14 @@ PbiIndexedBamReader::PbiIndexedBamReader(const std::string& bamFilename)
 
 PbiIndexedBamReader::PbiIndexedBamReader(const BamFile& bamFile)
     : BamReader(bamFile)
-    , d_(new internal::PbiIndexedBamReaderPrivate(File().PacBioIndexFilename()))
+    , d_(new internal::PbiIndexedBamReaderPrivate(File().Filename(),
+                                                File().PacBioIndexFilename()))
 { }
 
 PbiIndexedBamReader::PbiIndexedBamReader(BamFile&& bamFile)
     : BamReader(std::move(bamFile))
-    , d_(new internal::PbiIndexedBamReaderPrivate(File().PacBioIndexFilename()))
+    , d_(new internal::PbiIndexedBamReaderPrivate(File().Filename(),
+                                                File().PacBioIndexFilename()))
 { }
 
 PbiIndexedBamReader::~PbiIndexedBamReader(void) { }
@@ -171,6 +371,18 @@ const PbiFilter& PbiIndexedBamReader::Filter(void) const
     return d_->filter_;
 }
 
+const PbiRawData& PbiIndexedBamReader::PbiRawIndex(void) const
+{
+    assert(d_);
+    return d_->index_;
+}
+
+const IndexResultBlocks& PbiIndexedBamReader::ResultBlocks(void) const
+{
+    assert(d_);
+    return d_->resultBlocks_;
+}
+
 PbiIndexedBamReader& PbiIndexedBamReader::Filter(const PbiFilter& filter)
 {
     assert(d_);
@@ -178,5 +390,97 @@ PbiIndexedBamReader& PbiIndexedBamReader::Filter(const PbiFilter& filter)
     return *this;
 }
 
+PbiIndexedBamReader& PbiIndexedBamReader::Interval(const GenomicInterval& interval)
+{
+    assert(d_);
+    d_->Interval(Header(), interval);
+    return *this;
+}
+
+size_t PbiIndexedBamReader::ReadThroughThreshold(void) const
+{
+    assert(d_);
+    return d_->readThroughThreshold_;
+}
+
+PbiIndexedBamReader& PbiIndexedBamReader::ReadThroughThreshold(const size_t numBytes)
+{
+    assert(d_);
+    d_->readThroughThreshold_ = numBytes;
+    return *this;
+}
+
+size_t PbiIndexedBamReader::PrefetchDepth(void) const
+{
+    assert(d_);
+    return d_->prefetchDepth_;
+}
+
+PbiIndexedBamReader& PbiIndexedBamReader::PrefetchDepth(const size_t numChunks)
+{
+    assert(d_);
+    d_->prefetchDepth_ = numChunks;
+    return *this;
+}
+
+size_t PbiIndexedBamReader::PrefetchThreads(void) const
+{
+    assert(d_);
+    return d_->prefetchThreads_;
+}
+
+PbiIndexedBamReader& PbiIndexedBamReader::PrefetchThreads(const size_t numThreads)
+{
+    assert(d_);
+    d_->prefetchThreads_ = numThreads;
+    return *this;
+}
+
+size_t PbiIndexedBamReader::BlockCacheSize(void) const
+{
+    assert(d_);
+    return d_->blockCache_.MaxBytes();
+}
+
+PbiIndexedBamReader& PbiIndexedBamReader::BlockCacheSize(const size_t numBytes)
+{
+    assert(d_);
+    d_->blockCache_.MaxBytes(numBytes);
+    return *this;
+}
+
+BamRecord PbiIndexedBamReader::ReadRecordAt(const size_t row)
+{
+    assert(d_);
+    BamRecord record{ Header() };
+    d_->ReadRecordAt(row, internal::BamRecordMemory::GetRawData(record).get());
+    internal::BamRecordMemory::UpdateRecordTags(record);
+    record.ResetCachedPositions();
+    return record;
+}
+
+std::vector<BamRecord> PbiIndexedBamReader::ReadRecords(const std::vector<size_t>& rows)
+{
+    // visit each distinct row once, in file order, so that records sharing
+    // a BGZF block are read together
+    std::vector<size_t> sortedRows = rows;
+    std::sort(sortedRows.begin(), sortedRows.end());
+    sortedRows.erase(std::unique(sortedRows.begin(), sortedRows.end()), sortedRows.end());
+
+    std::vector<BamRecord> sortedRecords;
+    sortedRecords.reserve(sortedRows.size());
+    for (const size_t row : sortedRows)
+        sortedRecords.push_back(ReadRecordAt(row));
+
+    // return in requested order
+    std::vector<BamRecord> result;
+    result.reserve(rows.size());
+    for (const size_t row : rows) {
+        const auto found = std::lower_bound(sortedRows.cbegin(), sortedRows.cend(), row);
+        result.push_back(sortedRecords.at(found - sortedRows.cbegin()));
+    }
+    return result;
+}
+
 } // namespace BAM
 } // namespace PacBio
@@ -0,0 +1,129 @@
+// Copyright (c) 2016, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// File Description
+/// \file PbiIntervalIndex.cpp
+/// \brief Implements the PbiIntervalIndex class.
+//
+// Author: Derek Barnett
+
+#include "PbiIntervalIndex.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace PacBio {
+namespace BAM {
+namespace internal {
+
+PbiIntervalIndex::PbiIntervalIndex(const PbiRawData& index)
+    : index_(index)
+{
+    if (!index_.HasMappedData() || !index_.HasReferenceData()) {
+        throw std::runtime_error("PBI does not contain the mapped & reference "
+                                 "data required for interval queries "
+                                 "(is the BAM file aligned & coordinate-sorted?)");
+    }
+
+    const PbiRawMappedData& mappedData = index_.MappedData();
+    const std::vector<uint32_t>& tStart = mappedData.tStart_;
+    const std::vector<uint32_t>& tEnd = mappedData.tEnd_;
+    maxEnd_.assign(tEnd.size(), 0);
+
+    for (const PbiReferenceEntry& entry : index_.ReferenceData().entries_) {
+        if (entry.tId_ == PbiReferenceEntry::UNMAPPED_ID ||
+            entry.beginRow_ == PbiReferenceEntry::UNSET_ROW ||
+            entry.endRow_ == PbiReferenceEntry::UNSET_ROW)
+        {
+            continue;
+        }
+
+        ReferenceRows rows;
+        rows.beginRow_ = entry.beginRow_;
+        rows.endRow_ = std::min(entry.endRow_, static_cast<uint32_t>(tEnd.size()));
+        rows.isSorted_ = true;
+
+        uint32_t maxEnd = 0;
+        for (uint32_t row = rows.beginRow_; row < rows.endRow_; ++row) {
+            if (row > rows.beginRow_ && tStart.at(row) < tStart.at(row-1))
+                rows.isSorted_ = false;
+            maxEnd = std::max(maxEnd, tEnd.at(row));
+            maxEnd_[row] = maxEnd;
+        }
+        references_[static_cast<int32_t>(entry.tId_)] = rows;
+    }
+}
+
+IndexList PbiIntervalIndex::Overlapping(const int32_t tId,
+                                        const uint32_t start,
+                                        const uint32_t end) const
+{
+    IndexList result;
+
+    const auto found = references_.find(tId);
+    if (found == references_.cend())
+        return result;
+    const ReferenceRows& rows = found->second;
+
+    const PbiRawMappedData& mappedData = index_.MappedData();
+    const std::vector<int32_t>& tIds = mappedData.tId_;
+    const std::vector<uint32_t>& tStart = mappedData.tStart_;
+    const std::vector<uint32_t>& tEnd = mappedData.tEnd_;
+
+    size_t first = rows.beginRow_;
+    size_t last = rows.endRow_;
+    if (rows.isSorted_) {
+        // records starting at or after 'end' cannot overlap
+        const auto tStartBegin = tStart.cbegin();
+        last = std::lower_bound(tStartBegin + rows.beginRow_,
+                                tStartBegin + rows.endRow_,
+                                end) - tStartBegin;
+
+        // nor can any record before the first whose running max tEnd passes 'start'
+        const auto maxEndBegin = maxEnd_.cbegin();
+        first = std::upper_bound(maxEndBegin + rows.beginRow_,
+                                 maxEndBegin + last,
+                                 start) - maxEndBegin;
+    }
+
+    for (size_t row = first; row < last; ++row) {
+        if (tIds.at(row) == tId && tStart.at(row) < end && tEnd.at(row) > start)
+            result.push_back(row);
+    }
+    return result;
+}
+
+} // namespace internal
+} // namespace BAM
+} // namespace PacBio
@@ -0,0 +1,99 @@
+// Copyright (c) 2016, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// File Description
+/// \file PbiIntervalIndex.h
+/// \brief Defines the PbiIntervalIndex class.
+//
+// Author: Derek Barnett
+
+#ifndef PBIINTERVALINDEX_H
+#define PBIINTERVALINDEX_H
+
+#include "pbbam/PbiBasicTypes.h"
+#include "pbbam/PbiRawData.h"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace PacBio {
+namespace BAM {
+namespace internal {
+
+/// \internal
+///
+/// Answers genomic interval queries from a PBI's mapped & reference data,
+/// without requiring a BAI.
+///
+/// Within each reference's row range (coordinate-sorted), tStart is
+/// non-decreasing, so the last candidate row is found by binary search. A
+/// running maximum of tEnd over the same rows is also non-decreasing, so the
+/// first row that could possibly reach the interval is found the same way.
+/// Only the rows between those two bounds are checked individually.
+///
+class PbiIntervalIndex
+{
+public:
+    /// \throws std::runtime_error if index lacks mapped or reference data
+    explicit PbiIntervalIndex(const PbiRawData& index);
+
+public:
+    /// \returns rows (ascending) of records on reference 'tId' overlapping the
+    ///          half-open interval [start, end)
+    IndexList Overlapping(const int32_t tId,
+                          const uint32_t start,
+                          const uint32_t end) const;
+
+private:
+    struct ReferenceRows
+    {
+        uint32_t beginRow_;
+        uint32_t endRow_;
+        bool isSorted_;
+    };
+
+private:
+    const PbiRawData& index_;
+    std::unordered_map<int32_t, ReferenceRows> references_;
+
+    // running max of tEnd, restarted at each reference's first row
+    std::vector<uint32_t> maxEnd_;
+};
+
+} // namespace internal
+} // namespace BAM
+} // namespace PacBio
+
+#endif // PBIINTERVALINDEX_H
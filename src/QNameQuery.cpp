@@ -40,56 +40,135 @@
 // Author: Derek Barnett
 
 #include "pbbam/QNameQuery.h"
-#include "pbbam/CompositeBamReader.h"
-#include <boost/optional.hpp>
-#include <cassert>
+#include "pbbam/BamReader.h"
+#include "pbbam/PbiRawData.h"
+#include <deque>
+#include <string>
 
 namespace PacBio {
 namespace BAM {
 
 struct QNameQuery::QNameQueryPrivate
 {
+public:
+    // Identifies a record's name group. Records with a PBI entry are keyed on
+    // (read group, ZMW, qStart, qEnd), which determines the PacBio read name.
+    // Otherwise, the record's FullName is used.
+    struct GroupKey
+    {
+        bool fromIndex_;
+        int32_t rgId_;
+        int32_t holeNumber_;
+        int32_t qStart_;
+        int32_t qEnd_;
+        std::string name_;
+    };
+
 public:
     QNameQueryPrivate(const DataSet& dataset)
-        : reader_(new SequentialCompositeBamReader(dataset))
-        , nextRecord_(boost::none)
-    { }
+        : row_(0)
+        , hasNextRecord_(false)
+    {
+        for (auto&& bamFile : dataset.BamFiles())
+            files_.push_back(std::move(bamFile));
+    }
 
     bool GetNext(std::vector<BamRecord>& records)
     {
         records.clear();
 
-        std::string groupRecordName;
+        if (!hasNextRecord_) {
+            if (!ReadNext(&nextRecord_, &nextKey_))
+                return false;
+        }
+
+        std::swap(groupKey_, nextKey_);
+        records.push_back(std::move(nextRecord_));
+        hasNextRecord_ = false;
+
+        while (ReadNext(&nextRecord_, &nextKey_)) {
+            if (IsSameGroup(records.front(), nextRecord_))
+                records.push_back(std::move(nextRecord_));
+            else {
+                hasNextRecord_ = true;
+                return true;
+            }
+        }
+        return true;
+    }
 
-        if (nextRecord_.is_initialized()) {
-            BamRecord r = nextRecord_.get();
-            groupRecordName = r.FullName();
-            records.push_back(std::move(r));
-            nextRecord_ = boost::none;
+private:
+    // Compares against the current group's first record. Keys from different
+    // sources (a file with & one without a PBI) fall back to names.
+    bool IsSameGroup(const BamRecord& groupRecord,
+                     const BamRecord& record) const
+    {
+        if (groupKey_.fromIndex_ && nextKey_.fromIndex_) {
+            return groupKey_.holeNumber_ == nextKey_.holeNumber_ &&
+                   groupKey_.qStart_ == nextKey_.qStart_ &&
+                   groupKey_.qEnd_ == nextKey_.qEnd_ &&
+                   groupKey_.rgId_ == nextKey_.rgId_;
         }
+        if (!groupKey_.fromIndex_ && !nextKey_.fromIndex_)
+            return groupKey_.name_ == nextKey_.name_;
+        return groupRecord.FullName() == record.FullName();
+    }
 
-        BamRecord record;
-        while (reader_->GetNext(record)) {
-            if (records.empty()) {
-                groupRecordName = record.FullName();
-                records.push_back(record);
+    // Reads the next record (in file order) into a fresh BamRecord, so that
+    // previously read records can be moved into groups.
+    bool ReadNext(BamRecord* record, GroupKey* key)
+    {
+        while (true) {
+            if (!reader_) {
+                if (files_.empty())
+                    return false;
+                OpenNextFile();
             }
-            else {
-                assert(!records.empty());
-                if (record.FullName() == groupRecordName)
-                    records.push_back(record);
-                else {
-                    nextRecord_ = record;
-                    return true;
+
+            *record = BamRecord{ };
+            if (reader_->GetNext(*record)) {
+                if (index_ && row_ < index_->NumReads()) {
+                    const PbiRawBasicData& basicData = index_->BasicData();
+                    key->fromIndex_  = true;
+                    key->rgId_       = basicData.rgId_[row_];
+                    key->holeNumber_ = basicData.holeNumber_[row_];
+                    key->qStart_     = basicData.qStart_[row_];
+                    key->qEnd_       = basicData.qEnd_[row_];
+                } else {
+                    key->fromIndex_ = false;
+                    key->name_ = record->FullName();
                 }
+                ++row_;
+                return true;
             }
+            reader_.reset();
+            index_.reset();
         }
-        return !records.empty();
+    }
+
+    void OpenNextFile(void)
+    {
+        BamFile file = std::move(files_.front());
+        files_.pop_front();
+
+        // PBI rows follow file order, so row N describes the Nth record read
+        index_.reset();
+        if (file.PacBioIndexExists())
+            index_.reset(new PbiRawData(file.PacBioIndexFilename()));
+        row_ = 0;
+        reader_.reset(new BamReader{ std::move(file) });
     }
 
 public:
-    std::unique_ptr<SequentialCompositeBamReader> reader_;
-    boost::optional<BamRecord> nextRecord_;
+    std::deque<BamFile> files_;
+    std::unique_ptr<BamReader> reader_;
+    std::unique_ptr<PbiRawData> index_;
+    size_t row_;
+
+    GroupKey groupKey_;
+    GroupKey nextKey_;
+    BamRecord nextRecord_;
+    bool hasNextRecord_;
 };
 
 QNameQuery::QNameQuery(const DataSet& dataset)
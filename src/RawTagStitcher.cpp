@@ -0,0 +1,287 @@
+// Copyright (c) 2016, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// File Description
+/// \file RawTagStitcher.cpp
+/// \brief Implements the RawTagStitcher class.
+//
+// Author: Derek Barnett
+
+#include "RawTagStitcher.h"
+#include "BamRecordTags.h"
+#include "MemoryUtils.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace PacBio {
+namespace BAM {
+namespace internal {
+
+static
+size_t ArrayElementSize(const char subType)
+{
+    switch (subType) {
+        case 'c' :
+        case 'C' : return 1;
+        case 's' :
+        case 'S' : return 2;
+        case 'i' :
+        case 'I' :
+        case 'f' : return 4;
+        default:
+            throw std::runtime_error("unsupported array-tag-type encountered: " + std::string(1, subType));
+    }
+}
+
+static
+bool IsSignedArrayType(const char subType)
+{ return subType == 'c' || subType == 's' || subType == 'i'; }
+
+// Returns an array element type able to hold values of both types: float if
+// either is float, otherwise the narrowest integer type covering both ranges
+// (32-bit at most, so 'I' mixed with a signed type becomes 'i').
+//
+static
+char WidenedArrayType(const char lhs, const char rhs)
+{
+    if (lhs == rhs)
+        return lhs;
+    if (lhs == 'f' || rhs == 'f')
+        return 'f';
+
+    const bool isSigned = IsSignedArrayType(lhs) || IsSignedArrayType(rhs);
+    size_t width = 0;
+    for (const char subType : { lhs, rhs }) {
+        size_t w = ArrayElementSize(subType);
+        if (isSigned && !IsSignedArrayType(subType))
+            w = std::min(w * 2, size_t{4}); // unsigned values need a wider signed type
+        width = std::max(width, w);
+    }
+    switch (width) {
+        case 1  : return isSigned ? 'c' : 'C';
+        case 2  : return isSigned ? 's' : 'S';
+        default : return isSigned ? 'i' : 'I';
+    }
+}
+
+template<typename T>
+inline T ReadArrayElement(const uint8_t* data)
+{
+    T value;
+    memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+template<typename T>
+inline void WriteArrayElement(const T value, uint8_t* out)
+{ memcpy(out, &value, sizeof(T)); }
+
+// Converts array elements between BAM element types. The output type is
+// always at least as wide as the input type (see WidenedArrayType).
+//
+static
+uint8_t* ConvertArrayElements(const uint8_t* in,
+                              const char inType,
+                              const size_t numElements,
+                              const char outType,
+                              uint8_t* out)
+{
+    const size_t inSize  = ArrayElementSize(inType);
+    const size_t outSize = ArrayElementSize(outType);
+    for (size_t i = 0; i < numElements; ++i, in += inSize, out += outSize) {
+        if (inType == 'f') {
+            WriteArrayElement(ReadArrayElement<float>(in), out);
+            continue;
+        }
+
+        int64_t value = 0;
+        switch (inType) {
+            case 'c' : value = ReadArrayElement<int8_t>(in);   break;
+            case 'C' : value = ReadArrayElement<uint8_t>(in);  break;
+            case 's' : value = ReadArrayElement<int16_t>(in);  break;
+            case 'S' : value = ReadArrayElement<uint16_t>(in); break;
+            case 'i' : value = ReadArrayElement<int32_t>(in);  break;
+            case 'I' : value = ReadArrayElement<uint32_t>(in); break;
+            default:
+                assert(false);
+        }
+        switch (outType) {
+            case 'c' : WriteArrayElement(static_cast<int8_t>(value),   out); break;
+            case 'C' : WriteArrayElement(static_cast<uint8_t>(value),  out); break;
+            case 's' : WriteArrayElement(static_cast<int16_t>(value),  out); break;
+            case 'S' : WriteArrayElement(static_cast<uint16_t>(value), out); break;
+            case 'i' : WriteArrayElement(static_cast<int32_t>(value),  out); break;
+            case 'I' : WriteArrayElement(static_cast<uint32_t>(value), out); break;
+            case 'f' : WriteArrayElement(static_cast<float>(value),    out); break;
+            default:
+                assert(false);
+        }
+    }
+    return out;
+}
+
+RawTagStitcher::RawTagStitcher(const std::vector<BamRecord>& sources)
+    : sources_(sources)
+    , numBytes_(0)
+{ }
+
+bool RawTagStitcher::Add(const BamRecordTag tag,
+                         const std::vector<BamRecordTag>& sourceTags,
+                         const bool widenArrays)
+{
+    const std::string label = BamRecordTags::LabelFor(tag);
+    assert(label.size() == 2);
+
+    StitchedTag stitched;
+    stitched.name_[0] = label[0];
+    stitched.name_[1] = label[1];
+    stitched.type_ = 0;
+    stitched.subType_ = 0;
+    stitched.numElements_ = 0;
+
+    std::vector<std::string> sourceLabels;
+    sourceLabels.reserve(sourceTags.size());
+    for (const BamRecordTag sourceTag : sourceTags)
+        sourceLabels.push_back(BamRecordTags::LabelFor(sourceTag));
+
+    for (const BamRecord& source : sources_) {
+        const bam1_t* b = BamRecordMemory::GetRawData(source).get();
+        for (const std::string& sourceLabel : sourceLabels) {
+
+            // NOTE: htslib returns pointer to the type code, just past the name
+            const uint8_t* value = bam_aux_get(b, sourceLabel.c_str());
+            if (value == nullptr)
+                continue;
+
+            const char type = static_cast<char>(value[0]);
+            if (type == 'Z') {
+                if (stitched.type_ != 0 && stitched.type_ != 'Z')
+                    return false;
+                stitched.type_ = 'Z';
+                const char* str = reinterpret_cast<const char*>(value + 1);
+                const size_t length = strlen(str);
+                stitched.numElements_ += length;
+                stitched.segments_.push_back(Segment{ value + 1, length, 0, 0 });
+            }
+            else if (type == 'B') {
+                const char subType = static_cast<char>(value[1]);
+                if (stitched.type_ == 0)
+                    stitched.subType_ = subType;
+                else if (stitched.type_ != 'B')
+                    return false;
+                else if (stitched.subType_ != subType) {
+                    if (!widenArrays)
+                        return false;
+                    stitched.subType_ = WidenedArrayType(stitched.subType_, subType);
+                }
+                stitched.type_ = 'B';
+                uint32_t numElements = 0;
+                memcpy(&numElements, value + 2, sizeof(uint32_t));
+                stitched.numElements_ += numElements;
+                stitched.segments_.push_back(Segment{ value + 6,
+                                                      numElements * ArrayElementSize(subType),
+                                                      subType,
+                                                      numElements });
+            }
+            else
+                return false;
+        }
+    }
+
+    // tags with no elements are not written
+    if (stitched.numElements_ == 0)
+        return true;
+
+    size_t numBytes = 3; // name + type
+    if (stitched.type_ == 'Z')
+        numBytes += stitched.numElements_ + 1; // + null-term
+    else
+        numBytes += 1 + sizeof(uint32_t) + stitched.numElements_ * ArrayElementSize(stitched.subType_);
+    numBytes_ += numBytes;
+
+    tags_.push_back(std::move(stitched));
+    return true;
+}
+
+void RawTagStitcher::Write(BamRecord* record) const
+{
+    assert(record);
+    if (tags_.empty())
+        return;
+
+    // grow data block once, for all tags
+    bam1_t* b = BamRecordMemory::GetRawData(*record).get();
+    const int oldLength = b->l_data;
+    b->l_data += numBytes_;
+    if (b->m_data < b->l_data) {
+        b->m_data = b->l_data;
+        kroundup32(b->m_data);
+        b->data = static_cast<uint8_t*>(realloc(b->data, b->m_data));
+    }
+
+    uint8_t* out = b->data + oldLength;
+    for (const StitchedTag& tag : tags_) {
+        *out++ = static_cast<uint8_t>(tag.name_[0]);
+        *out++ = static_cast<uint8_t>(tag.name_[1]);
+        *out++ = static_cast<uint8_t>(tag.type_);
+        if (tag.type_ == 'B') {
+            *out++ = static_cast<uint8_t>(tag.subType_);
+            memcpy(out, &tag.numElements_, sizeof(uint32_t));
+            out += sizeof(uint32_t);
+        }
+        for (const Segment& segment : tag.segments_) {
+            if (tag.type_ == 'B' && segment.subType_ != tag.subType_) {
+                out = ConvertArrayElements(segment.data_, segment.subType_,
+                                           segment.numElements_, tag.subType_, out);
+            } else {
+                memcpy(out, segment.data_, segment.numBytes_);
+                out += segment.numBytes_;
+            }
+        }
+        if (tag.type_ == 'Z')
+            *out++ = 0;
+    }
+    assert(out == b->data + b->l_data);
+
+    BamRecordMemory::UpdateRecordTags(*record);
+}
+
+} // namespace internal
+} // namespace BAM
+} // namespace PacBio
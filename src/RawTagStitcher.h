@@ -0,0 +1,126 @@
+// Copyright (c) 2016, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// File Description
+/// \file RawTagStitcher.h
+/// \brief Defines the RawTagStitcher class.
+//
+// Author: Derek Barnett
+
+#ifndef RAWTAGSTITCHER_H
+#define RAWTAGSTITCHER_H
+
+#include "pbbam/BamRecord.h"
+#include "pbbam/BamRecordTag.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace PacBio {
+namespace BAM {
+namespace internal {
+
+/// \brief The RawTagStitcher class concatenates tag values across a series of
+///        records, working directly on their binary (BAM aux) data.
+///
+/// Each stitched tag is planned with Add(). Values are copied byte-for-byte
+/// from the source records into the output record by Write(), with a single
+/// resize of its data block. No per-value decoding takes place.
+///
+/// Only string ('Z') and array ('B') tags are supported. A tag is stitched
+/// only if all sources that carry it share the same type. Arrays with
+/// differing element types (e.g. 'B,S' & 'B,I') are widened to a common
+/// element type, unless the caller asks otherwise & falls back to decoding.
+///
+/// \note The source records must outlive the stitcher, and must not be
+///       modified between Add() and Write().
+///
+class RawTagStitcher
+{
+public:
+    explicit RawTagStitcher(const std::vector<BamRecord>& sources);
+
+public:
+    /// \brief Plans a stitched tag.
+    ///
+    /// \param[in] tag          tag to write to the output record
+    /// \param[in] sourceTags   tag(s) to take from each source record. Values
+    ///                         are concatenated in source order, then in the
+    ///                         order listed here.
+    ///
+    /// \param[in] widenArrays  if true, array values with differing element
+    ///                         types are widened to a common type. Should be
+    ///                         false where element values depend on their type
+    ///                         (e.g. lossy vs lossless frame codes).
+    ///
+    /// \returns false if source values have differing types (nothing planned)
+    ///
+    bool Add(const BamRecordTag tag,
+             const std::vector<BamRecordTag>& sourceTags,
+             const bool widenArrays = true);
+
+    /// \brief Appends all planned tags (those with at least one element) to
+    ///        \p record.
+    ///
+    void Write(BamRecord* record) const;
+
+private:
+    struct Segment
+    {
+        const uint8_t* data_;
+        size_t numBytes_;
+        char subType_;          // array element type ('B' tags only)
+        uint32_t numElements_;  // array element count ('B' tags only)
+    };
+
+    struct StitchedTag
+    {
+        char name_[2];
+        char type_;
+        char subType_;
+        uint32_t numElements_;
+        std::vector<Segment> segments_;
+    };
+
+    const std::vector<BamRecord>& sources_;
+    std::vector<StitchedTag> tags_;
+    size_t numBytes_;
+};
+
+} // namespace internal
+} // namespace BAM
+} // namespace PacBio
+
+#endif // RAWTAGSTITCHER_H
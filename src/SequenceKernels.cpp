@@ -0,0 +1,368 @@
+// Copyright (c) 2016, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// File Description
+/// \file SequenceKernels.cpp
+/// \brief Implements bulk kernels for %BAM sequence & quality conversion.
+//
+// Author: Derek Barnett
+
+#include "SequenceKernels.h"
+#include <htslib/hts.h>
+#include <algorithm>
+#include <array>
+#include <cctype>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// SSSE3 kernels are compiled via function target attributes & picked at
+// runtime, so the library itself needs no extra -m flags.
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define PBBAM_SSSE3_KERNELS 1
+#include <tmmintrin.h>
+#define PBBAM_TARGET_SSSE3 __attribute__((target("ssse3")))
+#endif
+
+namespace PacBio {
+namespace BAM {
+namespace internal {
+
+typedef std::array<uint8_t, 256> ByteTable;
+
+static const char DnaLookup[] = "=ACMGRSVTWYHKDBN";
+
+static ByteTable MakeComplementTable(void)
+{
+    static char const complementLookup[] =
+    {
+        '\0', 'T', 'V', 'G', 'H',
+        '\0', '\0', 'C', 'D', '\0',
+        '\0', 'M', '\0', 'K', 'N',
+        '\0', '\0', '\0', 'Y', 'S',
+        'A', 'A', 'B', 'W', '\0', 'R'
+    };
+
+    ByteTable table;
+    for (size_t c = 0; c < table.size(); ++c) {
+        if (c == '-' || c == '*')
+            table[c] = static_cast<uint8_t>(c);
+        else {
+            const size_t index = toupper(static_cast<int>(c)) & 0x1f;
+            table[c] = (index < sizeof(complementLookup)) ? complementLookup[index] : '\0';
+        }
+    }
+    return table;
+}
+
+static ByteTable MakeComplementCaseSensTable(void)
+{
+    static const int8_t rc_table[128] = {
+        4, 4, 4,   4,  4,   4, 4, 4,  4,  4,  4,  4, 4, 4,  4,  4, 4, 4, 4,
+        4, 4, 4,   4,  4,   4, 4, 4,  4,  4,  4,  4, 4, 32, 4,  4, 4, 4, 4,
+        4, 4, 4,   4,  42,  4, 4, 45, 4,  4,  4,  4, 4, 4,  4,  4, 4, 4, 4,
+        4, 4, 4,   4,  4,   4, 4, 4,  84, 4,  71, 4, 4, 4,  67, 4, 4, 4, 4,
+        4, 4, 78,  4,  4,   4, 4, 4,  65, 65, 4,  4, 4, 4,  4,  4, 4, 4, 4,
+        4, 4, 116, 4,  103, 4, 4, 4,  99, 4,  4,  4, 4, 4,  4,  4, 4, 4, 4,
+        4, 4, 97,  97, 4,   4, 4, 4,  4,  4,  4,  4, 4, 4};
+
+    ByteTable table;
+    table.fill(4);
+    for (size_t c = 0; c < 128; ++c)
+        table[c] = static_cast<uint8_t>(rc_table[c]);
+    return table;
+}
+
+static const ByteTable& ComplementTable(void)
+{
+    static const ByteTable table = MakeComplementTable();
+    return table;
+}
+
+static const ByteTable& ComplementCaseSensTable(void)
+{
+    static const ByteTable table = MakeComplementCaseSensTable();
+    return table;
+}
+
+// ------------------
+// scalar kernels
+// ------------------
+
+static
+void DecodeBamSequenceScalar(const uint8_t* packed, const size_t begin, const size_t length, char* bases)
+{
+    for (size_t i = begin; i < length; ++i)
+        bases[i] = DnaLookup[(packed[i >> 1] >> ((~i & 1) << 2)) & 0xf];
+}
+
+static
+void EncodeBamSequenceScalar(const char* bases, const size_t begin, const size_t length, uint8_t* packed)
+{
+    // NOTE: begin must be even
+    size_t i = begin;
+    for (; i + 1 < length; i += 2) {
+        packed[i >> 1] = static_cast<uint8_t>((seq_nt16_table[static_cast<uint8_t>(bases[i])] << 4) |
+                                               seq_nt16_table[static_cast<uint8_t>(bases[i+1])]);
+    }
+    if (i < length)
+        packed[i >> 1] = static_cast<uint8_t>(seq_nt16_table[static_cast<uint8_t>(bases[i])] << 4);
+}
+
+// reverses [left, right) while translating each character
+static
+void ReverseTranslateScalar(char* seq, size_t left, size_t right, const ByteTable& table)
+{
+    while (left + 1 < right) {
+        --right;
+        const char l = static_cast<char>(table[static_cast<uint8_t>(seq[left])]);
+        seq[left] = static_cast<char>(table[static_cast<uint8_t>(seq[right])]);
+        seq[right] = l;
+        ++left;
+    }
+    if (left < right)
+        seq[left] = static_cast<char>(table[static_cast<uint8_t>(seq[left])]);
+}
+
+// ------------------
+// SSSE3 kernels
+// ------------------
+
+#ifdef PBBAM_SSSE3_KERNELS
+
+static bool HasSsse3(void)
+{
+    static const bool hasSsse3 = __builtin_cpu_supports("ssse3");
+    return hasSsse3;
+}
+
+// Translation of letters via (c & 0x1f), split into upper & lower case and
+// into 16-entry halves for pshufb.
+struct LetterTable
+{
+    uint8_t upperLo[16], upperHi[16], lowerLo[16], lowerHi[16];
+
+    explicit LetterTable(const ByteTable& table)
+    {
+        for (size_t i = 0; i < 16; ++i) {
+            upperLo[i] = table['@' + i];
+            upperHi[i] = table['@' + 16 + i];
+            lowerLo[i] = table['`' + i];
+            lowerHi[i] = table['`' + 16 + i];
+        }
+    }
+};
+
+PBBAM_TARGET_SSSE3 static inline
+__m128i Load(const uint8_t* table)
+{ return _mm_loadu_si128(reinterpret_cast<const __m128i*>(table)); }
+
+// \returns false if any byte is not an ASCII letter
+PBBAM_TARGET_SSSE3 static inline
+bool TranslateLetters(const __m128i c, const LetterTable& t, __m128i* result)
+{
+    const __m128i upper = _mm_and_si128(c, _mm_set1_epi8(static_cast<char>(0xdf)));
+    const __m128i isLetter = _mm_and_si128(_mm_cmpgt_epi8(upper, _mm_set1_epi8('@')),
+                                           _mm_cmplt_epi8(upper, _mm_set1_epi8('[')));
+    if (_mm_movemask_epi8(isLetter) != 0xffff)
+        return false;
+
+    const __m128i index = _mm_and_si128(c, _mm_set1_epi8(0x1f));
+    const __m128i isHi = _mm_cmpgt_epi8(index, _mm_set1_epi8(15));
+    const __m128i isLower = _mm_cmpeq_epi8(_mm_and_si128(c, _mm_set1_epi8(0x20)), _mm_set1_epi8(0x20));
+
+    const __m128i u = _mm_or_si128(_mm_and_si128(isHi, _mm_shuffle_epi8(Load(t.upperHi), index)),
+                                   _mm_andnot_si128(isHi, _mm_shuffle_epi8(Load(t.upperLo), index)));
+    const __m128i l = _mm_or_si128(_mm_and_si128(isHi, _mm_shuffle_epi8(Load(t.lowerHi), index)),
+                                   _mm_andnot_si128(isHi, _mm_shuffle_epi8(Load(t.lowerLo), index)));
+    *result = _mm_or_si128(_mm_and_si128(isLower, l), _mm_andnot_si128(isLower, u));
+    return true;
+}
+
+PBBAM_TARGET_SSSE3 static inline
+__m128i ReverseBytes(const __m128i v)
+{ return _mm_shuffle_epi8(v, _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)); }
+
+PBBAM_TARGET_SSSE3 static
+void DecodeBamSequenceSsse3(const uint8_t* packed, const size_t length, char* bases)
+{
+    const __m128i lookup = _mm_loadu_si128(reinterpret_cast<const __m128i*>(DnaLookup));
+    const __m128i lowNibble = _mm_set1_epi8(0x0f);
+
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        const __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(packed + (i >> 1)));
+        const __m128i first  = _mm_shuffle_epi8(lookup, _mm_and_si128(_mm_srli_epi16(p, 4), lowNibble));
+        const __m128i second = _mm_shuffle_epi8(lookup, _mm_and_si128(p, lowNibble));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(bases + i),      _mm_unpacklo_epi8(first, second));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(bases + i + 16), _mm_unpackhi_epi8(first, second));
+    }
+    DecodeBamSequenceScalar(packed, i, length, bases);
+}
+
+PBBAM_TARGET_SSSE3 static
+void EncodeBamSequenceSsse3(const char* bases, const size_t length, uint8_t* packed)
+{
+    static const LetterTable table = LetterTable([]() {
+        ByteTable nt16;
+        std::copy(seq_nt16_table, seq_nt16_table + 256, nt16.begin());
+        return nt16;
+    }());
+
+    // (first << 4) | second, for each pair of codes
+    const __m128i weights = _mm_set1_epi16(0x0110);
+
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        __m128i lo;
+        __m128i hi;
+        if (!TranslateLetters(_mm_loadu_si128(reinterpret_cast<const __m128i*>(bases + i)), table, &lo) ||
+            !TranslateLetters(_mm_loadu_si128(reinterpret_cast<const __m128i*>(bases + i + 16)), table, &hi))
+        {
+            EncodeBamSequenceScalar(bases, i, i + 32, packed);
+            continue;
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(packed + (i >> 1)),
+                         _mm_packus_epi16(_mm_maddubs_epi16(lo, weights),
+                                          _mm_maddubs_epi16(hi, weights)));
+    }
+    EncodeBamSequenceScalar(bases, i, length, packed);
+}
+
+PBBAM_TARGET_SSSE3 static
+void ReverseTranslateSsse3(char* seq, const size_t length, const ByteTable& scalarTable, const LetterTable& table)
+{
+    size_t left = 0;
+    size_t right = length;
+    while (right - left >= 32) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(seq + left));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(seq + right - 16));
+        __m128i ta;
+        __m128i tb;
+        if (TranslateLetters(a, table, &ta) && TranslateLetters(b, table, &tb)) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(seq + left), ReverseBytes(tb));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(seq + right - 16), ReverseBytes(ta));
+        } else {
+            // swap just these 2 blocks, leaving the middle
+            for (size_t k = 0; k < 16; ++k) {
+                const char l = static_cast<char>(scalarTable[static_cast<uint8_t>(seq[left + k])]);
+                seq[left + k] = static_cast<char>(scalarTable[static_cast<uint8_t>(seq[right - 1 - k])]);
+                seq[right - 1 - k] = l;
+            }
+        }
+        left += 16;
+        right -= 16;
+    }
+    ReverseTranslateScalar(seq, left, right, scalarTable);
+}
+
+#endif // PBBAM_SSSE3_KERNELS
+
+// ------------------
+// public entry points
+// ------------------
+
+void DecodeBamSequence(const uint8_t* packed, const size_t length, char* bases)
+{
+#ifdef PBBAM_SSSE3_KERNELS
+    if (HasSsse3())
+        return DecodeBamSequenceSsse3(packed, length, bases);
+#endif
+    DecodeBamSequenceScalar(packed, 0, length, bases);
+}
+
+void EncodeBamSequence(const char* bases, const size_t length, uint8_t* packed)
+{
+#ifdef PBBAM_SSSE3_KERNELS
+    if (HasSsse3())
+        return EncodeBamSequenceSsse3(bases, length, packed);
+#endif
+    EncodeBamSequenceScalar(bases, 0, length, packed);
+}
+
+void FastqToQualities(const char* fastq, const size_t length, uint8_t* qualities)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i offset = _mm_set1_epi8(33);
+    for (; i + 16 <= length; i += 16) {
+        const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(fastq + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(qualities + i), _mm_sub_epi8(c, offset));
+    }
+#endif
+    for (; i < length; ++i)
+        qualities[i] = static_cast<uint8_t>(fastq[i] - 33);
+}
+
+void QualitiesToFastq(const uint8_t* qualities, const size_t length, char* fastq)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i offset = _mm_set1_epi8(33);
+    for (; i + 16 <= length; i += 16) {
+        const __m128i q = _mm_loadu_si128(reinterpret_cast<const __m128i*>(qualities + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(fastq + i), _mm_add_epi8(q, offset));
+    }
+#endif
+    for (; i < length; ++i)
+        fastq[i] = static_cast<char>(qualities[i] + 33);
+}
+
+void ReverseComplementInPlace(char* seq, const size_t length)
+{
+#ifdef PBBAM_SSSE3_KERNELS
+    if (HasSsse3()) {
+        static const LetterTable table{ ComplementTable() };
+        return ReverseTranslateSsse3(seq, length, ComplementTable(), table);
+    }
+#endif
+    ReverseTranslateScalar(seq, 0, length, ComplementTable());
+}
+
+void ReverseComplementCaseSensInPlace(char* seq, const size_t length)
+{
+#ifdef PBBAM_SSSE3_KERNELS
+    if (HasSsse3()) {
+        static const LetterTable table{ ComplementCaseSensTable() };
+        return ReverseTranslateSsse3(seq, length, ComplementCaseSensTable(), table);
+    }
+#endif
+    ReverseTranslateScalar(seq, 0, length, ComplementCaseSensTable());
+}
+
+} // namespace internal
+} // namespace BAM
+} // namespace PacBio
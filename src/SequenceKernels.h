@@ -0,0 +1,79 @@
+// Copyright (c) 2016, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// File Description
+/// \file SequenceKernels.h
+/// \brief Defines bulk kernels for %BAM sequence & quality conversion.
+//
+// Author: Derek Barnett
+
+#ifndef SEQUENCEKERNELS_H
+#define SEQUENCEKERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace PacBio {
+namespace BAM {
+namespace internal {
+
+// These work on caller-provided buffers. Vectorized versions are selected at
+// runtime, when the CPU supports them.
+
+/// \brief Unpacks \p length 4-bit %BAM bases (2 per byte) into ASCII.
+void DecodeBamSequence(const uint8_t* packed, const size_t length, char* bases);
+
+/// \brief Packs \p length ASCII bases into 4-bit %BAM codes (2 per byte).
+void EncodeBamSequence(const char* bases, const size_t length, uint8_t* packed);
+
+/// \brief Converts FASTQ characters to quality values (-33).
+void FastqToQualities(const char* fastq, const size_t length, uint8_t* qualities);
+
+/// \brief Converts quality values to FASTQ characters (+33).
+void QualitiesToFastq(const uint8_t* qualities, const size_t length, char* fastq);
+
+/// \brief Reverse complements \p seq in place. Output is upper case, '-' &
+///        '*' are kept as-is.
+void ReverseComplementInPlace(char* seq, const size_t length);
+
+/// \brief Reverse complements \p seq in place, keeping the case of A/C/G/T
+///        (U is complemented to A). Unknown characters become 0x04, as before.
+void ReverseComplementCaseSensInPlace(char* seq, const size_t length);
+
+} // namespace internal
+} // namespace BAM
+} // namespace PacBio
+
+#endif // SEQUENCEKERNELS_H
@@ -38,6 +38,7 @@
 #ifndef SEQUENCEUTILS_H
 #define SEQUENCEUTILS_H
 
+#include "SequenceKernels.h"
 #include "StringUtils.h"
 #include <algorithm>
 #include <string>
@@ -91,14 +92,8 @@ T Reversed(const T& input)
 //    return result;
 //}
 
-inline void ReverseComplement(std::string& seq) {
-
-    std::string::iterator sIter = seq.begin();
-    std::string::iterator sEnd  = seq.end();
-    for ( ; sIter != sEnd; ++sIter )
-        *sIter = Complement(*sIter);
-    Reverse(seq);
-}
+inline void ReverseComplement(std::string& seq)
+{ ReverseComplementInPlace(&seq[0], seq.size()); }
 
 inline std::string MaybeReverseComplement(std::string&& seq, bool reverse)
 {
@@ -108,21 +103,7 @@ inline std::string MaybeReverseComplement(std::string&& seq, bool reverse)
 
 /// Reverse complement a DNA sequence case-sensitive
 inline void ReverseComplementCaseSens(std::string& seq)
-{
-    const std::string original = seq;
-    int8_t rc_table[128] = {
-        4, 4, 4,   4,  4,   4, 4, 4,  4,  4,  4,  4, 4, 4,  4,  4, 4, 4, 4,
-        4, 4, 4,   4,  4,   4, 4, 4,  4,  4,  4,  4, 4, 32, 4,  4, 4, 4, 4,
-        4, 4, 4,   4,  42,  4, 4, 45, 4,  4,  4,  4, 4, 4,  4,  4, 4, 4, 4,
-        4, 4, 4,   4,  4,   4, 4, 4,  84, 4,  71, 4, 4, 4,  67, 4, 4, 4, 4,
-        4, 4, 78,  4,  4,   4, 4, 4,  65, 65, 4,  4, 4, 4,  4,  4, 4, 4, 4,
-        4, 4, 116, 4,  103, 4, 4, 4,  99, 4,  4,  4, 4, 4,  4,  4, 4, 4, 4,
-        4, 4, 97,  97, 4,   4, 4, 4,  4,  4,  4,  4, 4, 4};
-    std::string reverseCompl(original.length(), 'N');
-    for (uint32_t i = 0; i < original.length(); ++i)
-        reverseCompl[original.length()-i-1] = (char)rc_table[(int8_t)original[i]];
-    seq = reverseCompl;
-}
+{ ReverseComplementCaseSensInPlace(&seq[0], seq.size()); }
 
 inline std::string MaybeReverseComplementCaseSens(std::string&& seq, bool reverse)
 {
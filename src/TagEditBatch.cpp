@@ -0,0 +1,134 @@
+// Copyright (c) 2016, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+// File Description
+/// \file TagEditBatch.cpp
+/// \brief Implements the TagEditBatch class.
+//
+// Author: Derek Barnett
+
+#include "pbbam/TagEditBatch.h"
+#include "pbbam/BamTagCodec.h"
+#include "BamRecordTags.h"
+
+namespace PacBio {
+namespace BAM {
+
+TagEditBatch::TagEditBatch(void) { }
+
+TagEditBatch& TagEditBatch::Add(const std::string& tagName,
+                                const Tag& value,
+                                const TagModifier additionalModifier)
+{ return AddEdit(EditType::ADD, tagName, &value, additionalModifier); }
+
+TagEditBatch& TagEditBatch::Add(const BamRecordTag tag,
+                                const Tag& value,
+                                const TagModifier additionalModifier)
+{ return Add(internal::BamRecordTags::LabelFor(tag), value, additionalModifier); }
+
+TagEditBatch& TagEditBatch::AddEdit(const EditType type,
+                                    const std::string& tagName,
+                                    const Tag* value,
+                                    const TagModifier additionalModifier)
+{
+    Edit_ edit;
+    edit.type_   = type;
+    edit.code_   = 0;
+    edit.valid_  = (tagName.size() == 2);
+    edit.offset_ = data_.size();
+    edit.length_ = 0;
+
+    if (edit.valid_) {
+        edit.code_ = (static_cast<uint8_t>(tagName.at(0)) << 8) |
+                      static_cast<uint8_t>(tagName.at(1));
+
+        // encode value now, so applying the batch is just byte shuffling
+        if (value) {
+            const size_t numBytes = BamTagCodec::EncodedSize(*value, additionalModifier);
+            if (numBytes == 0)
+                edit.valid_ = false;
+            else {
+                const uint8_t typeCode = BamTagCodec::TagTypeCode(*value, additionalModifier);
+                data_.resize(edit.offset_ + 1 + numBytes);
+                data_[edit.offset_] = typeCode;
+                BamTagCodec::ToRawData(*value, additionalModifier, &data_[edit.offset_ + 1]);
+                edit.length_ = 1 + numBytes;
+            }
+        }
+    }
+
+    edits_.push_back(edit);
+    return *this;
+}
+
+void TagEditBatch::Clear(void)
+{
+    edits_.clear();
+    data_.clear();
+}
+
+TagEditBatch& TagEditBatch::Edit(const std::string& tagName,
+                                 const Tag& value,
+                                 const TagModifier additionalModifier)
+{ return AddEdit(EditType::EDIT, tagName, &value, additionalModifier); }
+
+TagEditBatch& TagEditBatch::Edit(const BamRecordTag tag,
+                                 const Tag& value,
+                                 const TagModifier additionalModifier)
+{ return Edit(internal::BamRecordTags::LabelFor(tag), value, additionalModifier); }
+
+bool TagEditBatch::IsEmpty(void) const
+{ return edits_.empty(); }
+
+TagEditBatch& TagEditBatch::Remove(const std::string& tagName)
+{ return AddEdit(EditType::REMOVE, tagName, nullptr, TagModifier::NONE); }
+
+TagEditBatch& TagEditBatch::Remove(const BamRecordTag tag)
+{ return Remove(internal::BamRecordTags::LabelFor(tag)); }
+
+TagEditBatch& TagEditBatch::Set(const std::string& tagName,
+                                const Tag& value,
+                                const TagModifier additionalModifier)
+{ return AddEdit(EditType::SET, tagName, &value, additionalModifier); }
+
+TagEditBatch& TagEditBatch::Set(const BamRecordTag tag,
+                                const Tag& value,
+                                const TagModifier additionalModifier)
+{ return Set(internal::BamRecordTags::LabelFor(tag), value, additionalModifier); }
+
+size_t TagEditBatch::Size(void) const
+{ return edits_.size(); }
+
+} // namespace BAM
+} // namespace PacBio
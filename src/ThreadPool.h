@@ -0,0 +1,157 @@
+// Copyright (c) 2016, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// Author: Derek Barnett
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace PacBio {
+namespace BAM {
+namespace internal {
+
+/// \internal
+///
+/// Fixed-size pool of worker threads, fed from a single FIFO task queue.
+///
+/// Tasks still waiting in the queue when the pool is destroyed are
+/// discarded (their futures report std::future_error). Tasks already running
+/// are allowed to complete.
+///
+class ThreadPool
+{
+public:
+    /// \returns the thread count to use for a requested count, where 0 means
+    ///          "use available hardware threads" (falling back to 1)
+    static size_t ActualNumThreads(const size_t numThreads)
+    {
+        size_t actualNumThreads = numThreads;
+        if (actualNumThreads == 0) {
+            actualNumThreads = std::thread::hardware_concurrency();
+
+            // if still unknown, default to single-threaded
+            if (actualNumThreads == 0)
+                actualNumThreads = 1;
+        }
+        return actualNumThreads;
+    }
+
+public:
+    explicit ThreadPool(const size_t numThreads)
+        : stop_(false)
+    {
+        const size_t actualNumThreads = ActualNumThreads(numThreads);
+        threads_.reserve(actualNumThreads);
+        for (size_t i = 0; i < actualNumThreads; ++i)
+            threads_.emplace_back(&ThreadPool::Run, this);
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool(void)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+            tasks_.clear();
+        }
+        condition_.notify_all();
+        for (auto& t : threads_)
+            t.join();
+    }
+
+public:
+    size_t NumThreads(void) const
+    { return threads_.size(); }
+
+    /// Queues 'task' for execution on a worker thread.
+    ///
+    /// \returns future for the task's result (or exception)
+    ///
+    template<typename F>
+    std::future<typename std::result_of<F()>::type> Submit(F&& task)
+    {
+        typedef typename std::result_of<F()>::type ResultType;
+        auto packaged = std::make_shared<std::packaged_task<ResultType()> >(std::forward<F>(task));
+        auto result = packaged->get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tasks_.emplace_back([packaged]() { (*packaged)(); });
+        }
+        condition_.notify_one();
+        return result;
+    }
+
+private:
+    void Run(void)
+    {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                condition_.wait(lock, [this]() { return stop_ || !tasks_.empty(); });
+                if (stop_)
+                    return;
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+            task();
+        }
+    }
+
+private:
+    std::vector<std::thread> threads_;
+    std::deque<std::function<void()> > tasks_;
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    bool stop_;
+};
+
+} // namespace internal
+} // namespace BAM
+} // namespace PacBio
+
+#endif // THREADPOOL_H
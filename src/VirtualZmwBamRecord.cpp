@@ -39,6 +39,7 @@
 //
 // Author: Armin Töpfer
 
+#include <cassert>
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
@@ -47,6 +48,9 @@
 #include "pbbam/virtual/VirtualZmwBamRecord.h"
 #include "pbbam/virtual/VirtualRegionType.h"
 #include "pbbam/virtual/VirtualRegionTypeMap.h"
+#include "BamRecordTags.h"
+#include "RawTagStitcher.h"
+#include "VirtualZmwStitching.h"
 
 namespace PacBio {
 namespace BAM {
@@ -92,6 +96,129 @@ inline void MoveAppend(std::vector<T>&& src, std::vector<T>& dst) noexcept
     }
 }
 
+/// \brief Stitches a frame-data tag (IPD, PW, etc) from source records.
+///
+/// Sources' raw data is concatenated as-is, when they share an encoding.
+/// Mixed lossy & lossless sources are decoded & stored as lossless frames.
+///
+inline void StitchFrames(const std::vector<BamRecord>& sources,
+                         const BamRecordTag tag,
+                         RawTagStitcher* stitcher,
+                         BamRecord* record)
+{
+    // frame codes mean different things per encoding, so never widen them
+    if (stitcher->Add(tag, { tag }, false))
+        return;
+
+    Frames frames;
+    for (const BamRecord& b : sources) {
+        Frames sourceFrames;
+        switch (tag) {
+            case BamRecordTag::IPD              : sourceFrames = b.IPD(); break;
+            case BamRecordTag::PULSE_WIDTH      : sourceFrames = b.PulseWidth(); break;
+            case BamRecordTag::PRE_PULSE_FRAMES : sourceFrames = b.PrePulseFrames(); break;
+            case BamRecordTag::PULSE_CALL_WIDTH : sourceFrames = b.PulseCallWidth(); break;
+            default:
+                assert(false);
+        }
+        MoveAppend(sourceFrames.DataRaw(), frames.DataRaw());
+    }
+    switch (tag) {
+        case BamRecordTag::IPD              : record->IPD(frames, FrameEncodingType::LOSSLESS); break;
+        case BamRecordTag::PULSE_WIDTH      : record->PulseWidth(frames, FrameEncodingType::LOSSLESS); break;
+        case BamRecordTag::PRE_PULSE_FRAMES : record->PrePulseFrames(frames, FrameEncodingType::LOSSLESS); break;
+        case BamRecordTag::PULSE_CALL_WIDTH : record->PulseCallWidth(frames, FrameEncodingType::LOSSLESS); break;
+        default:
+            assert(false);
+    }
+}
+
+/// \brief Stitches a non-frame tag from source records.
+///
+/// Array values with differing element types (e.g. 'sf' stored as 'B,S' in
+/// one source & 'B,I' in another) are widened to a common type. Only a mix of
+/// string & array values, which the spec does not allow, is an error.
+///
+inline void StitchTag(const BamRecordTag tag,
+                      const std::vector<BamRecordTag>& sourceTags,
+                      RawTagStitcher* stitcher)
+{
+    if (!stitcher->Add(tag, sourceTags))
+        throw std::runtime_error("source records have mismatched types for tag: " +
+                                 BamRecordTags::LabelFor(tag));
+}
+
+void SortVirtualZmwSources(std::vector<BamRecord>* sources)
+{
+    // Sort sources by queryStart
+    std::sort(sources->begin(), sources->end(),
+              [](const BamRecord& l1, const BamRecord& l2)
+              { return l1.QueryStart() < l2.QueryStart(); });
+}
+
+VirtualRegionsMap StitchVirtualRegions(const std::vector<BamRecord>& sources,
+                                       const size_t sequenceLength)
+{
+    VirtualRegionsMap virtualRegionsMap;
+    for (const BamRecord& b : sources)
+    {
+        if (b.HasScrapRegionType())
+        {
+            const VirtualRegionType regionType = b.ScrapRegionType();
+            virtualRegionsMap[regionType].emplace_back(
+                regionType, b.QueryStart(), b.QueryEnd());
+        }
+
+        if (b.HasLocalContextFlags())
+        {
+            std::pair<int, int> barcodes{-1, -1};
+            if (b.HasBarcodes())
+                barcodes = b.Barcodes();
+
+            constexpr auto regionType = VirtualRegionType::SUBREAD;
+            virtualRegionsMap[regionType].emplace_back(
+                regionType, b.QueryStart(), b.QueryEnd(), b.LocalContextFlags(),
+                barcodes.first, barcodes.second);
+        }
+    }
+
+    // Determine HQREGION bases on LQREGIONS
+    const auto lqRegions = virtualRegionsMap.find(VirtualRegionType::LQREGION);
+    if (lqRegions != virtualRegionsMap.end())
+    {
+        if (lqRegions->second.size() == 1)
+        {
+            const auto lq = lqRegions->second[0];
+            if (lq.beginPos == 0)
+                virtualRegionsMap[VirtualRegionType::HQREGION].emplace_back(
+                    VirtualRegionType::HQREGION, lq.endPos, sequenceLength);
+            else if (lq.endPos == static_cast<int>(sequenceLength))
+                virtualRegionsMap[VirtualRegionType::HQREGION].emplace_back(
+                    VirtualRegionType::HQREGION, 0, lq.beginPos);
+            else
+                throw std::runtime_error("Unknown HQREGION");
+        }
+        else
+        {
+            const std::vector<VirtualRegion> lqregions = lqRegions->second;
+            int beginPos = 0;
+            for (const auto& lqregion : lqregions)
+            {
+                if (lqregion.beginPos - beginPos > 0)
+                    virtualRegionsMap[VirtualRegionType::HQREGION].emplace_back(
+                        VirtualRegionType::HQREGION, beginPos, lqregion.beginPos);
+                beginPos = lqregion.endPos;
+            }
+        }
+    }
+    else
+    {
+        virtualRegionsMap[VirtualRegionType::HQREGION].emplace_back(
+            VirtualRegionType::HQREGION, 0, sequenceLength);
+    }
+    return virtualRegionsMap;
+}
+
 } // namespace internal
 
 VirtualZmwBamRecord::VirtualZmwBamRecord(
@@ -99,10 +226,7 @@ VirtualZmwBamRecord::VirtualZmwBamRecord(
     : BamRecord(header)
     , sources_(std::move(unorderedSources))
 {
-    // Sort sources by queryStart
-    std::sort(sources_.begin(), sources_.end(),
-              [](const BamRecord& l1, const BamRecord& l2)
-              { return l1.QueryStart() < l2.QueryStart(); });
+    internal::SortVirtualZmwSources(&sources_);
     StitchSources();
 }
 
@@ -111,9 +235,9 @@ bool VirtualZmwBamRecord::HasVirtualRegionType(const VirtualRegionType regionTyp
 
 Frames VirtualZmwBamRecord::IPDV1Frames(Orientation orientation) const
 {
-    const auto rawFrames = this->IPDRaw(orientation);
-    const std::vector<uint8_t> rawData(rawFrames.Data().begin(), rawFrames.Data().end());
-    return Frames::Decode(rawData);
+    // stitched IPD keeps its sources' encoding, so lossy (V1) codes are
+    // decoded here & lossless frames are returned as-is
+    return this->IPD(orientation);
 }
 
 
@@ -123,50 +247,12 @@ void VirtualZmwBamRecord::StitchSources(void)
     const auto& lastRecord = sources_[sources_.size() - 1];
 
     std::string   sequence;
-    std::string   deletionTag;
-    std::string   substitutionTag;
-    std::string   alternativeLabelTag;
-    std::string   pulseCall;
-
     QualityValues qualities;
-    QualityValues deletionQv;
-    QualityValues insertionQv;
-    QualityValues mergeQv;
-    QualityValues pulseMergeQv;
-    QualityValues substitutionQv;
-    QualityValues labelQv;
-    QualityValues alternativeLabelQv;
-
-    Frames                ipd;
-    Frames                pw;
-    Frames                pd;
-    Frames                px;
-    std::vector<float>    pa;
-    std::vector<float>    pm;
-    std::vector<uint32_t> sf;
 
     // initialize capacity
     const auto stitchedSize = lastRecord.QueryEnd() - firstRecord.QueryStart();
     sequence.reserve(stitchedSize);
-    deletionTag.reserve(stitchedSize);
-    substitutionTag.reserve(stitchedSize);
-    alternativeLabelTag.reserve(stitchedSize);
-    pulseCall.reserve(stitchedSize);
     qualities.reserve(stitchedSize);
-    deletionQv.reserve(stitchedSize);
-    insertionQv.reserve(stitchedSize);
-    mergeQv.reserve(stitchedSize);
-    pulseMergeQv.reserve(stitchedSize);
-    substitutionQv.reserve(stitchedSize);
-    labelQv.reserve(stitchedSize);
-    alternativeLabelQv.reserve(stitchedSize);
-    ipd.DataRaw().reserve(stitchedSize);
-    pw.DataRaw().reserve(stitchedSize);
-    pd.DataRaw().reserve(stitchedSize);
-    px.DataRaw().reserve(stitchedSize);
-    pa.reserve(stitchedSize);
-    pm.reserve(stitchedSize);
-    sf.reserve(stitchedSize);
 
     using internal::MoveAppend;
 
@@ -177,92 +263,6 @@ void VirtualZmwBamRecord::StitchSources(void)
 
         MoveAppend(b.Qualities(), qualities);
 
-        if (b.HasDeletionQV())
-            MoveAppend(std::move(b.DeletionQV()), deletionQv);
-
-        if (b.HasInsertionQV())
-            MoveAppend(std::move(b.InsertionQV()), insertionQv);
-
-        if (b.HasMergeQV())
-            MoveAppend(std::move(b.MergeQV()), mergeQv);
-
-        if (b.HasPulseMergeQV())
-            MoveAppend(std::move(b.PulseMergeQV()), pulseMergeQv);
-
-        if (b.HasSubstitutionQV())
-            MoveAppend(std::move(b.SubstitutionQV()), substitutionQv);
-
-        if (b.HasLabelQV())
-            MoveAppend(std::move(b.LabelQV()), labelQv);
-
-        if (b.HasAltLabelQV())
-            MoveAppend(std::move(b.AltLabelQV()), alternativeLabelQv);
-
-        if (b.HasDeletionTag())
-            deletionTag.append(std::move(b.DeletionTag()));
-
-        if (b.HasSubstitutionTag())
-            substitutionTag.append(std::move(b.SubstitutionTag()));
-
-        if (b.HasAltLabelTag())
-            alternativeLabelTag.append(std::move(b.AltLabelTag()));
-
-        if (b.HasPulseCall())
-            pulseCall.append(std::move(b.PulseCall()));
-
-        if (b.HasIPD())
-            MoveAppend(b.IPDRaw().DataRaw(), ipd.DataRaw());
-
-        if (b.HasPulseWidth())
-            MoveAppend(b.PulseWidthRaw().DataRaw(), pw.DataRaw());
-
-        if (b.HasPulseCallWidth())
-            MoveAppend(b.PulseCallWidth().DataRaw(), px.DataRaw());
-
-        if (b.HasPrePulseFrames())
-            MoveAppend(b.PrePulseFrames().DataRaw(), pd.DataRaw());
-
-        if (b.HasPkmid())
-            MoveAppend(b.Pkmid(), pm);
-
-        if (b.HasPkmean())
-            MoveAppend(b.Pkmean(), pa);
-
-        if (b.HasPkmid2())
-            MoveAppend(b.Pkmid2(), pm);
-
-        if (b.HasPkmean2())
-            MoveAppend(b.Pkmean2(), pa);
-
-        if (b.HasStartFrame())
-            MoveAppend(b.StartFrame(), sf);
-
-        if (b.HasScrapRegionType())
-        {
-            const VirtualRegionType regionType = b.ScrapRegionType();
-
-            if (!HasVirtualRegionType(regionType))
-                virtualRegionsMap_[regionType] = std::vector<VirtualRegion>();
-
-            virtualRegionsMap_[regionType].emplace_back(
-                regionType, b.QueryStart(), b.QueryEnd());
-        }
-
-        if (b.HasLocalContextFlags())
-        {
-            std::pair<int, int> barcodes{-1, -1};
-            if (b.HasBarcodes())
-                barcodes = b.Barcodes();
-
-            constexpr auto regionType = VirtualRegionType::SUBREAD;
-            if (!HasVirtualRegionType(regionType))
-                virtualRegionsMap_[regionType] = std::vector<VirtualRegion>();
-
-            virtualRegionsMap_[regionType].emplace_back(
-                regionType, b.QueryStart(), b.QueryEnd(), b.LocalContextFlags(),
-                barcodes.first, barcodes.second);
-        }
-
         if (b.HasBarcodes() && !this->HasBarcodes())
             this->Barcodes(b.Barcodes());
 
@@ -302,82 +302,35 @@ void VirtualZmwBamRecord::StitchSources(void)
     else
         this->Impl().SetSequenceAndQualities(sequence);
 
-    // Tags as strings
-    if (!deletionTag.empty())
-        this->DeletionTag(deletionTag);
-    if (!substitutionTag.empty())
-        this->SubstitutionTag(substitutionTag);
-    if (!alternativeLabelTag.empty())
-        this->AltLabelTag(alternativeLabelTag);
-    if (!pulseCall.empty())
-        this->PulseCall(pulseCall);
-
-    // QVs
-    if (!deletionQv.empty())
-        this->DeletionQV(deletionQv);
-    if (!insertionQv.empty())
-        this->InsertionQV(insertionQv);
-    if (!mergeQv.empty())
-        this->MergeQV(mergeQv);
-    if (!pulseMergeQv.empty())
-        this->PulseMergeQV(pulseMergeQv);
-    if (!substitutionQv.empty())
-        this->SubstitutionQV(substitutionQv);
-    if (!labelQv.empty())
-        this->LabelQV(labelQv);
-    if (!alternativeLabelQv.empty())
-        this->AltLabelQV(alternativeLabelQv);
-
-    // 16 bit arrays
-    if (!ipd.Data().empty())
-        this->IPD(ipd, FrameEncodingType::LOSSLESS);
-    if (!pw.Data().empty())
-        this->PulseWidth(pw, FrameEncodingType::LOSSLESS);
-    if (!pa.empty())
-        this->Pkmean(pa);
-    if (!pm.empty())
-        this->Pkmid(pm);
-    if (!pd.Data().empty())
-        this->PrePulseFrames(pd, FrameEncodingType::LOSSLESS);
-    if (!px.Data().empty())
-        this->PulseCallWidth(px, FrameEncodingType::LOSSLESS);
-
-    // 32 bit arrays
-    if (!sf.empty())
-        this->StartFrame(sf);
-
-    // Determine HQREGION bases on LQREGIONS
-    if (HasVirtualRegionType(VirtualRegionType::LQREGION))
-    {
-        if (virtualRegionsMap_[VirtualRegionType::LQREGION].size() == 1)
-        {
-            const auto lq = virtualRegionsMap_[VirtualRegionType::LQREGION][0];
-            if (lq.beginPos == 0)
-                virtualRegionsMap_[VirtualRegionType::HQREGION].emplace_back(
-                    VirtualRegionType::HQREGION, lq.endPos, sequence.size());
-            else if (lq.endPos == static_cast<int>(sequence.size()))
-                virtualRegionsMap_[VirtualRegionType::HQREGION].emplace_back(
-                    VirtualRegionType::HQREGION, 0, lq.beginPos);
-            else
-                throw std::runtime_error("Unknown HQREGION");
-        }
-        else
-        {
-            int beginPos = 0;
-            for (const auto& lqregion : virtualRegionsMap_[VirtualRegionType::LQREGION])
-            {
-                if (lqregion.beginPos - beginPos > 0)
-                    virtualRegionsMap_[VirtualRegionType::HQREGION].emplace_back(
-                        VirtualRegionType::HQREGION, beginPos, lqregion.beginPos);
-                beginPos = lqregion.endPos;
-            }
-        }
-    }
-    else
-    {
-        virtualRegionsMap_[VirtualRegionType::HQREGION].emplace_back(
-            VirtualRegionType::HQREGION, 0, sequence.size());
-    }
+    // Per-base & per-pulse tags, concatenated directly from the sources' raw
+    // tag data. Frame data keeps its source encoding (lossy or lossless).
+    //
+    // NOTE: pkmid2/pkmean2 are appended to pkmid/pkmean
+    //
+    internal::RawTagStitcher stitcher(sources_);
+    internal::StitchTag(BamRecordTag::DELETION_TAG,     { BamRecordTag::DELETION_TAG },     &stitcher);
+    internal::StitchTag(BamRecordTag::SUBSTITUTION_TAG, { BamRecordTag::SUBSTITUTION_TAG }, &stitcher);
+    internal::StitchTag(BamRecordTag::ALT_LABEL_TAG,    { BamRecordTag::ALT_LABEL_TAG },    &stitcher);
+    internal::StitchTag(BamRecordTag::PULSE_CALL,       { BamRecordTag::PULSE_CALL },       &stitcher);
+    internal::StitchTag(BamRecordTag::DELETION_QV,      { BamRecordTag::DELETION_QV },      &stitcher);
+    internal::StitchTag(BamRecordTag::INSERTION_QV,     { BamRecordTag::INSERTION_QV },     &stitcher);
+    internal::StitchTag(BamRecordTag::MERGE_QV,         { BamRecordTag::MERGE_QV },         &stitcher);
+    internal::StitchTag(BamRecordTag::PULSE_MERGE_QV,   { BamRecordTag::PULSE_MERGE_QV },   &stitcher);
+    internal::StitchTag(BamRecordTag::SUBSTITUTION_QV,  { BamRecordTag::SUBSTITUTION_QV },  &stitcher);
+    internal::StitchTag(BamRecordTag::LABEL_QV,         { BamRecordTag::LABEL_QV },         &stitcher);
+    internal::StitchTag(BamRecordTag::ALT_LABEL_QV,     { BamRecordTag::ALT_LABEL_QV },     &stitcher);
+    internal::StitchTag(BamRecordTag::PKMEAN, { BamRecordTag::PKMEAN, BamRecordTag::PKMEAN_2 }, &stitcher);
+    internal::StitchTag(BamRecordTag::PKMID,  { BamRecordTag::PKMID,  BamRecordTag::PKMID_2 },  &stitcher);
+    internal::StitchTag(BamRecordTag::START_FRAME,      { BamRecordTag::START_FRAME },      &stitcher);
+
+    internal::StitchFrames(sources_, BamRecordTag::IPD,              &stitcher, this);
+    internal::StitchFrames(sources_, BamRecordTag::PULSE_WIDTH,      &stitcher, this);
+    internal::StitchFrames(sources_, BamRecordTag::PRE_PULSE_FRAMES, &stitcher, this);
+    internal::StitchFrames(sources_, BamRecordTag::PULSE_CALL_WIDTH, &stitcher, this);
+
+    stitcher.Write(this);
+
+    virtualRegionsMap_ = internal::StitchVirtualRegions(sources_, sequence.size());
 }
 
 
@@ -42,12 +42,105 @@
 #include <stdexcept>
 
 #include "VirtualZmwReader.h"
+#include "pbbam/DataSet.h"
+#include "pbbam/PbiIndexedBamReader.h"
 #include "pbbam/ReadGroupInfo.h"
+#include <algorithm>
 
 namespace PacBio {
 namespace BAM {
 namespace internal {
 
+std::deque<std::pair<std::string, std::string> >
+ZmwStitchingSources(const DataSet& dataset)
+{
+    std::deque<std::pair<std::string, std::string> > sources;
+
+    std::string primaryFn;
+    std::string scrapsFn;
+    const ExternalResources& resources = dataset.ExternalResources();
+    for (const ExternalResource& resource : resources) {
+
+        primaryFn.clear();
+        scrapsFn.clear();
+
+        // if resource is possible "primary" BAM
+        const auto& metatype = resource.MetaType();
+        if (metatype == "PacBio.SubreadFile.SubreadBamFile" ||
+            metatype == "PacBio.SubreadFile.HqRegionBamFile")
+        {
+            // possible resolve relative path
+            primaryFn = dataset.ResolvePath(resource.ResourceId());
+
+            // check for associated scraps file
+            const ExternalResources& childResources = resource.ExternalResources();
+            for (const ExternalResource& childResource : childResources) {
+                const auto& childMetatype = childResource.MetaType();
+                if (childMetatype == "PacBio.SubreadFile.ScrapsBamFile" ||
+                    childMetatype == "PacBio.SubreadFile.HqScrapsBamFile")
+                {
+                    // possible resolve relative path
+                    scrapsFn = dataset.ResolvePath(childResource.ResourceId());
+                    break;
+                }
+            }
+        }
+
+        // queue up source for later
+        if (!primaryFn.empty() && !scrapsFn.empty())
+            sources.push_back(std::make_pair(primaryFn, scrapsFn));
+    }
+    return sources;
+}
+
+ZmwSourceCursor::ZmwSourceCursor(const BamFile& file, const PbiFilter& filter)
+    : pbiHoleNumbers_(nullptr)
+    , blockRow_(0)
+    , holeNumber_(-1)
+    , hasRecord_(false)
+{
+    if (file.PacBioIndexExists()) {
+        auto* reader = new PbiIndexedBamReader{ filter, file };
+        reader_.reset(reader);
+
+        // walk the reader's own filter result, alongside its records
+        pbiHoleNumbers_ = &reader->PbiRawIndex().BasicData().holeNumber_;
+        pbiBlocks_ = reader->ResultBlocks();
+    } else {
+        if (!filter.IsEmpty())
+            throw std::runtime_error("PBI index file required for filtered ZMW stitching: "
+                                     + file.Filename());
+        reader_.reset(new BamReader{ file });
+    }
+    ReadNext();
+}
+
+void ZmwSourceCursor::MoveTo(std::vector<BamRecord>* records)
+{
+    records->push_back(std::move(record_));
+    record_ = BamRecord{ };
+    ReadNext();
+}
+
+void ZmwSourceCursor::ReadNext(void)
+{
+    hasRecord_ = reader_->GetNext(record_);
+    if (!hasRecord_)
+        return;
+
+    if (pbiBlocks_.empty()) {
+        holeNumber_ = record_.HoleNumber();
+        return;
+    }
+
+    const IndexResultBlock& block = pbiBlocks_.front();
+    holeNumber_ = pbiHoleNumbers_->at(block.firstIndex_ + blockRow_);
+    if (++blockRow_ == block.numReads_) {
+        pbiBlocks_.pop_front();
+        blockRow_ = 0;
+    }
+}
+
 VirtualZmwReader::VirtualZmwReader(const std::string& primaryBamFilepath,
                                    const std::string& scrapsBamFilepath)
     : VirtualZmwReader(primaryBamFilepath, scrapsBamFilepath, PbiFilter{})
@@ -56,21 +149,13 @@ VirtualZmwReader::VirtualZmwReader(const std::string& primaryBamFilepath,
 VirtualZmwReader::VirtualZmwReader(const std::string& primaryBamFilepath,
                                    const std::string& scrapsBamFilepath,
                                    const PbiFilter& filter)
+    : lastZmwSize_(0)
 {
     primaryBamFile_.reset(new BamFile{ primaryBamFilepath });
     scrapsBamFile_.reset(new BamFile{ scrapsBamFilepath });
 
-    if (filter.IsEmpty()) {
-        primaryQuery_.reset(new EntireFileQuery(*primaryBamFile_));
-        scrapsQuery_.reset(new EntireFileQuery(*scrapsBamFile_));
-    }
-    else {
-        primaryQuery_.reset(new PbiFilterQuery{ filter, *primaryBamFile_ });
-        scrapsQuery_.reset(new PbiFilterQuery{ filter, *scrapsBamFile_ });
-    }
-
-    primaryIt_ = (primaryQuery_->begin());
-    scrapsIt_ = (scrapsQuery_->begin());
+    primary_.reset(new ZmwSourceCursor{ *primaryBamFile_, filter });
+    scraps_.reset(new ZmwSourceCursor{ *scrapsBamFile_, filter });
 
     stitchedHeader_.reset(new BamHeader{ primaryBamFile_->Header().ToSam() });
 
@@ -94,44 +179,41 @@ VirtualZmwReader::~VirtualZmwReader(void) { }
 
 bool VirtualZmwReader::HasNext(void)
 {
-    // Return true until both iterators are at the end of the query
-    return primaryIt_ != primaryQuery_->end() ||
-            scrapsIt_ != scrapsQuery_->end();
+    // Return true until both sources are exhausted
+    return primary_->HasRecord() || scraps_->HasRecord();
 }
 
 // This method is not thread safe
 VirtualZmwBamRecord VirtualZmwReader::Next(void)
 { return VirtualZmwBamRecord{ NextRaw(), *stitchedHeader_ }; }
 
+LazyVirtualZmwBamRecord VirtualZmwReader::NextLazy(void)
+{ return LazyVirtualZmwBamRecord{ NextRaw(), *stitchedHeader_ }; }
+
 std::vector<BamRecord> VirtualZmwReader::NextRaw(void)
 {
     std::vector<BamRecord> bamRecordVec;
+    bamRecordVec.reserve(lastZmwSize_);
 
     // Current hole number, the smallest of scraps and primary.
     // It can be that the next ZMW is scrap only.
-    int currentHoleNumber;
-    if (primaryIt_ == primaryQuery_->end())
-        currentHoleNumber = (*scrapsIt_).HoleNumber();
-    else if (scrapsIt_ == scrapsQuery_->end())
-        currentHoleNumber = (*primaryIt_).HoleNumber();
+    int32_t currentHoleNumber;
+    if (!primary_->HasRecord())
+        currentHoleNumber = scraps_->HoleNumber();
+    else if (!scraps_->HasRecord())
+        currentHoleNumber = primary_->HoleNumber();
     else
-        currentHoleNumber = std::min((*primaryIt_).HoleNumber(),
-                                     (*scrapsIt_).HoleNumber());
+        currentHoleNumber = std::min(primary_->HoleNumber(), scraps_->HoleNumber());
 
     // collect subreads or hqregions
-    while (primaryIt_ != primaryQuery_->end() &&
-           currentHoleNumber == (*primaryIt_).HoleNumber())
-    {
-        bamRecordVec.push_back(*primaryIt_++);
-    }
+    while (primary_->HasRecord() && currentHoleNumber == primary_->HoleNumber())
+        primary_->MoveTo(&bamRecordVec);
 
     // collect scraps
-    while (scrapsIt_ != scrapsQuery_->end() &&
-           currentHoleNumber == (*scrapsIt_).HoleNumber())
-    {
-        bamRecordVec.push_back(*scrapsIt_++);
-    }
+    while (scraps_->HasRecord() && currentHoleNumber == scraps_->HoleNumber())
+        scraps_->MoveTo(&bamRecordVec);
 
+    lastZmwSize_ = bamRecordVec.size();
     return bamRecordVec;
 }
 
@@ -141,6 +223,9 @@ BamHeader VirtualZmwReader::PrimaryHeader(void) const
 BamHeader VirtualZmwReader::ScrapsHeader(void) const
 { return scrapsBamFile_->Header(); }
 
+BamHeader VirtualZmwReader::StitchedHeader(void) const
+{ return *stitchedHeader_; }
+
 } // namespace internal
 } // namespace BAM
 } // namespace PacBio
@@ -42,20 +42,73 @@
 #ifndef VIRTUALZMWREADER_H
 #define VIRTUALZMWREADER_H
 
+#include <deque>
 #include <memory>
+#include <string>
+#include <utility>
 
 #include "pbbam/BamFile.h"
+#include "pbbam/BamReader.h"
 #include "pbbam/BamRecord.h"
 #include "pbbam/Config.h"
-#include "pbbam/EntireFileQuery.h"
+#include "pbbam/PbiBasicTypes.h"
 #include "pbbam/PbiFilter.h"
-#include "pbbam/PbiFilterQuery.h"
+#include "pbbam/virtual/LazyVirtualZmwBamRecord.h"
 #include "pbbam/virtual/VirtualZmwBamRecord.h"
 
 namespace PacBio {
 namespace BAM {
+
+class DataSet;
+
 namespace internal {
 
+/// \returns (primary, scraps) %BAM file paths for each of the dataset's
+///          subread (or hqregion) resources that has a scraps child resource
+///
+std::deque<std::pair<std::string, std::string> >
+ZmwStitchingSources(const DataSet& dataset);
+
+/// \brief The ZmwSourceCursor class reads one source %BAM file in order,
+///        holding its next record & that record's hole number.
+///
+/// The hole number is taken from the file's PBI index when available, or
+/// decoded once per record otherwise.
+///
+class ZmwSourceCursor
+{
+public:
+    ZmwSourceCursor(const BamFile& file, const PbiFilter& filter);
+
+public:
+    /// \returns true if a record is available
+    bool HasRecord(void) const
+    { return hasRecord_; }
+
+    /// \returns hole number of the current record
+    int32_t HoleNumber(void) const
+    { return holeNumber_; }
+
+    /// \brief Moves the current record to the end of \p records, then
+    ///        advances to the next one.
+    void MoveTo(std::vector<BamRecord>* records);
+
+private:
+    void ReadNext(void);
+
+private:
+    std::unique_ptr<BamReader> reader_;
+
+    // PBI rows being read (reader's own data), unused if no PBI
+    const std::vector<int32_t>* pbiHoleNumbers_;
+    IndexResultBlocks pbiBlocks_;
+    size_t blockRow_;  // within pbiBlocks_.front()
+
+    BamRecord record_;
+    int32_t holeNumber_;
+    bool hasRecord_;
+};
+
 class VirtualZmwReader
 {
 public:
@@ -99,6 +152,9 @@ public:
     /// \returns the BamHeader associated with this reader's "scraps" %BAM file
     BamHeader ScrapsHeader(void) const;
 
+    /// \returns the BamHeader used for this reader's stitched records
+    BamHeader StitchedHeader(void) const;
+
 public:
 
     /// \returns true if more ZMWs are available for reading.
@@ -107,6 +163,9 @@ public:
     /// \returns the next stitched polymerase read
     VirtualZmwBamRecord Next(void);
 
+    /// \returns the next polymerase read, with fields stitched on demand
+    LazyVirtualZmwBamRecord NextLazy(void);
+
     /// \returns the next set of reads that belong to one ZMW.
     ///          This enables stitching records in a distinct thread.
     ///
@@ -115,11 +174,10 @@ public:
 private:
     std::unique_ptr<BamFile>          primaryBamFile_;
     std::unique_ptr<BamFile>          scrapsBamFile_;
-    std::unique_ptr<internal::IQuery> primaryQuery_;
-    std::unique_ptr<internal::IQuery> scrapsQuery_;
-    internal::IQuery::iterator        primaryIt_;
-    internal::IQuery::iterator        scrapsIt_;
+    std::unique_ptr<ZmwSourceCursor>  primary_;
+    std::unique_ptr<ZmwSourceCursor>  scraps_;
     std::unique_ptr<BamHeader>        stitchedHeader_;
+    size_t                            lastZmwSize_;
 };
 
 } // namespace internal
@@ -42,7 +42,11 @@
 #include "pbbam/virtual/WhitelistedZmwReadStitcher.h"
 #include "pbbam/PbiIndexedBamReader.h"
 #include "VirtualZmwReader.h"
+#include "ZmwRowPlan.h"
+#include <algorithm>
 #include <cassert>
+#include <iterator>
+#include <stdexcept>
 
 namespace PacBio {
 namespace BAM {
@@ -57,6 +61,8 @@ public:
         , scrapsBamFile_(new BamFile{ scrapsBamFilePath })
         , primaryReader_(new PbiIndexedBamReader{ *primaryBamFile_ })
         , scrapsReader_(new PbiIndexedBamReader{ *scrapsBamFile_ })
+        , primaryIsStreaming_(false)
+        , scrapsIsStreaming_(false)
     {
         // setup new header for stitched data
         polyHeader_ = std::unique_ptr<BamHeader>(new BamHeader(primaryBamFile_->Header().ToSam()));
@@ -97,14 +103,8 @@ public:
             return result;
 
         const auto& zmw = zmwWhitelist_.front();
-        primaryReader_->Filter(PbiZmwFilter{zmw});
-        scrapsReader_->Filter(PbiZmwFilter{zmw});
-
-        auto record = BamRecord{ };
-        while (primaryReader_->GetNext(record))
-            result.push_back(record);
-        while (scrapsReader_->GetNext(record))
-            result.push_back(record);
+        AppendRecords(zmw, *primaryReader_, *primaryPlan_, primaryIsStreaming_, &result);
+        AppendRecords(zmw, *scrapsReader_, *scrapsPlan_, scrapsIsStreaming_, &result);
 
         zmwWhitelist_.pop_front();
         return result;
@@ -124,28 +124,72 @@ private:
     std::unique_ptr<BamHeader> polyHeader_;
     std::deque<int32_t>        zmwWhitelist_;
 
+    // whitelisted rows of each file, grouped by ZMW
+    std::unique_ptr<internal::ZmwRowPlan> primaryPlan_;
+    std::unique_ptr<internal::ZmwRowPlan> scrapsPlan_;
+    bool primaryIsStreaming_;
+    bool scrapsIsStreaming_;
+    IndexList rows_;
+
 private:
+    void AppendRecords(const int32_t zmw,
+                       PbiIndexedBamReader& reader,
+                       internal::ZmwRowPlan& plan,
+                       const bool isStreaming,
+                       std::vector<BamRecord>* result)
+    {
+        rows_.clear();
+        if (isStreaming) {
+            const size_t numRows = plan.TakeRows(zmw, &rows_);
+            for (size_t i = 0; i < numRows; ++i) {
+                result->emplace_back();
+                if (!reader.GetNext(result->back())) {
+                    throw std::runtime_error("WhitelistedZmwReadStitcher: unexpected end of records in " +
+                                             reader.Filename());
+                }
+            }
+        } else if (plan.FindRows(zmw, &rows_) > 0) {
+            auto records = reader.ReadRecords(rows_);
+            std::move(records.begin(), records.end(), std::back_inserter(*result));
+        }
+    }
+
+    // Plans both files' rows once, from their PBIs. If ZMWs are requested in
+    // ascending order & a file is grouped by ZMW (the usual case), the file is
+    // read in one forward pass, seeking only over gaps. Otherwise, each ZMW's
+    // rows are fetched by random access.
+    //
+    bool SetupReader(PbiIndexedBamReader& reader,
+                     const internal::ZmwRowPlan& plan,
+                     const bool isAscending)
+    {
+        const bool isStreaming = isAscending && plan.IsFileOrder();
+        if (isStreaming)
+            reader.Filter(plan.RowFilter());
+        return isStreaming;
+    }
+
     void PreFilterZmws(const std::vector<int32_t>& zmwWhitelist)
     {
-        // fetch input ZMWs
-        const PbiRawData primaryIndex(primaryBamFile_->PacBioIndexFilename());
-        const PbiRawData scrapsIndex(scrapsBamFile_->PacBioIndexFilename());
-        const auto& primaryZmws = primaryIndex.BasicData().holeNumber_;
-        const auto& scrapsZmws = scrapsIndex.BasicData().holeNumber_;
-
-        // toss them all into a set (for uniqueness & lookup here soon)
-        std::set<int32_t> inputZmws;
-        for (const auto& zmw : primaryZmws)
-            inputZmws.insert(zmw);
-        for (const auto& zmw : scrapsZmws)
-            inputZmws.insert(zmw);
+        auto sortedWhitelist = zmwWhitelist;
+        std::sort(sortedWhitelist.begin(), sortedWhitelist.end());
+        sortedWhitelist.erase(std::unique(sortedWhitelist.begin(), sortedWhitelist.end()),
+                              sortedWhitelist.end());
+        primaryPlan_.reset(new internal::ZmwRowPlan{ primaryReader_->PbiRawIndex(), sortedWhitelist });
+        scrapsPlan_.reset(new internal::ZmwRowPlan{ scrapsReader_->PbiRawIndex(), sortedWhitelist });
 
         // check our requested whitelist against files' ZMWs, keep if found
-        const auto inputEnd = inputZmws.cend();
         for (const int32_t zmw : zmwWhitelist) {
-            if (inputZmws.find(zmw) != inputEnd)
+            if (primaryPlan_->Contains(zmw) || scrapsPlan_->Contains(zmw))
                 zmwWhitelist_.push_back(zmw);
         }
+
+        const bool isAscending =
+            std::adjacent_find(zmwWhitelist_.cbegin(), zmwWhitelist_.cend(),
+                               [](const int32_t lhs, const int32_t rhs) { return lhs >= rhs; })
+            == zmwWhitelist_.cend();
+        primaryIsStreaming_ = SetupReader(*primaryReader_, *primaryPlan_, isAscending);
+        scrapsIsStreaming_ = SetupReader(*scrapsReader_, *scrapsPlan_, isAscending);
     }
 };
 
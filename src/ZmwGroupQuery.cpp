@@ -41,62 +41,145 @@
 
 #include "pbbam/ZmwGroupQuery.h"
 #include "pbbam/BamRecord.h"
-#include "pbbam/CompositeBamReader.h"
-#include "pbbam/PbiFilterTypes.h"
+#include "pbbam/PbiIndexedBamReader.h"
 #include "MemoryUtils.h"
+#include "ZmwRowPlan.h"
 #include <algorithm>
-#include <deque>
+#include <iterator>
+#include <set>
+#include <sstream>
+#include <stdexcept>
 
 namespace PacBio {
 namespace BAM {
 
 struct ZmwGroupQuery::ZmwGroupQueryPrivate
 {
-    typedef PbiFilterCompositeBamReader<Compare::Zmw> ReaderType;
-    typedef std::unique_ptr<ReaderType> ReaderPtr;
+    // A file's reader & its rows, grouped by ZMW. Files already grouped by ZMW
+    // are read in a single filtered pass, others by random access per ZMW.
+    struct FileGroups
+    {
+        std::unique_ptr<PbiIndexedBamReader> reader_;
+        std::unique_ptr<internal::ZmwRowPlan> plan_;
+    };
 
     ZmwGroupQueryPrivate(const std::vector<int32_t>& zmwWhitelist,
                          const DataSet& dataset)
-        : whitelist_(zmwWhitelist.cbegin(), zmwWhitelist.cend())
-        , reader_(nullptr)
+        : whitelist_(zmwWhitelist)
+        , useWhitelist_(true)
+        , nextWhitelisted_(0)
     {
         std::sort(whitelist_.begin(), whitelist_.end());
         whitelist_.erase(std::unique(whitelist_.begin(),
                                      whitelist_.end()),
                          whitelist_.end());
 
-        if (!whitelist_.empty()) {
-            reader_ = ReaderPtr(new ReaderType(PbiZmwFilter{whitelist_.front()}, dataset));
-            whitelist_.pop_front();
+        if (!whitelist_.empty())
+            OpenFiles(dataset);
+    }
+
+    ZmwGroupQueryPrivate(const DataSet& dataset)
+        : useWhitelist_(false)
+        , nextWhitelisted_(0)
+    {
+        OpenFiles(dataset);
+    }
+
+    void OpenFiles(const DataSet& dataset)
+    {
+        auto filesSeen = std::set<std::string>{ };
+        std::vector<std::string> missingPbi;
+        for (const BamFile& bamFile : dataset.BamFiles()) {
+            if (!filesSeen.insert(bamFile.Filename()).second)
+                continue;
+            if (!bamFile.PacBioIndexExists()) {
+                missingPbi.push_back(bamFile.Filename());
+                continue;
+            }
+
+            FileGroups file;
+            file.reader_.reset(new PbiIndexedBamReader{ bamFile });
+            const PbiRawData& index = file.reader_->PbiRawIndex();
+            if (useWhitelist_)
+                file.plan_.reset(new internal::ZmwRowPlan{ index, whitelist_ });
+            else
+                file.plan_.reset(new internal::ZmwRowPlan{ index });
+
+            if (file.plan_->AtEnd())
+                continue;
+            if (file.plan_->IsFileOrder())
+                file.reader_->Filter(file.plan_->RowFilter());
+            files_.push_back(std::move(file));
+        }
+
+        if (!missingPbi.empty()) {
+            std::stringstream e;
+            e << "failed to open ZmwGroupQuery because the following files are missing a PBI file:" << std::endl;
+            for (const auto& fn : missingPbi)
+                e << "  " << fn << std::endl;
+            throw std::runtime_error(e.str());
         }
     }
 
+    bool NextZmw(int32_t* zmw)
+    {
+        // whitelisted ZMWs are all visited, even if no records are found
+        if (useWhitelist_) {
+            if (nextWhitelisted_ >= whitelist_.size())
+                return false;
+            *zmw = whitelist_.at(nextWhitelisted_++);
+            return true;
+        }
+
+        // otherwise, lowest ZMW remaining in any file
+        bool found = false;
+        for (const FileGroups& file : files_) {
+            if (file.plan_->AtEnd())
+                continue;
+            const int32_t fileZmw = file.plan_->NextZmw();
+            if (!found || fileZmw < *zmw) {
+                *zmw = fileZmw;
+                found = true;
+            }
+        }
+        return found;
+    }
+
     bool GetNext(std::vector<BamRecord>& records)
     {
         records.clear();
-        if (!reader_)
+
+        int32_t zmw = 0;
+        if (!NextZmw(&zmw))
             return false;
 
-        // get all records matching ZMW
-        BamRecord r;
-        while (reader_->GetNext(r))
-            records.push_back(r);
+        for (FileGroups& file : files_) {
+            rows_.clear();
+            const size_t numRows = file.plan_->TakeRows(zmw, &rows_);
+            if (numRows == 0)
+                continue;
 
-        // set next ZMW (if any left)
-        if (!whitelist_.empty()) {
-            reader_->Filter(PbiZmwFilter{whitelist_.front()});
-            whitelist_.pop_front();
+            if (file.plan_->IsFileOrder()) {
+                for (size_t i = 0; i < numRows; ++i) {
+                    records.emplace_back();
+                    if (!file.reader_->GetNext(records.back())) {
+                        throw std::runtime_error("ZmwGroupQuery: unexpected end of records in " +
+                                                 file.reader_->Filename());
+                    }
+                }
+            } else {
+                auto fileRecords = file.reader_->ReadRecords(rows_);
+                std::move(fileRecords.begin(), fileRecords.end(), std::back_inserter(records));
+            }
         }
-
-        // otherwise destroy reader, next iteration will return false
-        else
-            reader_.reset(nullptr);
-
         return true;
     }
 
-    std::deque<int32_t> whitelist_;
-    ReaderPtr reader_;
+    std::vector<int32_t> whitelist_;
+    bool useWhitelist_;
+    size_t nextWhitelisted_;
+    std::vector<FileGroups> files_;
+    IndexList rows_;
 };
 
 ZmwGroupQuery::ZmwGroupQuery(const std::vector<int32_t>& zmwWhitelist,
@@ -105,6 +188,11 @@ ZmwGroupQuery::ZmwGroupQuery(const std::vector<int32_t>& zmwWhitelist,
     , d_(new ZmwGroupQueryPrivate(zmwWhitelist, dataset))
 { }
 
+ZmwGroupQuery::ZmwGroupQuery(const DataSet& dataset)
+    : internal::IGroupQuery()
+    , d_(new ZmwGroupQueryPrivate(dataset))
+{ }
+
 ZmwGroupQuery::~ZmwGroupQuery(void) { }
 
 bool ZmwGroupQuery::GetNext(std::vector<BamRecord>& records)
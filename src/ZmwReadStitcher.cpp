@@ -65,44 +65,9 @@ public:
     }
 
     ZmwReadStitcherPrivate(const DataSet& dataset)
-        : filter_(PbiFilter::FromDataSet(dataset))
+        : sources_(internal::ZmwStitchingSources(dataset))
+        , filter_(PbiFilter::FromDataSet(dataset))
     {
-        // set up source queue
-        std::string primaryFn;
-        std::string scrapsFn;
-        const ExternalResources& resources = dataset.ExternalResources();
-        for (const ExternalResource& resource : resources) {
-
-            primaryFn.clear();
-            scrapsFn.clear();
-
-            // if resource is possible "primary" BAM
-            const auto& metatype = resource.MetaType();
-            if (metatype == "PacBio.SubreadFile.SubreadBamFile" ||
-                metatype == "PacBio.SubreadFile.HqRegionBamFile")
-            {
-                // possible resolve relative path
-                primaryFn = dataset.ResolvePath(resource.ResourceId());
-
-                // check for associated scraps file
-                const ExternalResources& childResources = resource.ExternalResources();
-                for (const ExternalResource& childResource : childResources) {
-                    const auto& childMetatype = childResource.MetaType();
-                    if (childMetatype == "PacBio.SubreadFile.ScrapsBamFile" ||
-                        childMetatype == "PacBio.SubreadFile.HqScrapsBamFile")
-                    {
-                        // possible resolve relative path
-                        scrapsFn = dataset.ResolvePath(childResource.ResourceId());
-                        break;
-                    }
-                }
-            }
-
-            // queue up source for later
-            if (!primaryFn.empty() && !scrapsFn.empty())
-                sources_.push_back(make_pair(primaryFn,scrapsFn));
-        }
-
         OpenNextReader();
     }
 
@@ -127,6 +92,23 @@ public:
         throw std::runtime_error(msg);
     }
 
+    LazyVirtualZmwBamRecord NextLazy(void)
+    {
+        if (currentReader_) {
+            auto result = currentReader_->NextLazy();
+            if (!currentReader_->HasNext())
+                OpenNextReader();
+            return result;
+        }
+
+        // no reader active
+        const std::string msg = { "no readers active, make sure you use "
+                                  "ZmwReadStitcher::HasNext before "
+                                  "requesting next record"
+                                };
+        throw std::runtime_error(msg);
+    }
+
     std::vector<BamRecord> NextRaw(void)
     {
         if (currentReader_) {
@@ -205,6 +187,9 @@ bool ZmwReadStitcher::HasNext(void)
 VirtualZmwBamRecord ZmwReadStitcher::Next(void)
 { return d_->Next(); }
 
+LazyVirtualZmwBamRecord ZmwReadStitcher::NextLazy(void)
+{ return d_->NextLazy(); }
+
 std::vector<BamRecord> ZmwReadStitcher::NextRaw(void)
 { return d_->NextRaw(); }
 
@@ -0,0 +1,152 @@
+// Copyright (c) 2016, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// File Description
+/// \file ZmwRowPlan.cpp
+/// \brief Implements the ZmwRowPlan class.
+//
+// Author: Derek Barnett
+
+#include "ZmwRowPlan.h"
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+
+namespace PacBio {
+namespace BAM {
+namespace internal {
+
+ZmwRowPlan::ZmwRowPlan(const PbiRawData& index)
+    : next_(0)
+    , isFileOrder_(true)
+    , numIndexRows_(index.NumReads())
+{
+    Plan(index.BasicData().holeNumber_, nullptr);
+}
+
+ZmwRowPlan::ZmwRowPlan(const PbiRawData& index,
+                       const std::vector<int32_t>& whitelist)
+    : next_(0)
+    , isFileOrder_(true)
+    , numIndexRows_(index.NumReads())
+{
+    Plan(index.BasicData().holeNumber_, &whitelist);
+}
+
+bool ZmwRowPlan::AtEnd(void) const
+{ return next_ >= zmws_.size(); }
+
+bool ZmwRowPlan::Contains(const int32_t zmw) const
+{ return std::binary_search(zmws_.cbegin(), zmws_.cend(), zmw); }
+
+size_t ZmwRowPlan::FindRows(const int32_t zmw, IndexList* rows) const
+{
+    assert(rows);
+    const auto range = std::equal_range(zmws_.cbegin(), zmws_.cend(), zmw);
+    const size_t first = range.first - zmws_.cbegin();
+    const size_t last = range.second - zmws_.cbegin();
+    rows->insert(rows->end(), rows_.cbegin() + first, rows_.cbegin() + last);
+    return last - first;
+}
+
+bool ZmwRowPlan::IsFileOrder(void) const
+{ return isFileOrder_; }
+
+int32_t ZmwRowPlan::NextZmw(void) const
+{
+    assert(!AtEnd());
+    return zmws_.at(next_);
+}
+
+size_t ZmwRowPlan::NumRows(void) const
+{ return rows_.size(); }
+
+void ZmwRowPlan::Plan(const std::vector<int32_t>& holeNumbers,
+                      const std::vector<int32_t>* whitelist)
+{
+    for (size_t row = 0; row < holeNumbers.size(); ++row) {
+        const int32_t zmw = holeNumbers[row];
+        if (whitelist && !std::binary_search(whitelist->cbegin(), whitelist->cend(), zmw))
+            continue;
+        zmws_.push_back(zmw);
+        rows_.push_back(row);
+    }
+
+    // files are usually already grouped by ZMW. if not, order rows by ZMW,
+    // keeping file order within each ZMW
+    isFileOrder_ = std::is_sorted(zmws_.cbegin(), zmws_.cend());
+    if (!isFileOrder_) {
+        std::vector<size_t> order(zmws_.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(),
+                         [this](const size_t lhs, const size_t rhs)
+                         { return zmws_[lhs] < zmws_[rhs]; });
+
+        std::vector<int32_t> zmws;
+        IndexList rows;
+        zmws.reserve(order.size());
+        rows.reserve(order.size());
+        for (const size_t i : order) {
+            zmws.push_back(zmws_[i]);
+            rows.push_back(rows_[i]);
+        }
+        zmws_ = std::move(zmws);
+        rows_ = std::move(rows);
+    }
+}
+
+PbiFilter ZmwRowPlan::RowFilter(void) const
+{
+    auto mask = std::make_shared<std::vector<bool> >(numIndexRows_, false);
+    for (const size_t row : rows_)
+        (*mask)[row] = true;
+    return PbiFilter{ PbiRowFilter{ mask } };
+}
+
+size_t ZmwRowPlan::TakeRows(const int32_t zmw, IndexList* rows)
+{
+    assert(rows);
+    size_t numRows = 0;
+    while (next_ < zmws_.size() && zmws_[next_] == zmw) {
+        rows->push_back(rows_[next_]);
+        ++next_;
+        ++numRows;
+    }
+    return numRows;
+}
+
+} // namespace internal
+} // namespace BAM
+} // namespace PacBio
@@ -0,0 +1,137 @@
+// Copyright (c) 2016, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// File Description
+/// \file ZmwRowPlan.h
+/// \brief Defines the ZmwRowPlan class.
+//
+// Author: Derek Barnett
+
+#ifndef ZMWROWPLAN_H
+#define ZMWROWPLAN_H
+
+#include "pbbam/PbiBasicTypes.h"
+#include "pbbam/PbiFilter.h"
+#include "pbbam/PbiRawData.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace PacBio {
+namespace BAM {
+namespace internal {
+
+/// \internal
+///
+/// PBI filter accepting an explicit set of rows.
+///
+struct PbiRowFilter
+{
+    explicit PbiRowFilter(std::shared_ptr<const std::vector<bool> > rows)
+        : rows_(rows)
+    { }
+
+    bool Accepts(const PbiRawData& idx, const size_t row) const
+    { (void)idx; return row < rows_->size() && (*rows_)[row]; }
+
+    std::shared_ptr<const std::vector<bool> > rows_;
+};
+
+/// \internal
+///
+/// Rows of a PBI's records, grouped by ZMW hole number (ascending), so that
+/// ZMWs can be visited in order with a single pass over the index, rather than
+/// a full index scan per ZMW.
+///
+class ZmwRowPlan
+{
+public:
+    /// \brief Plans all ZMWs in the index.
+    explicit ZmwRowPlan(const PbiRawData& index);
+
+    /// \brief Plans only the whitelisted ZMWs (must be sorted & unique).
+    ZmwRowPlan(const PbiRawData& index, const std::vector<int32_t>& whitelist);
+
+public:
+    /// \returns true if \p zmw has any planned rows
+    bool Contains(const int32_t zmw) const;
+
+    /// \brief Appends the rows of \p zmw to \p rows, wherever it is in the
+    ///        plan. Does not advance the plan.
+    ///
+    /// \returns number of rows appended
+    ///
+    size_t FindRows(const int32_t zmw, IndexList* rows) const;
+
+    /// \returns true if no planned ZMWs remain
+    bool AtEnd(void) const;
+
+    /// \returns true if visiting ZMWs in ascending order visits the planned
+    ///          rows in file order (i.e. the file is grouped by ZMW)
+    bool IsFileOrder(void) const;
+
+    /// \returns the next planned ZMW (requires !AtEnd())
+    int32_t NextZmw(void) const;
+
+    /// \returns total number of planned rows
+    size_t NumRows(void) const;
+
+    /// \returns a filter accepting exactly the planned rows
+    PbiFilter RowFilter(void) const;
+
+    /// \brief Appends the rows of \p zmw to \p rows & advances past them, if
+    ///        \p zmw is the next planned ZMW.
+    ///
+    /// \returns number of rows appended
+    ///
+    size_t TakeRows(const int32_t zmw, IndexList* rows);
+
+private:
+    void Plan(const std::vector<int32_t>& holeNumbers,
+              const std::vector<int32_t>* whitelist);
+
+private:
+    std::vector<int32_t> zmws_;
+    IndexList rows_;
+    size_t next_;
+    bool isFileOrder_;
+    size_t numIndexRows_;
+};
+
+} // namespace internal
+} // namespace BAM
+} // namespace PacBio
+
+#endif // ZMWROWPLAN_H
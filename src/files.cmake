@@ -21,10 +21,12 @@ set( PacBioBAM_H
     ${PacBioBAM_IncludeDir}/pbbam/BarcodeQuery.h
     ${PacBioBAM_IncludeDir}/pbbam/Cigar.h
     ${PacBioBAM_IncludeDir}/pbbam/CigarOperation.h
+    ${PacBioBAM_IncludeDir}/pbbam/CigarView.h
     ${PacBioBAM_IncludeDir}/pbbam/ClipType.h
     ${PacBioBAM_IncludeDir}/pbbam/Compare.h
     ${PacBioBAM_IncludeDir}/pbbam/Config.h
     ${PacBioBAM_IncludeDir}/pbbam/DataSet.h
+    ${PacBioBAM_IncludeDir}/pbbam/DataSetChunking.h
     ${PacBioBAM_IncludeDir}/pbbam/DataSetTypes.h
     ${PacBioBAM_IncludeDir}/pbbam/DataSetXsd.h
     ${PacBioBAM_IncludeDir}/pbbam/EntireFileQuery.h
@@ -33,6 +35,7 @@ set( PacBioBAM_H
     ${PacBioBAM_IncludeDir}/pbbam/FastaSequenceQuery.h
     ${PacBioBAM_IncludeDir}/pbbam/FastqReader.h
     ${PacBioBAM_IncludeDir}/pbbam/FastqSequence.h
+    ${PacBioBAM_IncludeDir}/pbbam/FlatTagCollection.h
     ${PacBioBAM_IncludeDir}/pbbam/FrameEncodingType.h
     ${PacBioBAM_IncludeDir}/pbbam/Frames.h
     ${PacBioBAM_IncludeDir}/pbbam/GenomicInterval.h
@@ -42,6 +45,7 @@ set( PacBioBAM_H
     ${PacBioBAM_IncludeDir}/pbbam/IRecordWriter.h
     ${PacBioBAM_IncludeDir}/pbbam/LocalContextFlags.h
     ${PacBioBAM_IncludeDir}/pbbam/MD5.h
+    ${PacBioBAM_IncludeDir}/pbbam/MultiIntervalQuery.h
     ${PacBioBAM_IncludeDir}/pbbam/Orientation.h
     ${PacBioBAM_IncludeDir}/pbbam/PbiBasicTypes.h
     ${PacBioBAM_IncludeDir}/pbbam/PbiBuilder.h
@@ -65,10 +69,12 @@ set( PacBioBAM_H
     ${PacBioBAM_IncludeDir}/pbbam/SamTagCodec.h
     ${PacBioBAM_IncludeDir}/pbbam/SamWriter.h
     ${PacBioBAM_IncludeDir}/pbbam/SequenceInfo.h
+    ${PacBioBAM_IncludeDir}/pbbam/SharedBlockCache.h
     ${PacBioBAM_IncludeDir}/pbbam/Strand.h  
     ${PacBioBAM_IncludeDir}/pbbam/SubreadLengthQuery.h
     ${PacBioBAM_IncludeDir}/pbbam/Tag.h
     ${PacBioBAM_IncludeDir}/pbbam/TagCollection.h
+    ${PacBioBAM_IncludeDir}/pbbam/TagEditBatch.h
 #    ${PacBioBAM_IncludeDir}/pbbam/UnmappedReadsQuery.h
     ${PacBioBAM_IncludeDir}/pbbam/Validator.h
     ${PacBioBAM_IncludeDir}/pbbam/ZmwGroupQuery.h
@@ -86,9 +92,9 @@ set( PacBioBAM_H
     ${PacBioBAM_IncludeDir}/pbbam/internal/BamRecord.inl
     ${PacBioBAM_IncludeDir}/pbbam/internal/BamRecordBuilder.inl
     ${PacBioBAM_IncludeDir}/pbbam/internal/BamRecordImpl.inl
-    ${PacBioBAM_IncludeDir}/pbbam/internal/BamRecordView.inl
     ${PacBioBAM_IncludeDir}/pbbam/internal/Cigar.inl
     ${PacBioBAM_IncludeDir}/pbbam/internal/CigarOperation.inl
+    ${PacBioBAM_IncludeDir}/pbbam/internal/CigarView.inl
     ${PacBioBAM_IncludeDir}/pbbam/internal/Compare.inl
     ${PacBioBAM_IncludeDir}/pbbam/internal/CompositeBamReader.inl
     ${PacBioBAM_IncludeDir}/pbbam/internal/CompositeFastaReader.inl
@@ -122,6 +128,8 @@ set( PacBioBAM_H
     ${PacBioBAM_IncludeDir}/pbbam/internal/Validator.inl
 
     # virtual headers
+    ${PacBioBAM_IncludeDir}/pbbam/virtual/LazyVirtualZmwBamRecord.h
+    ${PacBioBAM_IncludeDir}/pbbam/virtual/ParallelZmwReadStitcher.h
     ${PacBioBAM_IncludeDir}/pbbam/virtual/VirtualPolymeraseBamRecord.h
     ${PacBioBAM_IncludeDir}/pbbam/virtual/VirtualPolymeraseCompositeReader.h
     ${PacBioBAM_IncludeDir}/pbbam/virtual/VirtualPolymeraseReader.h
@@ -135,6 +143,9 @@ set( PacBioBAM_H
 
     # library-internal headers
     ${PacBioBAM_SourceDir}/BamRecordTags.h
+    ${PacBioBAM_SourceDir}/BgzfBlockCache.h
+    ${PacBioBAM_SourceDir}/BgzfPrefetcher.h
+    ${PacBioBAM_SourceDir}/BgzfUtils.h
     ${PacBioBAM_SourceDir}/ChemistryTable.h
     ${PacBioBAM_SourceDir}/DataSetIO.h
     ${PacBioBAM_SourceDir}/DataSetUtils.h
@@ -144,16 +155,22 @@ set( PacBioBAM_H
     ${PacBioBAM_SourceDir}/FofnReader.h
     ${PacBioBAM_SourceDir}/MemoryUtils.h
     ${PacBioBAM_SourceDir}/PbiIndexIO.h
+    ${PacBioBAM_SourceDir}/PbiIntervalIndex.h
     ${PacBioBAM_SourceDir}/Pulse2BaseCache.h
+    ${PacBioBAM_SourceDir}/RawTagStitcher.h
+    ${PacBioBAM_SourceDir}/SequenceKernels.h
     ${PacBioBAM_SourceDir}/SequenceUtils.h
     ${PacBioBAM_SourceDir}/StringUtils.h
+    ${PacBioBAM_SourceDir}/ThreadPool.h
     ${PacBioBAM_SourceDir}/TimeUtils.h
     ${PacBioBAM_SourceDir}/ValidationErrors.h
     ${PacBioBAM_SourceDir}/Version.h
     ${PacBioBAM_SourceDir}/VirtualZmwCompositeReader.h
     ${PacBioBAM_SourceDir}/VirtualZmwReader.h
+    ${PacBioBAM_SourceDir}/VirtualZmwStitching.h
     ${PacBioBAM_SourceDir}/XmlReader.h
     ${PacBioBAM_SourceDir}/XmlWriter.h
+    ${PacBioBAM_SourceDir}/ZmwRowPlan.h
     ${PacBioBAM_SourceDir}/pugixml/pugiconfig.hpp
     ${PacBioBAM_SourceDir}/pugixml/pugixml.hpp
 )
@@ -170,17 +187,24 @@ set( PacBioBAM_CPP
     ${PacBioBAM_SourceDir}/BamRecord.cpp
     ${PacBioBAM_SourceDir}/BamRecordBuilder.cpp
     ${PacBioBAM_SourceDir}/BamRecordImpl.cpp
+    ${PacBioBAM_SourceDir}/BamRecordView.cpp
     ${PacBioBAM_SourceDir}/BamRecordTags.cpp
     ${PacBioBAM_SourceDir}/BamTagCodec.cpp
     ${PacBioBAM_SourceDir}/BamWriter.cpp
     ${PacBioBAM_SourceDir}/BarcodeQuery.cpp
+    ${PacBioBAM_SourceDir}/BgzfBlockCache.cpp
+    ${PacBioBAM_SourceDir}/BgzfPrefetcher.cpp
+    ${PacBioBAM_SourceDir}/BgzfUtils.cpp
     ${PacBioBAM_SourceDir}/ChemistryTable.cpp
+    ${PacBioBAM_SourceDir}/ClipAndGapifyPlan.cpp
     ${PacBioBAM_SourceDir}/Cigar.cpp
     ${PacBioBAM_SourceDir}/CigarOperation.cpp
     ${PacBioBAM_SourceDir}/Compare.cpp
+    ${PacBioBAM_SourceDir}/CompositeBamReader.cpp
     ${PacBioBAM_SourceDir}/Config.cpp
     ${PacBioBAM_SourceDir}/DataSet.cpp
     ${PacBioBAM_SourceDir}/DataSetBaseTypes.cpp
+    ${PacBioBAM_SourceDir}/DataSetChunking.cpp
     ${PacBioBAM_SourceDir}/DataSetElement.cpp
     ${PacBioBAM_SourceDir}/DataSetIO.cpp
     ${PacBioBAM_SourceDir}/DataSetTypes.cpp
@@ -191,14 +215,18 @@ set( PacBioBAM_CPP
     ${PacBioBAM_SourceDir}/FastqReader.cpp
     ${PacBioBAM_SourceDir}/FileProducer.cpp
     ${PacBioBAM_SourceDir}/FileUtils.cpp
+    ${PacBioBAM_SourceDir}/FlatTagCollection.cpp
     ${PacBioBAM_SourceDir}/FofnReader.cpp
     ${PacBioBAM_SourceDir}/Frames.cpp
     ${PacBioBAM_SourceDir}/GenomicInterval.cpp
     ${PacBioBAM_SourceDir}/GenomicIntervalQuery.cpp
     ${PacBioBAM_SourceDir}/IndexedFastaReader.cpp
     ${PacBioBAM_SourceDir}/IRecordWriter.cpp
+    ${PacBioBAM_SourceDir}/LazyVirtualZmwBamRecord.cpp
     ${PacBioBAM_SourceDir}/MD5.cpp
     ${PacBioBAM_SourceDir}/MemoryUtils.cpp
+    ${PacBioBAM_SourceDir}/MultiIntervalQuery.cpp
+    ${PacBioBAM_SourceDir}/ParallelZmwReadStitcher.cpp
     ${PacBioBAM_SourceDir}/PbiBuilder.cpp
     ${PacBioBAM_SourceDir}/PbiFile.cpp
     ${PacBioBAM_SourceDir}/PbiFilter.cpp
@@ -207,18 +235,24 @@ set( PacBioBAM_CPP
     ${PacBioBAM_SourceDir}/PbiIndex.cpp
     ${PacBioBAM_SourceDir}/PbiIndexedBamReader.cpp
     ${PacBioBAM_SourceDir}/PbiIndexIO.cpp
+    ${PacBioBAM_SourceDir}/PbiIntervalIndex.cpp
     ${PacBioBAM_SourceDir}/PbiRawData.cpp
     ${PacBioBAM_SourceDir}/ProgramInfo.cpp
     ${PacBioBAM_SourceDir}/QNameQuery.cpp
     ${PacBioBAM_SourceDir}/QualityValue.cpp
+    ${PacBioBAM_SourceDir}/QualityValues.cpp
+    ${PacBioBAM_SourceDir}/RawTagStitcher.cpp
     ${PacBioBAM_SourceDir}/ReadAccuracyQuery.cpp
     ${PacBioBAM_SourceDir}/ReadGroupInfo.cpp
     ${PacBioBAM_SourceDir}/SamTagCodec.cpp
     ${PacBioBAM_SourceDir}/SamWriter.cpp
     ${PacBioBAM_SourceDir}/SequenceInfo.cpp
+    ${PacBioBAM_SourceDir}/SequenceKernels.cpp
+    ${PacBioBAM_SourceDir}/SharedBlockCache.cpp
     ${PacBioBAM_SourceDir}/SubreadLengthQuery.cpp
     ${PacBioBAM_SourceDir}/Tag.cpp
     ${PacBioBAM_SourceDir}/TagCollection.cpp
+    ${PacBioBAM_SourceDir}/TagEditBatch.cpp
 #    ${PacBioBAM_SourceDir}/UnmappedReadsQuery.cpp
     ${PacBioBAM_SourceDir}/Validator.cpp
     ${PacBioBAM_SourceDir}/ValidationErrors.cpp
@@ -233,6 +267,7 @@ set( PacBioBAM_CPP
     ${PacBioBAM_SourceDir}/WhitelistedZmwReadStitcher.cpp
     ${PacBioBAM_SourceDir}/ZmwGroupQuery.cpp
     ${PacBioBAM_SourceDir}/ZmwReadStitcher.cpp
+    ${PacBioBAM_SourceDir}/ZmwRowPlan.cpp
     ${PacBioBAM_SourceDir}/ZmwQuery.cpp
     ${PacBioBAM_SourceDir}/ZmwTypeMap.cpp
 
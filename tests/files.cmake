@@ -21,6 +21,8 @@ set( PacBioBAMTest_CPP
     ${PacBioBAM_TestsDir}/src/test_BarcodeQuery.cpp
     ${PacBioBAM_TestsDir}/src/test_Cigar.cpp
     ${PacBioBAM_TestsDir}/src/test_Compare.cpp
+    ${PacBioBAM_TestsDir}/src/test_CompositeBamReader.cpp
+    ${PacBioBAM_TestsDir}/src/test_DataSetChunking.cpp
     ${PacBioBAM_TestsDir}/src/test_DataSetCore.cpp
     ${PacBioBAM_TestsDir}/src/test_DataSetIO.cpp
     ${PacBioBAM_TestsDir}/src/test_DataSetQuery.cpp
@@ -34,9 +36,12 @@ set( PacBioBAMTest_CPP
     ${PacBioBAM_TestsDir}/src/test_GenomicIntervalQuery.cpp
     ${PacBioBAM_TestsDir}/src/test_IndexedFastaReader.cpp
     ${PacBioBAM_TestsDir}/src/test_Intervals.cpp
+    ${PacBioBAM_TestsDir}/src/test_MultiIntervalQuery.cpp
     ${PacBioBAM_TestsDir}/src/test_PacBioIndex.cpp
+    ${PacBioBAM_TestsDir}/src/test_ParallelZmwReadStitcher.cpp
     ${PacBioBAM_TestsDir}/src/test_PbiFilter.cpp
     ${PacBioBAM_TestsDir}/src/test_PbiFilterQuery.cpp
+    ${PacBioBAM_TestsDir}/src/test_PbiIndexedBamReader.cpp
     ${PacBioBAM_TestsDir}/src/test_QNameQuery.cpp
     ${PacBioBAM_TestsDir}/src/test_QualityValues.cpp
     ${PacBioBAM_TestsDir}/src/test_Pulse2BaseCache.cpp
@@ -44,6 +49,7 @@ set( PacBioBAMTest_CPP
     ${PacBioBAM_TestsDir}/src/test_ReadGroupInfo.cpp
     ${PacBioBAM_TestsDir}/src/test_SamWriter.cpp
     ${PacBioBAM_TestsDir}/src/test_SequenceUtils.cpp
+    ${PacBioBAM_TestsDir}/src/test_SharedBlockCache.cpp
     ${PacBioBAM_TestsDir}/src/test_StringUtils.cpp
     ${PacBioBAM_TestsDir}/src/test_SubreadLengthQuery.cpp
     ${PacBioBAM_TestsDir}/src/test_Tags.cpp
@@ -43,6 +43,7 @@
 #include <pbbam/BamRecord.h>
 #include <pbbam/BamRecordView.h>
 #include <pbbam/BamTagCodec.h>
+#include <htslib/sam.h>
 #include <chrono>
 #include <string>
 using namespace PacBio;
@@ -1729,3 +1730,92 @@ TEST(BamRecordTest, CCS_ClipToReference)
     EXPECT_EQ(s3_tagQuals_clipped, view.AltLabelQVs().Fastq());
     EXPECT_EQ(s3_frames_clipped,   view.IPD().Data());
 }
+
+TEST(BamRecordClippingTest, ViewFieldsShareClipPlan)
+{
+    const string seq       = "AACCGTTAGC";
+    const string quals     = "?]?]?]?]?*";
+    const string tagBases  = "AACCGTTAGC";
+    const string tagQuals  = "?]?]?]?]?*";
+    const f_data frames    = { 10, 10, 20, 20, 30, 40, 40, 10, 30, 20 };
+    const string cigar     = "2S3=1D2I1P3=2H";
+
+    BamRecord record = tests::MakeRecord(500, 510, seq, quals, tagBases, tagQuals, frames);
+    record.Map(0, 100, Strand::FORWARD, Cigar::FromStdString(cigar), 80);
+
+    // aligned & soft clips excised
+    {
+        const BamRecordView view{ record, Orientation::GENOMIC, true, true };
+        EXPECT_EQ("CCG-TT*AGC", view.Sequence());
+        EXPECT_EQ("CCG-TT*AGC", view.DeletionTags());
+        EXPECT_EQ("?]?!]?!]?*", view.Qualities().Fastq());
+        EXPECT_EQ((f_data{ 20, 20, 30, 0, 40, 40, 0, 10, 30, 20 }), view.IPD().Data());
+    }
+
+    // soft clips excised, deletions not gapped
+    {
+        const BamRecordView view{ record, Orientation::GENOMIC, false, true };
+        EXPECT_EQ("CCGTTAGC", view.Sequence());
+        EXPECT_EQ((f_data{ 20, 20, 30, 40, 40, 10, 30, 20 }), view.PulseWidths().Data());
+    }
+
+    // every combination matches the per-field BamRecord methods
+    for (const bool aligned : { false, true }) {
+        for (const bool exciseSoftClips : { false, true }) {
+            const BamRecordView view{ record, Orientation::NATIVE, aligned, exciseSoftClips };
+            EXPECT_EQ(record.Sequence(Orientation::NATIVE, aligned, exciseSoftClips), view.Sequence());
+            EXPECT_EQ(record.Qualities(Orientation::NATIVE, aligned, exciseSoftClips), view.Qualities());
+            EXPECT_EQ(record.SubstitutionTag(Orientation::NATIVE, aligned, exciseSoftClips), view.SubstitutionTags());
+            EXPECT_EQ(record.InsertionQV(Orientation::NATIVE, aligned, exciseSoftClips), view.InsertionQVs());
+            EXPECT_EQ(record.IPD(Orientation::NATIVE, aligned, exciseSoftClips), view.IPD());
+            EXPECT_EQ(record.PulseWidth(Orientation::NATIVE, aligned, exciseSoftClips), view.PulseWidths());
+        }
+    }
+}
+
+TEST(BamRecordClippingTest, ClipPlanRejectsAlignmentMatch)
+{
+    const string seq       = "AACCGTTAGC";
+    const string quals     = "?]?]?]?]?*";
+    const f_data frames    = { 10, 10, 20, 20, 30, 40, 40, 10, 30, 20 };
+
+    BamRecord record = tests::MakeRecord(500, 510, seq, quals, seq, quals, frames);
+    record.Map(0, 100, Strand::FORWARD, Cigar::FromStdString("2S8="), 80);
+
+    // Cigar won't create 'M' ops, so swap one into the packed data
+    uint32_t* cigarData = bam_get_cigar(record.impl_.d_.get());
+    cigarData[1] = bam_cigar_gen(8, BAM_CMATCH);
+
+    EXPECT_THROW(record.Sequence(Orientation::NATIVE, true, false), std::runtime_error);
+    EXPECT_THROW(record.Qualities(Orientation::NATIVE, false, true), std::runtime_error);
+    EXPECT_THROW(record.IPD(Orientation::NATIVE, true, true), std::runtime_error);
+    EXPECT_THROW(BamRecordView(record, Orientation::NATIVE, true, false), std::runtime_error);
+
+    // unclipped, ungapped data doesn't need the CIGAR
+    EXPECT_EQ(seq, record.Sequence(Orientation::NATIVE, false, false));
+}
+
+TEST(BamRecordClippingTest, ViewFollowsRecordChanges)
+{
+    const string seq       = "AACCGTTAGC";
+    const string quals     = "?]?]?]?]?*";
+    const f_data frames    = { 10, 10, 20, 20, 30, 40, 40, 10, 30, 20 };
+
+    BamRecord record = tests::MakeRecord(500, 510, seq, quals, seq, quals, frames);
+    record.Map(0, 100, Strand::FORWARD, Cigar::FromStdString("2S3=1D2I1P3=2H"), 80);
+
+    const BamRecordView view{ record, Orientation::NATIVE, true, true };
+    EXPECT_EQ("CCG-TT*AGC", view.Sequence());
+
+    // re-map with a different CIGAR, view must not use its original plan
+    record.Map(0, 100, Strand::FORWARD, Cigar::FromStdString("4=2D6="), 80);
+    EXPECT_EQ("AACC--GTTAGC", view.Sequence());
+    EXPECT_EQ(record.Qualities(Orientation::NATIVE, true, true), view.Qualities());
+    EXPECT_EQ(record.IPD(Orientation::NATIVE, true, true), view.IPD());
+
+    // clipping shrinks the data under the view
+    record.Clip(ClipType::CLIP_TO_QUERY, 502, 508);
+    EXPECT_EQ(record.Sequence(Orientation::NATIVE, true, true), view.Sequence());
+    EXPECT_EQ(record.DeletionQV(Orientation::NATIVE, true, true), view.DeletionQVs());
+    EXPECT_EQ(record.PulseWidth(Orientation::NATIVE, true, true), view.PulseWidths());
+}
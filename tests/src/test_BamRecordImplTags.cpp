@@ -41,6 +41,8 @@
 
 #include <gtest/gtest.h>
 #include <pbbam/BamRecordImpl.h>
+#include <pbbam/TagEditBatch.h>
+#include <htslib/sam.h>
 using namespace PacBio;
 using namespace PacBio::BAM;
 using namespace std;
@@ -184,6 +186,134 @@ TEST(BamRecordImplTagsTest, SimpleEditTag)
     EXPECT_FALSE(bam.EditTag("zz", 500));                 // reject edit unknown
 }
 
+TEST(BamRecordImplTagsTest, EditTagInPlace)
+{
+    TagCollection tags;
+    tags["CA"] = std::vector<uint8_t>({34, 5, 125});
+    tags["XY"] = (int32_t)-42;
+    tags["ZZ"] = std::string("foo");
+
+    BamRecordImpl bam;
+    bam.Tags(tags);
+    const int lengthData = bam.d_->l_data;
+    const uint8_t* data = bam.d_->data;
+
+    // same encoded size - overwritten, nothing moves
+    EXPECT_TRUE(bam.EditTag("XY", (int32_t)500));
+    EXPECT_TRUE(bam.EditTag("CA", std::vector<uint8_t>({1, 2, 3})));
+    EXPECT_EQ(lengthData, bam.d_->l_data);
+    EXPECT_EQ(data, bam.d_->data);
+    EXPECT_EQ(500, bam.TagValue("XY").ToInt32());
+    EXPECT_EQ(vector<uint8_t>({1, 2, 3}), bam.TagValue("CA").ToUInt8Array());
+
+    // different size - spliced in at original position
+    EXPECT_TRUE(bam.EditTag("CA", std::vector<uint8_t>({1, 2, 3, 4, 5})));
+    EXPECT_EQ(lengthData + 2, bam.d_->l_data);
+    EXPECT_EQ(vector<uint8_t>({1, 2, 3, 4, 5}), bam.TagValue("CA").ToUInt8Array());
+    EXPECT_EQ(500, bam.TagValue("XY").ToInt32());
+    EXPECT_EQ(string("foo"), bam.TagValue("ZZ").ToString());
+    EXPECT_EQ('C', static_cast<char>(bam_get_aux(bam.d_)[0]));
+    EXPECT_EQ('A', static_cast<char>(bam_get_aux(bam.d_)[1]));
+
+    EXPECT_TRUE(bam.EditTag("ZZ", std::string("f")));
+    EXPECT_EQ(lengthData, bam.d_->l_data);
+    EXPECT_EQ(string("f"), bam.TagValue("ZZ").ToString());
+    EXPECT_EQ(500, bam.TagValue("XY").ToInt32());
+}
+
+TEST(BamRecordImplTagsTest, BatchTagEdits)
+{
+    TagCollection tags;
+    tags["CA"] = std::vector<uint8_t>({34, 5, 125});
+    tags["XY"] = (int32_t)-42;
+    tags["ZZ"] = std::string("foo");
+
+    BamRecordImpl bam;
+    bam.Tags(tags);
+
+    TagEditBatch edits;
+    edits.Add("XY", (int32_t)1)                       // skipped, present
+         .Add("NW", std::string("new"))
+         .Edit("QQ", (int32_t)2)                      // skipped, missing
+         .Edit("CA", std::vector<uint8_t>({1}))
+         .Set("XY", (int32_t)7)
+         .Set("SS", (int32_t)8)
+         .Remove("ZZ")
+         .Remove("ZZ")                                // skipped, already removed
+         .Set("ZZ", std::string("bar"))               // re-added after remove
+         .Add("too_long", (int32_t)0);                // skipped, invalid name
+    EXPECT_EQ(10, edits.Size());
+    EXPECT_EQ(6, bam.ApplyTagEdits(edits));
+
+    const TagCollection fetched = bam.Tags();
+    EXPECT_EQ(5, fetched.size());
+    EXPECT_EQ(vector<uint8_t>({1}), fetched.at("CA").ToUInt8Array());
+    EXPECT_EQ(7,                    fetched.at("XY").ToInt32());
+    EXPECT_EQ(8,                    fetched.at("SS").ToInt32());
+    EXPECT_EQ(string("new"),        fetched.at("NW").ToString());
+    EXPECT_EQ(string("bar"),        fetched.at("ZZ").ToString());
+
+    // offsets are refreshed for lookups
+    EXPECT_EQ(string("bar"), bam.TagValue("ZZ").ToString());
+    EXPECT_FALSE(bam.HasTag("QQ"));
+
+    // same-sized overwrites only, applied in place
+    const int lengthData = bam.d_->l_data;
+    edits.Clear();
+    EXPECT_TRUE(edits.IsEmpty());
+    edits.Edit("XY", (int32_t)70).Set("SS", (int32_t)80);
+    EXPECT_EQ(2, bam.ApplyTagEdits(edits));
+    EXPECT_EQ(lengthData, bam.d_->l_data);
+    EXPECT_EQ(70, bam.TagValue("XY").ToInt32());
+    EXPECT_EQ(80, bam.TagValue("SS").ToInt32());
+}
+
+TEST(BamRecordImplTagsTest, ReserveTagData)
+{
+    BamRecordImpl bam;
+    bam.ReserveTagData(0x10000);
+    EXPECT_LE(bam.d_->l_data + 0x10000, bam.d_->m_data);
+
+    const uint8_t* data = bam.d_->data;
+    TagEditBatch edits;
+    edits.Add("XX", std::vector<uint16_t>(0x1000, 42));
+    edits.Add("YY", std::vector<uint16_t>(0x1000, 7));
+    EXPECT_EQ(2, bam.ApplyTagEdits(edits));
+    EXPECT_EQ(data, bam.d_->data);
+    EXPECT_EQ(vector<uint16_t>(0x1000, 7), bam.TagValue("YY").ToUInt16Array());
+}
+
+TEST(BamRecordImplTagsTest, FlatTags)
+{
+    FlatTagCollection tags;
+    tags.Set("XY", (int32_t)-42)
+        .Set("CA", std::vector<uint8_t>({34, 5, 125}))
+        .Set("HX", Tag("1abc75", TagModifier::HEX_STRING));
+
+    BamRecordImpl bam;
+    bam.Tags(tags);
+    EXPECT_EQ(-42, bam.TagValue("XY").ToInt32());
+    EXPECT_EQ(string("1abc75"), bam.TagValue("HX").ToString());
+
+    // record order, not name order
+    const FlatTagCollection fetched = bam.FlatTags();
+    ASSERT_EQ(3, fetched.size());
+    EXPECT_EQ("XY", fetched.at(0).first);
+    EXPECT_EQ("CA", fetched.at(1).first);
+    EXPECT_EQ("HX", fetched.at(2).first);
+    EXPECT_EQ(bam.Tags(), fetched.ToTagCollection());
+
+    // replace with smaller set
+    FlatTagCollection smaller;
+    smaller.Set("ZZ", (int32_t)1);
+    bam.Tags(smaller);
+    bam.FlatTags(&tags);
+    ASSERT_EQ(1, tags.size());
+    EXPECT_EQ("ZZ", tags.at(0).first);
+    EXPECT_FALSE(bam.HasTag("XY"));
+    EXPECT_TRUE(bam.HasTag("ZZ"));
+}
+
 TEST(BamRecordImplTagsTest, SimpleQueryTag)
 {
     TagCollection tags;
@@ -40,7 +40,9 @@
 #endif
 
 #include <gtest/gtest.h>
+#include <pbbam/BamRecordImpl.h>
 #include <pbbam/Cigar.h>
+#include <pbbam/CigarView.h>
 #include <string>
 using namespace PacBio;
 using namespace PacBio::BAM;
@@ -196,3 +198,43 @@ TEST(CigarStringTest, ToStdString_MultipleOps)
 
     EXPECT_EQ(multiCigar, cigar.ToStdString());
 }
+
+TEST(CigarViewTest, ViewsPackedRecordData)
+{
+    BamRecordImpl impl;
+    impl.CigarData("2H3S10=2D4I1X2P5=3S1H");
+
+    const CigarView view = impl.CigarDataView();
+    ASSERT_EQ(10, view.size());
+    EXPECT_FALSE(view.empty());
+
+    EXPECT_EQ(CigarOperationType::HARD_CLIP, view.Type(0));
+    EXPECT_EQ(2, view.Length(0));
+    EXPECT_EQ(CigarOperation(CigarOperationType::SEQUENCE_MATCH, 10), view[2]);
+    EXPECT_EQ(CigarOperation(CigarOperationType::HARD_CLIP, 1), *(view.cend() - 1));
+
+    // S + = + I + X + = + S ; = + D + X + =
+    EXPECT_EQ(3 + 10 + 4 + 1 + 5 + 3, view.QueryLength());
+    EXPECT_EQ(10 + 2 + 1 + 5, view.ReferenceLength());
+
+    EXPECT_EQ(impl.CigarData(), view.ToCigar());
+    EXPECT_EQ("2H3S10=2D4I1X2P5=3S1H", view.ToStdString());
+
+    size_t count = 0;
+    for (const CigarOperation& op : view) {
+        EXPECT_EQ(impl.CigarData().at(count), op);
+        ++count;
+    }
+    EXPECT_EQ(view.size(), count);
+}
+
+TEST(CigarViewTest, EmptyView)
+{
+    BamRecordImpl impl;
+    const CigarView view = impl.CigarDataView();
+    EXPECT_TRUE(view.empty());
+    EXPECT_TRUE(view.cbegin() == view.cend());
+    EXPECT_EQ(0, view.QueryLength());
+    EXPECT_EQ(0, view.ReferenceLength());
+    EXPECT_TRUE(view.ToCigar().empty());
+}
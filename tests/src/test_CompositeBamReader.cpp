@@ -0,0 +1,306 @@
+// Copyright (c) 2016, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// Author: Derek Barnett
+
+#include "TestData.h"
+#include <gtest/gtest.h>
+#include <pbbam/CompositeBamReader.h>
+#include <pbbam/EntireFileQuery.h>
+#include <pbbam/GenomicIntervalQuery.h>
+#include <string>
+#include <type_traits>
+#include <vector>
+using namespace PacBio;
+using namespace PacBio::BAM;
+using namespace std;
+
+namespace PacBio {
+namespace BAM {
+namespace tests {
+
+static const string mappingBamFn1 = tests::Data_Dir + "/dataset/bam_mapping_1.bam";
+static const string mappingBamFn2 = tests::Data_Dir + "/dataset/bam_mapping_2.bam";
+
+static
+vector<string> NamesInFile(const string& fn)
+{
+    vector<string> names;
+    EntireFileQuery query(fn);
+    for (const BamRecord& r : query)
+        names.push_back(r.FullName());
+    return names;
+}
+
+static
+size_t CountInInterval(const GenomicInterval& interval, const string& fn)
+{
+    size_t count = 0;
+    GenomicIntervalQuery query(interval, fn);
+    for (const BamRecord& r : query) {
+        (void)r;
+        ++count;
+    }
+    return count;
+}
+
+} // namespace tests
+} // namespace BAM
+} // namespace PacBio
+
+TEST(CompositeBamReaderTest, PbiFilterReaderBreaksTiesByInputOrder)
+{
+    // Compare::None treats all records as equal, so results should be each
+    // file's contents in turn, in the order provided
+    const vector<string> names1 = tests::NamesInFile(tests::mappingBamFn1);
+    const vector<string> names2 = tests::NamesInFile(tests::mappingBamFn2);
+
+    {
+        vector<string> expected = names1;
+        expected.insert(expected.end(), names2.cbegin(), names2.cend());
+
+        const vector<BamFile> files = { BamFile{ tests::mappingBamFn1 }, BamFile{ tests::mappingBamFn2 } };
+        PbiFilterCompositeBamReader<Compare::None> reader(PbiFilter{ }, files);
+        vector<string> observed;
+        BamRecord r;
+        while (reader.GetNext(r))
+            observed.push_back(r.FullName());
+        EXPECT_EQ(expected, observed);
+    }
+    {
+        vector<string> expected = names2;
+        expected.insert(expected.end(), names1.cbegin(), names1.cend());
+
+        const vector<BamFile> files = { BamFile{ tests::mappingBamFn2 }, BamFile{ tests::mappingBamFn1 } };
+        PbiFilterCompositeBamReader<Compare::None> reader(PbiFilter{ }, files);
+        vector<string> observed;
+        BamRecord r;
+        while (reader.GetNext(r))
+            observed.push_back(r.FullName());
+        EXPECT_EQ(expected, observed);
+    }
+}
+
+TEST(CompositeBamReaderTest, GenomicIntervalReaderMergesInPositionOrder)
+{
+    const string fn1 = tests::Data_Dir + "/aligned.bam";
+    const string fn2 = tests::Data_Dir + "/aligned2.bam";
+    const GenomicInterval interval("lambda_NEB3011", 0, 100000);
+    const size_t expectedCount = tests::CountInInterval(interval, fn1) +
+                                 tests::CountInInterval(interval, fn2);
+    EXPECT_GT(expectedCount, 0);
+
+    const vector<BamFile> files = { BamFile{ fn1 }, BamFile{ fn2 } };
+    GenomicIntervalCompositeBamReader reader(interval, files);
+
+    // re-use reader, with the same interval (then with read-ahead)
+    for (int i = 0; i < 3; ++i) {
+        if (i == 2)
+            reader.ReadAheadThreads(2);
+        size_t count = 0;
+        Position lastPosition = -1;
+        BamRecord r;
+        while (reader.GetNext(r)) {
+            EXPECT_LE(lastPosition, r.ReferenceStart());
+            lastPosition = r.ReferenceStart();
+            ++count;
+        }
+        EXPECT_EQ(expectedCount, count);
+        EXPECT_EQ(interval, reader.Interval());
+        reader.Interval(interval);
+    }
+}
+
+TEST(CompositeBamReaderTest, MergeKeysStoreComparedValues)
+{
+    EXPECT_TRUE((std::is_same<int32_t,
+                 internal::RecordMergeKeyFor<Compare::Zmw>::type::key_type>::value));
+    EXPECT_TRUE((std::is_same<Position,
+                 internal::RecordMergeKeyFor<Compare::QueryStart>::type::key_type>::value));
+    EXPECT_TRUE((std::is_same<const BamRecord*,
+                 internal::RecordMergeKeyFor<Compare::Base>::type::key_type>::value));
+
+    BamRecord r1;
+    BamRecord r2;
+    r1.HoleNumber(10);
+    r2.HoleNumber(20);
+    const internal::RecordMergeKeyFor<Compare::Zmw>::type zmwKey;
+    EXPECT_TRUE(zmwKey.Less(zmwKey.MakeKey(r1), zmwKey.MakeKey(r2)));
+    EXPECT_FALSE(zmwKey.Less(zmwKey.MakeKey(r2), zmwKey.MakeKey(r1)));
+}
+
+TEST(CompositeBamReaderTest, PositionMergeKeyMatchesPositionOrder)
+{
+    vector<BamRecord> records;
+    EntireFileQuery query(tests::Data_Dir + "/aligned2.bam");
+    for (const BamRecord& r : query)
+        records.push_back(r);
+    ASSERT_FALSE(records.empty());
+
+    BamRecord unmapped;
+    records.push_back(unmapped);
+
+    const internal::PositionMergeKey positionKey;
+    for (const BamRecord& lhs : records) {
+        for (const BamRecord& rhs : records) {
+            EXPECT_EQ(OrderByPosition::less_than(lhs, rhs),
+                      positionKey.Less(positionKey.MakeKey(lhs), positionKey.MakeKey(rhs)));
+        }
+    }
+}
+
+TEST(CompositeBamReaderTest, ReadAheadMatchesDirectReading)
+{
+    const vector<BamFile> files = { BamFile{ tests::mappingBamFn1 }, BamFile{ tests::mappingBamFn2 } };
+    const PbiFilter filter = PbiZmwFilter{ 10000, Compare::GREATER_THAN_EQUAL };
+
+    vector<string> expected;
+    {
+        PbiFilterCompositeBamReader<Compare::None> reader(filter, files);
+        BamRecord r;
+        while (reader.GetNext(r))
+            expected.push_back(r.FullName());
+    }
+    ASSERT_FALSE(expected.empty());
+
+    PbiFilterCompositeBamReader<Compare::None> reader(filter, files);
+    EXPECT_EQ(0, reader.ReadAheadThreads());
+    reader.ReadAheadThreads(2);
+    EXPECT_EQ(2, reader.ReadAheadThreads());
+
+    // applies immediately, and is kept when filter is reset
+    for (int i = 0; i < 2; ++i) {
+        vector<string> observed;
+        BamRecord r;
+        while (reader.GetNext(r))
+            observed.push_back(r.FullName());
+        EXPECT_EQ(expected, observed);
+        reader.Filter(filter);
+    }
+}
+
+TEST(CompositeBamReaderTest, ReadAheadSmallQueue)
+{
+    const vector<string> expected = tests::NamesInFile(tests::mappingBamFn1);
+
+    BamReader reader1(tests::mappingBamFn1);
+    BamReader reader2(tests::mappingBamFn1);
+    internal::CompositeReadAhead readAhead(1, 1);
+    const size_t id1 = readAhead.Add(&reader1);
+    const size_t id2 = readAhead.Add(&reader2);
+
+    vector<string> observed1;
+    vector<string> observed2;
+    BamRecord r;
+    while (readAhead.GetNext(id1, r))
+        observed1.push_back(r.FullName());
+    while (readAhead.GetNext(id2, r))
+        observed2.push_back(r.FullName());
+    EXPECT_EQ(expected, observed1);
+    EXPECT_EQ(expected, observed2);
+    EXPECT_FALSE(readAhead.GetNext(id1, r));
+}
+
+TEST(CompositeBamReaderTest, ParkedReaderResumesAtSamePosition)
+{
+    const vector<string> expected = tests::NamesInFile(tests::mappingBamFn1);
+    ASSERT_GT(expected.size(), 2);
+
+    BamReader reader(tests::mappingBamFn1);
+    BamRecord r;
+    vector<string> observed;
+    while (reader.GetNext(r)) {
+        observed.push_back(r.FullName());
+        EXPECT_FALSE(reader.IsParked());
+        const int64_t offset = reader.VirtualTell();
+        reader.Park();
+        EXPECT_TRUE(reader.IsParked());
+        EXPECT_EQ(offset, reader.VirtualTell());
+    }
+    EXPECT_EQ(expected, observed);
+
+    // seeking while parked
+    const int64_t firstOffset = reader.File().FirstAlignmentOffset();
+    reader.Park();
+    reader.VirtualSeek(firstOffset);
+    EXPECT_TRUE(reader.IsParked());
+    EXPECT_TRUE(reader.GetNext(r));
+    EXPECT_EQ(expected.front(), r.FullName());
+}
+
+TEST(CompositeBamReaderTest, MaxOpenFilesMatchesUnlimited)
+{
+    const vector<BamFile> files = { BamFile{ tests::mappingBamFn1 },
+                                    BamFile{ tests::mappingBamFn2 },
+                                    BamFile{ tests::Data_Dir + "/dataset/bam_mapping_new.bam" } };
+    const PbiFilter filter = PbiZmwFilter{ 10000, Compare::GREATER_THAN_EQUAL };
+
+    vector<string> expected;
+    {
+        PbiFilterCompositeBamReader<Compare::Zmw> reader(filter, files);
+        BamRecord r;
+        while (reader.GetNext(r))
+            expected.push_back(r.FullName());
+    }
+    ASSERT_FALSE(expected.empty());
+
+    PbiFilterCompositeBamReader<Compare::Zmw> reader(filter, files);
+    reader.MaxOpenFiles(1);
+    EXPECT_EQ(1, reader.MaxOpenFiles());
+    for (int i = 0; i < 2; ++i) {
+        vector<string> observed;
+        BamRecord r;
+        while (reader.GetNext(r))
+            observed.push_back(r.FullName());
+        EXPECT_EQ(expected, observed);
+        reader.Filter(filter);
+    }
+}
+
+TEST(CompositeBamReaderTest, SequentialReaderReadsFilesInOrder)
+{
+    const vector<string> names1 = tests::NamesInFile(tests::mappingBamFn1);
+    const vector<string> names2 = tests::NamesInFile(tests::mappingBamFn2);
+    vector<string> expected = names2;
+    expected.insert(expected.end(), names1.cbegin(), names1.cend());
+
+    SequentialCompositeBamReader reader({ BamFile{ tests::mappingBamFn2 }, BamFile{ tests::mappingBamFn1 } });
+    vector<string> observed;
+    BamRecord r;
+    while (reader.GetNext(r))
+        observed.push_back(r.FullName());
+    EXPECT_EQ(expected, observed);
+    EXPECT_FALSE(reader.GetNext(r));
+}
@@ -0,0 +1,173 @@
+// Copyright (c) 2016, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// Author: Derek Barnett
+
+#ifdef PBBAM_TESTING
+#define private public
+#endif
+
+#include "TestData.h"
+#include <gtest/gtest.h>
+#include <pbbam/DataSetChunking.h>
+#include <pbbam/PbiFilterQuery.h>
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <vector>
+using namespace PacBio;
+using namespace PacBio::BAM;
+using namespace std;
+
+namespace PacBio {
+namespace BAM {
+namespace tests {
+
+static
+vector<string> RecordKeys(const DataSet& dataset, size_t* numBases = nullptr)
+{
+    vector<string> keys;
+    if (numBases)
+        *numBases = 0;
+    PbiFilterQuery query(PbiFilter::FromDataSet(dataset), dataset);
+    for (const BamRecord& r : query) {
+        keys.push_back(r.FullName() + "@" + to_string(r.ReferenceStart()));
+        if (numBases)
+            *numBases += (r.QueryEnd() - r.QueryStart());
+    }
+    return keys;
+}
+
+// chunk contents, taken together, should be exactly the input's contents
+static
+void CheckPartition(const vector<string>& expected,
+                    const vector<DataSet>& chunks)
+{
+    vector<string> observed;
+    for (const DataSet& chunk : chunks) {
+        const auto keys = RecordKeys(chunk);
+        observed.insert(observed.end(), keys.cbegin(), keys.cend());
+    }
+
+    auto sortedExpected = expected;
+    sort(sortedExpected.begin(), sortedExpected.end());
+    sort(observed.begin(), observed.end());
+    EXPECT_EQ(sortedExpected, observed);
+}
+
+} // namespace tests
+} // namespace BAM
+} // namespace PacBio
+
+TEST(DataSetChunkingTest, ZmwChunksPartitionFilteredDataset)
+{
+    // dataset already carries (movie & ZMW range) filters
+    const DataSet dataset(tests::Data_Dir + "/chunking/chunking.subreadset.xml");
+    const auto expected = tests::RecordKeys(dataset);
+    ASSERT_FALSE(expected.empty());
+
+    const auto chunks = DataSetChunking::ByZmw(dataset, 4, DataSetChunking::RECORDS);
+    ASSERT_EQ(4, chunks.size());
+    tests::CheckPartition(expected, chunks);
+
+    // roughly balanced & ZMWs never split
+    vector<int32_t> lastZmws;
+    for (const DataSet& chunk : chunks) {
+        EXPECT_NE(dataset.UniqueId(), chunk.UniqueId());
+
+        size_t count = 0;
+        int32_t minZmw = std::numeric_limits<int32_t>::max();
+        int32_t maxZmw = std::numeric_limits<int32_t>::min();
+        PbiFilterQuery query(PbiFilter::FromDataSet(chunk), chunk);
+        for (const BamRecord& r : query) {
+            minZmw = std::min(minZmw, r.HoleNumber());
+            maxZmw = std::max(maxZmw, r.HoleNumber());
+            ++count;
+        }
+        EXPECT_NEAR(expected.size() / 4.0, count, expected.size() / 8.0);
+        if (!lastZmws.empty())
+            EXPECT_LT(lastZmws.back(), minZmw);
+        lastZmws.push_back(maxZmw);
+    }
+
+    // chunk restrictions are carried as ordinary dataset filters
+    size_t numZmwProperties = 0;
+    for (const Filter& filter : chunks.at(1).Filters()) {
+        for (const Property& property : filter.Properties()) {
+            if (property.Name() == "zm")
+                ++numZmwProperties;
+        }
+    }
+    EXPECT_LT(dataset.Filters().Size(), numZmwProperties);
+}
+
+TEST(DataSetChunkingTest, ReferenceChunksPartitionAlignedDataset)
+{
+    DataSet dataset(DataSet::ALIGNMENT);
+    dataset.ExternalResources().Add(ExternalResource("PacBio.AlignmentFile.AlignmentBamFile",
+                                                     tests::Data_Dir + "/aligned2.bam"));
+    dataset.ExternalResources().Add(ExternalResource("PacBio.AlignmentFile.AlignmentBamFile",
+                                                     tests::Data_Dir + "/dataset/bam_mapping_1.bam"));
+    size_t totalBases = 0;
+    const auto expected = tests::RecordKeys(dataset, &totalBases);
+
+    const auto chunks = DataSetChunking::ByReference(dataset, 3);
+    ASSERT_EQ(3, chunks.size());
+    tests::CheckPartition(expected, chunks);
+
+    for (const DataSet& chunk : chunks) {
+        size_t numBases = 0;
+        tests::RecordKeys(chunk, &numBases);
+        EXPECT_NEAR(totalBases / 3.0, numBases, totalBases / 6.0);
+    }
+}
+
+TEST(DataSetChunkingTest, FewerChunksThanRequestedOk)
+{
+    const DataSet dataset(tests::Data_Dir + "/polymerase/production.subreads.bam");
+    const auto chunks = DataSetChunking::ByZmw(dataset, 10);
+    ASSERT_EQ(1, chunks.size()); // single ZMW
+    EXPECT_EQ(tests::RecordKeys(dataset).size(), tests::RecordKeys(chunks.front()).size());
+}
+
+TEST(DataSetChunkingTest, InvalidRequestsThrow)
+{
+    const DataSet subreads(tests::Data_Dir + "/polymerase/production.subreads.bam");
+    EXPECT_THROW(DataSetChunking::ByZmw(subreads, 0), std::runtime_error);
+    EXPECT_THROW(DataSetChunking::ByReference(subreads, 2), std::runtime_error);
+
+    const DataSet noPbi(tests::Data_Dir + "/polymerase/production.polymerase.bam");
+    EXPECT_THROW(DataSetChunking::ByZmw(noPbi, 2), std::runtime_error);
+}
@@ -43,6 +43,7 @@
 #include <pbbam/ZmwQuery.h>
 #include <pbbam/ZmwGroupQuery.h>
 #include <pbbam/DataSet.h>
+#include <map>
 #include <string>
 using namespace PacBio;
 using namespace PacBio::BAM;
@@ -498,3 +499,49 @@ TEST(DataSetQueryTest, ZmwGroupQueryTest)
         EXPECT_EQ(8, totalCount);
     });
 }
+
+TEST(DataSetQueryTest, ZmwGroupQueryWithoutWhitelist)
+{
+    // aligned2 is not grouped by ZMW, scraps file is
+    const string scrapsBamFn = tests::Data_Dir + "/polymerase/internal.scraps.bam";
+    DataSet dataset;
+    dataset.ExternalResources().Add(ExternalResource(BamFile(aligned2BamFn)));
+    dataset.ExternalResources().Add(ExternalResource(BamFile(scrapsBamFn)));
+
+    map<int32_t, vector<string> > expected;
+    for (const string& fn : { aligned2BamFn, scrapsBamFn }) {
+        EntireFileQuery query(fn);
+        for (const BamRecord& record : query)
+            expected[record.HoleNumber()].push_back(record.FullName());
+    }
+
+    auto expectedIter = expected.cbegin();
+    ZmwGroupQuery query(dataset);
+    for (const vector<BamRecord>& group : query) {
+        ASSERT_TRUE(expectedIter != expected.cend());
+        ASSERT_FALSE(group.empty());
+        EXPECT_EQ(expectedIter->first, group.front().HoleNumber());
+
+        vector<string> names;
+        for (const BamRecord& record : group)
+            names.push_back(record.FullName());
+        EXPECT_EQ(expectedIter->second, names);
+        ++expectedIter;
+    }
+    EXPECT_TRUE(expectedIter == expected.cend());
+}
+
+TEST(DataSetQueryTest, ZmwGroupQueryReturnsEmptyGroupForMissingZmw)
+{
+    const string scrapsBamFn = tests::Data_Dir + "/polymerase/internal.scraps.bam";
+    const vector<int32_t> whitelist = { 200000, 12345, 200000 };
+
+    vector<size_t> groupSizes;
+    ZmwGroupQuery query(whitelist, DataSet(scrapsBamFn));
+    for (const vector<BamRecord>& group : query) {
+        for (const BamRecord& record : group)
+            EXPECT_EQ(200000, record.HoleNumber());
+        groupSizes.push_back(group.size());
+    }
+    EXPECT_EQ((vector<size_t>{ 0, 23 }), groupSizes);
+}
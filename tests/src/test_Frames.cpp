@@ -95,3 +95,57 @@ TEST(FramesTest, Encoded)
     const auto e = f.Encode();
     ASSERT_EQ(tests::encodedFrames, e);
 }
+
+TEST(FramesTest, CodecMatchesDownsamplingTables)
+{
+    // build tables as in kineticsTools' _downsampling.py
+    vector<uint16_t> framepoints;
+    uint16_t next = 0;
+    for (int i = 0; i < 4; ++i) {
+        const uint16_t grain = 1 << i;
+        for (uint16_t j = 0; j < 64; ++j)
+            framepoints.push_back(j*grain + next);
+        next = framepoints.back() + grain;
+    }
+    vector<uint8_t> frameToCode(framepoints.back() + 1, 0);
+    for (size_t i = 0; i + 1 < framepoints.size(); ++i) {
+        const uint16_t fl = framepoints[i];
+        const uint16_t fu = framepoints[i+1];
+        const uint16_t middle = (fl+fu)/2;
+        for (uint16_t f = fl; f < fu; ++f)
+            frameToCode[f] = (f < middle || fu == fl+1) ? i : i+1;
+    }
+    frameToCode.back() = 255;
+
+    // every code
+    vector<uint8_t> allCodes(256);
+    for (size_t i = 0; i < allCodes.size(); ++i)
+        allCodes[i] = static_cast<uint8_t>(i);
+    EXPECT_EQ(framepoints, Frames::Decode(allCodes).Data());
+
+    // every frame value
+    vector<uint16_t> allFrames(UINT16_MAX + 1);
+    vector<uint8_t> expectedCodes(allFrames.size());
+    for (size_t i = 0; i < allFrames.size(); ++i) {
+        allFrames[i] = static_cast<uint16_t>(i);
+        expectedCodes[i] = frameToCode[std::min(i, frameToCode.size()-1)];
+    }
+    EXPECT_EQ(expectedCodes, Frames::Encode(allFrames));
+}
+
+TEST(FramesTest, BulkCodecUsesCallerBuffers)
+{
+    // odd length exercises both vectorized & trailing elements
+    const vector<uint8_t> codes(tests::encodedFrames.cbegin(), tests::encodedFrames.cend() - 2);
+    vector<uint16_t> frames(codes.size() + 1, 7);
+    Frames::Decode(codes.data(), codes.size(), frames.data());
+    EXPECT_EQ(Frames::Decode(codes).Data(), vector<uint16_t>(frames.cbegin(), frames.cend() - 1));
+    EXPECT_EQ(7, frames.back());
+
+    vector<uint8_t> reencoded(frames.size() - 1);
+    Frames::Encode(frames.data(), reencoded.size(), reencoded.data());
+    EXPECT_EQ(codes, reencoded);
+
+    Frames::Decode(nullptr, 0, frames.data());
+    Frames::Encode(nullptr, 0, reencoded.data());
+}
@@ -41,6 +41,7 @@
 
 #include "TestData.h"
 #include <gtest/gtest.h>
+#include <pbbam/EntireFileQuery.h>
 #include <pbbam/GenomicIntervalQuery.h>
 #include <iostream>
 #include <string>
@@ -155,3 +156,49 @@ TEST(GenomicIntervalQueryTest,  MissingBaiShouldThrow)
         EXPECT_THROW(GenomicIntervalQuery query(interval, ds), std::runtime_error);
     }
 }
+
+TEST(GenomicIntervalQueryTest, UsesPbiIfBaiMissing)
+{
+    // no BAI for this file, only PBI
+    const string pbiOnlyBam = tests::Data_Dir + "/dataset/bam_mapping_1.bam";
+    ASSERT_FALSE(BamFile(pbiOnlyBam).StandardIndexExists());
+
+    GenomicInterval interval("lambda_NEB3011", 30000, 42000);
+
+    int expected = 0;
+    EntireFileQuery entireFile(pbiOnlyBam);
+    for (const BamRecord& r : entireFile) {
+        if (r.ReferenceStart() < interval.Stop() && r.ReferenceEnd() > interval.Start())
+            ++expected;
+    }
+    ASSERT_GT(expected, 0);
+
+    int count = 0;
+    Position lastStart = 0;
+    GenomicIntervalQuery query(interval, pbiOnlyBam);
+    for (const BamRecord& r : query) {
+        EXPECT_LE(lastStart, r.ReferenceStart());
+        lastStart = r.ReferenceStart();
+        ++count;
+    }
+    EXPECT_EQ(expected, count);
+
+    // mixed BAI/PBI inputs, re-using query
+    DataSet ds;
+    ds.ExternalResources().Add(ExternalResource("PacBio.AlignmentFile.AlignmentBamFile", pbiOnlyBam));
+    ds.ExternalResources().Add(ExternalResource("PacBio.AlignmentFile.AlignmentBamFile", inputBamFn));
+    GenomicIntervalQuery mixedQuery(GenomicInterval{ "lambda_NEB3011", 5000, 6000 }, ds);
+    mixedQuery.Interval(interval);
+    count = 0;
+    for (const BamRecord& r : mixedQuery) {
+        (void)r;
+        ++count;
+    }
+    int expectedFromBai = 0;
+    GenomicIntervalQuery baiQuery(interval, inputBamFn);
+    for (const BamRecord& r : baiQuery) {
+        (void)r;
+        ++expectedFromBai;
+    }
+    EXPECT_EQ(expected + expectedFromBai, count);
+}
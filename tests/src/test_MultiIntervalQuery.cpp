@@ -0,0 +1,222 @@
+// Copyright (c) 2016, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// Author: Derek Barnett
+
+#ifdef PBBAM_TESTING
+#define private public
+#endif
+
+#include "TestData.h"
+#include <gtest/gtest.h>
+#include <pbbam/BamWriter.h>
+#include <pbbam/EntireFileQuery.h>
+#include <pbbam/GenomicIntervalQuery.h>
+#include <pbbam/MultiIntervalQuery.h>
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <tuple>
+#include <vector>
+using namespace PacBio;
+using namespace PacBio::BAM;
+using namespace std;
+
+namespace PacBio {
+namespace BAM {
+namespace tests {
+
+typedef std::tuple<Position, std::string, std::vector<size_t> > AttributedRecord;
+
+static const string alignedBamFn  = tests::Data_Dir + "/aligned.bam";
+static const string aligned2BamFn = tests::Data_Dir + "/aligned2.bam";
+
+static
+vector<AttributedRecord> ExpectedRecords(const vector<GenomicInterval>& intervals,
+                                         const vector<string>& filenames)
+{
+    vector<AttributedRecord> result;
+    for (const string& fn : filenames) {
+        EntireFileQuery query(fn);
+        for (const BamRecord& r : query) {
+            if (!r.IsMapped())
+                continue;
+            vector<size_t> overlapping;
+            for (size_t i = 0; i < intervals.size(); ++i) {
+                const GenomicInterval& interval = intervals.at(i);
+                if (r.ReferenceName() == interval.Name() &&
+                    r.ReferenceStart() < interval.Stop() &&
+                    r.ReferenceEnd() > interval.Start())
+                {
+                    overlapping.push_back(i);
+                }
+            }
+            if (!overlapping.empty())
+                result.push_back(make_tuple(r.ReferenceStart(), r.FullName(), overlapping));
+        }
+    }
+    sort(result.begin(), result.end());
+    return result;
+}
+
+static
+DataSet MakeDataSet(const vector<string>& filenames)
+{
+    DataSet ds;
+    for (const string& fn : filenames)
+        ds.ExternalResources().Add(ExternalResource("PacBio.AlignmentFile.AlignmentBamFile", fn));
+    return ds;
+}
+
+} // namespace tests
+} // namespace BAM
+} // namespace PacBio
+
+TEST(MultiIntervalQueryTest, AttributesRecordsToAllOverlappingIntervals)
+{
+    const string rname = "lambda_NEB3011";
+    const vector<GenomicInterval> intervals = {
+        GenomicInterval{ rname, 9000, 10000 },
+        GenomicInterval{ rname, 0, 500 },
+        GenomicInterval{ rname, 4500, 5300 },
+        GenomicInterval{ rname, 5000, 6000 },       // overlaps previous
+        GenomicInterval{ rname, 5100, 5200 },       // nested
+        GenomicInterval{ rname, 20000, 20001 },
+        GenomicInterval{ rname, 30000, 40000 },
+        GenomicInterval{ rname, 9000, 10000 },      // duplicate
+        GenomicInterval{ rname, 45000, 45000 },     // empty
+        GenomicInterval{ "does not exist", 0, 100 } // ignored
+    };
+    const vector<string> filenames = { tests::aligned2BamFn, tests::alignedBamFn };
+    const auto expected = tests::ExpectedRecords(intervals, filenames);
+    ASSERT_FALSE(expected.empty());
+
+    vector<tests::AttributedRecord> observed;
+    Position lastStart = 0;
+    MultiIntervalQuery query(intervals, tests::MakeDataSet(filenames));
+    for (const BamRecord& r : query) {
+        EXPECT_LE(lastStart, r.ReferenceStart());
+        lastStart = r.ReferenceStart();
+        observed.push_back(make_tuple(r.ReferenceStart(), r.FullName(), query.CurrentIntervals()));
+    }
+    sort(observed.begin(), observed.end());
+    EXPECT_EQ(expected, observed);
+    EXPECT_EQ(intervals.size(), query.Intervals().size());
+}
+
+TEST(MultiIntervalQueryTest, AttributesRecordsByNameAcrossHeaderOrders)
+{
+    // 'reordered' lists an extra reference first, so reference ID 0 names
+    // different references in the two files
+    const string rname = "lambda_NEB3011";
+    const string reorderedBamFn = tests::GeneratedData_Dir + "/multiinterval_reordered.bam";
+    {
+        const BamFile source{ tests::alignedBamFn };
+        BamHeader header = source.Header().DeepCopy();
+        const SequenceInfo lambda = header.Sequences().at(0);
+        header.ClearSequences();
+        header.AddSequence(SequenceInfo{ "decoy", lambda.Length() });
+        header.AddSequence(lambda);
+
+        // same records on both references, sorted by (ID, position)
+        BamWriter writer(reorderedBamFn, header);
+        for (const int32_t tId : { 0, 1 }) {
+            EntireFileQuery query(source);
+            for (BamRecord& r : query) {
+                if (!r.IsMapped())
+                    continue;
+                r.Impl().ReferenceId(tId);
+                writer.Write(r);
+            }
+        }
+    }
+    BamFile{ reorderedBamFn }.CreateStandardIndex();
+
+    const vector<GenomicInterval> intervals = {
+        GenomicInterval{ rname, 4500, 6000 },
+        GenomicInterval{ "decoy", 5000, 9000 },
+        GenomicInterval{ rname, 8000, 10000 }
+    };
+    const vector<string> filenames = { tests::alignedBamFn, reorderedBamFn };
+    const auto expected = tests::ExpectedRecords(intervals, filenames);
+    ASSERT_FALSE(expected.empty());
+
+    vector<tests::AttributedRecord> observed;
+    MultiIntervalQuery query(intervals, tests::MakeDataSet(filenames));
+    for (const BamRecord& r : query)
+        observed.push_back(make_tuple(r.ReferenceStart(), r.FullName(), query.CurrentIntervals()));
+    sort(observed.begin(), observed.end());
+    EXPECT_EQ(expected, observed);
+
+    remove(reorderedBamFn.c_str());
+    remove((reorderedBamFn + ".bai").c_str());
+}
+
+TEST(MultiIntervalQueryTest, SameRecordsAsGenomicIntervalQuery)
+{
+    const GenomicInterval interval{ "lambda_NEB3011", 5000, 6000 };
+
+    vector<string> expected;
+    GenomicIntervalQuery single(interval, tests::aligned2BamFn);
+    for (const BamRecord& r : single)
+        expected.push_back(r.FullName());
+
+    vector<string> observed;
+    MultiIntervalQuery multi({ interval }, tests::MakeDataSet({ tests::aligned2BamFn }));
+    for (const BamRecord& r : multi) {
+        observed.push_back(r.FullName());
+        EXPECT_EQ(vector<size_t>{ 0 }, multi.CurrentIntervals());
+    }
+    EXPECT_EQ(expected, observed);
+}
+
+TEST(MultiIntervalQueryTest, NoIntervalsReturnsNoRecords)
+{
+    MultiIntervalQuery query({ }, tests::MakeDataSet({ tests::alignedBamFn }));
+    int count = 0;
+    for (const BamRecord& r : query) {
+        (void)r;
+        ++count;
+    }
+    EXPECT_EQ(0, count);
+}
+
+TEST(MultiIntervalQueryTest, MissingBaiShouldThrow)
+{
+    const vector<GenomicInterval> intervals = { GenomicInterval{ "lambda_NEB3011", 0, 100 } };
+    const string phi29Bam = tests::Data_Dir + "/phi29.bam";
+    EXPECT_THROW(MultiIntervalQuery(intervals, tests::MakeDataSet({ tests::alignedBamFn, phi29Bam })),
+                 std::runtime_error);
+}
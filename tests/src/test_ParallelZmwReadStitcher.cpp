@@ -0,0 +1,219 @@
+// Copyright (c) 2016, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// Author: Derek Barnett
+
+#ifdef PBBAM_TESTING
+#define private public
+#endif
+
+#include "TestData.h"
+#include <gtest/gtest.h>
+#include <pbbam/BamReader.h>
+#include <pbbam/BamWriter.h>
+#include <pbbam/DataSet.h>
+#include <pbbam/PbiFilter.h>
+#include <pbbam/virtual/ParallelZmwReadStitcher.h>
+#include <pbbam/virtual/ZmwReadStitcher.h>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+using namespace PacBio;
+using namespace PacBio::BAM;
+using namespace std;
+
+namespace PacBio {
+namespace BAM {
+namespace tests {
+
+static const string internalSubreadsFn = tests::Data_Dir + "/polymerase/internal.subreads.bam";
+static const string internalScrapsFn   = tests::Data_Dir + "/polymerase/internal.scraps.bam";
+
+static
+vector<VirtualZmwBamRecord> SerialRecords(ZmwReadStitcher& stitcher)
+{
+    vector<VirtualZmwBamRecord> records;
+    while (stitcher.HasNext())
+        records.push_back(stitcher.Next());
+    return records;
+}
+
+static
+vector<VirtualZmwBamRecord> ParallelRecords(ParallelZmwReadStitcher& stitcher)
+{
+    vector<VirtualZmwBamRecord> records;
+    while (stitcher.HasNext())
+        records.push_back(stitcher.Next());
+    return records;
+}
+
+static
+void CompareRecords(const vector<VirtualZmwBamRecord>& expected,
+                    const vector<VirtualZmwBamRecord>& observed)
+{
+    ASSERT_EQ(expected.size(), observed.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        const VirtualZmwBamRecord& e = expected.at(i);
+        const VirtualZmwBamRecord& o = observed.at(i);
+        EXPECT_EQ(e.FullName(),   o.FullName());
+        EXPECT_EQ(e.HoleNumber(), o.HoleNumber());
+        EXPECT_EQ(e.Sequence(),   o.Sequence());
+        EXPECT_EQ(e.Qualities(),  o.Qualities());
+        EXPECT_EQ(e.IPD(),        o.IPD());
+        EXPECT_EQ(e.ReadGroup(),  o.ReadGroup());
+        EXPECT_EQ(e.VirtualRegionsMap().size(), o.VirtualRegionsMap().size());
+    }
+}
+
+} // namespace tests
+} // namespace BAM
+} // namespace PacBio
+
+TEST(ParallelZmwReadStitcherTest, MatchesSerialStitcher)
+{
+    ZmwReadStitcher serial(tests::internalSubreadsFn, tests::internalScrapsFn);
+    const auto expected = tests::SerialRecords(serial);
+    ASSERT_EQ(3, expected.size());
+
+    // includes a window smaller than thread count
+    for (const size_t numThreads : { 1, 2, 4 }) {
+        for (const size_t windowSize : { 1, 2, 256 }) {
+            ParallelZmwReadStitcher parallel(tests::internalSubreadsFn,
+                                             tests::internalScrapsFn,
+                                             numThreads,
+                                             windowSize);
+            EXPECT_EQ(numThreads, parallel.NumThreads());
+            EXPECT_EQ(windowSize, parallel.WindowSize());
+            tests::CompareRecords(expected, tests::ParallelRecords(parallel));
+            EXPECT_FALSE(parallel.HasNext());
+            EXPECT_THROW(parallel.Next(), std::runtime_error);
+        }
+    }
+}
+
+TEST(ParallelZmwReadStitcherTest, FilteredInput)
+{
+    const PbiFilter filter{ PbiZmwFilter{100000} };
+    ParallelZmwReadStitcher stitcher(tests::internalSubreadsFn,
+                                     tests::internalScrapsFn,
+                                     filter, 2);
+    const auto records = tests::ParallelRecords(stitcher);
+    ASSERT_EQ(1, records.size());
+    EXPECT_EQ(100000, records.front().HoleNumber());
+}
+
+TEST(ParallelZmwReadStitcherTest, FromDataSet)
+{
+    const DataSet ds(tests::Data_Dir + "/polymerase/multiple_resources.subread.dataset.xml");
+
+    ZmwReadStitcher serial(ds);
+    const auto expected = tests::SerialRecords(serial);
+
+    ParallelZmwReadStitcher parallel(ds, 3, 2);
+    tests::CompareRecords(expected, tests::ParallelRecords(parallel));
+
+    ParallelZmwReadStitcher empty(DataSet{ }, 2);
+    EXPECT_FALSE(empty.HasNext());
+}
+
+TEST(ParallelZmwReadStitcherTest, WritesRecordsInOrder)
+{
+    ZmwReadStitcher serial(tests::internalSubreadsFn, tests::internalScrapsFn);
+    const auto expected = tests::SerialRecords(serial);
+
+    const string outFn = tests::GeneratedData_Dir + "/parallel_stitched.bam";
+    {
+        ParallelZmwReadStitcher stitcher(tests::internalSubreadsFn,
+                                         tests::internalScrapsFn,
+                                         4, 2);
+        BamWriter writer(outFn, expected.front().Header());
+        EXPECT_EQ(expected.size(), stitcher.WriteTo(writer));
+    }
+
+    vector<string> names;
+    BamReader reader(outFn);
+    BamRecord record;
+    while (reader.GetNext(record))
+        names.push_back(record.FullName());
+
+    ASSERT_EQ(expected.size(), names.size());
+    for (size_t i = 0; i < names.size(); ++i)
+        EXPECT_EQ(expected.at(i).FullName(), names.at(i));
+
+    remove(outFn.c_str());
+}
+
+TEST(ParallelZmwReadStitcherTest, EarlyDestructionOk)
+{
+    // abandon in-flight ZMWs
+    ParallelZmwReadStitcher stitcher(tests::internalSubreadsFn,
+                                     tests::internalScrapsFn,
+                                     2, 1);
+    EXPECT_TRUE(stitcher.HasNext());
+}
+
+TEST(ParallelZmwReadStitcherTest, ReaderErrorReportedOnce)
+{
+    // second source cannot be opened, after the first one's ZMWs are read
+    ExternalResource good("PacBio.SubreadFile.SubreadBamFile", tests::internalSubreadsFn);
+    good.ExternalResources().Add(ExternalResource("PacBio.SubreadFile.ScrapsBamFile", tests::internalScrapsFn));
+    ExternalResource bad("PacBio.SubreadFile.SubreadBamFile", "does_not_exist.subreads.bam");
+    bad.ExternalResources().Add(ExternalResource("PacBio.SubreadFile.ScrapsBamFile", "does_not_exist.scraps.bam"));
+    DataSet ds;
+    ds.ExternalResources().Add(good);
+    ds.ExternalResources().Add(bad);
+
+    ParallelZmwReadStitcher stitcher(ds, 2);
+    size_t numRecords = 0;
+    size_t numErrors = 0;
+    for (size_t i = 0; i < 10 && stitcher.HasNext(); ++i) {
+        try {
+            stitcher.Next();
+            ++numRecords;
+        } catch (std::exception&) {
+            ++numErrors;
+        }
+    }
+    EXPECT_EQ(3, numRecords);
+    EXPECT_EQ(1, numErrors);
+    EXPECT_FALSE(stitcher.HasNext());
+}
+
+TEST(ParallelZmwReadStitcherTest, MissingFileThrows)
+{
+    EXPECT_THROW(ParallelZmwReadStitcher(tests::internalSubreadsFn, "does_not_exist.bam"),
+                 std::runtime_error);
+}
@@ -42,9 +42,12 @@
 #include "TestData.h"
 #include <gtest/gtest.h>
 #include <pbbam/PbiFilter.h>
+#include <fstream>
 #include <string>
+#include <thread>
 #include <cstdio>
 #include <cstdlib>
+#include <sys/stat.h>
 using namespace PacBio;
 using namespace PacBio::BAM;
 using namespace std;
@@ -727,6 +730,99 @@ TEST(PbiFilterTest, QueryNameFilterOk)
     std::exception); // come back to see why this is not runtime_error but something else
 }
 
+TEST(PbiFilterTest, QueryNamesFromFileFilterOk)
+{
+    const string namesFn = tests::GeneratedData_Dir + "/qnames_whitelist.txt";
+    {
+        ofstream names(namesFn);
+        names << "m140905_042212_sidney_c100564852550000001823085912221377_s1_X0/14743/2579_4055\n"
+              << "\n"
+              << "does_not_exist/0/0_0\r\n"
+              << "m140905_042212_sidney_c100564852550000001823085912221377_s1_X0/14743/5615_6237\n"
+              << "m140905_042212_sidney_c100564852550000001823085912221377_s1_X0/14743/2579_4055"; // dupe, no newline
+    }
+
+    for (size_t numThreads : { 1, 4 }) {
+        const auto qnameFilter = PbiQueryNameFilter::FromFile(namesFn, numThreads);
+        EXPECT_FALSE(qnameFilter.Accepts(tests::shared_index, 0));
+        EXPECT_TRUE(qnameFilter.Accepts(tests::shared_index, 1));
+        EXPECT_FALSE(qnameFilter.Accepts(tests::shared_index, 2));
+        EXPECT_TRUE(qnameFilter.Accepts(tests::shared_index, 3));
+
+        // out-of-order lookups give same results
+        EXPECT_TRUE(qnameFilter.Accepts(tests::shared_index, 1));
+        EXPECT_FALSE(qnameFilter.Accepts(tests::shared_index, 0));
+
+        const auto filter = PbiFilter{ qnameFilter };
+        tests::checkFilterRows(filter, std::vector<size_t>{1,3});
+    }
+
+    // invalid QNAME syntax throws
+    {
+        ofstream names(namesFn);
+        names << "m140905_042212_sidney_c100564852550000001823085912221377_s1_X0/14743/2579_4055\n"
+              << "foo/bar\n";
+    }
+    EXPECT_THROW(PbiQueryNameFilter::FromFile(namesFn), std::runtime_error);
+
+    // missing file throws
+    EXPECT_THROW(PbiQueryNameFilter::FromFile(tests::GeneratedData_Dir + "/does_not_exist.txt"),
+                 std::runtime_error);
+
+    remove(namesFn.c_str());
+}
+
+TEST(PbiFilterTest, QueryNamesFromNonSeekableFileOk)
+{
+    // names arrive through a FIFO, as with /dev/stdin or process substitution
+    const string fifoFn = tests::GeneratedData_Dir + "/qnames_whitelist.fifo";
+    remove(fifoFn.c_str());
+    ASSERT_EQ(0, mkfifo(fifoFn.c_str(), 0600));
+
+    std::thread writer([&fifoFn]()
+    {
+        ofstream names(fifoFn);
+        names << "m140905_042212_sidney_c100564852550000001823085912221377_s1_X0/14743/2579_4055\n"
+              << "m140905_042212_sidney_c100564852550000001823085912221377_s1_X0/14743/5615_6237\n";
+    });
+    const auto qnameFilter = PbiQueryNameFilter::FromFile(fifoFn, 4);
+    writer.join();
+    remove(fifoFn.c_str());
+
+    const auto filter = PbiFilter{ qnameFilter };
+    tests::checkFilterRows(filter, std::vector<size_t>{1,3});
+}
+
+TEST(PbiFilterTest, QueryNameFilterSharedAcrossThreadsOk)
+{
+    const auto names = vector<string>{"m140905_042212_sidney_c100564852550000001823085912221377_s1_X0/14743/2579_4055",
+                                      "m140905_042212_sidney_c100564852550000001823085912221377_s1_X0/14743/5615_6237"};
+    const auto filter = PbiFilter{ PbiQueryNameFilter{ names } };
+
+    // each thread walks the rows in a different order, through the same filter
+    const size_t numThreads = 4;
+    const size_t numRows = tests::shared_index.NumReads();
+    vector<vector<bool> > accepted(numThreads, vector<bool>(numRows, false));
+    vector<std::thread> threads;
+    for (size_t t = 0; t < numThreads; ++t) {
+        threads.emplace_back([&, t]()
+        {
+            for (size_t pass = 0; pass < 100; ++pass) {
+                for (size_t i = 0; i < numRows; ++i) {
+                    const size_t row = (t % 2 == 0) ? i : numRows - 1 - i;
+                    accepted[t][row] = filter.Accepts(tests::shared_index, row);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    const auto expected = vector<bool>{ false, true, false, true };
+    for (size_t t = 0; t < numThreads; ++t)
+        EXPECT_EQ(expected, accepted.at(t));
+}
+
 TEST(PbiFilterTest, QueryStartFilterOk)
 {
     {
@@ -0,0 +1,308 @@
+// Copyright (c) 2016, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// Author: Derek Barnett
+
+#include "TestData.h"
+#include <gtest/gtest.h>
+#include <pbbam/EntireFileQuery.h>
+#include <pbbam/PbiIndexedBamReader.h>
+#include <string>
+#include <vector>
+using namespace PacBio;
+using namespace PacBio::BAM;
+using namespace std;
+
+namespace PacBio {
+namespace BAM {
+namespace tests {
+
+static const string sparseBamFn = tests::Data_Dir + "/dataset/bam_mapping_1.bam";
+
+// accepts every n-th record
+struct EveryNthRowFilter
+{
+    EveryNthRowFilter(const size_t n) : n_(n) { }
+
+    bool Accepts(const PbiRawData& idx, const size_t row) const
+    { (void)idx; return (row % n_) == 0; }
+
+    size_t n_;
+};
+
+static
+vector<string> ExpectedEveryNthName(const size_t n)
+{
+    vector<string> names;
+    size_t row = 0;
+    EntireFileQuery query(sparseBamFn);
+    for (const BamRecord& r : query) {
+        if ((row % n) == 0)
+            names.push_back(r.FullName());
+        ++row;
+    }
+    return names;
+}
+
+static
+vector<string> FilteredNames(PbiIndexedBamReader& reader)
+{
+    vector<string> names;
+    BamRecord r;
+    while (reader.GetNext(r))
+        names.push_back(r.FullName());
+    return names;
+}
+
+static
+vector<string> ExpectedOverlappingNames(const GenomicInterval& interval)
+{
+    vector<string> names;
+    EntireFileQuery query(sparseBamFn);
+    for (const BamRecord& r : query) {
+        if (r.IsMapped() &&
+            r.ReferenceName() == interval.Name() &&
+            r.ReferenceStart() < interval.Stop() &&
+            r.ReferenceEnd() > interval.Start())
+        {
+            names.push_back(r.FullName());
+        }
+    }
+    return names;
+}
+
+} // namespace tests
+} // namespace BAM
+} // namespace PacBio
+
+TEST(PbiIndexedBamReaderTest, ReadThroughThresholdDefaultOk)
+{
+    PbiIndexedBamReader reader(tests::sparseBamFn);
+    EXPECT_EQ(PbiIndexedBamReader::DefaultReadThroughThreshold, reader.ReadThroughThreshold());
+    reader.ReadThroughThreshold(0);
+    EXPECT_EQ(0, reader.ReadThroughThreshold());
+}
+
+TEST(PbiIndexedBamReaderTest, SparseFilterSameRecordsForAnyThreshold)
+{
+    for (const size_t n : { 2, 3, 50 }) {
+        const auto expected = tests::ExpectedEveryNthName(n);
+        EXPECT_FALSE(expected.empty());
+
+        for (const size_t threshold : { size_t{0}, size_t{1024}, size_t{1} << 30 }) {
+            PbiIndexedBamReader reader(tests::sparseBamFn);
+            reader.ReadThroughThreshold(threshold);
+            reader.Filter(tests::EveryNthRowFilter{ n });
+            EXPECT_EQ(expected, tests::FilteredNames(reader));
+        }
+    }
+}
+
+TEST(PbiIndexedBamReaderTest, ReadThroughRecoversFromClientSeek)
+{
+    const auto expected = tests::ExpectedEveryNthName(3);
+
+    PbiIndexedBamReader reader(tests::sparseBamFn);
+    reader.ReadThroughThreshold(size_t{1} << 30);
+    reader.Filter(tests::EveryNthRowFilter{ 3 });
+
+    // read first record, then move file position out from under the reader
+    BamRecord r;
+    EXPECT_TRUE(reader.GetNext(r));
+    EXPECT_EQ(expected.at(0), r.FullName());
+    reader.VirtualSeek(reader.File().FirstAlignmentOffset());
+
+    auto names = tests::FilteredNames(reader);
+    names.insert(names.begin(), r.FullName());
+    EXPECT_EQ(expected, names);
+}
+
+TEST(PbiIndexedBamReaderTest, ResultBlocksListFilteredRows)
+{
+    PbiIndexedBamReader reader(PbiFilter{ }, tests::sparseBamFn);
+    const size_t numReads = reader.PbiRawIndex().NumReads();
+    ASSERT_EQ(1, reader.ResultBlocks().size());
+    EXPECT_EQ(0, reader.ResultBlocks().front().firstIndex_);
+    EXPECT_EQ(numReads, reader.ResultBlocks().front().numReads_);
+
+    reader.Filter(tests::EveryNthRowFilter{ 3 });
+    const IndexResultBlocks blocks = reader.ResultBlocks();
+    vector<size_t> rows;
+    for (const IndexResultBlock& block : blocks) {
+        for (size_t i = 0; i < block.numReads_; ++i)
+            rows.push_back(block.firstIndex_ + i);
+    }
+    vector<size_t> expected;
+    for (size_t row = 0; row < numReads; row += 3)
+        expected.push_back(row);
+    EXPECT_EQ(expected, rows);
+
+    // unaffected by reading
+    tests::FilteredNames(reader);
+    EXPECT_EQ(blocks, reader.ResultBlocks());
+}
+
+TEST(PbiIndexedBamReaderTest, PrefetchDisabledByDefault)
+{
+    PbiIndexedBamReader reader(tests::sparseBamFn);
+    EXPECT_EQ(0, reader.PrefetchDepth());
+    EXPECT_EQ(0, reader.PrefetchThreads());
+}
+
+TEST(PbiIndexedBamReaderTest, PrefetchSameRecordsAsSequentialRead)
+{
+    for (const size_t n : { 1, 3, 50 }) {
+        const auto expected = tests::ExpectedEveryNthName(n);
+        for (const size_t depth : { 1, 4 }) {
+            for (const size_t threshold : { size_t{0}, PbiIndexedBamReader::DefaultReadThroughThreshold }) {
+                PbiIndexedBamReader reader(tests::sparseBamFn);
+                reader.PrefetchDepth(depth).PrefetchThreads(2).ReadThroughThreshold(threshold);
+                reader.Filter(tests::EveryNthRowFilter{ n });
+                EXPECT_EQ(expected, tests::FilteredNames(reader));
+            }
+        }
+    }
+}
+
+TEST(PbiIndexedBamReaderTest, PrefetchRecordContentsOk)
+{
+    EntireFileQuery query(tests::sparseBamFn);
+    PbiIndexedBamReader reader(PbiFilter{ }, tests::sparseBamFn);
+    reader.PrefetchDepth(2);
+
+    BamRecord prefetched;
+    for (const BamRecord& expected : query) {
+        EXPECT_TRUE(reader.GetNext(prefetched));
+        EXPECT_EQ(expected.FullName(), prefetched.FullName());
+        EXPECT_EQ(expected.Sequence(), prefetched.Sequence());
+        EXPECT_EQ(expected.Impl().CigarData(), prefetched.Impl().CigarData());
+        EXPECT_EQ(expected.Impl().Tags().size(), prefetched.Impl().Tags().size());
+    }
+    EXPECT_FALSE(reader.GetNext(prefetched));
+}
+
+TEST(PbiIndexedBamReaderTest, PrefetchAfterPartialReadOk)
+{
+    const auto expected = tests::ExpectedEveryNthName(1);
+
+    PbiIndexedBamReader reader(PbiFilter{ }, tests::sparseBamFn);
+    vector<string> names;
+    BamRecord r;
+    for (size_t i = 0; i < 5; ++i) {
+        EXPECT_TRUE(reader.GetNext(r));
+        names.push_back(r.FullName());
+    }
+
+    reader.PrefetchDepth(2);
+    while (reader.GetNext(r))
+        names.push_back(r.FullName());
+    EXPECT_EQ(expected, names);
+}
+
+TEST(PbiIndexedBamReaderTest, ReadRecordAtOk)
+{
+    vector<string> expected;
+    EntireFileQuery query(tests::sparseBamFn);
+    for (const BamRecord& r : query)
+        expected.push_back(r.FullName());
+
+    PbiIndexedBamReader reader(tests::sparseBamFn);
+    reader.BlockCacheSize(128 * 1024);
+    for (const size_t row : { size_t{0}, expected.size() - 1, expected.size() / 2, size_t{1} })
+        EXPECT_EQ(expected.at(row), reader.ReadRecordAt(row).FullName());
+
+    EXPECT_THROW(reader.ReadRecordAt(expected.size()), std::runtime_error);
+}
+
+TEST(PbiIndexedBamReaderTest, ReadRecordsInRequestedOrder)
+{
+    vector<string> expected;
+    EntireFileQuery query(tests::sparseBamFn);
+    for (const BamRecord& r : query)
+        expected.push_back(r.FullName());
+
+    const vector<size_t> rows = { 7, 2, expected.size() - 1, 2, 0, 100, 99 };
+
+    PbiIndexedBamReader reader(tests::sparseBamFn);
+    const auto records = reader.ReadRecords(rows);
+    ASSERT_EQ(rows.size(), records.size());
+    for (size_t i = 0; i < rows.size(); ++i) {
+        EXPECT_EQ(expected.at(rows.at(i)), records.at(i).FullName());
+        EXPECT_EQ(reader.Header().ReadGroups().size(), records.at(i).Header().ReadGroups().size());
+    }
+
+    // random access does not disturb filtered iteration
+    reader.Filter(tests::EveryNthRowFilter{ 3 });
+    BamRecord r;
+    EXPECT_TRUE(reader.GetNext(r));
+    reader.ReadRecordAt(5);
+    EXPECT_TRUE(reader.GetNext(r));
+    EXPECT_EQ(expected.at(3), r.FullName());
+}
+
+TEST(PbiIndexedBamReaderTest, IntervalMatchesOverlappingRecords)
+{
+    const string rname = "lambda_NEB3011";
+    const vector<GenomicInterval> intervals = {
+        GenomicInterval{ rname, 0, 48502 },
+        GenomicInterval{ rname, 13375, 13376 },
+        GenomicInterval{ rname, 5000, 6000 },
+        GenomicInterval{ rname, 30000, 42000 },
+        GenomicInterval{ rname, 41227, 41227 },
+        GenomicInterval{ rname, 48000, 100000 }
+    };
+
+    PbiIndexedBamReader reader(tests::sparseBamFn);
+    for (const GenomicInterval& interval : intervals) {
+        reader.Interval(interval);
+        EXPECT_EQ(tests::ExpectedOverlappingNames(interval), tests::FilteredNames(reader));
+    }
+
+    // equivalent filter is reported
+    reader.Interval(intervals.at(3));
+    PbiRawData index(tests::sparseBamFn + ".pbi");
+    size_t numAccepted = 0;
+    for (size_t row = 0; row < index.NumReads(); ++row) {
+        if (reader.Filter().Accepts(index, row))
+            ++numAccepted;
+    }
+    EXPECT_EQ(tests::ExpectedOverlappingNames(intervals.at(3)).size(), numAccepted);
+}
+
+TEST(PbiIndexedBamReaderTest, IntervalOnUnknownReferenceThrows)
+{
+    PbiIndexedBamReader reader(tests::sparseBamFn);
+    EXPECT_THROW(reader.Interval(GenomicInterval{ "does not exist", 0, 100 }), std::runtime_error);
+}
@@ -37,6 +37,7 @@
 
 #include "TestData.h"
 #include <gtest/gtest.h>
+#include <pbbam/BamReader.h>
 #include <pbbam/QNameQuery.h>
 #include <string>
 using namespace PacBio;
@@ -47,6 +48,7 @@ static const string dataDir = tests::Data_Dir + "/group/";
 static const string test1fn = string(dataDir) + "test1.bam";
 static const string test2fn = string(dataDir) + "test2.bam";
 static const string test3fn = string(dataDir) + "test3.bam";
+static const string alignedFn = tests::Data_Dir + "/aligned.bam";
 
 static
 void TestQNameQuery(const string& fn, const vector<int>& expected)
@@ -94,3 +96,49 @@ TEST(QNameQueryTest, CountQSizes)
     TestNoneConstQNameQuery(fn, expected);
 }
 
+
+static
+vector<int> NameGroupSizes(const string& fn)
+{
+    vector<int> sizes;
+    string lastName;
+    BamReader reader(fn);
+    BamRecord record;
+    while (reader.GetNext(record)) {
+        const string name = record.FullName();
+        if (sizes.empty() || name != lastName)
+            sizes.push_back(0);
+        ++sizes.back();
+        lastName = name;
+    }
+    return sizes;
+}
+
+TEST(QNameQueryTest, GroupsFromPbiMatchNames)
+{
+    ASSERT_TRUE(BamFile(alignedFn).PacBioIndexExists());
+    const vector<int> alignedExpected = NameGroupSizes(alignedFn);
+    TestQNameQuery(alignedFn, alignedExpected);
+
+    // mixed inputs: PBI-keyed file, then one compared by name
+    DataSet dataset;
+    dataset.ExternalResources().Add(ExternalResource("PacBio.SubreadFile.SubreadBamFile", alignedFn));
+    dataset.ExternalResources().Add(ExternalResource("PacBio.SubreadFile.SubreadBamFile", test3fn));
+
+    vector<int> counts;
+    vector<string> names;
+    QNameQuery query(dataset);
+    for (const vector<BamRecord>& records : query) {
+        for (const BamRecord& record : records)
+            EXPECT_EQ(records.front().FullName(), record.FullName());
+        counts.push_back(records.size());
+        names.push_back(records.front().FullName());
+    }
+
+    vector<int> expected = alignedExpected;
+    const vector<int> test3Expected = {2,1,1,1,1,1,1,2,1,1,1};
+    expected.insert(expected.end(), test3Expected.cbegin(), test3Expected.cend());
+    EXPECT_EQ(expected, counts);
+    for (size_t i = 1; i < names.size(); ++i)
+        EXPECT_NE(names.at(i-1), names.at(i));
+}
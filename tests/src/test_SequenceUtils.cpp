@@ -40,7 +40,9 @@
 #endif
 
 #include <gtest/gtest.h>
+#include <pbbam/../../src/SequenceKernels.h>
 #include <pbbam/../../src/SequenceUtils.h>
+#include <htslib/hts.h>
 #include <string>
 #include <vector>
 #include <climits>
@@ -115,3 +117,99 @@ TEST(SequenceUtilsTest, ReverseComplement)
     ReverseComplement(input1);
     EXPECT_EQ(rc1, input1);
 }
+
+namespace tests {
+
+// long enough for vectorized blocks, odd for trailing elements, with a few
+// non-letters mixed in
+static string KernelTestSequence(void)
+{
+    const string alphabet = "ACGTNacgtnRYUu";
+    string seq;
+    for (size_t i = 0; i < 301; ++i)
+        seq.push_back(alphabet[(i * 7 + i / 13) % alphabet.size()]);
+    seq[5] = '-';
+    seq[150] = '*';
+    seq[290] = '=';
+    return seq;
+}
+
+} // namespace tests
+
+TEST(SequenceUtilsTest, ReverseComplementKernelsMatchScalar)
+{
+    const string seq = tests::KernelTestSequence();
+    for (size_t length = 0; length <= seq.size(); ++length) {
+        const string input = seq.substr(0, length);
+
+        string expected = input;
+        for (char& c : expected)
+            c = Complement(c);
+        std::reverse(expected.begin(), expected.end());
+        string observed = input;
+        ReverseComplementInPlace(&observed[0], observed.size());
+        EXPECT_EQ(expected, observed);
+
+        // case-sensitive: A/C/G/T (either case) & N, U, '-', '*'
+        string expectedCaseSens;
+        for (auto it = input.crbegin(); it != input.crend(); ++it) {
+            switch (*it) {
+                case 'A' : expectedCaseSens.push_back('T'); break;
+                case 'C' : expectedCaseSens.push_back('G'); break;
+                case 'G' : expectedCaseSens.push_back('C'); break;
+                case 'T' : expectedCaseSens.push_back('A'); break;
+                case 'U' : expectedCaseSens.push_back('A'); break;
+                case 'N' : expectedCaseSens.push_back('N'); break;
+                case 'a' : expectedCaseSens.push_back('t'); break;
+                case 'c' : expectedCaseSens.push_back('g'); break;
+                case 'g' : expectedCaseSens.push_back('c'); break;
+                case 't' : expectedCaseSens.push_back('a'); break;
+                case 'u' : expectedCaseSens.push_back('a'); break;
+                case '-' : expectedCaseSens.push_back('-'); break;
+                case '*' : expectedCaseSens.push_back('*'); break;
+                default  : expectedCaseSens.push_back(4);   break;
+            }
+        }
+        string observedCaseSens = input;
+        ReverseComplementCaseSens(observedCaseSens);
+        EXPECT_EQ(expectedCaseSens, observedCaseSens);
+    }
+}
+
+TEST(SequenceUtilsTest, BamSequenceKernelsRoundTrip)
+{
+    const string seq = tests::KernelTestSequence();
+    for (size_t length = 0; length <= seq.size(); ++length) {
+        const string input = seq.substr(0, length);
+
+        vector<uint8_t> expected((length+1)/2, 0);
+        for (size_t i = 0; i < length; ++i)
+            expected[i>>1] |= seq_nt16_table[static_cast<uint8_t>(input[i])] << ((~i&1)<<2);
+        vector<uint8_t> packed(expected.size(), 0xff);
+        EncodeBamSequence(input.data(), length, packed.data());
+        EXPECT_EQ(expected, packed);
+
+        string decoded(length, '\0');
+        DecodeBamSequence(packed.data(), length, &decoded[0]);
+        string expectedDecoded;
+        for (size_t i = 0; i < length; ++i)
+            expectedDecoded.push_back("=ACMGRSVTWYHKDBN"[(packed[i>>1] >> ((~i&1)<<2)) & 0xf]);
+        EXPECT_EQ(expectedDecoded, decoded);
+    }
+}
+
+TEST(SequenceUtilsTest, QualityKernelsRoundTrip)
+{
+    string fastq;
+    for (size_t i = 0; i < 77; ++i)
+        fastq.push_back(static_cast<char>(33 + (i * 11) % 94));
+
+    vector<uint8_t> quals(fastq.size());
+    FastqToQualities(fastq.data(), fastq.size(), quals.data());
+    for (size_t i = 0; i < fastq.size(); ++i)
+        EXPECT_EQ(fastq[i] - 33, quals[i]);
+
+    string roundTrip(quals.size(), '\0');
+    QualitiesToFastq(quals.data(), quals.size(), &roundTrip[0]);
+    EXPECT_EQ(fastq, roundTrip);
+}
@@ -0,0 +1,134 @@
+// Copyright (c) 2016, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// Author: Derek Barnett
+
+#include "TestData.h"
+#include <gtest/gtest.h>
+#include <pbbam/BamReader.h>
+#include <pbbam/EntireFileQuery.h>
+#include <pbbam/PbiRawData.h>
+#include <pbbam/SharedBlockCache.h>
+#include <string>
+#include <vector>
+using namespace PacBio;
+using namespace PacBio::BAM;
+using namespace std;
+
+namespace PacBio {
+namespace BAM {
+namespace tests {
+
+static const string sharedCacheBamFn = tests::Data_Dir + "/dataset/bam_mapping_1.bam";
+
+// seeks to each record's offset (last to first), reading one record each time
+static
+vector<string> NamesBySeeking(BamReader& reader)
+{
+    const PbiRawData index(sharedCacheBamFn + ".pbi");
+    const vector<int64_t>& offsets = index.BasicData().fileOffset_;
+
+    vector<string> names(offsets.size());
+    BamRecord record;
+    for (size_t i = offsets.size(); i > 0; --i) {
+        reader.VirtualSeek(offsets.at(i-1));
+        EXPECT_TRUE(reader.GetNext(record));
+        names[i-1] = record.FullName();
+    }
+    return names;
+}
+
+static
+vector<string> ExpectedNames(void)
+{
+    vector<string> names;
+    EntireFileQuery query(sharedCacheBamFn);
+    for (const BamRecord& r : query)
+        names.push_back(r.FullName());
+    return names;
+}
+
+} // namespace tests
+} // namespace BAM
+} // namespace PacBio
+
+TEST(SharedBlockCacheTest, DisabledByDefault)
+{
+    EXPECT_FALSE(SharedBlockCache::IsEnabled());
+    EXPECT_EQ(0, SharedBlockCache::NumBytes());
+}
+
+TEST(SharedBlockCacheTest, EnableDisable)
+{
+    SharedBlockCache::Enable(1024);
+    EXPECT_TRUE(SharedBlockCache::IsEnabled());
+    EXPECT_EQ(1024, SharedBlockCache::MaxBytes());
+
+    SharedBlockCache::Disable();
+    EXPECT_FALSE(SharedBlockCache::IsEnabled());
+    EXPECT_EQ(0, SharedBlockCache::NumBytes());
+}
+
+TEST(SharedBlockCacheTest, ReadersShareCachedBlocks)
+{
+    const vector<string> expected = tests::ExpectedNames();
+
+    SharedBlockCache::Enable();
+
+    BamReader first(tests::sharedCacheBamFn);
+    EXPECT_EQ(expected, tests::NamesBySeeking(first));
+    const size_t numBytes = SharedBlockCache::NumBytes();
+    EXPECT_GT(numBytes, 0);
+
+    // second reader should find all of its blocks already cached
+    BamReader second(tests::sharedCacheBamFn);
+    EXPECT_EQ(expected, tests::NamesBySeeking(second));
+    EXPECT_EQ(numBytes, SharedBlockCache::NumBytes());
+
+    SharedBlockCache::Disable();
+}
+
+TEST(SharedBlockCacheTest, TinyCacheStillReadsCorrectly)
+{
+    const vector<string> expected = tests::ExpectedNames();
+
+    // too small to hold any block
+    SharedBlockCache::Enable(16);
+    BamReader reader(tests::sharedCacheBamFn);
+    EXPECT_EQ(expected, tests::NamesBySeeking(reader));
+    EXPECT_EQ(0, SharedBlockCache::NumBytes());
+
+    SharedBlockCache::Disable();
+}
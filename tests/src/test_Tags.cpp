@@ -42,6 +42,7 @@
 #include <boost/type_traits/is_convertible.hpp>
 #include <gtest/gtest.h>
 #include <pbbam/BamTagCodec.h>
+#include <pbbam/FlatTagCollection.h>
 #include <pbbam/TagCollection.h>
 #include <pbbam/SamTagCodec.h>
 #include <algorithm>
@@ -1142,3 +1143,91 @@ TEST(BamTagCodecTest, AsciiTagsTest)
         EXPECT_EQ(expected, data);
     }
 }
+
+TEST(BamTagCodecTest, BufferCodecMatchesVectorCodec)
+{
+    TagCollection tags;
+    tags["HX"] = Tag("1abc75", TagModifier::HEX_STRING);
+    tags["CA"] = vector<uint8_t>({34, 5, 125});
+    tags["XY"] = (int32_t)-42;
+    tags["PW"] = vector<uint16_t>({1, 2, 300});
+    tags["FL"] = vector<float>();
+    tags["AC"] = Tag('$', TagModifier::ASCII_CHAR);
+    tags["ZS"] = std::string("foo");
+
+    const vector<uint8_t> expected = BamTagCodec::Encode(tags);
+    ASSERT_EQ(expected.size(), BamTagCodec::EncodedSize(tags));
+
+    vector<uint8_t> buffer(expected.size() + 1, 0xAB);
+    EXPECT_EQ(expected.size(), BamTagCodec::Encode(tags, buffer.data()));
+    EXPECT_TRUE(std::equal(expected.cbegin(), expected.cend(), buffer.cbegin()));
+    EXPECT_EQ(0xAB, buffer.back());     // nothing written past end
+
+    // decode straight from the buffer
+    const TagCollection decoded = BamTagCodec::Decode(buffer.data(), expected.size());
+    EXPECT_EQ(BamTagCodec::Decode(expected), decoded);
+    EXPECT_EQ(vector<uint16_t>({1, 2, 300}), decoded.at("PW").ToUInt16Array());
+    EXPECT_TRUE(decoded.at("HX").HasModifier(TagModifier::HEX_STRING));
+    EXPECT_TRUE(decoded.at("AC").HasModifier(TagModifier::ASCII_CHAR));
+
+    // per-tag
+    for (const auto& entry : tags) {
+        const vector<uint8_t> raw = BamTagCodec::ToRawData(entry.second);
+        ASSERT_EQ(raw.size(), BamTagCodec::EncodedSize(entry.second));
+        vector<uint8_t> rawBuffer(raw.size());
+        EXPECT_EQ(raw.size(), BamTagCodec::ToRawData(entry.second, TagModifier::NONE, rawBuffer.data()));
+        EXPECT_EQ(raw, rawBuffer);
+    }
+}
+
+TEST(BamTagCodecTest, FlatDecodeKeepsOrder)
+{
+    FlatTagCollection tags;
+    tags.Set("ZZ", (int32_t)1)
+        .Set("AA", std::string("a"))
+        .Set("MM", vector<int16_t>({-1, 2}));
+
+    const vector<uint8_t> data = BamTagCodec::Encode(tags);
+    EXPECT_EQ('Z', data.at(0));
+    EXPECT_EQ(BamTagCodec::EncodedSize(tags), data.size());
+
+    // decode re-uses (& clears) the destination
+    FlatTagCollection decoded;
+    decoded.Set("XX", (int32_t)0);
+    BamTagCodec::Decode(data.data(), data.size(), &decoded);
+    ASSERT_EQ(3, decoded.size());
+    EXPECT_EQ("ZZ", decoded.at(0).first);
+    EXPECT_EQ("AA", decoded.at(1).first);
+    EXPECT_EQ("MM", decoded.at(2).first);
+    EXPECT_EQ(1, decoded.at(0).second.ToInt32());
+    EXPECT_EQ(string("a"), decoded.at(1).second.ToString());
+    EXPECT_EQ(vector<int16_t>({-1, 2}), decoded.at(2).second.ToInt16Array());
+
+    EXPECT_EQ(data, BamTagCodec::Encode(decoded));
+}
+
+TEST(FlatTagCollectionTest, BasicOperations)
+{
+    FlatTagCollection tags;
+    EXPECT_TRUE(tags.empty());
+    EXPECT_FALSE(tags.Contains("XY"));
+    EXPECT_EQ(nullptr, tags.Find("XY"));
+
+    tags.Set("XY", (int32_t)1).Set("AB", std::string("foo"));
+    tags.Set("XY", (int32_t)2);             // overwrite keeps position
+    ASSERT_EQ(2, tags.size());
+    EXPECT_EQ("XY", tags.at(0).first);
+    EXPECT_EQ(2, tags.Find("XY")->ToInt32());
+
+    const TagCollection asMap = tags.ToTagCollection();
+    EXPECT_EQ(2, asMap.size());
+    EXPECT_EQ(string("foo"), asMap.at("AB").ToString());
+
+    const FlatTagCollection fromMap(asMap);
+    EXPECT_EQ("AB", fromMap.at(0).first);  // map (name) order
+
+    EXPECT_TRUE(tags.Remove("XY"));
+    EXPECT_FALSE(tags.Remove("XY"));
+    EXPECT_EQ(1, tags.size());
+    EXPECT_TRUE(tags.Contains("AB"));
+}
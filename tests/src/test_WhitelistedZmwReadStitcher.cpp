@@ -258,3 +258,26 @@ TEST(WhitelistedZmwReadStitching, EmptyScrapsFileOk)
     EXPECT_EQ(3, primaryIdx.NumReads());
     EXPECT_EQ(0, scrapsIdx.NumReads());
 }
+
+TEST(WhitelistedZmwReadStitching, UnorderedWhitelistWithDuplicates)
+{
+    // out of order & repeated ZMWs are stitched in whitelist order
+    const std::vector<int32_t> whitelist = { 300000, 100000, 300000 };
+    WhitelistedZmwReadStitcher stitcher(whitelist,
+                                        tests::Data_Dir + "/polymerase/internal.subreads.bam",
+                                        tests::Data_Dir + "/polymerase/internal.scraps.bam");
+
+    std::vector<BamRecord> polyRecords;
+    EntireFileQuery polyQuery(tests::Data_Dir + "/polymerase/internal.polymerase.bam");
+    for (const BamRecord& record : polyQuery)
+        polyRecords.push_back(record);
+    ASSERT_EQ(3, polyRecords.size());
+
+    for (const size_t expectedIndex : { 2, 0, 2 }) {
+        ASSERT_TRUE(stitcher.HasNext());
+        auto virtualRecord = stitcher.Next();
+        EXPECT_EQ(polyRecords.at(expectedIndex).HoleNumber(), virtualRecord.HoleNumber());
+        tests::Compare(polyRecords.at(expectedIndex), virtualRecord);
+    }
+    EXPECT_FALSE(stitcher.HasNext());
+}
@@ -43,9 +43,12 @@
 #include <gtest/gtest.h>
 #include <pbbam/EntireFileQuery.h>
 #include <pbbam/PbiFilter.h>
+#include <pbbam/virtual/LazyVirtualZmwBamRecord.h>
+#include <pbbam/virtual/VirtualZmwBamRecord.h>
 #include <pbbam/virtual/VirtualPolymeraseReader.h>
 #include <pbbam/virtual/VirtualPolymeraseCompositeReader.h>
 #include <pbbam/virtual/ZmwReadStitcher.h>
+#include <fstream>
 #include <string>
 using namespace PacBio;
 using namespace PacBio::BAM;
@@ -490,6 +493,221 @@ TEST(ZmwReadStitching, VirtualRecord_VirtualRegionsTable)
     EXPECT_TRUE(filtered.empty());    // this type not present in this data
 }
 
+TEST(ZmwReadStitching, StitchedTagsKeepSourceEncoding)
+{
+    // collect the single ZMW's subreads & scraps
+    vector<BamRecord> sources;
+    BamHeader header;
+    for (const string& fn : { tests::Data_Dir + "/polymerase/production.subreads.bam",
+                              tests::Data_Dir + "/polymerase/production.scraps.bam" })
+    {
+        EntireFileQuery query(fn);
+        for (const BamRecord& r : query) {
+            sources.push_back(r);
+            header = r.Header();
+        }
+    }
+    ASSERT_LT(1, sources.size());
+    ASSERT_TRUE(sources.front().Impl().TagValue("ip").IsUInt8Array());
+
+    // lossy IPD codes concatenated as-is
+    {
+        const VirtualZmwBamRecord stitched(vector<BamRecord>(sources), header);
+        const Tag ipTag = stitched.Impl().TagValue("ip");
+        EXPECT_TRUE(ipTag.IsUInt8Array());
+        EXPECT_EQ(stitched.Sequence().size(), ipTag.ToUInt8Array().size());
+
+        vector<BamRecord> sorted = stitched.sources_;
+        Frames expectedIpd;
+        string expectedDeletionTag;
+        for (const BamRecord& r : sorted) {
+            const auto ipd = r.IPD().Data();
+            expectedIpd.DataRaw().insert(expectedIpd.DataRaw().end(), ipd.cbegin(), ipd.cend());
+            expectedDeletionTag += r.DeletionTag();
+        }
+        EXPECT_EQ(expectedIpd, stitched.IPD());
+        EXPECT_EQ(expectedIpd, stitched.IPDV1Frames());
+        EXPECT_EQ(expectedDeletionTag, stitched.DeletionTag());
+    }
+
+    // mixed encodings are decoded & stored lossless
+    {
+        vector<BamRecord> mixed = sources;
+        mixed.front().IPD(mixed.front().IPD(), FrameEncodingType::LOSSLESS);
+        ASSERT_TRUE(mixed.front().Impl().TagValue("ip").IsUInt16Array());
+
+        const VirtualZmwBamRecord stitched(std::move(mixed), header);
+        const VirtualZmwBamRecord expected(vector<BamRecord>(sources), header);
+        EXPECT_TRUE(stitched.Impl().TagValue("ip").IsUInt16Array());
+        EXPECT_EQ(expected.IPD(), stitched.IPD());
+        EXPECT_EQ(expected.PulseWidth(), stitched.PulseWidth());
+    }
+}
+
+TEST(ZmwReadStitching, StitchedArrayTagsWidenMixedTypes)
+{
+    vector<BamRecord> sources;
+    BamHeader header;
+    EntireFileQuery query(tests::Data_Dir + "/polymerase/production.subreads.bam");
+    for (const BamRecord& r : query) {
+        sources.push_back(r);
+        header = r.Header();
+    }
+    ASSERT_LT(1, sources.size());
+
+    // first source stores narrower arrays than the rest
+    for (size_t i = 0; i < sources.size(); ++i) {
+        BamRecordImpl& impl = sources.at(i).Impl();
+        impl.RemoveTag("sf");
+        impl.RemoveTag("pm");
+        if (i == 0) {
+            impl.AddTag("sf", Tag{ vector<uint16_t>{ 1, 2, 65535 } });
+            impl.AddTag("pm", Tag{ vector<uint8_t>{ 3, 255 } });
+        } else {
+            impl.AddTag("sf", Tag{ vector<uint32_t>{ 70000 + static_cast<uint32_t>(i) } });
+            impl.AddTag("pm", Tag{ vector<uint16_t>{ 1000 } });
+        }
+    }
+
+    const VirtualZmwBamRecord stitched(vector<BamRecord>(sources), header);
+    const Tag sfTag = stitched.Impl().TagValue("sf");
+    const Tag pmTag = stitched.Impl().TagValue("pm");
+    ASSERT_TRUE(sfTag.IsUInt32Array());
+    ASSERT_TRUE(pmTag.IsUInt16Array());
+
+    vector<uint32_t> expectedSf;
+    vector<uint16_t> expectedPm;
+    for (const BamRecord& r : stitched.sources_) {
+        const Tag sourceSf = r.Impl().TagValue("sf");
+        const Tag sourcePm = r.Impl().TagValue("pm");
+        if (sourceSf.IsUInt16Array()) {
+            for (const uint16_t v : sourceSf.ToUInt16Array())
+                expectedSf.push_back(v);
+            for (const uint8_t v : sourcePm.ToUInt8Array())
+                expectedPm.push_back(v);
+        } else {
+            for (const uint32_t v : sourceSf.ToUInt32Array())
+                expectedSf.push_back(v);
+            for (const uint16_t v : sourcePm.ToUInt16Array())
+                expectedPm.push_back(v);
+        }
+    }
+    EXPECT_EQ(expectedSf, sfTag.ToUInt32Array());
+    EXPECT_EQ(expectedPm, pmTag.ToUInt16Array());
+    EXPECT_EQ(expectedSf, stitched.StartFrame());
+}
+
+TEST(ZmwReadStitching, LazyRecordMatchesEager)
+{
+    for (const string& prefix : { tests::Data_Dir + "/polymerase/internal",
+                                  tests::Data_Dir + "/polymerase/production" })
+    {
+        ZmwReadStitcher eagerStitcher(prefix + ".subreads.bam", prefix + ".scraps.bam");
+        ZmwReadStitcher lazyStitcher(prefix + ".subreads.bam", prefix + ".scraps.bam");
+        size_t count = 0;
+        while (eagerStitcher.HasNext()) {
+            ASSERT_TRUE(lazyStitcher.HasNext());
+            const VirtualZmwBamRecord eager = eagerStitcher.Next();
+            const LazyVirtualZmwBamRecord lazy = lazyStitcher.NextLazy();
+
+            EXPECT_EQ(eager.FullName(), lazy.FullName());
+            EXPECT_EQ(eager.HoleNumber(), lazy.HoleNumber());
+            EXPECT_EQ(eager.QueryStart(), lazy.QueryStart());
+            EXPECT_EQ(eager.QueryEnd(), lazy.QueryEnd());
+            EXPECT_EQ(eager.VirtualRegionsMap(), lazy.VirtualRegionsMap());
+            EXPECT_EQ(eager.Sequence(), lazy.Sequence());
+            EXPECT_EQ(eager.Qualities(), lazy.Qualities());
+
+            EXPECT_EQ(eager.HasDeletionTag(), lazy.HasDeletionTag());
+            if (eager.HasDeletionTag()) {
+                EXPECT_EQ(eager.DeletionTag(), lazy.DeletionTag());
+            }
+            EXPECT_EQ(eager.HasIPD(), lazy.HasIPD());
+            if (eager.HasIPD()) {
+                EXPECT_EQ(eager.IPD(), lazy.IPD());
+            }
+            EXPECT_EQ(eager.HasPulseWidth(), lazy.HasPulseWidth());
+            if (eager.HasPulseWidth()) {
+                EXPECT_EQ(eager.PulseWidth(), lazy.PulseWidth());
+            }
+            EXPECT_EQ(eager.HasPulseCall(), lazy.HasPulseCall());
+            if (eager.HasPulseCall()) {
+                EXPECT_EQ(eager.PulseCall(), lazy.PulseCall());
+            }
+            EXPECT_EQ(eager.HasPkmid(), lazy.HasPkmid());
+            if (eager.HasPkmid()) {
+                EXPECT_EQ(eager.Pkmid(), lazy.Pkmid());
+            }
+            EXPECT_EQ(eager.HasStartFrame(), lazy.HasStartFrame());
+            if (eager.HasStartFrame()) {
+                EXPECT_EQ(eager.StartFrame(), lazy.StartFrame());
+            }
+
+            // writable record matches the eager one
+            const VirtualZmwBamRecord converted = lazy.ToBamRecord();
+            EXPECT_EQ(eager.FullName(), converted.FullName());
+            EXPECT_EQ(eager.Sequence(), converted.Sequence());
+            EXPECT_EQ(eager.Qualities(), converted.Qualities());
+            EXPECT_EQ(eager.Impl().Tags().size(), converted.Impl().Tags().size());
+            EXPECT_EQ(eager.VirtualRegionsMap(), converted.VirtualRegionsMap());
+            if (eager.HasIPD()) {
+                EXPECT_EQ(eager.IPD(), converted.IPD());
+            }
+            ++count;
+        }
+        EXPECT_FALSE(lazyStitcher.HasNext());
+        EXPECT_LT(0, count);
+    }
+}
+
+TEST(ZmwReadStitching, LazyRecordRequiresSources)
+{
+    EXPECT_THROW(LazyVirtualZmwBamRecord(vector<BamRecord>(), BamHeader()), std::runtime_error);
+}
+
+TEST(ZmwReadStitching, SameGroupsWithOrWithoutIndex)
+{
+    // copy BAMs, without their PBI files
+    const string primaryFn = tests::Data_Dir + "/polymerase/internal.subreads.bam";
+    const string scrapsFn  = tests::Data_Dir + "/polymerase/internal.scraps.bam";
+    const string primaryCopy = tests::GeneratedData_Dir + "/noindex.subreads.bam";
+    const string scrapsCopy  = tests::GeneratedData_Dir + "/noindex.scraps.bam";
+    {
+        std::ifstream primaryIn(primaryFn, std::ios::binary);
+        std::ofstream primaryOut(primaryCopy, std::ios::binary);
+        primaryOut << primaryIn.rdbuf();
+        std::ifstream scrapsIn(scrapsFn, std::ios::binary);
+        std::ofstream scrapsOut(scrapsCopy, std::ios::binary);
+        scrapsOut << scrapsIn.rdbuf();
+    }
+    ASSERT_TRUE(BamFile(primaryFn).PacBioIndexExists());
+    ASSERT_FALSE(BamFile(primaryCopy).PacBioIndexExists());
+
+    ZmwReadStitcher indexed(primaryFn, scrapsFn);
+    ZmwReadStitcher unindexed(primaryCopy, scrapsCopy);
+    size_t count = 0;
+    while (indexed.HasNext()) {
+        ASSERT_TRUE(unindexed.HasNext());
+        const vector<BamRecord> expected = indexed.NextRaw();
+        const vector<BamRecord> observed = unindexed.NextRaw();
+        ASSERT_EQ(expected.size(), observed.size());
+        for (size_t i = 0; i < expected.size(); ++i) {
+            EXPECT_EQ(expected.at(i).FullName(), observed.at(i).FullName());
+            EXPECT_EQ(expected.front().HoleNumber(), observed.at(i).HoleNumber());
+        }
+        ++count;
+    }
+    EXPECT_FALSE(unindexed.HasNext());
+    EXPECT_EQ(3, count);
+
+    // filtering still requires the index
+    EXPECT_THROW(ZmwReadStitcher(primaryCopy, scrapsCopy, PbiFilter{ PbiZmwFilter{100000} }),
+                 std::runtime_error);
+
+    remove(primaryCopy.c_str());
+    remove(scrapsCopy.c_str());
+}
+
 TEST(ZmwReadStitching, LegacyTypedefsOk)
 {
     {
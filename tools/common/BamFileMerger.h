@@ -60,13 +60,19 @@ public:
     /// \param[in] outputFilename   resulting BAM output
     /// \param[in] mergeProgram     info about the calling program. Adds a @PG entry to merged header.
     /// \param[in] createPbi        if true, creates a PBI alongside output BAM
+    /// \param[in] numThreads       number of background threads used to read
+    ///                             input files (0 to read on the calling thread)
+    /// \param[in] maxOpenFiles     maximum number of input files kept open at
+    ///                             once (0 for no limit)
     ///
     /// \throws std::runtime_error if any any errors encountered while reading or writing
     ///
     static void Merge(const PacBio::BAM::DataSet& dataset,
                       const std::string& outputFilename,
                       const PacBio::BAM::ProgramInfo& mergeProgram = PacBio::BAM::ProgramInfo(),
-                      bool createPbi = true);
+                      bool createPbi = true,
+                      size_t numThreads = 0,
+                      size_t maxOpenFiles = 0);
 };
 
 } // namespace common
@@ -44,9 +44,10 @@
 #include <pbbam/CompositeBamReader.h>
 #include <pbbam/PbiBuilder.h>
 
-#include <deque>
+#include <algorithm>
 #include <memory>
 #include <stdexcept>
+#include <unordered_map>
 #include <cassert>
 
 namespace PacBio {
@@ -58,113 +59,112 @@ namespace common {
 class ICollator
 {
 public:
-    ~ICollator(void) { }
-
-    bool GetNext(BamRecord& record)
-    {
-        // nothing left to read
-        if (mergeItems_.empty())
-            return false;
-
-        // non-destructive 'pop' of first item from queue
-        auto firstIter = mergeItems_.begin();
-        auto firstItem = PacBio::BAM::internal::CompositeMergeItem{ std::move(firstIter->reader),
-                                                                    std::move(firstIter->record)
-                                                                  };
-        mergeItems_.pop_front();
-
-        // store its record in our output record
-        std::swap(record, firstItem.record);
-
-        // try fetch 'next' from first item's reader
-        // if successful, re-insert it into container & re-sort on our new values
-        // otherwise, this item will go out of scope & reader destroyed
-        if (firstItem.reader->GetNext(firstItem.record)) {
-            mergeItems_.push_front(std::move(firstItem));
-            UpdateSort();
-        }
-
-        // return success
-        return true;
-    }
+    virtual ~ICollator(void) { }
+    virtual bool GetNext(BamRecord& record) =0;
+};
 
-protected:
-    std::deque<PacBio::BAM::internal::CompositeMergeItem> mergeItems_;
+// Collator - merges readers' records, using a binary heap of merge items
 
-protected:
-    ICollator(std::vector<std::unique_ptr<PacBio::BAM::BamReader> >&& readers)
+template<typename MergeKey>
+class Collator : public ICollator
+{
+public:
+    Collator(std::vector<std::unique_ptr<PacBio::BAM::BamReader> >&& readers,
+             const size_t numThreads,
+             const size_t maxOpenFiles,
+             const MergeKey& mergeKey = MergeKey())
+        : mergeItems_(mergeKey)
     {
+        mergeItems_.ReadAheadThreads(numThreads);
+        mergeItems_.MaxOpenFiles(maxOpenFiles);
         for (auto&& reader : readers) {
             auto item = internal::CompositeMergeItem{std::move(reader)};
             if (item.reader->GetNext(item.record))
-                mergeItems_.push_back(std::move(item));
+                mergeItems_.Push(std::move(item));
         }
     }
 
-    virtual void UpdateSort(void) =0;
+    bool GetNext(BamRecord& record)
+    { return mergeItems_.GetNext(record); }
+
+private:
+    PacBio::BAM::internal::CompositeMergeHeap<MergeKey> mergeItems_;
 };
 
 // QNameCollator
 
-struct QNameSorter : std::binary_function<internal::CompositeMergeItem,
-                                          internal::CompositeMergeItem,
-                                          bool>
+// Sort key for query name order: movie name, hole number, then query start
+// (with CCS reads after all others). Movie names are replaced by their rank
+// among all movies in the merged header, so that all comparisons are on
+// integers.
+//
+class QNameMergeKey
 {
-    bool operator()(const internal::CompositeMergeItem& lhs,
-                    const internal::CompositeMergeItem& rhs)
+public:
+    struct key_type
     {
-        const BamRecord& l = lhs.record;
-        const BamRecord& r = rhs.record;
-
-        // movie name
-        const int cmp = l.MovieName().compare(r.MovieName());
-        if (cmp != 0)
-            return cmp < 0;
-
-        // hole number
-        const auto lhsZmw = l.HoleNumber();
-        const auto rhsZmw = r.HoleNumber();
-        if (lhsZmw != rhsZmw)
-            return lhsZmw < rhsZmw;
-
-        // shuffle CCS reads after all others
-        const auto lhsReadType = l.Type();
-        const auto rhsReadType = r.Type();
-        if (lhsReadType == RecordType::CCS)
-            return false;
-        if (rhsReadType == RecordType::CCS)
-            return true;
-
-        // sort on qStart, then finally qEnd
-        const auto lhsQStart = l.QueryStart();
-        const auto rhsQStart = r.QueryStart();
-        return lhsQStart < rhsQStart;
-    }
-};
+        uint64_t zmw;   // movie rank, hole number
+        uint64_t read;  // CCS flag, query start
+    };
 
-class QNameCollator : public ICollator
-{
 public:
-    QNameCollator(std::vector<std::unique_ptr<PacBio::BAM::BamReader>>&& readers)
-        : ICollator(std::move(readers))
-    { UpdateSort(); }
+    QNameMergeKey(const BamHeader& header)
+    {
+        const std::vector<ReadGroupInfo> readGroups = header.ReadGroups();
+
+        std::vector<std::string> movieNames;
+        movieNames.reserve(readGroups.size());
+        for (const ReadGroupInfo& rg : readGroups)
+            movieNames.push_back(rg.MovieName());
+        std::sort(movieNames.begin(), movieNames.end());
+        movieNames.erase(std::unique(movieNames.begin(), movieNames.end()), movieNames.end());
+
+        for (const ReadGroupInfo& rg : readGroups) {
+            const auto found = std::lower_bound(movieNames.cbegin(), movieNames.cend(), rg.MovieName());
+            ReadGroupKey& rgKey = readGroups_[rg.Id()];
+            rgKey.movieRank = static_cast<uint32_t>(found - movieNames.cbegin());
+            rgKey.isCcs = (rg.ReadType() == "CCS");
+        }
+    }
+
+    key_type MakeKey(const BamRecord& record) const
+    {
+        const std::string rgId = record.ReadGroupId();
+        const auto found = readGroups_.find(rgId);
+        if (found == readGroups_.cend())
+            throw std::runtime_error("read group ID not found: " + rgId);
+        const ReadGroupKey& rgKey = found->second;
+
+        // flip sign bits, so that (signed) values order as unsigned
+        key_type key;
+        key.zmw = (static_cast<uint64_t>(rgKey.movieRank) << 32) |
+                  (static_cast<uint32_t>(record.HoleNumber()) ^ 0x80000000u);
+        key.read = rgKey.isCcs ? (uint64_t(1) << 32)
+                               : (static_cast<uint32_t>(record.QueryStart()) ^ 0x80000000u);
+        return key;
+    }
+
+    bool Less(const key_type& lhs, const key_type& rhs) const
+    {
+        if (lhs.zmw != rhs.zmw)
+            return lhs.zmw < rhs.zmw;
+        return lhs.read < rhs.read;
+    }
 
-    void UpdateSort(void)
-    { std::sort(mergeItems_.begin(), mergeItems_.end(), QNameSorter{ }); }
+private:
+    struct ReadGroupKey
+    {
+        uint32_t movieRank;
+        bool isCcs;
+    };
+    std::unordered_map<std::string, ReadGroupKey> readGroups_;
 };
 
-// AlignedCollator
+typedef Collator<QNameMergeKey> QNameCollator;
 
-class AlignedCollator : public ICollator
-{
-public:
-    AlignedCollator(std::vector<std::unique_ptr<PacBio::BAM::BamReader>>&& readers)
-        : ICollator(std::move(readers))
-    { UpdateSort(); }
+// AlignedCollator
 
-    void UpdateSort(void)
-    { std::sort(mergeItems_.begin(), mergeItems_.end(), PacBio::BAM::PositionSorter{ }); }
-};
+typedef Collator<PacBio::BAM::internal::PositionMergeKey> AlignedCollator;
 
 // BamFileMerger
 
@@ -172,7 +172,9 @@ inline
 void BamFileMerger::Merge(const DataSet& dataset,
                           const std::string& outputFilename,
                           const ProgramInfo& mergeProgram,
-                          bool createPbi)
+                          bool createPbi,
+                          size_t numThreads,
+                          size_t maxOpenFiles)
 {
     const PbiFilter filter = PbiFilter::FromDataSet(dataset);
 
@@ -197,6 +199,10 @@ void BamFileMerger::Merge(const DataSet& dataset,
             readers.emplace_back(new BamReader(fn));
         else
             readers.emplace_back(new PbiIndexedBamReader(filter, fn));
+
+        // if limiting open files, close until needed
+        if (maxOpenFiles > 0)
+            readers.back()->Park();
     }
 
     // read headers
@@ -224,9 +230,10 @@ void BamFileMerger::Merge(const DataSet& dataset,
     // setup collator, based on sort order
     std::unique_ptr<ICollator> collator;
     if (isCoordinateSorted)
-        collator.reset(new AlignedCollator(std::move(readers)));
+        collator.reset(new AlignedCollator(std::move(readers), numThreads, maxOpenFiles));
     else
-        collator.reset(new QNameCollator(std::move(readers)));
+        collator.reset(new QNameCollator(std::move(readers), numThreads, maxOpenFiles,
+                                         QNameMergeKey{ mergedHeader }));
     // NOTE: readers *moved*, so no longer accessible here
 
     // do merge, creating PBI on-the-fly
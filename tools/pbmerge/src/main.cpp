@@ -76,6 +76,26 @@ public:
                 settings.createPbi_ = true; // not specified, go ahead and generate by default
         }
 
+        // threads
+        settings.numThreads_ = 0;
+        if (options.is_set("num_threads")) {
+            const int numThreads = options.get("num_threads");
+            if (numThreads < 0)
+                settings.errors_.push_back("number of threads must not be negative");
+            else
+                settings.numThreads_ = static_cast<size_t>(numThreads);
+        }
+
+        // open file limit
+        settings.maxOpenFiles_ = 0;
+        if (options.is_set("max_open_files")) {
+            const int maxOpenFiles = options.get("max_open_files");
+            if (maxOpenFiles < 0)
+                settings.errors_.push_back("maximum number of open files must not be negative");
+            else
+                settings.maxOpenFiles_ = static_cast<size_t>(maxOpenFiles);
+        }
+
         return settings;
     }
 
@@ -83,6 +103,8 @@ public:
     std::vector<std::string> inputFilenames_;
     std::string outputFilename_;
     bool createPbi_;
+    size_t numThreads_;
+    size_t maxOpenFiles_;
     std::vector<std::string> errors_;
 
 private:
@@ -127,6 +149,20 @@ int main(int argc, char* argv[])
                  );
     parser.add_option_group(ioGroup);
 
+    auto perfGroup = optparse::OptionGroup(parser, "Performance");
+    perfGroup.add_option("-j")
+             .dest("num_threads")
+             .metavar("INT")
+             .help("Number of threads used to read input files in the background. "
+                   "Use 0 (default) to read all input on the main thread.");
+    perfGroup.add_option("--max-open-files")
+             .dest("max_open_files")
+             .metavar("INT")
+             .help("Maximum number of input files kept open at once. Others are "
+                   "closed, and reopened when needed. Use 0 (default) for no limit. "
+                   "Not applied when reading input in the background (-j).");
+    parser.add_option_group(perfGroup);
+
     // parse command line for settings
     const pbmerge::Settings settings = pbmerge::Settings::FromCommandLine(parser, argc, argv);
     if (!settings.errors_.empty()) {
@@ -156,7 +192,9 @@ int main(int argc, char* argv[])
         PacBio::BAM::common::BamFileMerger::Merge(dataset,
                                                   settings.outputFilename_,
                                                   mergeProgram,
-                                                  settings.createPbi_);
+                                                  settings.createPbi_,
+                                                  settings.numThreads_,
+                                                  settings.maxOpenFiles_);
 
 
 //        PacBio::BAM::common::BamFileMerger merger(dataset,